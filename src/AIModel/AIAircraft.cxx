@@ -91,6 +91,8 @@ FGAIAircraft::FGAIAircraft(FGAISchedule *ref) :
     holdPos = false;
     needsTaxiClearance = false;
     _needsGroundElevation = true;
+    _statePending = false;
+    _externalState = false;
 
     _performance = 0; //TODO initialize to JET_TRANSPORT from PerformanceDB
     dt = 0;
@@ -130,9 +132,9 @@ void FGAIAircraft::bind() {
 }
 
 void FGAIAircraft::update(double dt) {
-    FGAIBase::update(dt);
-    Run(dt);
-    Transform();
+    prepareUpdate(dt);
+    computeUpdate(dt);
+    commitUpdate(dt);
 }
 
 void FGAIAircraft::setPerformance(const std::string& acType, const std::string& acclass)
@@ -147,8 +149,12 @@ void FGAIAircraft::setPerformance(const std::string& acType, const std::string&
   }
 #endif
 
- void FGAIAircraft::Run(double dt) {
-      FGAIAircraft::dt = dt;
+// flight plan, ATC and target values; these reach into the traffic
+// manager, ATC, scenery and other aircraft, so stay on the main thread
+void FGAIAircraft::prepareUpdate(double dt) {
+     FGAIBase::update(dt);
+     FGAIAircraft::dt = dt;
+     _statePending = false;
     
      bool outOfSight = false, 
         flightplanActive = true;
@@ -163,21 +169,59 @@ void FGAIAircraft::setPerformance(const std::string& acType, const std::string&
 
      handleATCRequests(); // ATC also has a word to say
      updateSecondaryTargetValues(); // target roll, vertical speed, pitch
-     updateActualState();
+     _statePending = true;
+}
+
+// integrate the performance model towards the targets, or take the state
+// of the external flight model
+void FGAIAircraft::computeUpdate(double dt) {
+     if (!_statePending)
+        return;
+
+     if (_externalState) {
+        pos = _external.pos;
+        altitude_ft = pos.getElevationFt();
+        hdg = _external.heading;
+        pitch = _external.pitch;
+        roll = _external.roll;
+        speed = _external.speed;
+        vs = _external.vs;
+     } else {
+        updateActualState();
+     }
+}
+
+void FGAIAircraft::setExternalState(const SGGeod& position, double heading,
+                                    double pitch, double roll,
+                                    double speed_kts, double vs_fpm) {
+     _externalState = true;
+     _external.pos = position;
+     _external.heading = heading;
+     _external.pitch = pitch;
+     _external.roll = roll;
+     _external.speed = speed_kts;
+     _external.vs = vs_fpm;
+}
+
+void FGAIAircraft::commitUpdate(double dt) {
+     if (_statePending) {
 #if 0
    // 25/11/12 - added but disabled, since setting properties isn't
    // affecting the AI-model as expected.
-     updateModelProperties(dt);
+        updateModelProperties(dt);
 #endif
    
     // We currently have one situation in which an AIAircraft object is used that is not attached to the
     // AI manager. In this particular case, the AIAircraft is used to shadow the user's aircraft's behavior in the AI world.
     // Since we perhaps don't want a radar entry of our own aircraft, the following conditional should probably be adequate
     // enough
-     if (manager)
-        UpdateRadar(manager);
-     checkVisibility();
-  }
+        if (manager)
+           UpdateRadar(manager);
+        checkVisibility();
+        _statePending = false;
+     }
+     Transform();
+}
 
 void FGAIAircraft::checkVisibility() 
 {
@@ -44,6 +44,11 @@ public:
     virtual void bind();
     virtual void update(double dt);
 
+    virtual bool parallelUpdate() const { return true; }
+    virtual void prepareUpdate(double dt);
+    virtual void computeUpdate(double dt);
+    virtual void commitUpdate(double dt);
+
     void setPerformance(const std::string& acType, const std::string& perfString);
   //  void setPerformance(PerformanceData *ps);
 
@@ -107,10 +112,17 @@ public:
     double calcVerticalSpeed(double vert_ft, double dist_m, double speed, double error);
 
     FGATCController * getATCController() { return controller; };
-    
-protected:
-    void Run(double dt);
 
+    /**
+     * Take the position, attitude and speeds of the next update from an
+     * external flight model (see FDMPool) rather than from the
+     * performance model. The flight plan and targets are still followed.
+     */
+    void setExternalState(const SGGeod& position, double heading, double pitch,
+                          double roll, double speed_kts, double vs_fpm);
+    void clearExternalState() { _externalState = false; };
+    bool hasExternalState() const { return _externalState; };
+    
 private:
     FGAISchedule *trafficRef;
     FGATCController *controller, 
@@ -177,6 +189,12 @@ private:
     bool reachedWaypoint;
     bool needsTaxiClearance;
     bool _needsGroundElevation;
+    bool _statePending; // between prepareUpdate and commitUpdate
+    bool _externalState; // driven by setExternalState()
+    struct {
+        SGGeod pos;
+        double heading, pitch, roll, speed, vs;
+    } _external;
     int  takeOffStatus; // 1 = joined departure cue; 2 = Passed DepartureHold waypoint; handover control to tower; 0 = any other state. 
     time_t timeElapsed;
 
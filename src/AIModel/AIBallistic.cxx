@@ -66,6 +66,7 @@ _report_collision(false),
 _report_impact(false),
 _external_force(false),
 _report_expiry(false),
+_run_pending(false),
 _impact_report_node(fgGetNode("/ai/models/model-impact", true)),
 _old_height(0)
 
@@ -256,17 +257,48 @@ void FGAIBallistic::bind() {
 }
 
 void FGAIBallistic::update(double dt)
+{
+    prepareUpdate(dt);
+    computeUpdate(dt);
+    commitUpdate(dt);
+}
+
+bool FGAIBallistic::parallelUpdate() const
+{
+    // the external force and slaved loads read properties and the scenery
+    // in the middle of the integration
+    return !_slave_to_ac && !_slave_load_to_ac && !_external_force;
+}
+
+void FGAIBallistic::prepareUpdate(double dt)
 {
     FGAIBase::update(dt);
 
+    _run_pending = false;
+
     if (_slave_to_ac){
         slaveToAC(dt);
-        Transform();
     } else if (!invisible){
-        Run(dt);
-        Transform();
+        prepareRun(dt);
+        _run_pending = true;
     }
+}
+
+void FGAIBallistic::computeUpdate(double dt)
+{
+    if (_run_pending)
+        integrate(dt);
+}
+
+void FGAIBallistic::commitUpdate(double dt)
+{
+    if (_run_pending)
+        finishRun();
+
+    if (_slave_to_ac || _run_pending)
+        Transform();
 
+    _run_pending = false;
 }
 
 void FGAIBallistic::setAzimuth(double az) {
@@ -647,6 +679,12 @@ void FGAIBallistic::slaveToAC(double dt){
 }
 
 void FGAIBallistic::Run(double dt) {
+    prepareRun(dt);
+    integrate(dt);
+    finishRun();
+}
+
+void FGAIBallistic::prepareRun(double dt) {
     _life_timer += dt;
     
     //_pass += 1;
@@ -675,7 +713,9 @@ void FGAIBallistic::Run(double dt) {
     //randomise Cd by +- 10%
     if (_random)
         _Cd = _Cd * 0.90 + (0.10 * sg_random());
+}
 
+void FGAIBallistic::integrate(double dt) {
     // Adjust Cd by Mach number. The equations are based on curves
     // for a conventional shell/bullet (no boat-tail).
     double Cdm;
@@ -913,6 +953,9 @@ void FGAIBallistic::Run(double dt) {
         setHdg(_azimuth, dt, coeff);
     }
 
+}
+
+void FGAIBallistic::finishRun() {
     //do impacts and collisions
     if (_report_impact && !_impact_reported)
         handle_impact();
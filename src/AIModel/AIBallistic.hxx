@@ -48,6 +48,11 @@ public:
     virtual void reinit();
     virtual void update(double dt);
 
+    virtual bool parallelUpdate() const;
+    virtual void prepareUpdate(double dt);
+    virtual void computeUpdate(double dt);
+    virtual void commitUpdate(double dt);
+
     virtual const char* getTypeString(void) const { return "ballistic"; }
 
     void Run(double dt);
@@ -194,6 +199,7 @@ private:
     bool   _report_impact;          // if true an impact point on the terrain is calculated
     bool   _external_force;         // if true then apply external force
     bool   _report_expiry;
+    bool   _run_pending;            // between prepareUpdate and commitUpdate
 
     SGPropertyNode_ptr _impact_report_node;  // report node for impact and collision
     SGPropertyNode_ptr _contents_node;  // node for droptank etc. contents
@@ -219,6 +225,10 @@ private:
     string _force_path;
     string _contents_path;
 
+    void prepareRun(double dt);
+    void integrate(double dt);
+    void finishRun();
+
     void handle_collision();
     void handle_expiry();
     void handle_impact();
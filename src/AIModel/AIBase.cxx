@@ -570,8 +570,8 @@ SGVec3d FGAIBase::getCartPos() const {
 
 bool FGAIBase::getGroundElevationM(const SGGeod& pos, double& elev,
                                    const simgear::BVHMaterial** material) const {
-    return globals->get_scenery()->get_elevation_m(pos, elev, material,
-                                                   _model.get());
+    return globals->get_scenery()->get_cached_elevation_m(pos, elev, material,
+                                                          _model.get());
 }
 
 double FGAIBase::_getCartPosX() const {
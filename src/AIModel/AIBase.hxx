@@ -68,6 +68,19 @@ public:
     virtual void unbind();
     virtual void reinit() {}
 
+    /**
+     * Objects which can do the bulk of their update off the main thread
+     * return true here. The manager then calls prepareUpdate(), then
+     * computeUpdate(), then commitUpdate() instead of update(). Only
+     * computeUpdate() may run on a worker thread, concurrently with
+     * other objects; it must touch nothing but the object's own members
+     * (no properties, scenery, ATC or other AI objects).
+     */
+    virtual bool parallelUpdate() const { return false; }
+    virtual void prepareUpdate(double) {}
+    virtual void computeUpdate(double) {}
+    virtual void commitUpdate(double) {}
+
     void updateLOD();
     void setManager(FGAIManager* mgr, SGPropertyNode* p);
     void setPath( const char* model );
@@ -101,6 +101,11 @@ FGAIManager::init() {
     user_altitude_agl_node  = fgGetNode("/position/altitude-agl-ft", true);
     user_yaw_node       = fgGetNode("/orientation/side-slip-deg", true);
     user_speed_node     = fgGetNode("/velocities/uBody-fps", true);
+
+    // worker threads for the AI update, in addition to the main thread
+    update_threads_node = root->getNode("update-threads", true);
+    if (!update_threads_node->hasValue())
+        update_threads_node->setIntValue(3);
     
     globals->get_commands()->addCommand("load-scenario", this, &FGAIManager::loadScenarioCommand);
     globals->get_commands()->addCommand("unload-scenario", this, &FGAIManager::unloadScenarioCommand);
@@ -173,8 +178,10 @@ FGAIManager::update(double dt) {
     range_nearest = 10000.0;
     strength = 0.0;
 
-    if (!enabled->getBoolValue())
+    if (!enabled->getBoolValue()) {
+        spatial_index.clear();
         return;
+    }
 
     fetchUserState();
 
@@ -182,23 +189,53 @@ FGAIManager::update(double dt) {
     ai_list_iterator firstAlive =
       std::stable_partition(ai_list.begin(), ai_list.end(), boost::mem_fn(&FGAIBase::getDie));
     
-    // clean up each item and finally remove from the container
+    // clean up each item and finally remove from the container, and from
+    // the index, which the updates below query (collisions of ballistic
+    // objects)
     for (ai_list_iterator it=ai_list.begin(); it != firstAlive; ++it) {
         removeDeadItem(*it);
+        spatial_index.remove(*it);
     }
   
     ai_list.erase(ai_list.begin(), firstAlive);
   
-    // every remaining item is alive
+    // every remaining item is alive. Objects which support it are updated
+    // in three phases: the main-thread parts before and after, and the
+    // integration in between spread across the worker threads.
+    parallel_list.clear();
     BOOST_FOREACH(FGAIBase* base, ai_list) {
         if (base->isa(FGAIBase::otThermal)) {
             processThermal(dt, (FGAIThermal*)base);
+        } else if (base->parallelUpdate()) {
+            base->prepareUpdate(dt);
+            parallel_list.push_back(base);
         } else {
             base->update(dt);
         }
     } // of live AI objects iteration
 
+    update_scheduler.setThreadCount(std::max(0, update_threads_node->getIntValue()));
+    update_scheduler.run(parallel_list, dt);
+
+    BOOST_FOREACH(FGAIBase* base, parallel_list) {
+        base->commitUpdate(dt);
+    }
+    parallel_list.clear();
+
     thermal_lift_node->setDoubleValue( strength );  // for thermals
+
+    // index the new positions, for the queries until the next update
+    rebuildSpatialIndex();
+}
+
+void
+FGAIManager::rebuildSpatialIndex()
+{
+    spatial_index.clear();
+    BOOST_FOREACH(FGAIBase* base, ai_list) {
+        spatial_index.insert(base, base->getCartPos());
+    }
+    spatial_index.finalize();
 }
 
 /** update LOD settings of all AI/MP models */
@@ -241,6 +278,20 @@ FGAIManager::attach(FGAIBase *model)
     p->setBoolValue("valid", true);
 }
 
+void
+FGAIManager::findInRange(const SGVec3d& cartPos, double rangeM,
+                         FGAIBaseVec& result) const
+{
+    spatial_index.findInRange(cartPos, rangeM, result);
+}
+
+void
+FGAIManager::findNearest(const SGVec3d& cartPos, unsigned int count,
+                         double maxRangeM, FGAIBaseVec& result) const
+{
+    spatial_index.findNearest(cartPos, count, maxRangeM, result);
+}
+
 int
 FGAIManager::getNumAiObjects(void) const
 {
@@ -428,55 +479,46 @@ const FGAIBase *
 FGAIManager::calcCollision(double alt, double lat, double lon, double fuse_range)
 {
     // we specify tgt extent (ft) according to the AIObject type
-    double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
-    double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
-    ai_list_iterator ai_list_itr = ai_list.begin();
-    ai_list_iterator end = ai_list.end();
+    const double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
+    const double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
+    const size_t num_types = sizeof(tgt_length) / sizeof(tgt_length[0]);
 
     SGGeod pos(SGGeod::fromDegFt(lon, lat, alt));
     SGVec3d cartPos(SGVec3d::fromGeod(pos));
-    
-    while (ai_list_itr != end) {
-        double tgt_alt = (*ai_list_itr)->_getAltitude();
-        int type       = (*ai_list_itr)->getType();
-        tgt_ht[type] += fuse_range;
 
-        if (fabs(tgt_alt - alt) > tgt_ht[type] || type == FGAIBase::otBallistic
+    // Only objects within the largest target extent can be hit. The index
+    // holds the positions of the last frame, so allow for some movement
+    // since then; the exact test below uses the current positions.
+    double max_length = *std::max_element(tgt_length, tgt_length + num_types);
+    double query_range = (max_length + fuse_range) * SG_FEET_TO_METER + 1000.0;
+    FGAIBaseVec candidates;
+    spatial_index.findInRange(cartPos, query_range, candidates);
+
+    BOOST_FOREACH(FGAIBase* object, candidates) {
+        double tgt_alt = object->_getAltitude();
+        int type       = object->getType();
+        if (type < 0 || (size_t) type >= num_types)
+            continue;
+
+        if (fabs(tgt_alt - alt) > tgt_ht[type] + fuse_range
+            || type == FGAIBase::otBallistic
             || type == FGAIBase::otStorm || type == FGAIBase::otThermal ) {
-                //SG_LOG(SG_AI, SG_DEBUG, "AIManager: skipping "
-                //    << fabs(tgt_alt - alt)
-                //    << " "
-                //    << type
-                //    );
-                ++ai_list_itr;
                 continue;
         }
 
-        int id         = (*ai_list_itr)->getID();
-
-        double range = calcRange(cartPos, (*ai_list_itr));
-
-        //SG_LOG(SG_AI, SG_DEBUG, "AIManager:  AI list size "
-        //    << ai_list.size()
-        //    << " type " << type
-        //    << " ID " << id
-        //    << " range " << range
-        //    //<< " bearing " << bearing
-        //    << " alt " << tgt_alt
-        //    );
+        int id         = object->getID();
 
-        tgt_length[type] += fuse_range;
+        double range = calcRange(cartPos, object);
 
-        if (range < tgt_length[type]){
+        if (range < tgt_length[type] + fuse_range){
             SG_LOG(SG_AI, SG_DEBUG, "AIManager: HIT! "
                 << " type " << type
                 << " ID " << id
                 << " range " << range
                 << " alt " << tgt_alt
                 );
-            return (*ai_list_itr).get();
+            return object;
         }
-        ++ai_list_itr;
     }
     return 0;
 }
@@ -34,6 +34,8 @@
 
 #include <AIModel/AIBase.hxx>
 #include <AIModel/AIFlightPlan.hxx>
+#include <AIModel/AISpatialIndex.hxx>
+#include <AIModel/AIUpdateScheduler.hxx>
 
 #include <Traffic/SchedFlight.hxx>
 #include <Traffic/Schedule.hxx>
@@ -70,6 +72,17 @@ public:
 
     const FGAIBase *calcCollision(double alt, double lat, double lon, double fuse_range);
 
+    /**
+     * Spatial queries over the live AI objects, nearest first. These are
+     * answered from an index which is rebuilt at the end of each update,
+     * so they see the positions of the last frame; the pointers are valid
+     * until the next update.
+     */
+    void findInRange(const SGVec3d& cartPos, double rangeM,
+                     FGAIBaseVec& result) const;
+    void findNearest(const SGVec3d& cartPos, unsigned int count,
+                     double maxRangeM, FGAIBaseVec& result) const;
+
     inline double get_user_heading() const { return user_heading; }
     inline double get_user_pitch() const { return user_pitch; }
     inline double get_user_yaw() const { return user_yaw; }
@@ -110,9 +123,13 @@ private:
     SGPropertyNode_ptr user_speed_node;
     SGPropertyNode_ptr wind_from_east_node;
     SGPropertyNode_ptr wind_from_north_node;
+    SGPropertyNode_ptr update_threads_node;
 
 
     ai_list_type ai_list;
+    FGAISpatialIndex spatial_index;
+    FGAIUpdateScheduler update_scheduler;
+    FGAIBaseVec parallel_list; // objects in the current parallel update
     
     double user_altitude_agl;
     double user_heading;
@@ -130,6 +147,7 @@ private:
     double range_nearest;
     double strength;
     void processThermal( double dt, FGAIThermal* thermal );
+    void rebuildSpatialIndex();
 
     SGPropertyChangeCallback<FGAIManager> cb_ai_bare;
     SGPropertyChangeCallback<FGAIManager> cb_ai_detailed;
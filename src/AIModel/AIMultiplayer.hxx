@@ -23,6 +23,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <MultiPlayer/mpmessages.hxx>
 #include "AIBase.hxx"
@@ -65,9 +66,22 @@ public:
 
 private:
 
-  // Automatic sorting of motion data according to its timestamp
-  typedef std::map<double,FGExternalMotionData> MotionInfo;
-  MotionInfo mMotionInfo;
+  // The received motion data, sorted by time, in a ring of fixed capacity.
+  // The entries are assigned in place, so that their property vectors keep
+  // their storage from one packet to the next.
+  enum { MotionInfoCapacity = 64 };
+  std::vector<FGExternalMotionData> mMotionInfo;
+  unsigned mMotionInfoBegin; // index of the oldest entry
+  unsigned mMotionInfoSize;
+
+  FGExternalMotionData& motionInfoAt(unsigned i)
+  { return mMotionInfo[(mMotionInfoBegin + i) % MotionInfoCapacity]; }
+  unsigned motionInfoUpperBound(double time);
+  void popMotionInfo(unsigned count)
+  {
+    mMotionInfoBegin = (mMotionInfoBegin + count) % MotionInfoCapacity;
+    mMotionInfoSize -= count;
+  }
 
   // Map between the property id's from the multiplayers network packets
   // and the property nodes
@@ -0,0 +1,182 @@
+// AISpatialIndex.cxx - a uniform grid over the live AI objects, for range
+// and nearest neighbour queries without scanning every object.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AISpatialIndex.hxx"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// edge length of the grid cells in meters. Roughly the size of the
+// smaller queries (collisions, TCAS), larger ones visit more columns.
+const double CELL_SIZE = 10000.0;
+
+// cell coordinates are biased into 21 bits each, which is plenty for
+// anything within a few earth radii of the center.
+const int CELL_BIAS = 1 << 20;
+const int CELL_MAX = (1 << 21) - 1;
+
+bool hitLess(const std::pair<double, FGAIBase*>& a,
+             const std::pair<double, FGAIBase*>& b)
+{
+    return a.first < b.first;
+}
+
+} // of anonymous namespace
+
+FGAISpatialIndex::FGAISpatialIndex()
+{
+}
+
+void FGAISpatialIndex::clear()
+{
+    _entries.clear();
+}
+
+void FGAISpatialIndex::insert(FGAIBase* object, const SGVec3d& cartPos)
+{
+    Entry e;
+    e.key = cellKey(cellCoord(cartPos.x()), cellCoord(cartPos.y()),
+                    cellCoord(cartPos.z()));
+    e.cartPos = cartPos;
+    e.object = object;
+    _entries.push_back(e);
+}
+
+void FGAISpatialIndex::finalize()
+{
+    std::sort(_entries.begin(), _entries.end());
+}
+
+void FGAISpatialIndex::remove(FGAIBase* object)
+{
+    std::vector<Entry>::iterator it;
+    for (it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->object == object) {
+            _entries.erase(it);
+            return;
+        }
+    }
+}
+
+int FGAISpatialIndex::cellCoord(double v)
+{
+    double c = floor(v / CELL_SIZE) + CELL_BIAS;
+    if (!(c >= 0)) // also catches NaN positions
+        return 0;
+    if (c > CELL_MAX)
+        return CELL_MAX;
+    return (int) c;
+}
+
+uint64_t FGAISpatialIndex::cellKey(int x, int y, int z)
+{
+    return ((uint64_t) x << 42) | ((uint64_t) y << 21) | (uint64_t) z;
+}
+
+void FGAISpatialIndex::collect(const SGVec3d& cartPos, double rangeM,
+                               HitVec& hits) const
+{
+    if (!(rangeM >= 0)) {
+        return;
+    }
+
+    double rangeSqr = rangeM * rangeM;
+    int lo[3], hi[3];
+    for (int i = 0; i < 3; ++i) {
+        lo[i] = cellCoord(cartPos[i] - rangeM);
+        hi[i] = cellCoord(cartPos[i] + rangeM);
+    }
+
+    // a large query over few objects is quicker as a plain scan
+    size_t columns = (size_t) (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1);
+    if (columns >= _entries.size()) {
+        std::vector<Entry>::const_iterator it;
+        for (it = _entries.begin(); it != _entries.end(); ++it) {
+            double d = distSqr(cartPos, it->cartPos);
+            if (d <= rangeSqr) {
+                hits.push_back(Hit(d, it->object));
+            }
+        }
+        return;
+    }
+
+    Entry probe;
+    for (int x = lo[0]; x <= hi[0]; ++x) {
+        for (int y = lo[1]; y <= hi[1]; ++y) {
+            probe.key = cellKey(x, y, lo[2]);
+            uint64_t lastKey = cellKey(x, y, hi[2]);
+            std::vector<Entry>::const_iterator it =
+                std::lower_bound(_entries.begin(), _entries.end(), probe);
+            for (; (it != _entries.end()) && (it->key <= lastKey); ++it) {
+                double d = distSqr(cartPos, it->cartPos);
+                if (d <= rangeSqr) {
+                    hits.push_back(Hit(d, it->object));
+                }
+            }
+        } // of y iteration
+    } // of x iteration
+}
+
+void FGAISpatialIndex::findInRange(const SGVec3d& cartPos, double rangeM,
+                                   FGAIBaseVec& result) const
+{
+    result.clear();
+    HitVec hits;
+    collect(cartPos, rangeM, hits);
+    std::sort(hits.begin(), hits.end(), hitLess);
+
+    result.reserve(hits.size());
+    for (HitVec::const_iterator it = hits.begin(); it != hits.end(); ++it) {
+        result.push_back(it->second);
+    }
+}
+
+void FGAISpatialIndex::findNearest(const SGVec3d& cartPos, unsigned int count,
+                                   double maxRangeM, FGAIBaseVec& result) const
+{
+    result.clear();
+    if (count == 0) {
+        return;
+    }
+
+    // grow the search radius until it holds enough objects; everything
+    // nearer than the count-th hit is then guaranteed to be inside it.
+    HitVec hits;
+    double range = std::min(CELL_SIZE, maxRangeM);
+    while (true) {
+        hits.clear();
+        collect(cartPos, range, hits);
+        if ((hits.size() >= count) || (range >= maxRangeM)) {
+            break;
+        }
+        range = std::min(range * 2.0, maxRangeM);
+    }
+
+    size_t n = std::min(hits.size(), (size_t) count);
+    std::partial_sort(hits.begin(), hits.begin() + n, hits.end(), hitLess);
+
+    result.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        result.push_back(hits[i].second);
+    }
+}
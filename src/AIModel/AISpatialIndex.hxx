@@ -0,0 +1,86 @@
+// AISpatialIndex.hxx - a uniform grid over the live AI objects, for range
+// and nearest neighbour queries without scanning every object.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AISPATIALINDEX_HXX
+#define _FG_AISPATIALINDEX_HXX
+
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <simgear/math/SGMath.hxx>
+
+class FGAIBase;
+
+typedef std::vector<FGAIBase*> FGAIBaseVec;
+
+/**
+ * Live AI objects, bucketed by their cartesian position into cubic cells.
+ * The entries are kept sorted by cell, so all cells of one grid column
+ * are a contiguous range found by a binary search.
+ *
+ * The index is a snapshot: FGAIManager rebuilds it once per update, and
+ * the object pointers stay valid until the next rebuild.
+ */
+class FGAISpatialIndex
+{
+public:
+    FGAISpatialIndex();
+
+    void clear();
+    void insert(FGAIBase* object, const SGVec3d& cartPos);
+    /// sort the inserted objects; must be called before any query
+    void finalize();
+
+    /// drop an object about to be destroyed; the rest stays sorted
+    void remove(FGAIBase* object);
+
+    /// all objects within rangeM of cartPos, nearest first
+    void findInRange(const SGVec3d& cartPos, double rangeM,
+                     FGAIBaseVec& result) const;
+
+    /// the count objects nearest to cartPos, but not further away than
+    /// maxRangeM, nearest first
+    void findNearest(const SGVec3d& cartPos, unsigned int count,
+                     double maxRangeM, FGAIBaseVec& result) const;
+
+    size_t size() const
+    { return _entries.size(); }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        SGVec3d cartPos;
+        FGAIBase* object;
+
+        bool operator<(const Entry& other) const
+        { return key < other.key; }
+    };
+
+    typedef std::pair<double, FGAIBase*> Hit; // squared distance, object
+    typedef std::vector<Hit> HitVec;
+
+    static int cellCoord(double v);
+    static uint64_t cellKey(int x, int y, int z);
+
+    void collect(const SGVec3d& cartPos, double rangeM, HitVec& hits) const;
+
+    std::vector<Entry> _entries;
+};
+
+#endif // _FG_AISPATIALINDEX_HXX
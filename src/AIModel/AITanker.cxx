@@ -78,8 +78,8 @@ void FGAITanker::Run(double dt) {
 }
 
 
-void FGAITanker::update(double dt) {
-     FGAIAircraft::update(dt);
+void FGAITanker::commitUpdate(double dt) {
+     FGAIAircraft::commitUpdate(dt);
      Run(dt);
      Transform();
 }
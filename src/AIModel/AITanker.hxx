@@ -51,7 +51,7 @@ private:
     bool contact;                // set if this tanker is within fuelling range
 
     virtual void Run(double dt);
-    virtual void update (double dt);
+    virtual void commitUpdate(double dt);
 };
 
 #endif
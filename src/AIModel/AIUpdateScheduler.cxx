@@ -0,0 +1,160 @@
+// AIUpdateScheduler.cxx - runs the compute phase of the AI update on a
+// small pool of worker threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AIUpdateScheduler.hxx"
+
+#include <algorithm>
+
+#include <simgear/threads/SGGuard.hxx>
+
+#include "AIBase.hxx"
+
+namespace {
+
+// objects handed to a thread at a time. Small enough to balance the load,
+// large enough that the lock is not taken per object.
+const size_t CHUNK_SIZE = 16;
+
+} // of anonymous namespace
+
+class FGAIUpdateScheduler::Worker : public SGThread
+{
+public:
+    Worker(FGAIUpdateScheduler* scheduler) :
+        _scheduler(scheduler)
+    {
+    }
+
+protected:
+    virtual void run()
+    {
+        _scheduler->workerLoop();
+    }
+
+private:
+    FGAIUpdateScheduler* _scheduler;
+};
+
+FGAIUpdateScheduler::FGAIUpdateScheduler() :
+    _objects(NULL),
+    _dt(0.0),
+    _next(0),
+    _busy(0),
+    _quit(false)
+{
+}
+
+FGAIUpdateScheduler::~FGAIUpdateScheduler()
+{
+    setThreadCount(0);
+}
+
+void FGAIUpdateScheduler::setThreadCount(unsigned int count)
+{
+    if (count == _workers.size()) {
+        return;
+    }
+
+    // simplest to restart the pool; this only happens when the setting
+    // changes, and never while a batch is running
+    if (!_workers.empty()) {
+        {
+            SGGuard<SGMutex> g(_lock);
+            _quit = true;
+            _workAvailable.broadcast();
+        }
+
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            _workers[i]->join();
+            delete _workers[i];
+        }
+        _workers.clear();
+        _quit = false;
+    }
+
+    for (unsigned int i = 0; i < count; ++i) {
+        Worker* w = new Worker(this);
+        w->start();
+        _workers.push_back(w);
+    }
+}
+
+void FGAIUpdateScheduler::run(const FGAIBaseVec& objects, double dt)
+{
+    // not worth waking anyone up for a single chunk
+    if (_workers.empty() || (objects.size() <= CHUNK_SIZE)) {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            objects[i]->computeUpdate(dt);
+        }
+        return;
+    }
+
+    SGGuard<SGMutex> g(_lock);
+    _objects = &objects;
+    _dt = dt;
+    _next = 0;
+    _workAvailable.broadcast();
+
+    // the calling thread works too, rather than just waiting
+    processChunks();
+    while (_busy > 0) {
+        _workDone.wait(_lock);
+    }
+
+    _objects = NULL;
+}
+
+void FGAIUpdateScheduler::workerLoop()
+{
+    SGGuard<SGMutex> g(_lock);
+    while (!_quit) {
+        if (_objects && (_next < _objects->size())) {
+            processChunks();
+        } else {
+            _workAvailable.wait(_lock);
+        }
+    }
+}
+
+// called with _lock held, and returns with it held; the lock is released
+// while the objects of each chunk are computed
+void FGAIUpdateScheduler::processChunks()
+{
+    while (_objects && (_next < _objects->size())) {
+        const FGAIBaseVec& objects = *_objects;
+        double dt = _dt;
+        size_t begin = _next;
+        size_t end = std::min(begin + CHUNK_SIZE, objects.size());
+        _next = end;
+        ++_busy;
+
+        _lock.unlock();
+        for (size_t i = begin; i < end; ++i) {
+            objects[i]->computeUpdate(dt);
+        }
+        _lock.lock();
+
+        --_busy;
+        if ((_busy == 0) && (_next >= objects.size())) {
+            _workDone.signal();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// AIUpdateScheduler.hxx - runs the compute phase of the AI update on a
+// small pool of worker threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AIUPDATESCHEDULER_HXX
+#define _FG_AIUPDATESCHEDULER_HXX
+
+#include <vector>
+
+#include <simgear/threads/SGThread.hxx>
+
+#include <AIModel/AISpatialIndex.hxx> // for FGAIBaseVec
+
+/**
+ * Calls FGAIBase::computeUpdate() on a set of objects, spread across
+ * persistent worker threads and the calling thread. The objects are
+ * handed out in small chunks, so a few expensive ones don't leave the
+ * other threads idle. run() returns once every object has been computed.
+ */
+class FGAIUpdateScheduler
+{
+public:
+    FGAIUpdateScheduler();
+    ~FGAIUpdateScheduler();
+
+    /**
+     * start or stop workers to have the given number of them. With no
+     * workers, run() computes everything on the calling thread.
+     */
+    void setThreadCount(unsigned int count);
+
+    unsigned int threadCount() const
+    { return _workers.size(); }
+
+    void run(const FGAIBaseVec& objects, double dt);
+
+private:
+    class Worker;
+
+    void workerLoop();
+    void processChunks();
+
+    SGMutex _lock;
+    SGWaitCondition _workAvailable;
+    SGWaitCondition _workDone;
+    std::vector<Worker*> _workers;
+
+    // the current batch, guarded by _lock
+    const FGAIBaseVec* _objects;
+    double _dt;
+    size_t _next;       // first object not yet handed out
+    unsigned int _busy; // chunks being computed right now
+    bool _quit;
+};
+
+#endif  // _FG_AIUPDATESCHEDULER_HXX
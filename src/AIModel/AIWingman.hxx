@@ -40,6 +40,9 @@ public:
     virtual void reinit();
     virtual void update (double dt);
 
+    // formation flying does not use the split ballistic update
+    virtual bool parallelUpdate() const { return false; }
+
     virtual const char* getTypeString(void) const { return "wingman"; }
 
 private:
@@ -308,6 +308,20 @@ FGFlightRecorder::processSignalList(const char* pSignalType, TSignalList& Signal
     }
 }
 
+/** Get the number of signals of each type, as laid out in a record. */
+FGReplayLayout
+FGFlightRecorder::getRecordLayout(void)
+{
+    FGReplayLayout Layout;
+    Layout.doubles = m_CaptureDouble.size();
+    Layout.floats  = m_CaptureFloat.size();
+    Layout.ints    = m_CaptureInteger.size();
+    Layout.int16s  = m_CaptureInt16.size();
+    Layout.int8s   = m_CaptureInt8.size();
+    Layout.bools   = m_CaptureBool.size();
+    return Layout;
+}
+
 /** Get an empty container for a single capture. */
 FGReplayData*
 FGFlightRecorder::createEmptyRecord(void)
@@ -62,6 +62,7 @@ public:
     void            deleteRecord        (FGReplayData* pRecord);
 
     int             getRecordSize       (void) { return m_TotalRecordSize;}
+    FGReplayLayout  getRecordLayout     (void);
     void            getConfig           (SGPropertyNode* root);
 
 private:
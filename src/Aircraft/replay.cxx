@@ -41,7 +41,6 @@
 #include "replay.hxx"
 #include "flightrecorder.hxx"
 
-using std::deque;
 using std::vector;
 using simgear::gzContainerReader;
 using simgear::gzContainerWriter;
@@ -85,7 +84,9 @@ FGReplay::FGReplay() :
     m_low_res_time(3600.0),
     m_medium_sample_rate(0.5), // medium term sample rate (sec)
     m_long_sample_rate(5.0),   // long term sample rate (sec)
-    m_pRecorder(new FGFlightRecorder("replay-config"))
+    m_pRecorder(new FGFlightRecorder("replay-config")),
+    m_pCurrentFrame(NULL),
+    m_pOldFrame(NULL)
 {
 }
 
@@ -97,6 +98,8 @@ FGReplay::~FGReplay()
 {
     clear();
 
+    m_pRecorder->deleteRecord(m_pCurrentFrame);
+    m_pRecorder->deleteRecord(m_pOldFrame);
     delete m_pRecorder;
     m_pRecorder = NULL;
 }
@@ -107,26 +110,9 @@ FGReplay::~FGReplay()
 void
 FGReplay::clear()
 {
-    while ( !short_term.empty() )
-    {
-        m_pRecorder->deleteRecord(short_term.front());
-        short_term.pop_front();
-    }
-    while ( !medium_term.empty() )
-    {
-        m_pRecorder->deleteRecord(medium_term.front());
-        medium_term.pop_front();
-    }
-    while ( !long_term.empty() )
-    {
-        m_pRecorder->deleteRecord(long_term.front());
-        long_term.pop_front();
-    }
-    while ( !recycler.empty() )
-    {
-        m_pRecorder->deleteRecord(recycler.front());
-        recycler.pop_front();
-    }
+    short_term.clear();
+    medium_term.clear();
+    long_term.clear();
 
     // clear messages belonging to old replay session
     fgGetNode("/sim/replay/messages", 0, true)->removeChildren("msg", false);
@@ -167,6 +153,7 @@ FGReplay::reinit()
     // Flush queues
     clear();
     m_pRecorder->reinit();
+    setLayout();
 
     m_high_res_time   = fgGetDouble("/sim/replay/buffer/high-res-time",    60.0);
     m_medium_res_time = fgGetDouble("/sim/replay/buffer/medium-res-time", 600.0); // 10 mins
@@ -175,7 +162,6 @@ FGReplay::reinit()
     m_medium_sample_rate = fgGetDouble("/sim/replay/buffer/medium-res-sample-dt", 0.5); // medium term sample rate (sec)
     m_long_sample_rate   = fgGetDouble("/sim/replay/buffer/low-res-sample-dt",    5.0); // long term sample rate (sec)
 
-    fillRecycler();
     loadMessages();
 
     replay_master->setIntValue(0);
@@ -203,23 +189,21 @@ FGReplay::unbind()
     // nothing to unbind
 }
 
+/**
+ * Adapt buffers to the current recorder configuration. Drops all data.
+ */
 void
-FGReplay::fillRecycler()
+FGReplay::setLayout()
 {
-    // Create an estimated nr of required ReplayData objects
-    // 120 is an estimated maximum frame rate.
-    int estNrObjects = (int) ((m_high_res_time*120) + (m_medium_res_time*m_medium_sample_rate) +
-                             (m_low_res_time*m_long_sample_rate));
-    for (int i = 0; i < estNrObjects; i++)
-    {
-        FGReplayData* r = m_pRecorder->createEmptyRecord();
-        if (r)
-            recycler.push_back(r);
-        else
-        {
-            SG_LOG(SG_SYSTEMS, SG_ALERT, "ReplaySystem: Out of memory!");
-        }
-    }
+    m_pRecorder->deleteRecord(m_pCurrentFrame);
+    m_pRecorder->deleteRecord(m_pOldFrame);
+    m_pCurrentFrame = m_pRecorder->createEmptyRecord();
+    m_pOldFrame     = m_pRecorder->createEmptyRecord();
+
+    FGReplayLayout Layout = m_pRecorder->getRecordLayout();
+    short_term.setLayout(Layout);
+    medium_term.setLayout(Layout);
+    long_term.setLayout(Layout);
 }
 
 static void
@@ -318,9 +302,8 @@ FGReplay::start(bool NewTape)
     printTimeStr(StrBuffer,EndTime,false);
     fgSetString("/sim/replay/end-time-str",   StrBuffer);
 
-    unsigned long buffer_elements =  short_term.size()+medium_term.size()+long_term.size();
-    fgSetDouble("/sim/replay/buffer-size-mbyte",
-                buffer_elements*m_pRecorder->getRecordSize() / (1024*1024.0));
+    size_t buffer_size = short_term.memoryUsage()+medium_term.memoryUsage()+long_term.memoryUsage();
+    fgSetDouble("/sim/replay/buffer-size-mbyte", buffer_size / (1024*1024.0));
     if ((fgGetBool("/sim/freeze/master"))||
         (0 == replay_master->getIntValue()))
         guiMessage("Replay active. 'Esc' to stop.");
@@ -497,19 +480,13 @@ FGReplay::update( double dt )
 
     // update the short term list
     short_term.push_back( r );
-    FGReplayData *st_front = short_term.front();
-    
-    if (!st_front)
-    {
-        SG_LOG(SG_SYSTEMS, SG_ALERT, "ReplaySystem: Inconsistent data!");
-    }
+    double st_front_time = short_term.frontTime();
 
-    if ( sim_time - st_front->sim_time > m_high_res_time )
+    if ( sim_time - st_front_time > m_high_res_time )
     {
-        while ( sim_time - st_front->sim_time > m_high_res_time )
+        while ( sim_time - st_front_time > m_high_res_time )
         {
-            st_front = short_term.front();
-            recycler.push_back(st_front);
+            st_front_time = short_term.frontTime();
             short_term.pop_front();
         }
 
@@ -517,34 +494,32 @@ FGReplay::update( double dt )
         if ( sim_time - last_mt_time > m_medium_sample_rate )
         {
             last_mt_time = sim_time;
-            st_front = short_term.front();
-            medium_term.push_back( st_front );
+            short_term.front(m_pCurrentFrame);
+            medium_term.push_back( m_pCurrentFrame );
             short_term.pop_front();
 
-            FGReplayData *mt_front = medium_term.front();
-            if ( sim_time - mt_front->sim_time > m_medium_res_time )
+            double mt_front_time = medium_term.frontTime();
+            if ( sim_time - mt_front_time > m_medium_res_time )
             {
-                while ( sim_time - mt_front->sim_time > m_medium_res_time )
+                while ( sim_time - mt_front_time > m_medium_res_time )
                 {
-                    mt_front = medium_term.front();
-                    recycler.push_back(mt_front);
+                    mt_front_time = medium_term.frontTime();
                     medium_term.pop_front();
                 }
                 // update the long term list
                 if ( sim_time - last_lt_time > m_long_sample_rate )
                 {
                     last_lt_time = sim_time;
-                    mt_front = medium_term.front();
-                    long_term.push_back( mt_front );
+                    medium_term.front(m_pCurrentFrame);
+                    long_term.push_back( m_pCurrentFrame );
                     medium_term.pop_front();
 
-                    FGReplayData *lt_front = long_term.front();
-                    if ( sim_time - lt_front->sim_time > m_low_res_time )
+                    double lt_front_time = long_term.frontTime();
+                    if ( sim_time - lt_front_time > m_low_res_time )
                     {
-                        while ( sim_time - lt_front->sim_time > m_low_res_time )
+                        while ( sim_time - lt_front_time > m_low_res_time )
                         {
-                            lt_front = long_term.front();
-                            recycler.push_back(lt_front);
+                            lt_front_time = long_term.frontTime();
                             long_term.pop_front();
                         }
                     }
@@ -555,13 +530,13 @@ FGReplay::update( double dt )
 
 #if 0
     cout << "short term size = " << short_term.size()
-         << "  time = " << sim_time - short_term.front().sim_time
+         << "  time = " << sim_time - short_term.frontTime()
          << endl;
     cout << "medium term size = " << medium_term.size()
-         << "  time = " << sim_time - medium_term.front().sim_time
+         << "  time = " << sim_time - medium_term.frontTime()
          << endl;
     cout << "long term size = " << long_term.size()
-         << "  time = " << sim_time - long_term.front().sim_time
+         << "  time = " << sim_time - long_term.frontTime()
          << endl;
 #endif
    //stamp("point_finished");
@@ -570,22 +545,17 @@ FGReplay::update( double dt )
 FGReplayData*
 FGReplay::record(double time)
 {
-    FGReplayData* r = NULL;
-
-    if (recycler.size())
-    {
-        r = recycler.front();
-        recycler.pop_front();
-    }
+    if (!m_pCurrentFrame)
+        return NULL;
 
-    return m_pRecorder->capture(time, r);
+    return m_pRecorder->capture(time, m_pCurrentFrame);
 }
 
 /** 
  * interpolate a specific time from a specific list
  */
 void
-FGReplay::interpolate( double time, const replay_list_type &list)
+FGReplay::interpolate( double time, replay_list_type &list)
 {
     // sanity checking
     if ( list.size() == 0 )
@@ -595,7 +565,8 @@ FGReplay::interpolate( double time, const replay_list_type &list)
     } else if ( list.size() == 1 )
     {
         // handle list size == 1
-        replay(time, list[0]);
+        list.get(0, m_pCurrentFrame);
+        replay(time, m_pCurrentFrame);
         return;
     }
 
@@ -609,11 +580,11 @@ FGReplay::interpolate( double time, const replay_list_type &list)
         // cout << "  " << first << " <=> " << last << endl;
         if ( last == first ) {
             done = true;
-        } else if ( list[mid]->sim_time < time && list[mid+1]->sim_time < time ) {
+        } else if ( list.time(mid) < time && list.time(mid+1) < time ) {
             // too low
             first = mid;
             mid = ( last + first ) / 2;
-        } else if ( list[mid]->sim_time > time && list[mid+1]->sim_time > time ) {
+        } else if ( list.time(mid) > time && list.time(mid+1) > time ) {
             // too high
             last = mid;
             mid = ( last + first ) / 2;
@@ -622,7 +593,10 @@ FGReplay::interpolate( double time, const replay_list_type &list)
         }
     }
 
-    replay(time, list[mid+1], list[mid]);
+    // only the two frames around the given time are decoded
+    list.get(mid, m_pOldFrame);
+    list.get(mid+1, m_pCurrentFrame);
+    replay(time, m_pCurrentFrame, m_pOldFrame);
 }
 
 /** 
@@ -640,50 +614,58 @@ FGReplay::replay( double time ) {
     replayMessage(time);
 
     if ( short_term.size() > 0 ) {
-        t1 = short_term.back()->sim_time;
-        t2 = short_term.front()->sim_time;
+        t1 = short_term.backTime();
+        t2 = short_term.frontTime();
         if ( time > t1 ) {
             // replay the most recent frame
-            replay( time, short_term.back() );
+            short_term.back(m_pCurrentFrame);
+            replay( time, m_pCurrentFrame );
             // replay is finished now
             return true;
         } else if ( time <= t1 && time >= t2 ) {
             interpolate( time, short_term );
         } else if ( medium_term.size() > 0 ) {
-            t1 = short_term.front()->sim_time;
-            t2 = medium_term.back()->sim_time;
+            t1 = short_term.frontTime();
+            t2 = medium_term.backTime();
             if ( time <= t1 && time >= t2 )
             {
-                replay(time, medium_term.back(), short_term.front());
+                medium_term.back(m_pCurrentFrame);
+                short_term.front(m_pOldFrame);
+                replay(time, m_pCurrentFrame, m_pOldFrame);
             } else {
-                t1 = medium_term.back()->sim_time;
-                t2 = medium_term.front()->sim_time;
+                t1 = medium_term.backTime();
+                t2 = medium_term.frontTime();
                 if ( time <= t1 && time >= t2 ) {
                     interpolate( time, medium_term );
                 } else if ( long_term.size() > 0 ) {
-                    t1 = medium_term.front()->sim_time;
-                    t2 = long_term.back()->sim_time;
+                    t1 = medium_term.frontTime();
+                    t2 = long_term.backTime();
                     if ( time <= t1 && time >= t2 )
                     {
-                        replay(time, long_term.back(), medium_term.front());
+                        long_term.back(m_pCurrentFrame);
+                        medium_term.front(m_pOldFrame);
+                        replay(time, m_pCurrentFrame, m_pOldFrame);
                     } else {
-                        t1 = long_term.back()->sim_time;
-                        t2 = long_term.front()->sim_time;
+                        t1 = long_term.backTime();
+                        t2 = long_term.frontTime();
                         if ( time <= t1 && time >= t2 ) {
                             interpolate( time, long_term );
                         } else {
                             // replay the oldest long term frame
-                            replay(time, long_term.front());
+                            long_term.front(m_pCurrentFrame);
+                            replay(time, m_pCurrentFrame);
                         }
                     }
                 } else {
                     // replay the oldest medium term frame
-                    replay(time, medium_term.front());
+                    medium_term.front(m_pCurrentFrame);
+                    replay(time, m_pCurrentFrame);
                 }
             }
         } else {
             // replay the oldest short term frame
-            replay(time, short_term.front());
+            short_term.front(m_pCurrentFrame);
+            replay(time, m_pCurrentFrame);
         }
     } else {
         // nothing to replay
@@ -706,13 +688,13 @@ FGReplay::get_start_time()
 {
     if ( long_term.size() > 0 )
     {
-        return long_term.front()->sim_time;
+        return long_term.frontTime();
     } else if ( medium_term.size() > 0 )
     {
-        return medium_term.front()->sim_time;
+        return medium_term.frontTime();
     } else if ( short_term.size() )
     {
-        return short_term.front()->sim_time;
+        return short_term.frontTime();
     } else
     {
         return 0.0;
@@ -724,7 +706,7 @@ FGReplay::get_end_time()
 {
     if ( short_term.size() )
     {
-        return short_term.back()->sim_time;
+        return short_term.backTime();
     } else
     {
         return 0.0;
@@ -733,7 +715,7 @@ FGReplay::get_end_time()
 
 /** Save raw replay data in a separate container */
 static bool
-saveRawReplayData(gzContainerWriter& output, const replay_list_type& ReplayData, size_t RecordSize)
+saveRawReplayData(gzContainerWriter& output, replay_list_type& ReplayData, FGReplayData* pBuffer, size_t RecordSize)
 {
     // get number of records in this stream
     size_t Count = ReplayData.size();
@@ -746,13 +728,12 @@ saveRawReplayData(gzContainerWriter& output, const replay_list_type& ReplayData,
     }
 
     // write the raw data (all records in the given list)
-    replay_list_type::const_iterator it = ReplayData.begin();
     size_t CheckCount = 0;
-    while ((it != ReplayData.end())&&
+    while ((CheckCount < Count)&&
            !output.fail())
     {
-        const FGReplayData* pRecord = *it++;
-        output.write((char*)pRecord, RecordSize);
+        ReplayData.get(CheckCount, pBuffer);
+        output.write((char*)pBuffer, RecordSize);
         CheckCount++;
     }
 
@@ -769,7 +750,7 @@ saveRawReplayData(gzContainerWriter& output, const replay_list_type& ReplayData,
 
 /** Load raw replay data from a separate container */
 static bool
-loadRawReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_list_type& ReplayData, size_t RecordSize)
+loadRawReplayData(gzContainerReader& input, replay_list_type& ReplayData, FGReplayData* pBuffer, size_t RecordSize)
 {
     size_t Size = 0;
     simgear::ContainerType Type = ReplayContainer::Invalid;
@@ -795,7 +776,6 @@ loadRawReplayData(gzContainerReader& input, FGFlightRecorder* pRecorder, replay_
     size_t CheckCount = 0;
     for (CheckCount=0; (CheckCount<Count)&&(!input.eof()); ++CheckCount)
     {
-        FGReplayData* pBuffer = pRecorder->createEmptyRecord();
         input.read((char*) pBuffer, RecordSize);
         ReplayData.push_back(pBuffer);
     }
@@ -848,11 +828,11 @@ FGReplay::saveTape(const char* Filename, SGPropertyNode* MetaDataProps)
         SG_LOG(SG_SYSTEMS, MY_SG_DEBUG, "Total signal count: " <<  Config->getIntValue("recorder/signal-count", 0)
                << ", record size: " << RecordSize);
         if (ok)
-            ok &= saveRawReplayData(output, short_term,  RecordSize);
+            ok &= saveRawReplayData(output, short_term,  m_pCurrentFrame, RecordSize);
         if (ok)
-            ok &= saveRawReplayData(output, medium_term, RecordSize);
+            ok &= saveRawReplayData(output, medium_term, m_pCurrentFrame, RecordSize);
         if (ok)
-            ok &= saveRawReplayData(output, long_term,   RecordSize);
+            ok &= saveRawReplayData(output, long_term,   m_pCurrentFrame, RecordSize);
         Config = 0;
     }
 
@@ -1028,7 +1008,7 @@ FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
                 // reconfigure the recorder - and wipe old data (no longer matches the current recorder)
                 m_pRecorder->reinit(Config);
                 clear();
-                fillRecycler();
+                setLayout();
             }
         }
 
@@ -1053,11 +1033,11 @@ FGReplay::loadTape(const char* Filename, bool Preview, SGPropertyNode* UserData)
             }
 
             if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, short_term,  RecordSize);
+                ok &= loadRawReplayData(input, short_term,  m_pCurrentFrame, RecordSize);
             if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, medium_term, RecordSize);
+                ok &= loadRawReplayData(input, medium_term, m_pCurrentFrame, RecordSize);
             if (ok)
-                ok &= loadRawReplayData(input, m_pRecorder, long_term,   RecordSize);
+                ok &= loadRawReplayData(input, long_term,   m_pCurrentFrame, RecordSize);
 
             // restore replay messages
             if (ok)
@@ -34,16 +34,11 @@
 #include <simgear/props/props.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
 
-#include <deque>
 #include <vector>
 
-class FGFlightRecorder;
+#include "replaybuffer.hxx"
 
-typedef struct {
-    double sim_time;
-    char   raw_data;
-    /* more data here, hidden to the outside world */
-} FGReplayData;
+class FGFlightRecorder;
 
 typedef struct {
     double sim_time;
@@ -51,7 +46,7 @@ typedef struct {
     std::string speaker;
 } FGReplayMessages;
 
-typedef std::deque < FGReplayData *> replay_list_type;
+typedef FGReplayBuffer replay_list_type;
 typedef std::vector < FGReplayMessages > replay_messages_type;
 
 /**
@@ -78,11 +73,11 @@ public:
 private:
     void clear();
     FGReplayData* record(double time);
-    void interpolate(double time, const replay_list_type &list);
+    void interpolate(double time, replay_list_type &list);
     void replay(double time, FGReplayData* pCurrentFrame, FGReplayData* pOldFrame=NULL);
     void guiMessage(const char* message);
     void loadMessages();
-    void fillRecycler();
+    void setLayout();
 
     bool replay( double time );
     void replayMessage( double time );
@@ -105,7 +100,6 @@ private:
     replay_list_type short_term;
     replay_list_type medium_term;
     replay_list_type long_term;
-    replay_list_type recycler;
     replay_messages_type replay_messages;
 
     SGPropertyNode_ptr disable_replay;
@@ -123,6 +117,9 @@ private:
     double m_long_sample_rate;   // long term sample rate (sec)
 
     FGFlightRecorder* m_pRecorder;
+    // frames being recorded or decoded, as buffers are compressed
+    FGReplayData* m_pCurrentFrame;
+    FGReplayData* m_pOldFrame;
 };
 
 #endif // _FG_REPLAY_HXX
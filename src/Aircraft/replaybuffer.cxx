@@ -0,0 +1,423 @@
+// replaybuffer.cxx - compressed in-memory storage of flight recorder frames
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <assert.h>
+
+#include "replaybuffer.hxx"
+
+namespace
+{
+    /** Frames per chunk. Decoding a frame walks at most this many deltas. */
+    const size_t CHUNK_FRAMES = 128;
+
+    /** Tags of a bool column. */
+    enum { AllFalse = 0, AllTrue = 1, Packed = 2 };
+
+    inline uint64_t zigzag(uint64_t delta)
+    {
+        int64_t d = (int64_t) delta;
+        return ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);
+    }
+
+    inline uint64_t unzigzag(uint64_t v)
+    {
+        return (v >> 1) ^ (~(v & 1) + 1);
+    }
+
+    inline void putVarint(std::vector<unsigned char>& data, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            data.push_back((unsigned char) (v | 0x80));
+            v >>= 7;
+        }
+        data.push_back((unsigned char) v);
+    }
+
+    inline uint64_t getVarint(const unsigned char* data, size_t& pos)
+    {
+        uint64_t v = 0;
+        int shift = 0;
+        unsigned char b;
+        do
+        {
+            b = data[pos++];
+            v |= (uint64_t) (b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        return v;
+    }
+}
+
+FGReplayBuffer::FGReplayBuffer() :
+    _first(0),
+    _size(0)
+{
+    FGReplayLayout empty = {0, 0, 0, 0, 0, 0};
+    setLayout(empty);
+}
+
+FGReplayBuffer::~FGReplayBuffer()
+{
+    clear();
+}
+
+void
+FGReplayBuffer::setLayout(const FGReplayLayout& layout)
+{
+    clear();
+
+    // same order as FGFlightRecorder::capture
+    _columns.clear();
+    unsigned int Offset = sizeof(double); // sim time
+    Column c;
+    c.kind = Float64;
+    for (unsigned int i=0; i<layout.doubles; i++, Offset += sizeof(double))
+    {
+        c.offset = Offset;
+        _columns.push_back(c);
+    }
+    c.kind = Float32;
+    for (unsigned int i=0; i<layout.floats; i++, Offset += sizeof(float))
+    {
+        c.offset = Offset;
+        _columns.push_back(c);
+    }
+    c.kind = Int32;
+    for (unsigned int i=0; i<layout.ints; i++, Offset += sizeof(int))
+    {
+        c.offset = Offset;
+        _columns.push_back(c);
+    }
+    c.kind = Int16;
+    for (unsigned int i=0; i<layout.int16s; i++, Offset += sizeof(short int))
+    {
+        c.offset = Offset;
+        _columns.push_back(c);
+    }
+    c.kind = Int8;
+    for (unsigned int i=0; i<layout.int8s; i++, Offset += sizeof(signed char))
+    {
+        c.offset = Offset;
+        _columns.push_back(c);
+    }
+
+    _boolOffset = Offset;
+    _boolCount = layout.bools;
+    _recordSize = Offset + (_boolCount+7)/8;
+
+    _cursor.positions.resize(_columns.size());
+    _cursor.values.resize(_columns.size());
+    _cursor.previous.resize(_columns.size());
+}
+
+void
+FGReplayBuffer::clear()
+{
+    while (!_chunks.empty())
+    {
+        delete _chunks.front();
+        _chunks.pop_front();
+    }
+    _open.clear();
+    _first = 0;
+    _size = 0;
+    _cursor.chunk = NULL;
+    _cursor.frame = 0;
+}
+
+double
+FGReplayBuffer::time(size_t index) const
+{
+    assert(index < _size);
+    size_t j = index + _first;
+    size_t c = j / CHUNK_FRAMES;
+    if (c < _chunks.size())
+        return _chunks[c]->times[j % CHUNK_FRAMES];
+
+    double t;
+    memcpy(&t, &_open[(j - _chunks.size()*CHUNK_FRAMES) * _recordSize], sizeof(double));
+    return t;
+}
+
+void
+FGReplayBuffer::get(size_t index, FGReplayData* pFrame)
+{
+    assert(index < _size);
+    size_t j = index + _first;
+    size_t c = j / CHUNK_FRAMES;
+    size_t f = j % CHUNK_FRAMES;
+    if (c >= _chunks.size())
+    {
+        memcpy(pFrame, &_open[(j - _chunks.size()*CHUNK_FRAMES) * _recordSize], _recordSize);
+        return;
+    }
+
+    const Chunk* chunk = _chunks[c];
+    if ((_cursor.chunk == chunk)&&(_cursor.frame > 0)&&(_cursor.frame - 1 == f))
+    {
+        // the older of two neighbouring frames, typically when interpolating
+        unpack(chunk, f, _cursor.previous, pFrame);
+        return;
+    }
+
+    seek(chunk, f);
+    unpack(chunk, f, _cursor.values, pFrame);
+}
+
+void
+FGReplayBuffer::push_back(const FGReplayData* pFrame)
+{
+    _open.insert(_open.end(), (const char*) pFrame, (const char*) pFrame + _recordSize);
+    _size++;
+    if (_open.size() >= CHUNK_FRAMES * _recordSize)
+        seal();
+}
+
+void
+FGReplayBuffer::pop_front()
+{
+    assert(_size > 0);
+    _size--;
+    _first++;
+    if ((_first == CHUNK_FRAMES)&&(!_chunks.empty()))
+    {
+        if (_cursor.chunk == _chunks.front())
+            _cursor.chunk = NULL;
+        delete _chunks.front();
+        _chunks.pop_front();
+        _first = 0;
+    }
+    else
+    if ((_size == 0)&&(_chunks.empty()))
+    {
+        _open.clear();
+        _first = 0;
+    }
+}
+
+size_t
+FGReplayBuffer::memoryUsage() const
+{
+    size_t Size = _open.capacity();
+    for (size_t i=0; i<_chunks.size(); i++)
+    {
+        const Chunk* chunk = _chunks[i];
+        Size += sizeof(Chunk) +
+                chunk->times.capacity() * sizeof(double) +
+                chunk->columns.capacity() * sizeof(uint32_t) +
+                chunk->data.capacity();
+    }
+    return Size;
+}
+
+/** Compress the full raw chunk, column by column. */
+void
+FGReplayBuffer::seal()
+{
+    Chunk* chunk = new Chunk;
+    chunk->times.resize(CHUNK_FRAMES);
+    chunk->columns.reserve(_columns.size() + _boolCount);
+    for (size_t f=0; f<CHUNK_FRAMES; f++)
+        memcpy(&chunk->times[f], &_open[f * _recordSize], sizeof(double));
+
+    std::vector<unsigned char>& data = chunk->data;
+    data.reserve(CHUNK_FRAMES * (_columns.size() + _boolCount));
+    for (size_t i=0; i<_columns.size(); i++)
+    {
+        chunk->columns.push_back(data.size());
+        const Column& c = _columns[i];
+        uint64_t last = 0;
+        for (size_t f=0; f<CHUNK_FRAMES; f++)
+        {
+            uint64_t v = readValue(&_open[f * _recordSize + c.offset], c.kind);
+            putVarint(data, zigzag(v - last));
+            last = v;
+        }
+    }
+
+    unsigned char Bits[CHUNK_FRAMES/8];
+    for (unsigned int i=0; i<_boolCount; i++)
+    {
+        chunk->columns.push_back(data.size());
+        memset(Bits, 0, sizeof(Bits));
+        size_t Set = 0;
+        for (size_t f=0; f<CHUNK_FRAMES; f++)
+        {
+            unsigned char Flags = _open[f * _recordSize + _boolOffset + (i>>3)];
+            if (Flags & (1 << (i&7)))
+            {
+                Bits[f>>3] |= 1 << (f&7);
+                Set++;
+            }
+        }
+
+        if (Set == 0)
+            data.push_back(AllFalse);
+        else
+        if (Set == CHUNK_FRAMES)
+            data.push_back(AllTrue);
+        else
+        {
+            data.push_back(Packed);
+            data.insert(data.end(), Bits, Bits + sizeof(Bits));
+        }
+    }
+
+    // drop the slack of the estimate above
+    std::vector<unsigned char>(data).swap(data);
+
+    _chunks.push_back(chunk);
+    _open.clear();
+}
+
+/** Move the cursor to the given frame of a chunk. */
+void
+FGReplayBuffer::seek(const Chunk* chunk, size_t frame)
+{
+    if ((_cursor.chunk != chunk)||(frame < _cursor.frame))
+    {
+        // start over, at the first frame of the chunk
+        _cursor.chunk = chunk;
+        _cursor.frame = 0;
+        for (size_t i=0; i<_columns.size(); i++)
+        {
+            _cursor.positions[i] = chunk->columns[i];
+            _cursor.values[i] = getVarint(&chunk->data[0], _cursor.positions[i]);
+            _cursor.values[i] = unzigzag(_cursor.values[i]);
+        }
+    }
+
+    while (_cursor.frame < frame)
+    {
+        // only the values right before the target are worth keeping
+        if (_cursor.frame + 1 == frame)
+            _cursor.previous = _cursor.values;
+        step();
+    }
+}
+
+/** Advance the cursor by one frame. */
+void
+FGReplayBuffer::step()
+{
+    _cursor.frame++;
+    if (_columns.empty())
+        return;
+
+    const unsigned char* data = &_cursor.chunk->data[0];
+    for (size_t i=0; i<_columns.size(); i++)
+        _cursor.values[i] += unzigzag(getVarint(data, _cursor.positions[i]));
+}
+
+/** Build a raw frame from decoded values. */
+void
+FGReplayBuffer::unpack(const Chunk* chunk, size_t frame,
+                       const std::vector<uint64_t>& values, FGReplayData* pFrame) const
+{
+    char* pBuffer = (char*) pFrame;
+    memcpy(pBuffer, &chunk->times[frame], sizeof(double));
+    for (size_t i=0; i<_columns.size(); i++)
+        writeValue(&pBuffer[_columns[i].offset], _columns[i].kind, values[i]);
+
+    unsigned char* pFlags = (unsigned char*) &pBuffer[_boolOffset];
+    memset(pFlags, 0, (_boolCount+7)/8);
+    for (unsigned int i=0; i<_boolCount; i++)
+    {
+        const unsigned char* pColumn = &chunk->data[chunk->columns[_columns.size() + i]];
+        bool Value;
+        if (pColumn[0] == Packed)
+            Value = 0 != (pColumn[1 + (frame>>3)] & (1 << (frame&7)));
+        else
+            Value = (pColumn[0] == AllTrue);
+        if (Value)
+            pFlags[i>>3] |= 1 << (i&7);
+    }
+}
+
+/** Read a signal as an integer whose differences are small for small
+ * changes: the bit pattern for floating point values, which stays exact. */
+uint64_t
+FGReplayBuffer::readValue(const char* pRecord, Kind kind)
+{
+    switch (kind)
+    {
+        case Float64:
+        {
+            uint64_t v;
+            memcpy(&v, pRecord, sizeof(v));
+            return v;
+        }
+        case Float32:
+        {
+            uint32_t v;
+            memcpy(&v, pRecord, sizeof(v));
+            return v;
+        }
+        case Int32:
+        {
+            int v;
+            memcpy(&v, pRecord, sizeof(v));
+            return (uint64_t) (int64_t) v;
+        }
+        case Int16:
+        {
+            short int v;
+            memcpy(&v, pRecord, sizeof(v));
+            return (uint64_t) (int64_t) v;
+        }
+        case Int8:
+            return (uint64_t) (int64_t) (signed char) pRecord[0];
+    }
+    return 0;
+}
+
+void
+FGReplayBuffer::writeValue(char* pRecord, Kind kind, uint64_t value)
+{
+    switch (kind)
+    {
+        case Float64:
+            memcpy(pRecord, &value, sizeof(value));
+            break;
+        case Float32:
+        {
+            uint32_t v = (uint32_t) value;
+            memcpy(pRecord, &v, sizeof(v));
+            break;
+        }
+        case Int32:
+        {
+            int v = (int) (int64_t) value;
+            memcpy(pRecord, &v, sizeof(v));
+            break;
+        }
+        case Int16:
+        {
+            short int v = (short int) (int64_t) value;
+            memcpy(pRecord, &v, sizeof(v));
+            break;
+        }
+        case Int8:
+            pRecord[0] = (char) (signed char) (int64_t) value;
+            break;
+    }
+}
@@ -0,0 +1,134 @@
+// replaybuffer.hxx - compressed in-memory storage of flight recorder frames
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_REPLAYBUFFER_HXX
+#define _FG_REPLAYBUFFER_HXX 1
+
+#include <simgear/misc/stdint.hxx>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+typedef struct {
+    double sim_time;
+    char   raw_data;
+    /* more data here, hidden to the outside world */
+} FGReplayData;
+
+/** Number of signals of each type in a flight recorder frame. */
+typedef struct {
+    unsigned int doubles;
+    unsigned int floats;
+    unsigned int ints;
+    unsigned int int16s;
+    unsigned int int8s;
+    unsigned int bools;
+} FGReplayLayout;
+
+/**
+ * A FIFO of flight recorder frames, ordered by time.
+ *
+ * Frames are grouped into chunks of a fixed number of frames. The newest
+ * chunk is kept raw while it is filled; once full, it is stored column by
+ * column: each numeric signal as variable-length deltas to its previous
+ * value (of the bit pattern, for floating point, so nothing is lost), each
+ * bool signal as one bit per frame, or a single byte when constant.
+ * Signals which hardly change cost about a byte per frame, instead of the
+ * full value.
+ *
+ * Frames are addressed by index, 0 being the oldest. Decoding remembers
+ * its position, so reading two neighbouring frames, or moving forward a
+ * few frames, only decodes the deltas in between.
+ */
+class FGReplayBuffer
+{
+public:
+    FGReplayBuffer();
+    ~FGReplayBuffer();
+
+    /** Set the frame layout. Drops all frames. */
+    void setLayout(const FGReplayLayout& layout);
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    void clear();
+
+    double time(size_t index) const;
+    double frontTime() const { return time(0); }
+    double backTime() const { return time(_size - 1); }
+
+    /** Copy the given frame into pFrame, which must have the record size. */
+    void get(size_t index, FGReplayData* pFrame);
+    void front(FGReplayData* pFrame) { get(0, pFrame); }
+    void back(FGReplayData* pFrame) { get(_size - 1, pFrame); }
+
+    void push_back(const FGReplayData* pFrame);
+    void pop_front();
+
+    /** Bytes of memory used for the frames. */
+    size_t memoryUsage() const;
+
+private:
+    enum Kind { Float64, Float32, Int32, Int16, Int8 };
+
+    struct Column
+    {
+        unsigned int offset; ///< byte offset within a raw frame
+        Kind kind;
+    };
+
+    struct Chunk
+    {
+        std::vector<double> times;
+        /// start of each column within data: numeric columns, then bools
+        std::vector<uint32_t> columns;
+        std::vector<unsigned char> data;
+    };
+
+    /** Decoding state: the values of all numeric columns at one frame. */
+    struct Cursor
+    {
+        const Chunk* chunk;
+        size_t frame;
+        std::vector<size_t> positions;
+        std::vector<uint64_t> values;
+        std::vector<uint64_t> previous; ///< values at frame - 1
+    };
+
+    void seal();
+    void seek(const Chunk* chunk, size_t frame);
+    void step();
+    void unpack(const Chunk* chunk, size_t frame,
+                const std::vector<uint64_t>& values, FGReplayData* pFrame) const;
+
+    static uint64_t readValue(const char* pRecord, Kind kind);
+    static void writeValue(char* pRecord, Kind kind, uint64_t value);
+
+    std::vector<Column> _columns;
+    unsigned int _boolOffset;
+    unsigned int _boolCount;
+    size_t _recordSize;
+
+    std::deque<Chunk*> _chunks;
+    std::vector<char> _open;  ///< raw frames of the chunk being filled
+    size_t _first;            ///< frames already dropped from the oldest chunk
+    size_t _size;
+
+    Cursor _cursor;
+};
+
+#endif // _FG_REPLAYBUFFER_HXX
@@ -36,7 +36,6 @@
 
 #include <simgear/constants.h>
 #include <simgear/debug/logstream.hxx>
-#include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/strutils.hxx>
 #include <simgear/structure/exception.hxx>
 #include <simgear/misc/sg_path.hxx>
@@ -47,6 +46,7 @@
 #include "runways.hxx"
 #include "pavement.hxx"
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 #include <ATC/CommStation.hxx>
 
 #include <iostream>
@@ -84,70 +84,54 @@ public:
     cache = NavDataCache::instance();
   }
 
-  void parseAPT(const SGPath &aptdb_file)
+  void parseAPT(DatFileReader& reader)
   {
-    sg_gzifstream in( aptdb_file.str() );
-
-    if ( !in.is_open() ) {
-        SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << aptdb_file );
+    if ( !reader.isOpen() ) {
+        SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << reader.path() );
         exit(-1);
     }
 
-    string line;
-    char tmp[2049];
-    tmp[2048] = 0;
-    
     unsigned int line_id = 0;
-    unsigned int line_num = 0;
-
-    while ( ! in.eof() ) {
-      in.getline(tmp, 2048);
-      line = tmp; // string copy, ack
-      line_num++;
-
-      if ( line.empty() || isspace(tmp[0]) || tmp[0] == '#' ) {
-        continue;
+    bool expectVersion = false;
+
+    // lines have already been split into tokens by the reader thread; blank
+    // and comment lines have also been discarded.
+    for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+      const string& line(rec->line);
+      const vector<string>& token(rec->tokens);
+      if (isspace((unsigned char) line[0])) {
+        continue; // apt.dat ignores indented lines
       }
 
-      if (line.size() >= 3) {
-          char *p = (char *)memchr(tmp, ' ', 3);
-          if ( p )
-              *p = 0;
+      if (expectVersion) {
+        // the line following the IBM / Macintosh marker is the version and
+        // copyright information
+        expectVersion = false;
+        SG_LOG( SG_GENERAL, SG_INFO, "Data file version = " << token[0] );
+        continue;
       }
 
-      line_id = atoi(tmp);
-      if ( tmp[0] == 'I' || tmp[0] == 'A' ) {
+      line_id = atoi(token[0].c_str());
+      if ( line[0] == 'I' || line[0] == 'A' ) {
         // First line, indicates IBM ("I") or Macintosh ("A")
         // line endings.
-
-        // move past this line and read and discard the next line
-        // which is the version and copyright information
-        in.getline(tmp, 2048);
-
-        if ( strlen(tmp) > 5 ) {
-           char *p = (char *)memchr(tmp, ' ', 5);
-           if ( p )
-              *p = 0;
-        }
-        SG_LOG( SG_GENERAL, SG_INFO, "Data file version = " << tmp );
+        expectVersion = true;
       } else if ( line_id == 1 /* Airport */ ||
                     line_id == 16 /* Seaplane base */ ||
                     line_id == 17 /* Heliport */ ) {
-        parseAirportLine(simgear::strutils::split(line));
+        parseAirportLine(token);
       } else if ( line_id == 10 ) { // Runway v810
-        parseRunwayLine810(simgear::strutils::split(line));
+        parseRunwayLine810(token);
       } else if ( line_id == 100 ) { // Runway v850
-        parseRunwayLine850(simgear::strutils::split(line));
+        parseRunwayLine850(token);
       } else if ( line_id == 101 ) { // Water Runway v850
-        parseWaterRunwayLine850(simgear::strutils::split(line));
+        parseWaterRunwayLine850(token);
       } else if ( line_id == 102 ) { // Helipad v850
-        parseHelipadLine850(simgear::strutils::split(line));
+        parseHelipadLine850(token);
       } else if ( line_id == 18 ) {
             // beacon entry (ignore)
       } else if ( line_id == 14 ) {
         // control tower entry
-        vector<string> token(simgear::strutils::split(line));
-        
         double lat = atof( token[1].c_str() );
         double lon = atof( token[2].c_str() );
         double elev = atof( token[3].c_str() );
@@ -166,13 +150,13 @@ public:
       } else if ( line_id == 0 ) {
           // ??
       } else if ( line_id >= 50 && line_id <= 56) {
-        parseCommLine(line_id, simgear::strutils::split(line));
+        parseCommLine(line_id, token);
       } else if ( line_id == 110 ) {
         pavement = true;
         parsePavementLine850(simgear::strutils::split(line, 0, 4));
       } else if ( line_id >= 111 && line_id <= 114 ) {
         if ( pavement )
-          parsePavementNodeLine850(line_id, simgear::strutils::split(line));
+          parsePavementNodeLine850(line_id, token);
       } else if ( line_id >= 115 && line_id <= 116 ) {
           // other pavement nodes (ignore)
       } else if ( line_id == 120 ) {
@@ -185,7 +169,7 @@ public:
           SG_LOG( SG_GENERAL, SG_DEBUG, "End of file reached" );
       } else {
           SG_LOG( SG_GENERAL, SG_ALERT, 
-                  "Unknown line(#" << line_num << ") in apt.dat file: " << line );
+                  "Unknown line(#" << rec->lineNum << ") in apt.dat file: " << line );
           exit( -1 );
       }
     }
@@ -542,29 +526,39 @@ private:
 // metar file is used to mark the airports as having metar available
 // or not.
 bool airportDBLoad( const SGPath &aptdb_file )
+{
+  DatFileReader reader(aptdb_file);
+  return airportDBLoad(reader);
+}
+
+bool airportDBLoad(DatFileReader& reader)
 {
   APTLoader ld;
-  ld.parseAPT(aptdb_file);
+  ld.parseAPT(reader);
   return true;
 }
   
 bool metarDataLoad(const SGPath& metar_file)
 {
-  sg_gzifstream metar_in( metar_file.str() );
-  if ( !metar_in.is_open() ) {
-    SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << metar_file );
+  DatFileReader reader(metar_file);
+  return metarDataLoad(reader);
+}
+
+bool metarDataLoad(DatFileReader& reader)
+{
+  if ( !reader.isOpen() ) {
+    SG_LOG( SG_GENERAL, SG_ALERT, "Cannot open file: " << reader.path() );
     return false;
   }
   
   NavDataCache* cache = NavDataCache::instance();
-  string ident;
-  while ( metar_in ) {
-    metar_in >> ident;
-    if ( ident == "#" || ident == "//" ) {
-      metar_in >> skipeol;
-    } else {
-      cache->setAirportMetar(ident, true);
+  for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+    const string& ident(rec->tokens.front());
+    if ( ident == "//" ) {
+      continue;
     }
+
+    cache->setAirportMetar(ident, true);
   }
   
   return true;
@@ -31,6 +31,8 @@ class SGPath;
 
 namespace flightgear
 {
+
+class DatFileReader;
   
 // Load the airport data base from the specified aptdb file.  The
 // metar file is used to mark the airports as having metar available
@@ -38,8 +40,13 @@ namespace flightgear
 
 bool airportDBLoad(const SGPath& path);
 
+/// variant of the above, consuming records from an already running reader
+bool airportDBLoad(DatFileReader& reader);
+
 bool metarDataLoad(const SGPath& path);
 
+bool metarDataLoad(DatFileReader& reader);
+
 } // of namespace flighgear
 
 #endif // _FG_APT_LOADER_HXX
@@ -65,6 +65,7 @@ using std::string;
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
 #include "panel.hxx"
+#include <AIModel/AIManager.hxx>
 #include <Navaids/routePath.hxx>
 #include <Autopilot/route_mgr.hxx>
 #include <Navaids/navrecord.hxx>
@@ -1312,9 +1313,26 @@ static string mapAINodeToType(SGPropertyNode* model)
 
 void NavDisplay::processAI()
 {
-    SGPropertyNode *ai = fgGetNode("/ai/models", true);
-    for (int i = ai->nChildren() - 1; i >= 0; i--) {
-        SGPropertyNode *model = ai->getChild(i);
+    std::vector<SGPropertyNode*> models;
+    FGAIManager* aiManager =
+        static_cast<FGAIManager*>(globals->get_subsystem("ai-model"));
+    if (aiManager) {
+    // anything further than the display corners is clipped anyway. _pos is
+    // at sea level, so allow for the altitude of the models too.
+        double rangeM = (_odg->size() * sqrt(2.0) / _scale) * SG_NM_TO_METER + 30000;
+        FGAIBaseVec objects;
+        aiManager->findInRange(SGVec3d::fromGeod(_pos), rangeM, objects);
+        BOOST_FOREACH(FGAIBase* obj, objects) {
+            models.push_back(obj->_getProps());
+        }
+    } else {
+        SGPropertyNode *ai = fgGetNode("/ai/models", true);
+        for (int i = ai->nChildren() - 1; i >= 0; i--) {
+            models.push_back(ai->getChild(i));
+        }
+    }
+
+    BOOST_FOREACH(SGPropertyNode* model, models) {
         if (!model->nChildren()) {
             continue;
         }
@@ -1326,7 +1344,7 @@ void NavDisplay::processAI()
         SymbolRuleVector rules;
         findRules(mapAINodeToType(model), ss, rules);
         if (rules.empty()) {
-            return; // no rules matched, we can skip this item
+            continue; // no rules matched, we can skip this item
         }
 
         double heading = model->getDoubleValue("orientation/true-heading-deg");
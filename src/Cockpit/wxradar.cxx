@@ -56,6 +56,7 @@ using std::string;
 
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
+#include <AIModel/AIManager.hxx>
 
 #include "panel.hxx" // for FGTextureManager
 #include "od_gauge.hxx"
@@ -702,15 +703,16 @@ wxRadarBg::update_aircraft()
     int selected_id = fgGetInt("/instrumentation/radar/selected-id", -1);
 
     const SGPropertyNode *selected_ac = 0;
-    const SGPropertyNode *ai = fgGetNode("/ai/models", true);
+    std::vector<const SGPropertyNode*> models;
+    find_aircraft(models);
 
-    for (int i = ai->nChildren() - 1; i >= -1; i--) {
+    for (int i = models.size() - 1; i >= -1; i--) {
         const SGPropertyNode *model;
 
         if (i < 0) { // last iteration: selected model
             model = selected_ac;
         } else {
-            model = ai->getChild(i);
+            model = models[i];
             if (!model->nChildren())
                 continue;
             if ((model->getIntValue("id") == selected_id)&&
@@ -803,6 +805,30 @@ wxRadarBg::update_aircraft()
     }
 }
 
+/** Collect the AI models which may be within radar range. */
+void
+wxRadarBg::find_aircraft(std::vector<const SGPropertyNode*>& models)
+{
+    FGAIManager* aiManager =
+        static_cast<FGAIManager*>(globals->get_subsystem("ai-model"));
+    if (!aiManager) {
+        const SGPropertyNode *ai = fgGetNode("/ai/models", true);
+        for (int i = 0; i < ai->nChildren(); i++)
+            models.push_back(ai->getChild(i));
+        return;
+    }
+
+    // the largest cross section (sigma = 100) gives the largest range, see
+    // inRadarRange(); allow for targets far above or below us
+    double constant = _radar_ref_rng > 0 ? _radar_ref_rng : 35;
+    double range = constant * pow(100.0, 0.25) * SG_NM_TO_METER + 20000;
+
+    FGAIBaseVec objects;
+    aiManager->findInRange(globals->get_aircraft_position_cart(), range, objects);
+    for (size_t i = 0; i < objects.size(); i++)
+        models.push_back(objects[i]->_getProps());
+}
+
 /** Update TCAS display.
  * Return true when processed as TCAS contact, false otherwise. */
 bool
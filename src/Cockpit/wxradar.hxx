@@ -149,6 +149,7 @@ private:
 
     void update_weather();
     void update_aircraft();
+    void find_aircraft(std::vector<const SGPropertyNode*>& models);
     void update_tacan();
     void update_heading_marker();
     void update_data(const SGPropertyNode *ac, double alt, double heading,
@@ -231,7 +231,7 @@ void AreaSampler::update( double dt )
         SGGeod probe = SGGeod::fromGeoc(center.advanceRadM( course, distance ));
         double elevation_m = 0.0;
 
-        if (scenery->get_elevation_m( probe, elevation_m, NULL )) 
+        if (scenery->get_cached_elevation_m( probe, elevation_m, NULL )) 
             _elevations.push_front(elevation_m *= SG_METER_TO_FEET);
         
         if( _elevations.size() >= (deque<unsigned>::size_type)_max_samples ) {
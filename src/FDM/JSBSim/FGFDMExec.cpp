@@ -67,6 +67,7 @@ INCLUDES
 #include "initialization/FGSimplexTrim.h"
 #include "input_output/FGPropertyManager.h"
 #include "input_output/FGScript.h"
+#include "input_output/FGProfiler.h"
 
 using namespace std;
 
@@ -134,6 +135,7 @@ FGFDMExec::FGFDMExec(FGPropertyManager* root, unsigned int* fdmctr) : Root(root)
   (*FDMctr)++;       // instance. "child" instances are loaded last.
 
   instance = Root->GetNode("/fdm/jsbsim",IdFDM,true);
+  Profiler = new FGProfiler(instance);
   Debug(0);
   // this is to catch errors in binding member functions to the property tree.
   try {
@@ -222,6 +224,7 @@ FGFDMExec::~FGFDMExec()
   try {
     Unbind();
     DeAllocate();
+    delete Profiler;
 
     if (IdFDM == 0) { // Meaning this is no child FDM
       if(Root != 0) {
@@ -293,6 +296,10 @@ bool FGFDMExec::Allocate(void)
   Accelerations = (FGAccelerations*)Models[eAccelerations];
   Output = (FGOutput*)Models[eOutput];
 
+  ModelProbes.resize(eNumStandardModels);
+  for (unsigned int i = 0; i < eNumStandardModels; i++)
+    ModelProbes[i] = Profiler->AddProbe(FGProfiler::eModel, Models[i]->Name);
+
   // Initialize planet (environment) constants
   LoadPlanetConstants();
   GetGroundCallback()->SetSeaLevelRadius(Inertial->GetRefRadius());
@@ -320,6 +327,7 @@ bool FGFDMExec::DeAllocate(void)
 
   for (unsigned int i=0; i<eNumStandardModels; i++) delete Models[i];
   Models.clear();
+  ModelProbes.clear();
 
   delete Script;
   delete IC;
@@ -337,6 +345,7 @@ void FGFDMExec::Schedule(FGModel* model, int rate)
 {
   model->SetRate(rate);
   Models.push_back(model);
+  ModelProbes.push_back(Profiler->AddProbe(FGProfiler::eModel, model->Name));
 }
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -357,9 +366,17 @@ bool FGFDMExec::Run(void)
   // returns true if success, false if complete
   if (Script != 0 && !IntegrationSuspended()) success = Script->RunScript();
 
+  bool profiling = Profiler->IsEnabled();
+
   for (unsigned int i = 0; i < Models.size(); i++) {
     LoadInputs(i);
-    Models[i]->Run(holding);
+    if (profiling) {
+      SGTimeStamp start = SGTimeStamp::now();
+      Models[i]->Run(holding);
+      Profiler->Record(ModelProbes[i], start);
+    } else {
+      Models[i]->Run(holding);
+    }
   }
 
   if (Terminate) success = false;
@@ -369,6 +386,34 @@ bool FGFDMExec::Run(void)
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+bool FGFDMExec::EvaluateStateDerivatives(double dt)
+{
+  if (GroundReactions->GetRate() != 1 || Aircraft->GetRate() != 1
+      || Accelerations->GetRate() != 1)
+    return false;
+
+  LoadInputs(eGroundReactions);
+  // The gear bookkeeping (wheel spin down, distances traveled, takeoff and
+  // landing reports, crash detection) only advances once per frame, when the
+  // ground reactions run in the normal sequence.
+  GroundReactions->in.TotalDeltaT = 0.0;
+  GroundReactions->in.StageEvaluation = true;
+  GroundReactions->Run(false);
+  GroundReactions->in.StageEvaluation = false;
+
+  LoadInputs(eAircraft);
+  Aircraft->Run(false);
+
+  LoadInputs(eAccelerations);
+  Accelerations->in.DeltaT = dt;
+  Accelerations->Run(false);
+
+  LoadInputs(ePropagate);
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 void FGFDMExec::LoadInputs(unsigned int idx)
 {
   switch(idx) {
@@ -490,6 +535,7 @@ void FGFDMExec::LoadInputs(unsigned int idx)
     GroundReactions->in.WOW             = GroundReactions->GetWOW();
     GroundReactions->in.Location        = Propagate->GetLocation();
     GroundReactions->in.vXYZcg          = MassBalance->GetXYZcg();
+    GroundReactions->in.StageEvaluation = false;
     break;
   case eExternalReactions:
     // There are no external inputs to this model.
@@ -65,6 +65,7 @@ FORWARD DECLARATIONS
 namespace JSBSim {
 
 class FGScript;
+class FGProfiler;
 class FGTrim;
 class FGAerodynamics;
 class FGAircraft;
@@ -262,6 +263,18 @@ public:
       @return true if successful, false if sim should be ended  */
   bool Run(void);
 
+  /** Re-evaluates the state derivatives at the current (trial) state of
+      FGPropagate. Only the models that depend strongly on the state within
+      a frame are run again: the ground reactions, the force and moment sums
+      and the accelerations. Aerodynamic, propulsion and FCS outputs are kept
+      from the current frame. The derivatives are loaded into FGPropagate.
+      This is used by the Runge-Kutta state integrators for their stages.
+      @param dt the length of the integration (sub)step, used to resolve the
+                ground friction forces.
+      @return false if those models are not run every frame, in which case
+              nothing is evaluated. */
+  bool EvaluateStateDerivatives(double dt);
+
   /** Initializes the sim from the initial condition object and executes
       each scheduled model without integrating i.e. dt=0.
       @return true if successful */
@@ -374,6 +387,8 @@ public:
   FGGroundCallback* GetGroundCallback(void) {return FGLocation::GetGroundCallback();}
   /// Retrieves the script object
   FGScript* GetScript(void) {return Script;}
+  /// Returns the profiler of the models and FCS components.
+  FGProfiler* GetProfiler(void) {return Profiler;}
   /// Returns a pointer to the FGInitialCondition object
   FGInitialCondition* GetIC(void)      {return IC;}
   /// Returns a pointer to the FGTrim object
@@ -617,6 +632,7 @@ private:
   FGScript*           Script;
   FGInitialCondition* IC;
   FGTrim*             Trim;
+  FGProfiler*         Profiler;
 
   FGPropertyManager* Root;
   bool StandAlone;
@@ -628,6 +644,7 @@ private:
   vector <string> PropertyCatalog;
   vector <childData*> ChildFDMList;
   vector <FGModel*> Models;
+  vector <unsigned int> ModelProbes; // profiler probe of each model
 
   bool ReadFileHeader(Element*);
   bool ReadChild(Element*);
@@ -85,7 +85,8 @@ FMAX (double a, double b)
 
 class FGFSGroundCallback : public FGGroundCallback {
 public:
-  FGFSGroundCallback(FGJSBsim* ifc) : mInterface(ifc) {}
+  FGFSGroundCallback(FGJSBsim* ifc) :
+    mInterface(ifc), mPrefetchTime(-1), mPrefetchCursor(0) {}
   virtual ~FGFSGroundCallback() {}
 
   /** Get the altitude above sea level dependent on the location. */
@@ -102,8 +103,13 @@ public:
   virtual double GetAGLevel(double t, const FGLocation& l,
                             FGLocation& cont, FGColumnVector3& n,
                             FGColumnVector3& v, FGColumnVector3& w) const {
+    double agl;
+    if (GetPrefetchedAGLevel(t, l, cont, n, v, w, agl))
+      return agl;
+
     double loc_cart[3] = { l(eX), l(eY), l(eZ) };
-    double contact[3], normal[3], vel[3], angularVel[3], agl = 0;
+    double contact[3], normal[3], vel[3], angularVel[3];
+    agl = 0;
     mInterface->get_agl_ft(t, loc_cart, SG_METER_TO_FEET*2, contact, normal,
                            vel, angularVel, &agl);
     n = FGColumnVector3( normal[0], normal[1], normal[2] );
@@ -113,6 +119,23 @@ public:
     return agl;
   }
 
+  /** Look up the ground below all gear units with a single pass through
+      the ground cache. GetAGLevel then answers from these results, as long
+      as it is asked for exactly the same time and location. */
+  virtual void PrefetchAGLevel(double t,
+                               const std::vector<FGLocation>& locations) const {
+    mPrefetchTime = t;
+    mPrefetchCursor = 0;
+    mPrefetchLocations.resize(locations.size());
+    mPrefetchQueries.resize(locations.size());
+    for (unsigned i = 0; i < locations.size(); ++i) {
+      const FGLocation& l = locations[i];
+      mPrefetchLocations[i] = SGVec3d(l(eX), l(eY), l(eZ));
+      mPrefetchQueries[i].pt = SG_FEET_TO_METER*mPrefetchLocations[i];
+    }
+    mInterface->get_agl_m(t, 2, mPrefetchQueries);
+  }
+
   virtual double GetTerrainGeoCentRadius(double t, const FGLocation& l) const {
     double loc_cart[3] = { l(eX), l(eY), l(eZ) };
     double contact[3], normal[3], vel[3], angularVel[3], agl = 0;
@@ -133,7 +156,49 @@ public:
   virtual void SetTerrainGeoCentRadius(double radius) {}
   virtual void SetSeaLevelRadius(double radius) {}
 private:
+  bool GetPrefetchedAGLevel(double t, const FGLocation& l, FGLocation& cont,
+                            FGColumnVector3& n, FGColumnVector3& v,
+                            FGColumnVector3& w, double& agl) const {
+    if (t != mPrefetchTime)
+      return false;
+
+    // The gear units ask in the order they were prefetched, so start
+    // looking right after the last hit.
+    SGVec3d pt(l(eX), l(eY), l(eZ));
+    unsigned count = mPrefetchLocations.size();
+    for (unsigned k = 0; k < count; ++k) {
+      unsigned i = (mPrefetchCursor + k) % count;
+      const SGVec3d& p = mPrefetchLocations[i];
+      if (p[0] != pt[0] || p[1] != pt[1] || p[2] != pt[2])
+        continue;
+
+      const FGGroundCache::AglQuery& q = mPrefetchQueries[i];
+      if (!q.valid)
+        return false;
+      mPrefetchCursor = i + 1;
+
+      // Same unit conversions as FGInterface::get_agl_ft
+      SGVec3d contact = SG_METER_TO_FEET*q.contact;
+      SGVec3d vel = SG_METER_TO_FEET*q.linearVel;
+      n = FGColumnVector3( q.normal[0], q.normal[1], q.normal[2] );
+      v = FGColumnVector3( vel[0], vel[1], vel[2] );
+      w = FGColumnVector3( q.angularVel[0], q.angularVel[1], q.angularVel[2] );
+      cont = FGColumnVector3( contact[0], contact[1], contact[2] );
+
+      SGGeod geodPt = SGGeod::fromCart(SG_FEET_TO_METER*pt);
+      SGQuatd hlToEc = SGQuatd::fromLonLat(geodPt);
+      agl = dot(hlToEc.rotate(SGVec3d(0, 0, 1)), contact - pt);
+      return true;
+    }
+    return false;
+  }
+
   FGJSBsim* mInterface;
+
+  mutable double mPrefetchTime;
+  mutable unsigned mPrefetchCursor;
+  mutable std::vector<SGVec3d> mPrefetchLocations;
+  mutable FGGroundCache::AglQueryList mPrefetchQueries;
 };
 
 // FG uses a squared normalized magnitude for turbulence
@@ -192,7 +257,7 @@ FGJSBsim::FGJSBsim( double dt )
         }
     }
 
-    fdmex = new FGFDMExec( (FGPropertyManager*)globals->get_props() );
+    fdmex = new FGFDMExec( (FGPropertyManager*)fgGetPropertyRoot() );
 
     // Register ground callback.
     fdmex->SetGroundCallback( new FGFSGroundCallback(this) );
@@ -38,6 +38,8 @@ SENTRY
 INCLUDES
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
+#include <vector>
+
 #include "FGJSBBase.h"
 #include "simgear/structure/SGReferenced.hxx"
 #include "simgear/structure/SGSharedPtr.hxx"
@@ -97,6 +99,17 @@ public:
                             FGColumnVector3& normal, FGColumnVector3& v,
                             FGColumnVector3& w) const = 0;
 
+  /** Announce the locations which are about to be passed to GetAGLevel.
+      Implementations for which a batched query is cheaper than the single
+      ones can look up all of them here and answer the following GetAGLevel
+      calls from the result. The default implementation does nothing.
+      @param t simulation time
+      @param locations the locations to be queried
+   */
+  virtual void PrefetchAGLevel(double t,
+                               const std::vector<FGLocation>& locations) const
+  { }
+
   /** Compute the local terrain radius
       @param t simulation time
       @param location location
@@ -0,0 +1,314 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGOutputBinaryFile.cpp
+ Date started: 10/17/26
+ Purpose:      Manage output of sim parameters to a binary file
+ Called by:    FGOutput
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+Records are copied into a ring buffer by the simulation and written to the file
+by a background thread, in large blocks.
+
+HISTORY
+--------------------------------------------------------------------------------
+10/17/26         Created
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include <simgear/misc/stdint.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include "FGOutputBinaryFile.h"
+#include "FGFDMExec.h"
+#include "FGXMLElement.h"
+#include "input_output/FGPropertyManager.h"
+
+using namespace std;
+
+namespace JSBSim {
+
+static const char *IdSrc = "$Id$";
+static const char *IdHdr = ID_OUTPUTBINARYFILE;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+// Writes the data pushed into a ring buffer to the file. The thread wakes up
+// when a quarter of the buffer is filled, so the file sees few, large writes.
+
+class FGOutputBinaryFile::Writer : public SGThread
+{
+public:
+  Writer(ofstream& file, size_t size)
+    : file(file), ring(size), head(0), tail(0), done(false), failed(false) {}
+
+  void Push(const char* data, size_t n);
+  void Finish(void);
+
+protected:
+  virtual void run(void);
+
+private:
+  ofstream& file;
+  vector<char> ring;
+  size_t head;  // bytes pushed so far
+  size_t tail;  // bytes written so far
+  bool done;
+  bool failed;
+  SGMutex mutex;
+  SGWaitCondition dataReady;
+  SGWaitCondition spaceFree;
+};
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinaryFile::Writer::Push(const char* data, size_t n)
+{
+  SGGuard<SGMutex> lock(mutex);
+
+  while (n > 0) {
+    // only waits when the file cannot keep up with the simulation
+    while (head - tail == ring.size()) {
+      dataReady.signal();
+      spaceFree.wait(mutex);
+    }
+
+    size_t pos = head % ring.size();
+    size_t chunk = min(n, min(ring.size() - (head - tail), ring.size() - pos));
+    memcpy(&ring[pos], data, chunk);
+    head += chunk;
+    data += chunk;
+    n -= chunk;
+  }
+
+  if (head - tail >= ring.size()/4) dataReady.signal();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinaryFile::Writer::Finish(void)
+{
+  {
+    SGGuard<SGMutex> lock(mutex);
+    done = true;
+    dataReady.signal();
+  }
+  join();
+  file.flush();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinaryFile::Writer::run(void)
+{
+  SGGuard<SGMutex> lock(mutex);
+
+  for (;;) {
+    while (!done && head - tail < ring.size()/4) dataReady.wait(mutex);
+    if (head == tail) break;
+
+    // the pending data up to the end of the ring, the rest comes next round
+    size_t pos = tail % ring.size();
+    size_t chunk = min(head - tail, ring.size() - pos);
+
+    mutex.unlock();
+    if (!failed) {
+      file.write(&ring[pos], chunk);
+      if (!file) {
+        cerr << "ERROR: writing the binary output failed, the rest of the "
+             << "output is dropped." << endl;
+        failed = true;
+      }
+    }
+    mutex.lock();
+
+    tail += chunk;
+    spaceFree.signal();
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGOutputBinaryFile::FGOutputBinaryFile(FGFDMExec* fdmex) :
+  FGOutputFile(fdmex),
+  writer(0),
+  BufferSize(1024*1024)
+{
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGOutputBinaryFile::~FGOutputBinaryFile()
+{
+  // the base class destructor cannot reach this CloseFile()
+  CloseFile();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGOutputBinaryFile::Load(Element* el)
+{
+  if (!FGOutputFile::Load(el))
+    return false;
+
+  double size = el->GetAttributeValueAsNumber("buffer_size");
+  if (size != HUGE_VAL && size > 0.0)
+    BufferSize = (unsigned int)(size*1024.0);
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGOutputBinaryFile::OpenFile(void)
+{
+  datafile.clear();
+  datafile.open(Filename.c_str(), ios::out | ios::binary);
+  if (!datafile) {
+    cerr << endl << fgred << highint << "ERROR: unable to open the file "
+         << reset << Filename.c_str() << endl
+         << fgred << highint << "       => Output to this file is disabled."
+         << reset << endl << endl;
+    Disable();
+    return false;
+  }
+
+  if (SubSystems && debug_lvl > 0)
+    cout << "  The binary output " << Filename << " only records properties"
+         << endl;
+
+  // The column types follow the types of the properties
+  vector<string> names;
+  names.push_back("Time");
+  Types.clear();
+  Types.push_back('d');
+  uint32_t recordSize = sizeof(double);
+  for (unsigned int i=0; i<OutputProperties.size(); i++) {
+    if (i < OutputCaptions.size() && OutputCaptions[i].size() > 0)
+      names.push_back(OutputCaptions[i]);
+    else
+      names.push_back(OutputProperties[i]->GetFullyQualifiedName());
+
+    switch (OutputProperties[i]->getType()) {
+    case simgear::props::BOOL:
+      Types.push_back('b');
+      recordSize += 1;
+      break;
+    case simgear::props::INT:
+      Types.push_back('i');
+      recordSize += sizeof(int32_t);
+      break;
+    case simgear::props::FLOAT:
+      Types.push_back('f');
+      recordSize += sizeof(float);
+      break;
+    default:
+      Types.push_back('d');
+      recordSize += sizeof(double);
+      break;
+    }
+  }
+  Record.resize(recordSize);
+
+  const uint32_t byteOrder = 0x01020304;
+  const uint32_t version = 1;
+  uint32_t columns = names.size();
+  datafile.write("JSBSBIN", 8);
+  datafile.write((const char*)&byteOrder, sizeof(byteOrder));
+  datafile.write((const char*)&version, sizeof(version));
+  datafile.write((const char*)&recordSize, sizeof(recordSize));
+  datafile.write((const char*)&columns, sizeof(columns));
+  for (unsigned int i=0; i<columns; i++) {
+    uint32_t length = names[i].size();
+    datafile.write(&Types[i], 1);
+    datafile.write((const char*)&length, sizeof(length));
+    datafile.write(names[i].data(), length);
+  }
+
+  writer = new Writer(datafile, max((size_t)BufferSize, 16*Record.size()));
+  writer->start();
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinaryFile::CloseFile(void)
+{
+  if (writer) {
+    writer->Finish();
+    delete writer;
+    writer = 0;
+  }
+  if (datafile.is_open()) datafile.close();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinaryFile::Print(void)
+{
+  if (!writer) return;
+
+  char* p = &Record[0];
+  double time = FDMExec->GetSimTime();
+  memcpy(p, &time, sizeof(time));
+  p += sizeof(time);
+
+  for (unsigned int i=0; i<OutputProperties.size(); i++) {
+    switch (Types[i+1]) {
+    case 'b':
+      *p++ = OutputProperties[i]->getBoolValue() ? 1 : 0;
+      break;
+    case 'i':
+      {
+        int32_t value = OutputProperties[i]->getIntValue();
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+      }
+      break;
+    case 'f':
+      {
+        float value = OutputProperties[i]->getFloatValue();
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+      }
+      break;
+    default:
+      {
+        double value = OutputProperties[i]->getDoubleValue();
+        memcpy(p, &value, sizeof(value));
+        p += sizeof(value);
+      }
+      break;
+    }
+  }
+
+  writer->Push(&Record[0], Record.size());
+}
+}
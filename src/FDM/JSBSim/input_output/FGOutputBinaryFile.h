@@ -0,0 +1,128 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGOutputBinaryFile.h
+ Date started: 10/17/26
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+HISTORY
+--------------------------------------------------------------------------------
+10/17/26         Created
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGOUTPUTBINARYFILE_H
+#define FGOUTPUTBINARYFILE_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <fstream>
+#include <vector>
+
+#include "FGOutputFile.h"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_OUTPUTBINARYFILE "$Id$"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+namespace JSBSim {
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Implements the output to a binary file, for logging at the full FDM rate.
+    The simulation time and the listed properties are written unformatted into
+    a memory buffer; a background thread writes the buffer to the file. The
+    subsystem groups of the text output are not supported, their properties
+    can be listed instead.
+
+    The file starts with a header describing the records, in native byte
+    order:
+<pre>
+    char[8]  "JSBSBIN" and a zero byte
+    uint32   0x01020304, to detect the byte order
+    uint32   format version, 1
+    uint32   record size in bytes
+    uint32   number of columns; the first one is the simulation time
+    for each column:
+      char     type: 'd' double, 'f' float, 'i' int32, 'b' bool as one byte
+      uint32   length of the name
+      char[]   name
+</pre>
+    Fixed size records follow, the columns packed without padding.
+
+@code
+<output name="B737_datalog.bin" type="BINARY" rate="120" buffer_size="4096">
+   <property> velocities/vc-kts </property>
+</output>
+@endcode
+
+    buffer_size is the size of the memory buffer in kilobytes (1024 by
+    default). The simulation only waits for the file when the buffer is full.
+    The utility jsbbin2csv converts these files to CSV.
+ */
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGOutputBinaryFile : public FGOutputFile
+{
+public:
+  /// Constructor
+  FGOutputBinaryFile(FGFDMExec* fdmex);
+
+  /// Destructor : writes out the buffer and closes the file.
+  ~FGOutputBinaryFile();
+
+  /** Init the output directives from an XML file.
+      @param element XML Element that is pointing to the output directives
+  */
+  virtual bool Load(Element* el);
+
+  /// Appends a record to the buffer.
+  virtual void Print(void);
+
+protected:
+  std::ofstream datafile;
+
+  virtual bool OpenFile(void);
+  virtual void CloseFile(void);
+
+private:
+  class Writer;
+
+  Writer* writer;
+  unsigned int BufferSize;
+  std::vector<char> Types;
+  std::vector<char> Record;
+};
+}
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#endif
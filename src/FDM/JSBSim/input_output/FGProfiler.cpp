@@ -0,0 +1,267 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGProfiler.cpp
+ Date started: 10/17/26
+ Purpose:      Accumulates the execution time of models and FCS components
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+HISTORY
+-------------------------------------------------------------------------------
+10/17/26   Created
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "FGProfiler.h"
+#include "FGPropertyManager.h"
+
+using namespace std;
+
+namespace JSBSim {
+
+static const char *IdSrc = "$Id$";
+static const char *IdHdr = ID_PROFILER;
+
+static const char* ProbeTypeNames[] = {"model", "component"};
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+FGProfiler::FGProfiler(FGPropertyManager* pm)
+  : PropertyManager(pm), enabled(false)
+{
+  for (int i=0; i<eNumProbeTypes; i++) NumProbes[i] = 0;
+
+  typedef int (FGProfiler::*iPMF)(void) const;
+  PropertyManager->Tie("simulation/profiler/enabled", &enabled);
+  PropertyManager->Tie("simulation/profiler/reset", this, (iPMF)0, &FGProfiler::SetReset, false);
+  PropertyManager->Tie("simulation/profiler/dump", this, (iPMF)0, &FGProfiler::SetDump, false);
+
+  Debug(0);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGProfiler::~FGProfiler()
+{
+  Debug(1);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGProfiler::AddProbe(eProbeType type, const string& name)
+{
+  // The models are allocated again when an aircraft is reloaded. Their probes,
+  // and the properties tied to them, are reused.
+  for (unsigned int i=0; i<Probes.size(); i++) {
+    if (Probes[i].type == type && Probes[i].name == name) return i;
+  }
+
+  Probe probe;
+  probe.type = type;
+  probe.name = name;
+  ResetProbe(probe);
+  Probes.push_back(probe);
+
+  int idx = Probes.size() - 1;
+  ostringstream path;
+  path << "simulation/profiler/" << ProbeTypeNames[type]
+       << "[" << NumProbes[type]++ << "]/";
+  string base = path.str();
+
+  PropertyManager->SetString(base + "name", name);
+  PropertyManager->Tie(base + "calls", this, idx, &FGProfiler::GetCalls);
+  PropertyManager->Tie(base + "total-ms", this, idx, &FGProfiler::GetTotalMSec);
+  PropertyManager->Tie(base + "mean-us", this, idx, &FGProfiler::GetMeanUSec);
+  PropertyManager->Tie(base + "max-us", this, idx, &FGProfiler::GetMaxUSec);
+  PropertyManager->Tie(base + "p95-us", this, idx, &FGProfiler::GetP95USec);
+
+  return idx;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGProfiler::GetMeanUSec(int idx) const
+{
+  const Probe& probe = Probes[idx];
+  if (probe.calls == 0) return 0.0;
+  return probe.total_ns*1E-3/probe.calls;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGProfiler::GetPercentileUSec(int idx, double fraction) const
+{
+  const Probe& probe = Probes[idx];
+  if (probe.calls == 0) return 0.0;
+
+  double target = fraction*probe.calls;
+  long cumulated = 0;
+  for (int bin=0; bin<NumBins-1; bin++) {
+    cumulated += probe.histogram[bin];
+    if (cumulated >= target)
+      return min(GetBinUpperUSec(bin), GetMaxUSec(idx));
+  }
+  return GetMaxUSec(idx);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGProfiler::GetBinUpperUSec(int bin)
+{
+  return ldexp(1.0, bin + FirstBinExponent + 1)*1E-3;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGProfiler::ResetProbe(Probe& probe)
+{
+  probe.calls = 0;
+  probe.total_ns = 0.0;
+  probe.max_ns = 0.0;
+  for (int bin=0; bin<NumBins; bin++) probe.histogram[bin] = 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGProfiler::Reset(void)
+{
+  for (unsigned int i=0; i<Probes.size(); i++) ResetProbe(Probes[i]);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGProfiler::SetDump(int)
+{
+  Print(cout);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+namespace {
+
+// Orders the probes by decreasing total time
+struct MoreExpensive {
+  MoreExpensive(const FGProfiler* p) : profiler(p) {}
+  bool operator()(int a, int b) const {
+    return profiler->GetTotalMSec(a) > profiler->GetTotalMSec(b);
+  }
+  const FGProfiler* profiler;
+};
+
+}
+
+void FGProfiler::Print(ostream& out) const
+{
+  out << endl << highint << "  JSBSim execution profile" << normint << endl;
+  PrintProbes(out, eModel);
+  PrintProbes(out, eComponent);
+  out << endl;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGProfiler::PrintProbes(ostream& out, eProbeType type) const
+{
+  vector<int> order;
+  for (unsigned int i=0; i<Probes.size(); i++) {
+    if (Probes[i].type == type && Probes[i].calls > 0) order.push_back(i);
+  }
+  if (order.empty()) return;
+  sort(order.begin(), order.end(), MoreExpensive(this));
+
+  out << endl << underon << (type == eModel ? "Models" : "FCS components")
+      << underoff << endl;
+  out << "  " << left << setw(32) << "name" << right
+      << setw(10) << "calls" << setw(12) << "total ms"
+      << setw(10) << "mean us" << setw(10) << "p95 us"
+      << setw(10) << "max us" << endl;
+
+  ios::fmtflags flags = out.flags();
+  out << fixed << setprecision(3);
+  for (unsigned int i=0; i<order.size(); i++) {
+    int idx = order[i];
+    out << "  " << left << setw(32) << Probes[idx].name.substr(0, 31) << right
+        << setw(10) << Probes[idx].calls
+        << setw(12) << GetTotalMSec(idx)
+        << setw(10) << GetMeanUSec(idx)
+        << setw(10) << GetP95USec(idx)
+        << setw(10) << GetMaxUSec(idx) << endl;
+  }
+
+  // Histograms, as the call counts per bin, labeled with the bin upper bound
+  out << endl << "  histograms (calls below the given us):" << endl;
+  for (unsigned int i=0; i<order.size(); i++) {
+    int idx = order[i];
+    out << "  " << Probes[idx].name << ":";
+    for (int bin=0; bin<NumBins; bin++) {
+      if (Probes[idx].histogram[bin] == 0) continue;
+      if (bin == NumBins-1)
+        out << " more:";
+      else
+        out << " " << setprecision(3) << GetBinUpperUSec(bin) << ":";
+      out << Probes[idx].histogram[bin];
+    }
+    out << endl;
+  }
+  out.flags(flags);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//    The bitmasked value choices are as follows:
+//    unset: In this case (the default) JSBSim would only print
+//       out the normally expected messages, essentially echoing
+//       the config files as they are read. If the environment
+//       variable is not set, debug_lvl is set to 1 internally
+//    0: This requests JSBSim not to output any messages
+//       whatsoever.
+//    1: This value explicity requests the normal JSBSim
+//       startup messages
+//    2: This value asks for a message to be printed out when
+//       a class is instantiated
+//    4: When this value is set, a message is displayed when a
+//       FGModel object executes its Run() method
+//    8: When this value is set, various runtime state variables
+//       are printed out periodically
+//    16: When set various parameters are sanity checked and
+//       a message is printed out when they go out of bounds
+
+void FGProfiler::Debug(int from)
+{
+  if (debug_lvl <= 0) return;
+
+  if (debug_lvl & 2 ) { // Instantiation/Destruction notification
+    if (from == 0) cout << "Instantiated: FGProfiler" << endl;
+    if (from == 1) cout << "Destroyed:    FGProfiler" << endl;
+  }
+  if (debug_lvl & 64) {
+    if (from == 0) { // Constructor
+      cout << IdSrc << endl;
+      cout << IdHdr << endl;
+    }
+  }
+}
+}
@@ -0,0 +1,173 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGProfiler.h
+ Date started: 10/17/26
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+HISTORY
+-------------------------------------------------------------------------------
+10/17/26   Created
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGPROFILER_H
+#define FGPROFILER_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <cmath>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "FGJSBBase.h"
+#include "simgear/timing/timestamp.hxx"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_PROFILER "$Id$"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+namespace JSBSim {
+
+class FGPropertyManager;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Accumulates the wall time spent in the models run by the executive and
+    in the components of the flight control channels.
+
+    Each timed item is a probe. A probe counts its calls and keeps the total,
+    the maximum and a histogram of the call durations. The histogram bins
+    double in width: the first one holds the calls shorter than 0.128
+    microsecond, the last one the calls longer than about 33 milliseconds.
+
+    The profiler is off by default, and then costs one test per model and per
+    channel. When it is on, each timed call reads the clock twice.
+
+    <h3>Properties</h3>
+    @code
+    simulation/profiler/enabled          (read/write) turns the profiler on
+    simulation/profiler/reset            (write only) clears all the probes
+    simulation/profiler/dump             (write only) prints the probes
+    simulation/profiler/model[i]/        one per model, in execution order
+    simulation/profiler/component[i]/    one per FCS component
+    @endcode
+
+    Each probe node holds its <tt>name</tt>, and the read only
+    <tt>calls</tt>, <tt>total-ms</tt>, <tt>mean-us</tt>, <tt>max-us</tt> and
+    <tt>p95-us</tt>. The percentile is read from the histogram and is
+    therefore an upper bound within a factor of two.
+
+    Components sharing a name also share a probe.
+*/
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGProfiler : public FGJSBBase
+{
+public:
+  enum eProbeType {eModel=0, eComponent, eNumProbeTypes};
+
+  /** Constructor
+      @param pm the property manager of the executive instance */
+  FGProfiler(FGPropertyManager* pm);
+  ~FGProfiler();
+
+  bool IsEnabled(void) const {return enabled;}
+  void SetEnabled(bool enable) {enabled = enable;}
+
+  /** Returns the probe of the given type and name, creating it and its
+      properties if needed. */
+  unsigned int AddProbe(eProbeType type, const std::string& name);
+
+  /** Accounts one call of a probe which started at the given time. */
+  void Record(unsigned int idx, const SGTimeStamp& start) {
+    double ns = (SGTimeStamp::now() - start).toSecs()*1E9;
+    Probe& probe = Probes[idx];
+    probe.calls++;
+    probe.total_ns += ns;
+    if (ns > probe.max_ns) probe.max_ns = ns;
+    int exponent;
+    frexp(ns, &exponent);
+    int bin = exponent - 1 - FirstBinExponent;
+    if (bin < 0) bin = 0;
+    else if (bin >= NumBins) bin = NumBins - 1;
+    probe.histogram[bin]++;
+  }
+
+  long   GetCalls(int idx) const {return Probes[idx].calls;}
+  double GetTotalMSec(int idx) const {return Probes[idx].total_ns*1E-6;}
+  double GetMeanUSec(int idx) const;
+  double GetMaxUSec(int idx) const {return Probes[idx].max_ns*1E-3;}
+  double GetP95USec(int idx) const {return GetPercentileUSec(idx, 0.95);}
+  /** Returns the upper bound of the histogram bin holding the given
+      fraction of the calls, in microseconds. */
+  double GetPercentileUSec(int idx, double fraction) const;
+
+  /// Clears the statistics of all the probes
+  void Reset(void);
+  /// Prints the probes, the most expensive ones first, and their histograms.
+  void Print(std::ostream& out) const;
+
+private:
+  // Bin 0 holds the durations below 2^7 ns, bin i those in [2^(i+6), 2^(i+7))
+  // ns, and the last bin everything above.
+  static const int FirstBinExponent = 6;
+  static const int NumBins = 20;
+
+  struct Probe {
+    eProbeType type;
+    std::string name;
+    long calls;
+    double total_ns;
+    double max_ns;
+    long histogram[NumBins];
+  };
+
+  std::vector<Probe> Probes;
+  unsigned int NumProbes[eNumProbeTypes];
+  FGPropertyManager* PropertyManager;
+  bool enabled;
+
+  void ResetProbe(Probe& probe);
+  void PrintProbes(std::ostream& out, eProbeType type) const;
+  static double GetBinUpperUSec(int bin);
+
+  void SetReset(int) {Reset();}
+  void SetDump(int);
+
+  void Debug(int from);
+};
+}
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#endif
@@ -309,6 +309,8 @@ FGFunction::FGFunction(FGPropertyManager* propMan, Element* el, const string& pr
 
   bind(); // Allow any function to save its value
 
+  if (Type == eTopLevel) Compile();
+
   Debug(0);
 }
 
@@ -353,6 +355,12 @@ double FGFunction::GetValue(void) const
 
   if (cached) return cachedValue;
 
+  if (!Program.empty()) {
+    temp = Run(&Program[0], &Program[0] + Program.size(), &Stack[0]);
+    if (pCopyTo) pCopyTo->setDoubleValue(temp);
+    return temp;
+  }
+
   if (   Type != eRandom
       && Type != eUrandom
       && Type != ePi      ) temp = Parameters[0]->GetValue();
@@ -747,6 +755,312 @@ double FGFunction::GetValue(void) const
   return temp;
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Flattens the operand of a top level function into Program.
+
+void FGFunction::Compile(void)
+{
+  static const char* compile = getenv("JSBSIM_COMPILE_FUNCTIONS");
+  if ((compile && atoi(compile) == 0) || Parameters.empty()) return;
+
+  vector<Instruction> code;
+  Compile(Parameters[0], code);
+
+  // A single tree evaluation gains nothing
+  if (code.size() == 1 && code[0].kind == iParameter) return;
+
+  Program = code;
+  Stack.resize(StackDepth(&Program[0], &Program[0] + Program.size()));
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Appends the code which pushes the value of the parameter. Returns true if
+// that value is a constant.
+
+bool FGFunction::Compile(const FGParameter* parameter, vector<Instruction>& code) const
+{
+  Instruction in;
+  in.kind = iParameter;
+  in.operation = eTopLevel;
+  in.operands = 0;
+  in.value = 0.0;
+  in.node = 0L;
+  in.parameter = parameter;
+
+  if (const FGRealValue* real = dynamic_cast<const FGRealValue*>(parameter)) {
+    in.kind = iConstant;
+    in.value = real->GetValue();
+    code.push_back(in);
+    return true;
+  }
+
+  if (const FGPropertyValue* property = dynamic_cast<const FGPropertyValue*>(parameter)) {
+    if (property->GetNode()) {
+      in.kind = iProperty;
+      in.node = property->GetNode();
+    }
+    code.push_back(in);
+    return false;
+  }
+
+  const FGFunction* function = dynamic_cast<const FGFunction*>(parameter);
+  if (function && function->Type == ePi) {
+    in.kind = iConstant;
+    in.value = M_PI;
+    code.push_back(in);
+    return true;
+  }
+
+  unsigned int n = function ? function->CompiledOperands() : 0;
+  if (n == 0) { // tables, and operations left to the tree
+    code.push_back(in);
+    return false;
+  }
+
+  size_t start = code.size();
+  bool constant = true;
+  for (unsigned int i=0; i<n; i++) {
+    if (!Compile(function->Parameters[i], code)) constant = false;
+  }
+
+  in.kind = iOperation;
+  in.operation = function->Type;
+  in.operands = n;
+  in.parameter = 0L;
+  code.push_back(in);
+
+  if (constant) { // fold it
+    const Instruction* begin = &code[start];
+    const Instruction* end = &code[0] + code.size();
+    vector<double> stack(StackDepth(begin, end));
+    try {
+      in.value = Run(begin, end, &stack[0]);
+    } catch (...) {
+      // leave the error to the evaluation, as before
+      return false;
+    }
+    in.kind = iConstant;
+    in.operation = eTopLevel;
+    in.operands = 0;
+    code.resize(start);
+    code.push_back(in);
+  }
+
+  return constant;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The number of operands the compiled operation takes, or zero when the
+// function is to be evaluated through the tree.
+
+unsigned int FGFunction::CompiledOperands(void) const
+{
+  unsigned int n = Parameters.size();
+
+  switch (Type) {
+  case eProduct:
+  case eDifference:
+  case eSum:
+  case eMin:
+  case eMax:
+  case eAvg:
+    return n;
+  case eExp:
+  case eLog2:
+  case eLn:
+  case eLog10:
+  case eAbs:
+  case eSign:
+  case eSin:
+  case eCos:
+  case eTan:
+  case eASin:
+  case eACos:
+  case eATan:
+  case eFrac:
+  case eInteger:
+  case eNOT:
+    return n < 1 ? 0 : 1;
+  case eQuotient:
+  case ePow:
+  case eATan2:
+  case eMod:
+  case eLT:
+  case eLE:
+  case eGT:
+  case eGE:
+  case eEQ:
+  case eNE:
+    return n < 2 ? 0 : 2;
+  default:
+    return 0;
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGFunction::StackDepth(const Instruction* code, const Instruction* end)
+{
+  unsigned int depth = 0, maxDepth = 1;
+
+  for (; code != end; ++code) {
+    if (code->kind == iOperation) depth -= code->operands - 1;
+    else depth++;
+    if (depth > maxDepth) maxDepth = depth;
+  }
+
+  return maxDepth;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGFunction::Run(const Instruction* code, const Instruction* end, double* stack) const
+{
+  double* top = stack; // first free entry
+
+  for (; code != end; ++code) {
+    switch (code->kind) {
+    case iConstant:
+      *top++ = code->value;
+      break;
+    case iProperty:
+      *top++ = code->node->getDoubleValue();
+      break;
+    case iParameter:
+      *top++ = code->parameter->GetValue();
+      break;
+    case iOperation:
+      top -= code->operands;
+      *top = Apply(code->operation, top, code->operands);
+      top++;
+      break;
+    }
+  }
+
+  return stack[0];
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The compiled operations, with the same results as GetValue().
+
+double FGFunction::Apply(functionType operation, const double* args, unsigned int n) const
+{
+  unsigned int i;
+  double scratch;
+  double temp = args[0];
+
+  switch (operation) {
+  case eProduct:
+    for (i=1;i<n;i++) temp *= args[i];
+    break;
+  case eDifference:
+    for (i=1;i<n;i++) temp -= args[i];
+    break;
+  case eSum:
+    for (i=1;i<n;i++) temp += args[i];
+    break;
+  case eQuotient:
+    if (args[1] != 0.0) temp /= args[1];
+    else temp = HUGE_VAL;
+    break;
+  case ePow:
+    temp = pow(temp,args[1]);
+    break;
+  case eExp:
+    temp = exp(temp);
+    break;
+  case eLog2:
+    if (temp > 0.00) temp = log10(temp)*invlog2val;
+    else temp = -HUGE_VAL;
+    break;
+  case eLn:
+    if (temp > 0.00) temp = log(temp);
+    else temp = -HUGE_VAL;
+    break;
+  case eLog10:
+    if (temp > 0.00) temp = log10(temp);
+    else temp = -HUGE_VAL;
+    break;
+  case eAbs:
+    temp = fabs(temp);
+    break;
+  case eSign:
+    temp =  temp < 0 ? -1:1; // 0.0 counts as positive.
+    break;
+  case eSin:
+    temp = sin(temp);
+    break;
+  case eCos:
+    temp = cos(temp);
+    break;
+  case eTan:
+    temp = tan(temp);
+    break;
+  case eACos:
+    temp = acos(temp);
+    break;
+  case eASin:
+    temp = asin(temp);
+    break;
+  case eATan:
+    temp = atan(temp);
+    break;
+  case eATan2:
+    temp = atan2(temp, args[1]);
+    break;
+  case eMod:
+    temp = ((int)temp) % ((int) args[1]);
+    break;
+  case eMin:
+    for (i=1;i<n;i++) {
+      if (args[i] < temp) temp = args[i];
+    }
+    break;
+  case eMax:
+    for (i=1;i<n;i++) {
+      if (args[i] > temp) temp = args[i];
+    }
+    break;
+  case eAvg:
+    for (i=1;i<n;i++) temp += args[i];
+    temp /= n;
+    break;
+  case eFrac:
+    temp = modf(temp, &scratch);
+    break;
+  case eInteger:
+    modf(temp, &scratch);
+    temp = scratch;
+    break;
+  case eLT:
+    temp = (temp < args[1])?1:0;
+    break;
+  case eLE:
+    temp = (temp <= args[1])?1:0;
+    break;
+  case eGT:
+    temp = (temp > args[1])?1:0;
+    break;
+  case eGE:
+    temp = (temp >= args[1])?1:0;
+    break;
+  case eEQ:
+    temp = (temp == args[1])?1:0;
+    break;
+  case eNE:
+    temp = (temp != args[1])?1:0;
+    break;
+  case eNOT:
+    temp = (GetBinary(temp) != 0) ? 0 : 1;
+    break;
+  default:
+    cerr << "Unknown compiled function operation type" << endl;
+    break;
+  }
+
+  return temp;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 string FGFunction::GetValueAsString(void) const
@@ -155,6 +155,15 @@ an operation (such as sum) which can contain other items. The point to keep in
 mind is that it evaluates to a single value - which is just what the trigonometric
 functions require (except atan2, which takes two arguments).
 
+When a top level function has been read, its operand tree is compiled into a
+flat postfix program, which GetValue() runs on a small value stack. Subtrees
+made of values only are evaluated once, at that time, and properties which
+exist at load time are read straight from their nodes. Tables, properties bound
+late and the operations which evaluate their arguments selectively (and, or,
+ifthen, switch, interpolate1d, random, urandom and the rotations) are still
+evaluated through the tree. Setting the environment variable
+JSBSIM_COMPILE_FUNCTIONS to 0 disables the compilation.
+
 @author Jon Berndt
 */
 
@@ -272,6 +281,27 @@ private:
                      eIfThen, eSwitch, eInterpolate1D, eRotation_alpha_local,
                      eRotation_beta_local, eRotation_gamma_local, eRotation_bf_to_wf,
                      eRotation_wf_to_bf} Type;
+
+  // Compiled form of a top level function: a postfix program in which each
+  // operation replaces its operands on the stack by its result.
+  enum instructionType {iConstant, iProperty, iParameter, iOperation};
+  struct Instruction {
+    instructionType kind;
+    functionType operation;       // iOperation
+    unsigned int operands;        // iOperation
+    double value;                 // iConstant
+    FGPropertyManager* node;      // iProperty
+    const FGParameter* parameter; // iParameter
+  };
+  std::vector<Instruction> Program;
+  mutable std::vector<double> Stack;
+
+  void Compile(void);
+  bool Compile(const FGParameter* parameter, std::vector<Instruction>& code) const;
+  unsigned int CompiledOperands(void) const;
+  double Run(const Instruction* code, const Instruction* end, double* stack) const;
+  double Apply(functionType operation, const double* args, unsigned int n) const;
+  static unsigned int StackDepth(const Instruction* code, const Instruction* end);
   std::string Name;
   std::string sCopyTo;        // Property name to copy function value to
   FGPropertyManager* pCopyTo; // Property node for CopyTo property string
@@ -72,6 +72,8 @@ public:
 
   double GetValue(void) const;
   void SetNode(FGPropertyManager* node) {PropertyNode = node;} 
+  /// The property node, or 0L while it is still to be bound late.
+  FGPropertyManager* GetNode(void) const {return PropertyNode;}
 
   std::string GetName(void) const;
 
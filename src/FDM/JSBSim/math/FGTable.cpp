@@ -42,6 +42,8 @@ INCLUDES
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
+#include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -355,13 +357,16 @@ FGTable::FGTable(FGPropertyManager* propMan, Element* el) : PropertyManager(prop
 
 double** FGTable::Allocate(void)
 {
+  // a single block, row after row, so that neighbouring rows share cache lines
   Data = new double*[nRows+1];
+  Data[0] = new double[(nRows+1)*(nCols+1)];
   for (unsigned int r=0; r<=nRows; r++) {
-    Data[r] = new double[nCols+1];
+    Data[r] = Data[0] + r*(nCols+1);
     for (unsigned int c=0; c<=nCols; c++) {
       Data[r][c] = 0.0;
     }
   }
+  breakpointsValid = false;
   return Data;
 }
 
@@ -373,7 +378,7 @@ FGTable::~FGTable()
     for (unsigned int i=0; i<nTables; i++) delete Tables[i];
     Tables.clear();
   }
-  for (unsigned int r=0; r<=nRows; r++) delete[] Data[r];
+  delete[] Data[0];
   delete[] Data;
 
   Debug(1);
@@ -420,10 +425,83 @@ double FGTable::GetValue(void) const
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+void FGTable::UpdateBreakpoints(void) const
+{
+  // the keys of a 3D table are the breakpoints of its 2D tables
+  unsigned int keyColumn = (Type == tt3D) ? 1 : 0;
+
+  rowBreakpoints.keys.resize(nRows+1);
+  for (unsigned int r=1; r<=nRows; r++) rowBreakpoints.keys[r] = Data[r][keyColumn];
+  rowBreakpoints.Update();
+
+  if (Type == tt2D) {
+    columnBreakpoints.keys.assign(Data[0], Data[0]+nCols+1);
+    columnBreakpoints.Update();
+  }
+
+  breakpointsValid = true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGTable::Breakpoints::Update(void)
+{
+  unsigned int n = keys.size()-1;
+  uniform = false;
+  if (n < 3) return;
+
+  // Roughly even spacing is good enough, the index computed in Find() is
+  // corrected by the search anyway
+  double step = (keys[n] - keys[1])/(n-1);
+  if (!(step > 0.0)) return;
+  for (unsigned int i=2; i<n; i++) {
+    if (fabs(keys[i] - (keys[1] + (i-1)*step)) > 0.25*step) return;
+  }
+
+  first = keys[1];
+  inverseStep = 1.0/step;
+  uniform = true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Returns the index r of the interval between keys r-1 and r which holds the
+// key, in [2, n].
+
+unsigned int FGTable::Breakpoints::Find(double key, unsigned int hint) const
+{
+  unsigned int n = keys.size()-1;
+  if (n < 2) return 2;
+
+  const double* k = &keys[0];
+  unsigned int r;
+
+  if (uniform) {
+    double x = (key - first)*inverseStep;
+    if (!(x >= 0.0)) r = 2;
+    else if (x >= n-2) r = n;
+    else r = 2 + (unsigned int)x;
+  } else if (hint >= 2 && hint <= n && k[hint-1] <= key && key <= k[hint]) {
+    return hint;
+  } else {
+    r = upper_bound(k+1, k+n+1, key) - k;
+    if (r < 2) r = 2;
+    else if (r > n) r = n;
+  }
+
+  while (r > 2 && k[r-1] > key) { r--; }
+  while (r < n && k[r]   < key) { r++; }
+
+  return r;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 double FGTable::GetValue(double key) const
 {
   double Factor, Value, Span;
-  unsigned int r = lastRowIndex;
+  unsigned int r;
+
+  if (!breakpointsValid) UpdateBreakpoints();
 
   //if the key is off the end of the table, just return the
   //end-of-table value, do not extrapolate
@@ -438,12 +516,8 @@ double FGTable::GetValue(double key) const
   }
 
   // the key is somewhere in the middle, search for the right breakpoint
-  // The search is particularly efficient if 
-  // the correct breakpoint has not changed since last frame or
-  // has only changed very little
 
-  while (r > 2     && Data[r-1][0] > key) { r--; }
-  while (r < nRows && Data[r][0]   < key) { r++; }
+  r = rowBreakpoints.Find(key, lastRowIndex);
 
   lastRowIndex=r;
   // make sure denominator below does not go to zero.
@@ -466,14 +540,11 @@ double FGTable::GetValue(double key) const
 double FGTable::GetValue(double rowKey, double colKey) const
 {
   double rFactor, cFactor, col1temp, col2temp, Value;
-  unsigned int r = lastRowIndex;
-  unsigned int c = lastColumnIndex;
 
-  while(r > 2     && Data[r-1][0] > rowKey) { r--; }
-  while(r < nRows && Data[r]  [0] < rowKey) { r++; }
+  if (!breakpointsValid) UpdateBreakpoints();
 
-  while(c > 2     && Data[0][c-1] > colKey) { c--; }
-  while(c < nCols && Data[0][c]   < colKey) { c++; }
+  unsigned int r = rowBreakpoints.Find(rowKey, lastRowIndex);
+  unsigned int c = columnBreakpoints.Find(colKey, lastColumnIndex);
 
   lastRowIndex=r;
   lastColumnIndex=c;
@@ -500,7 +571,9 @@ double FGTable::GetValue(double rowKey, double colKey) const
 double FGTable::GetValue(double rowKey, double colKey, double tableKey) const
 {
   double Factor, Value, Span;
-  unsigned int r = lastRowIndex;
+  unsigned int r;
+
+  if (!breakpointsValid) UpdateBreakpoints();
 
   //if the key is off the end  (or before the beginning) of the table,
   // just return the boundary-table value, do not extrapolate
@@ -514,12 +587,8 @@ double FGTable::GetValue(double rowKey, double colKey, double tableKey) const
   }
 
   // the key is somewhere in the middle, search for the right breakpoint
-  // The search is particularly efficient if 
-  // the correct breakpoint has not changed since last frame or
-  // has only changed very little
 
-  while(r > 2     && Data[r-1][1] > tableKey) { r--; }
-  while(r < nRows && Data[r]  [1] < tableKey) { r++; }
+  r = rowBreakpoints.Find(tableKey, lastRowIndex);
 
   lastRowIndex=r;
   // make sure denominator below does not go to zero.
@@ -532,12 +601,118 @@ double FGTable::GetValue(double rowKey, double colKey, double tableKey) const
     Factor = 1.0;
   }
 
-  Value = Factor*(Tables[r-1]->GetValue(rowKey, colKey) - Tables[r-2]->GetValue(rowKey, colKey))
-                              + Tables[r-2]->GetValue(rowKey, colKey);
+  double lower = Tables[r-2]->GetValue(rowKey, colKey);
+  Value = Factor*(Tables[r-1]->GetValue(rowKey, colKey) - lower) + lower;
 
   return Value;
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// The keys are processed in blocks: first the breakpoints and weights of all
+// keys of a block are found, then the values are interpolated in a loop
+// without branches, which the compiler is free to vectorize.
+
+static const unsigned int BlockSize = 64;
+
+void FGTable::GetValues(const double* keys, double* values, unsigned int n) const
+{
+  unsigned int lower[BlockSize], upper[BlockSize];
+  double factor[BlockSize];
+
+  if (!breakpointsValid) UpdateBreakpoints();
+
+  const double* k = &rowBreakpoints.keys[0];
+  const double* v = Data[0] + 1; // the values, nCols+1 apart
+  unsigned int stride = nCols+1;
+  unsigned int r = lastRowIndex;
+
+  for (unsigned int start=0; start<n; start+=BlockSize) {
+    unsigned int count = min(BlockSize, n-start);
+
+    for (unsigned int i=0; i<count; i++) {
+      double key = keys[start+i];
+      // off the ends of the table: the end values, as GetValue(key)
+      if (key <= k[1]) {
+        lower[i] = upper[i] = 1;
+        factor[i] = 0.0;
+      } else if (key >= k[nRows]) {
+        lower[i] = upper[i] = nRows;
+        factor[i] = 0.0;
+      } else {
+        r = rowBreakpoints.Find(key, r);
+        double Span = k[r] - k[r-1];
+        double Factor = 1.0;
+        if (Span != 0.0) {
+          Factor = (key - k[r-1]) / Span;
+          if (Factor > 1.0) Factor = 1.0;
+        }
+        lower[i] = r-1;
+        upper[i] = r;
+        factor[i] = Factor;
+      }
+    }
+
+    for (unsigned int i=0; i<count; i++) {
+      double a = v[lower[i]*stride];
+      double b = v[upper[i]*stride];
+      values[start+i] = factor[i]*(b - a) + a;
+    }
+  }
+
+  lastRowIndex = r;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGTable::GetValues(const double* rowKeys, const double* colKeys,
+                        double* values, unsigned int n) const
+{
+  unsigned int row[BlockSize], col[BlockSize];
+  double rowFactor[BlockSize], colFactor[BlockSize];
+
+  if (!breakpointsValid) UpdateBreakpoints();
+
+  const double* rk = &rowBreakpoints.keys[0];
+  const double* ck = &columnBreakpoints.keys[0];
+  unsigned int stride = nCols+1;
+  unsigned int r = lastRowIndex;
+  unsigned int c = lastColumnIndex;
+
+  for (unsigned int start=0; start<n; start+=BlockSize) {
+    unsigned int count = min(BlockSize, n-start);
+
+    for (unsigned int i=0; i<count; i++) {
+      r = rowBreakpoints.Find(rowKeys[start+i], r);
+      c = columnBreakpoints.Find(colKeys[start+i], c);
+
+      double rFactor = (rowKeys[start+i] - rk[r-1]) / (rk[r] - rk[r-1]);
+      double cFactor = (colKeys[start+i] - ck[c-1]) / (ck[c] - ck[c-1]);
+
+      if (rFactor > 1.0) rFactor = 1.0;
+      else if (rFactor < 0.0) rFactor = 0.0;
+
+      if (cFactor > 1.0) cFactor = 1.0;
+      else if (cFactor < 0.0) cFactor = 0.0;
+
+      row[i] = r;
+      col[i] = c;
+      rowFactor[i] = rFactor;
+      colFactor[i] = cFactor;
+    }
+
+    for (unsigned int i=0; i<count; i++) {
+      const double* upperRow = Data[0] + row[i]*stride + col[i];
+      const double* lowerRow = upperRow - stride;
+      double col1temp = rowFactor[i]*(upperRow[-1] - lowerRow[-1]) + lowerRow[-1];
+      double col2temp = rowFactor[i]*(upperRow[0] - lowerRow[0]) + lowerRow[0];
+      values[start+i] = col1temp + colFactor[i]*(col2temp - col1temp);
+    }
+  }
+
+  lastRowIndex = r;
+  lastColumnIndex = c;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 void FGTable::operator<<(istream& in_stream)
@@ -555,6 +730,7 @@ void FGTable::operator<<(istream& in_stream)
       }
     }
   }
+  breakpointsValid = false;
 }
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -564,6 +740,7 @@ void FGTable::operator<<(istream& in_stream)
 FGTable& FGTable::operator<<(const double n)
 {
   Data[rowCounter][colCounter] = n;
+  breakpointsValid = false;
   if (colCounter == (int)nCols) {
     colCounter = 0;
     rowCounter++;
@@ -258,6 +258,17 @@ public:
   double GetValue(double key) const;
   double GetValue(double rowKey, double colKey) const;
   double GetValue(double rowKey, double colKey, double TableKey) const;
+  /** Looks up a number of keys in a one dimensional table at once, with the
+      same results as GetValue(key) for each key. The breakpoints are searched
+      for all keys first, so that the interpolation is a single tight loop.
+      @param keys the row keys
+      @param values receives the interpolated values
+      @param n the number of keys */
+  void GetValues(const double* keys, double* values, unsigned int n) const;
+  /** Looks up a number of key pairs in a two dimensional table at once, with
+      the same results as GetValue(rowKeys[i], colKeys[i]) for each pair. */
+  void GetValues(const double* rowKeys, const double* colKeys, double* values,
+                 unsigned int n) const;
   /** Read the table in.
       Data in the config file should be in matrix format with the row
       independents as the first column and the column independents in
@@ -304,11 +315,25 @@ private:
   enum axis {eRow=0, eColumn, eTable};
   bool internal;
   FGPropertyManager *lookupProperty[3];
-  double** Data;
+  double** Data; // row pointers into a single block
   std::vector <FGTable*> Tables;
   unsigned int nRows, nCols, nTables, dimension;
   int colCounter, rowCounter, tableCounter;
   mutable int lastRowIndex, lastColumnIndex, lastTableIndex;
+
+  // The keys of a table axis, packed for searching. Evenly spaced keys
+  // are indexed directly, others are searched from the last index found
+  // and then by bisection.
+  struct Breakpoints {
+    std::vector<double> keys; // indexed as the rows or columns of Data
+    double first, inverseStep;
+    bool uniform;
+    void Update(void);
+    unsigned int Find(double key, unsigned int hint) const;
+  };
+  mutable Breakpoints rowBreakpoints, columnBreakpoints;
+  mutable bool breakpointsValid;
+  void UpdateBreakpoints(void) const;
   double** Allocate(void);
   FGPropertyManager* const PropertyManager;
   std::string Name;
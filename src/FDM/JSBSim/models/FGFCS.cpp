@@ -574,10 +574,10 @@ bool FGFCS::Load(Element* el, SystemType systype)
              << "understood. The simulation will abort" << reset << endl;
         throw("Bad system definition");
       } else {
-        newChannel = new FGFCSChannel(OnOffPropertyNode);
+        newChannel = new FGFCSChannel(OnOffPropertyNode, FDMExec->GetProfiler());
       }
     } else {
-      newChannel = new FGFCSChannel();
+      newChannel = new FGFCSChannel(0, FDMExec->GetProfiler());
     }
 
     SystemChannels.push_back(newChannel);
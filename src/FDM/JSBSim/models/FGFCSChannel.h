@@ -40,6 +40,8 @@ INCLUDES
 
 #include <iostream>
 
+#include "input_output/FGProfiler.h"
+
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 DEFINITIONS
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
@@ -69,9 +71,11 @@ typedef std::vector <FGFCSComponent*> FCSCompVec;
 
 class FGFCSChannel {
 public:
-  /// Constructor
-  FGFCSChannel(FGPropertyManager* node=0) :
-  OnOffNode(node)
+  /** Constructor
+      @param node the on/off property of the channel, if any
+      @param profiler the profiler which times the components, if any */
+  FGFCSChannel(FGPropertyManager* node=0, FGProfiler* profiler=0) :
+  OnOffNode(node), Profiler(profiler)
   {
   }
   /// Destructor
@@ -80,7 +84,11 @@ public:
     FCSComponents.clear();
   }
   /// Adds a component to a channel
-  void Add(FGFCSComponent* comp) {FCSComponents.push_back(comp);}
+  void Add(FGFCSComponent* comp) {
+    FCSComponents.push_back(comp);
+    if (Profiler != 0)
+      Probes.push_back(Profiler->AddProbe(FGProfiler::eComponent, comp->GetName()));
+  }
   /// Returns the number of components in the channel.
   unsigned int GetNumComponents() {return FCSComponents.size();}
   /// Retrieves a specific component.
@@ -115,12 +123,23 @@ public:
     if (OnOffNode != 0)
       if (!OnOffNode->getBoolValue()) return;
 
+    if (Profiler != 0 && Profiler->IsEnabled()) {
+      for (unsigned int i=0; i<FCSComponents.size(); i++) {
+        SGTimeStamp start = SGTimeStamp::now();
+        FCSComponents[i]->Run();
+        Profiler->Record(Probes[i], start);
+      }
+      return;
+    }
+
     for (unsigned int i=0; i<FCSComponents.size(); i++) FCSComponents[i]->Run();
   }
 
   private:
     FCSCompVec FCSComponents;
     const FGPropertyManager* OnOffNode;
+    FGProfiler* Profiler;
+    std::vector<unsigned int> Probes; // profiler probe of each component
 };
 
 }
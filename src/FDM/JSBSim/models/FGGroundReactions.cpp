@@ -42,6 +42,7 @@ INCLUDES
 #include "FGLGear.h"
 #include "FGAccelerations.h"
 #include "input_output/FGPropertyManager.h"
+#include "input_output/FGGroundCallback.h"
 
 using namespace std;
 
@@ -94,6 +95,19 @@ bool FGGroundReactions::Run(bool Holding)
 
   multipliers.clear();
 
+  // Give the ground callback the chance to look up the ground below all the
+  // gear units at once, rather than one at a time from FGLGear.
+  FGGroundCallback* groundCallback = FGLocation::GetGroundCallback();
+  if (groundCallback) {
+    vGearLocations.clear();
+    for (unsigned int i=0; i<lGear.size(); i++) {
+      FGLocation gearLoc;
+      if (lGear[i]->GetWheelLocation(gearLoc)) vGearLocations.push_back(gearLoc);
+    }
+    if (!vGearLocations.empty())
+      groundCallback->PrefetchAGLevel(FDMExec->GetSimTime(), vGearLocations);
+  }
+
   // Sum forces and moments for all gear, here.
   // Some optimizations may be made here - or rather in the gear code itself.
   // The gear ::Run() method is called several times - once for each gear.
@@ -120,6 +120,7 @@ private:
   FGColumnVector3 vForces;
   FGColumnVector3 vMoments;
   vector <LagrangeMultiplier*> multipliers;
+  vector <FGLocation> vGearLocations;
 
   void bind(void);
   void Debug(int from);
@@ -309,7 +309,7 @@ const FGColumnVector3& FGLGear::GetBodyForces(void)
 
       vWhlVelVec = mTGear.Transposed() * vBodyWhlVel;
 
-      InitializeReporting();
+      if (!in.StageEvaluation) InitializeReporting();
       ComputeSteeringAngle();
       ComputeGroundFrame();
 
@@ -355,7 +355,7 @@ const FGColumnVector3& FGLGear::GetBodyForces(void)
       // Return to neutral position between 1.0 and 0.8 gear pos.
       SteerAngle *= max(gearPos-0.8, 0.0)/0.2;
 
-      ResetReporting();
+      if (!in.StageEvaluation) ResetReporting();
     }
   }
   else if (gearPos < 0.01) { // Gear UP
@@ -363,7 +363,9 @@ const FGColumnVector3& FGLGear::GetBodyForces(void)
     vWhlVelVec.InitMatrix();
   }
 
-  if (!fdmex->GetTrimStatus()) {
+  // The reports and the crash detection look at the state of the frame, not
+  // at the trial states of the integrator stages.
+  if (!fdmex->GetTrimStatus() && !in.StageEvaluation) {
     ReportTakeoffOrLanding();
 
     // Require both WOW and LastWOW to be true before checking crash conditions
@@ -376,6 +378,17 @@ const FGColumnVector3& FGLGear::GetBodyForces(void)
   return FGForce::GetBodyForces();
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGLGear::GetWheelLocation(FGLocation& loc) const
+{
+  if (isRetractable && GetGearUnitPos() <= 0.99) return false;
+
+  FGColumnVector3 vWhlBodyVec = Ts2b * (vXYZn - in.vXYZcg);
+  loc = in.Location.LocalToLocation(in.Tb2l * vWhlBodyVec);
+  return true;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 // Build a local "ground" coordinate system defined by
 //  eX : projection of the rolling direction on the ground
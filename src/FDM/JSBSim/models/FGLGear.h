@@ -213,6 +213,7 @@ public:
     std::vector <double> BrakePos;
     double FCSGearPos;
     double EmptyWeight;
+    bool StageEvaluation; // run at an intermediate stage of the state integrator
   };
 
   /// Brake grouping enumerators
@@ -248,6 +249,12 @@ public:
     return vWhlBodyVec(idx);
   }
 
+  /** Gets the location of the uncompressed wheel, as used by GetBodyForces()
+      to query the ground.
+      @param loc the wheel location
+      @return false if the gear is not down, no ground query is made then */
+  bool GetWheelLocation(FGLocation& loc) const;
+
   const FGColumnVector3& GetLocalGear(void) const { return vLocalGear; }
   double GetLocalGear(int idx) const { return vLocalGear(idx); }
 
@@ -43,6 +43,7 @@ INCLUDES
 #include "FGFDMExec.h"
 #include "input_output/FGOutputSocket.h"
 #include "input_output/FGOutputTextFile.h"
+#include "input_output/FGOutputBinaryFile.h"
 #include "input_output/FGOutputFG.h"
 
 using namespace std;
@@ -222,6 +223,8 @@ bool FGOutput::Load(int subSystems, std::string protocol, std::string type,
     FGOutputTextFile* OutputTextFile = new FGOutputTextFile(FDMExec);
     OutputTextFile->SetDelimiter("\t");
     Output = OutputTextFile;
+  } else if (type == "BINARY") {
+    Output = new FGOutputBinaryFile(FDMExec);
   } else if (type == "SOCKET") {
     Output = new FGOutputSocket(FDMExec);
     name += ":" + port + "/" + protocol;
@@ -264,6 +267,8 @@ bool FGOutput::Load(Element* document)
     Output = new FGOutputTextFile(FDMExec);
   } else if (type == "TABULAR") {
     Output = new FGOutputTextFile(FDMExec);
+  } else if (type == "BINARY") {
+    Output = new FGOutputBinaryFile(FDMExec);
   } else if (type == "SOCKET") {
     Output = new FGOutputSocket(FDMExec);
   } else if (type == "FLIGHTGEAR") {
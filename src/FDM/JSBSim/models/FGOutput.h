@@ -79,6 +79,8 @@ CLASS DOCUMENTATION
                   an external instance of FlightGear for visuals.  Parameters
                   defining the socket are given on the \<output> line.
       TABULAR     Columnar data.
+      BINARY      Unformatted data, written from a background thread; only the
+                  listed properties are recorded. See FGOutputBinaryFile.
       TERMINAL    Output to terminal. NOT IMPLEMENTED YET!
       NONE        Specifies to do nothing. This setting makes it easy to turn on and
                   off the data output without having to mess with anything else.
@@ -58,6 +58,10 @@ COMMENTS, REFERENCES,  and NOTES
 [8] Phillips W.F, Hailey C.E and Gebert G.A, "Review of Attitude Representations
     Used for Aircraft Kinematics", Journal Of Aircraft Vol. 38, No. 4,
     July-August 2001
+[9] J.R. Dormand and P.J. Prince, "A family of embedded Runge-Kutta formulae",
+    Journal of Computational and Applied Mathematics Vol. 6, No. 1, 1980
+[10] E. Hairer, S.P. Norsett and G. Wanner, "Solving Ordinary Differential
+    Equations I, Nonstiff Problems", Springer, 2nd edition 1993
 
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 INCLUDES
@@ -98,6 +102,11 @@ FGPropagate::FGPropagate(FGFDMExec* fdmex)
   integrator_translational_rate = eAdamsBashforth2;
   integrator_rotational_position = eRectEuler;
   integrator_translational_position = eAdamsBashforth3;
+  integrator_state = eNone;
+  integrator_tolerance = 1E-3;
+  integrator_max_substeps = 16;
+  integrator_substeps = 0;
+  integrator_step = 0.0;
 
   VState.dqPQRidot.resize(4, FGColumnVector3(0.0,0.0,0.0));
   VState.dqUVWidot.resize(4, FGColumnVector3(0.0,0.0,0.0));
@@ -132,6 +141,9 @@ bool FGPropagate::InitModel(void)
   integrator_translational_rate = eAdamsBashforth2;
   integrator_rotational_position = eRectEuler;
   integrator_translational_position = eAdamsBashforth3;
+  integrator_state = eNone;
+  integrator_substeps = 0;
+  integrator_step = 0.0;
 
   return true;
 }
@@ -219,6 +231,11 @@ bool FGPropagate::Run(bool Holding)
 
   double dt = in.DeltaT * rate;  // The 'stepsize'
 
+  if (integrator_state != eNone && IntegrateState(dt)) {
+    Debug(2);
+    return false;
+  }
+
   // Propagate rotational / translational velocity, angular /translational position, respectively.
 
   Integrate(VState.qAttitudeECI,      in.vQtrndot,          VState.dqQtrndot,          dt, integrator_rotational_position);
@@ -226,11 +243,24 @@ bool FGPropagate::Run(bool Holding)
   Integrate(VState.vInertialPosition, VState.vInertialVelocity, VState.dqInertialVelocity, dt, integrator_translational_position);
   Integrate(VState.vInertialVelocity, in.vUVWidot,          VState.dqUVWidot,          dt, integrator_translational_rate);
 
+  UpdateFromInertialState(in.vOmegaPlanet(eZ)*dt);
+
+  Debug(2);
+  return false;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Update the location, the transformation matrices and the auxiliary state
+// variables from the inertial position, velocity, attitude and angular rate,
+// after the Earth has turned by dEPA.
+
+void FGPropagate::UpdateFromInertialState(double dEPA)
+{
   // CAUTION : the order of the operations below is very important to get transformation
   // matrices that are consistent with the new state of the vehicle
 
   // 1. Update the Earth position angle (EPA)
-  VState.vLocation.IncrementEarthPositionAngle(in.vOmegaPlanet(eZ)*(in.DeltaT*rate));
+  VState.vLocation.IncrementEarthPositionAngle(dEPA);
 
   // 2. Update the Ti2ec and Tec2i transforms from the updated EPA
   Ti2ec = VState.vLocation.GetTi2ec(); // ECI to ECEF transform
@@ -260,9 +290,228 @@ bool FGPropagate::Run(bool Holding)
 
   // Compute vehicle velocity wrt ECEF frame, expressed in Local horizontal frame.
   vVel = Tb2l * VState.vUVW;
+}
 
-  Debug(2);
-  return false;
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+/*
+The state integrators advance the attitude, angular rate, position and velocity
+together, with the classical Runge-Kutta 4 (one step per frame) or the
+Dormand-Prince 5(4) pair of ref. [9] (adaptive substeps). The derivatives at
+the intermediate stages are evaluated by FGFDMExec::EvaluateStateDerivatives(),
+which runs the ground reactions and the accelerations again at the stage state:
+the gear forces, which make the stiffest part of the dynamics, follow the state
+within the frame while the other forces are held.
+
+The first stage is the derivative loaded in the inputs, computed at the end of
+the previous frame. The Dormand-Prince pair evaluates its last stage at the
+new state ("first same as last"), which becomes the first stage of the next
+substep. The step size control is the one of ref. [10], section II.4.
+*/
+
+bool FGPropagate::IntegrateState(double dt)
+{
+  static const double rk4_a[4][7] = {
+    {0.0},
+    {0.5},
+    {0.0, 0.5},
+    {0.0, 0.0, 1.0}
+  };
+  static const double rk4_b[4] = { 1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0 };
+
+  static const double dp_a[7][7] = {
+    {0.0},
+    {1.0/5.0},
+    {3.0/40.0, 9.0/40.0},
+    {44.0/45.0, -56.0/15.0, 32.0/9.0},
+    {19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0},
+    {9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0},
+    {35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0}
+  };
+  static const double dp_b[7] = { 35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0,
+                                  -2187.0/6784.0, 11.0/84.0, 0.0 };
+  // Difference between the 5th and the embedded 4th order solutions
+  static const double dp_e[7] = { 71.0/57600.0, 0.0, -71.0/16695.0, 71.0/1920.0,
+                                  -17253.0/339200.0, 22.0/525.0, -1.0/40.0 };
+
+  if (dt <= 0.0) return false;
+
+  FGLocation location0 = VState.vLocation;
+  IntegratedState y0, y, y1;
+  y0.qAttitudeECI = VState.qAttitudeECI;
+  y0.vPQRi = VState.vPQRi;
+  y0.vInertialPosition = VState.vInertialPosition;
+  y0.vInertialVelocity = VState.vInertialVelocity;
+  y = y0;
+
+  StateDot k[7];
+  k[0].vQtrndot = in.vQtrndot;
+  k[0].vPQRidot = in.vPQRidot;
+  k[0].vInertialVelocity = VState.vInertialVelocity;
+  k[0].vUVWidot = in.vUVWidot;
+
+  // Keep the past derivatives up to date, so that the multistep integrators
+  // can take over at any time.
+  VState.dqQtrndot.push_front(in.vQtrndot);
+  VState.dqPQRidot.push_front(in.vPQRidot);
+  VState.dqInertialVelocity.push_front(VState.vInertialVelocity);
+  VState.dqUVWidot.push_front(in.vUVWidot);
+
+  bool ok = true;
+  integrator_substeps = 0;
+
+  if (integrator_state == eRungeKutta4) {
+    ok = RungeKuttaStep(y0, 0.0, dt, 4, rk4_a, rk4_b, 0, location0, k, y) >= 0.0;
+    integrator_substeps = 1;
+  }
+  else {
+    int max_substeps = integrator_max_substeps > 1 ? integrator_max_substeps : 1;
+    double hmin = dt / max_substeps;
+    double h = integrator_step > 0.0 ? integrator_step : dt;
+    double t = 0.0;
+
+    while (ok && dt - t > 1E-9*dt) {
+      double remaining = dt - t;
+      double step = h > hmin ? h : hmin;
+      if (step > remaining) step = remaining;
+
+      double err = RungeKuttaStep(y, t, step, 7, dp_a, dp_b, dp_e, location0, k, y1);
+      if (err < 0.0) {
+        ok = false;
+        break;
+      }
+
+      double factor = err > 0.0 ? 0.9*pow(err, -0.2) : 5.0;
+      factor = Constrain(0.2, factor, 5.0);
+
+      // At the smallest step allowed by max-substeps the step is accepted
+      // whatever its error.
+      if (err <= 1.0 || step <= hmin) {
+        t += step;
+        y = y1;
+        k[0] = k[6];
+        integrator_substeps++;
+        // A step shortened to end the frame says little about the next one.
+        if (step < h && err <= 1.0) {
+          if (step*factor > h) h = step*factor;
+        }
+        else
+          h = step*factor;
+      }
+      else
+        h = step*factor;
+    }
+
+    integrator_step = h < dt ? h : dt;
+  }
+
+  if (!ok) {
+    // The stage derivatives are not available: restore the state, the caller
+    // falls back to the separate integrators.
+    VState.dqQtrndot.pop_front();
+    VState.dqPQRidot.pop_front();
+    VState.dqInertialVelocity.pop_front();
+    VState.dqUVWidot.pop_front();
+    y = y0;
+    integrator_substeps = 0;
+  }
+  else {
+    VState.dqQtrndot.pop_back();
+    VState.dqPQRidot.pop_back();
+    VState.dqInertialVelocity.pop_back();
+    VState.dqUVWidot.pop_back();
+  }
+
+  VState.qAttitudeECI = y.qAttitudeECI;
+  VState.qAttitudeECI.Normalize();
+  VState.vPQRi = y.vPQRi;
+  VState.vInertialPosition = y.vInertialPosition;
+  VState.vInertialVelocity = y.vInertialVelocity;
+  VState.vLocation = location0;
+  UpdateFromInertialState(ok ? in.vOmegaPlanet(eZ)*dt : 0.0);
+
+  return ok;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// One explicit Runge-Kutta step of size h from the state y0 at the time t
+// within the frame, with the Butcher tableau a, b. k[0] holds the derivative
+// at y0 on entry, and the stages on exit. The new state is returned in y1.
+// Returns the error estimate given by the weights e relative to the tolerance
+// (0 if e is null), or a negative value if the derivatives could not be
+// evaluated.
+
+double FGPropagate::RungeKuttaStep(const IntegratedState& y0, double t, double h,
+                                   int stages, const double a[][7], const double* b,
+                                   const double* e, const FGLocation& location0,
+                                   StateDot* k, IntegratedState& y1)
+{
+  IntegratedState y;
+
+  for (int i=1; i<stages; i++) {
+    double c = 0.0;
+    y = y0;
+    for (int j=0; j<i; j++) {
+      double ha = h*a[i][j];
+      if (ha == 0.0) continue;
+      y.qAttitudeECI += ha*k[j].vQtrndot;
+      y.vPQRi += ha*k[j].vPQRidot;
+      y.vInertialPosition += ha*k[j].vInertialVelocity;
+      y.vInertialVelocity += ha*k[j].vUVWidot;
+      c += a[i][j];
+    }
+    if (!EvaluateDerivatives(y, location0, t + c*h, h, k[i])) return -1.0;
+  }
+
+  y1 = y0;
+  for (int j=0; j<stages; j++) {
+    double hb = h*b[j];
+    if (hb == 0.0) continue;
+    y1.qAttitudeECI += hb*k[j].vQtrndot;
+    y1.vPQRi += hb*k[j].vPQRidot;
+    y1.vInertialPosition += hb*k[j].vInertialVelocity;
+    y1.vInertialVelocity += hb*k[j].vUVWidot;
+  }
+
+  if (!e) return 0.0;
+
+  FGColumnVector3 errPQRi, errVelocity;
+  for (int j=0; j<stages; j++) {
+    errPQRi += (h*e[j])*k[j].vPQRidot;
+    errVelocity += (h*e[j])*k[j].vUVWidot;
+  }
+
+  double err = 0.0;
+  for (int i=1; i<=3; i++) {
+    err = max(err, fabs(errPQRi(i)));
+    err = max(err, fabs(errVelocity(i)));
+  }
+
+  return err / integrator_tolerance;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sets the vehicle to the state y at the time t within the frame, and
+// evaluates the derivatives there.
+
+bool FGPropagate::EvaluateDerivatives(const IntegratedState& y,
+                                      const FGLocation& location0,
+                                      double t, double h, StateDot& k)
+{
+  VState.qAttitudeECI = y.qAttitudeECI;
+  VState.qAttitudeECI.Normalize();
+  VState.vPQRi = y.vPQRi;
+  VState.vInertialPosition = y.vInertialPosition;
+  VState.vInertialVelocity = y.vInertialVelocity;
+  VState.vLocation = location0;
+  UpdateFromInertialState(in.vOmegaPlanet(eZ)*t);
+
+  if (!FDMExec->EvaluateStateDerivatives(h)) return false;
+
+  k.vQtrndot = in.vQtrndot;
+  k.vPQRidot = in.vPQRidot;
+  k.vInertialVelocity = VState.vInertialVelocity;
+  k.vUVWidot = in.vUVWidot;
+  return true;
 }
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
@@ -594,6 +843,18 @@ void FGPropagate::DumpState(void)
 
 //******************************************************************************
 
+void FGPropagate::SetStateIntegrator(int type)
+{
+  // Only the Runge-Kutta schemes integrate the whole state, any other value
+  // falls back to the per-component integrators.
+  if (type == eRungeKutta4 || type == eDormandPrince)
+    integrator_state = (eIntegrateType)type;
+  else
+    integrator_state = eNone;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 void FGPropagate::WriteStateFile(int num)
 {
   string filename = FDMExec->GetFullAircraftPath();
@@ -681,6 +942,10 @@ void FGPropagate::bind(void)
   PropertyManager->Tie("simulation/integrator/rate/translational", (int*)&integrator_translational_rate);
   PropertyManager->Tie("simulation/integrator/position/rotational", (int*)&integrator_rotational_position);
   PropertyManager->Tie("simulation/integrator/position/translational", (int*)&integrator_translational_position);
+  PropertyManager->Tie("simulation/integrator/state", this, (iPMF)&FGPropagate::GetStateIntegrator, &FGPropagate::SetStateIntegrator);
+  PropertyManager->Tie("simulation/integrator/tolerance", &integrator_tolerance);
+  PropertyManager->Tie("simulation/integrator/max-substeps", &integrator_max_substeps);
+  PropertyManager->Tie("simulation/integrator/substeps", this, &FGPropagate::GetSubsteps);
 
   PropertyManager->Tie("simulation/write-state-file", this, (iPMF)0, &FGPropagate::WriteStateFile);
 }
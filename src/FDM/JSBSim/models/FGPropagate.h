@@ -92,6 +92,47 @@ CLASS DOCUMENTATION
     5: Adams Bashforth 4
     @endcode
 
+    Alternatively, the complete state (orientation, angular rate, position and
+    velocity) can be integrated at once by a Runge-Kutta scheme, selected with
+
+    @code
+    simulation/integrator/state
+    @endcode
+
+    which takes one of the following values:
+
+    @code
+    0: No state integrator, the four integrators above are used (default)
+    9: Runge-Kutta 4
+    10: Dormand-Prince 5(4), with an adaptive step size
+    @endcode
+
+    Any other value is taken as 0.
+
+    For each stage of a Runge-Kutta step the ground reactions and the
+    accelerations are computed again at the intermediate state, while the
+    aerodynamic, propulsion and FCS outputs are held for the frame. The
+    Dormand-Prince integrator estimates the local error of each step and
+    divides the frame in as many substeps as needed to keep the errors of the
+    translational velocity (ft/sec) and angular rate (rad/sec) below
+
+    @code
+    simulation/integrator/tolerance
+    @endcode
+
+    (1E-3 by default), up to
+
+    @code
+    simulation/integrator/max-substeps
+    @endcode
+
+    per frame (16 by default). The number of substeps of the last frame can be
+    read from simulation/integrator/substeps. This allows a larger frame time
+    in flight, while stiff phases such as the ground contact are still resolved
+    by smaller substeps. The state integrators need the ground reactions, the
+    aircraft and the accelerations models to run every frame; otherwise the
+    four integrators above are used.
+
     @author Jon S. Berndt, Mathias Froehlich, Bertrand Coconnier
     @version $Id: FGPropagate.h,v 1.74 2013/01/19 13:49:37 bcoconni Exp $
   */
@@ -159,7 +200,8 @@ public:
 
   /// These define the indices use to select the various integrators.
   enum eIntegrateType {eNone = 0, eRectEuler, eTrapezoidal, eAdamsBashforth2,
-                       eAdamsBashforth3, eAdamsBashforth4, eBuss1, eBuss2, eLocalLinearization};
+                       eAdamsBashforth3, eAdamsBashforth4, eBuss1, eBuss2, eLocalLinearization,
+                       eRungeKutta4, eDormandPrince};
 
   /** Initializes the FGPropagate class after instantiation and prior to first execution.
       The base class FGModel::InitModel is called first, initializing pointers to the
@@ -583,6 +625,27 @@ private:
   eIntegrateType integrator_translational_rate;
   eIntegrateType integrator_rotational_position;
   eIntegrateType integrator_translational_position;
+  eIntegrateType integrator_state;
+  double integrator_tolerance;
+  int integrator_max_substeps;
+  int integrator_substeps;
+  double integrator_step; // Last step size of the Dormand-Prince integrator
+
+  /// The part of the state vector integrated by the state integrators.
+  struct IntegratedState {
+    FGQuaternion qAttitudeECI;
+    FGColumnVector3 vPQRi;
+    FGColumnVector3 vInertialPosition;
+    FGColumnVector3 vInertialVelocity;
+  };
+
+  /// The derivatives of IntegratedState.
+  struct StateDot {
+    FGQuaternion vQtrndot;
+    FGColumnVector3 vPQRidot;
+    FGColumnVector3 vInertialVelocity;
+    FGColumnVector3 vUVWidot;
+  };
 
   void CalculateInertialVelocity(void);
   void CalculateUVW(void);
@@ -599,9 +662,21 @@ private:
                   double dt,
                   eIntegrateType integration_type);
 
+  bool IntegrateState(double dt);
+  double RungeKuttaStep(const IntegratedState& y0, double t, double h,
+                        int stages, const double a[][7], const double* b,
+                        const double* e, const FGLocation& location0,
+                        StateDot* k, IntegratedState& y1);
+  bool EvaluateDerivatives(const IntegratedState& y, const FGLocation& location0,
+                           double t, double h, StateDot& k);
+
   void UpdateLocationMatrices(void);
   void UpdateBodyMatrices(void);
   void UpdateVehicleState(void);
+  void UpdateFromInertialState(double dEPA);
+  int GetSubsteps(void) const { return integrator_substeps; }
+  int GetStateIntegrator(void) const { return integrator_state; }
+  void SetStateIntegrator(int type);
 
   void WriteStateFile(int num);
   void bind(void);
@@ -27,14 +27,10 @@
 
 #include <simgear/math/sg_geodesy.hxx>
 
-#include <Aircraft/controls.hxx>
-#include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
 
 #include "UFO.hxx"
 
-double FGUFO::lowpass::_dt;
-
 
 FGUFO::FGUFO( double dt ) :
     Throttle(new lowpass(fgGetDouble("/controls/damping/throttle", 0.1))),
@@ -44,7 +40,16 @@ FGUFO::FGUFO( double dt ) :
     Aileron_Trim(new lowpass(fgGetDouble("/controls/damping/aileron-trim", 0.65))),
     Elevator_Trim(new lowpass(fgGetDouble("/controls/damping/elevator-trim", 0.65))),
     Rudder_Trim(new lowpass(fgGetDouble("/controls/damping/rudder-trim", 0.05))),
-    Speed_Max(fgGetNode("/engines/engine/speed-max-mps", true))
+    Speed_Max(fgGetNode("/engines/engine/speed-max-mps", true)),
+    Throttle_Ctrl(fgGetNode("/controls/engines/engine[0]/throttle", true)),
+    Brake_Left_Ctrl(fgGetNode("/controls/gear/brake-left", true)),
+    Brake_Right_Ctrl(fgGetNode("/controls/gear/brake-right", true)),
+    Aileron_Ctrl(fgGetNode("/controls/flight/aileron", true)),
+    Elevator_Ctrl(fgGetNode("/controls/flight/elevator", true)),
+    Rudder_Ctrl(fgGetNode("/controls/flight/rudder", true)),
+    Aileron_Trim_Ctrl(fgGetNode("/controls/flight/aileron-trim", true)),
+    Elevator_Trim_Ctrl(fgGetNode("/controls/flight/elevator-trim", true)),
+    Rudder_Trim_Ctrl(fgGetNode("/controls/flight/rudder-trim", true))
 {
 }
 
@@ -75,29 +80,27 @@ void FGUFO::update( double dt ) {
     if (is_suspended())
         return;
 
-    lowpass::set_delta(dt);
     double time_step = dt;
-    FGControls *ctrl = globals->get_controls();
 
     // read the throttle
-    double throttle = ctrl->get_throttle( 0 );
-    double brake_left = ctrl->get_brake_left();
-    double brake_right = ctrl->get_brake_right();
+    double throttle = Throttle_Ctrl->getDoubleValue();
+    double brake_left = Brake_Left_Ctrl->getDoubleValue();
+    double brake_right = Brake_Right_Ctrl->getDoubleValue();
 
     if (brake_left > 0.5 || brake_right > 0.5)
         throttle = -throttle;
 
-    double velocity = Throttle->filter(throttle) * Speed_Max->getDoubleValue(); // meters/sec
+    double velocity = Throttle->filter(throttle, dt) * Speed_Max->getDoubleValue(); // meters/sec
 
 
     // read and lowpass-filter the state of the control surfaces
-    double aileron = Aileron->filter(ctrl->get_aileron());
-    double elevator = Elevator->filter(ctrl->get_elevator());
-    double rudder = Rudder->filter(ctrl->get_rudder());
+    double aileron = Aileron->filter(Aileron_Ctrl->getDoubleValue(), dt);
+    double elevator = Elevator->filter(Elevator_Ctrl->getDoubleValue(), dt);
+    double rudder = Rudder->filter(Rudder_Ctrl->getDoubleValue(), dt);
 
-    aileron += Aileron_Trim->filter(ctrl->get_aileron_trim());
-    elevator += Elevator_Trim->filter(ctrl->get_elevator_trim());
-    rudder += Rudder_Trim->filter(ctrl->get_rudder_trim());
+    aileron += Aileron_Trim->filter(Aileron_Trim_Ctrl->getDoubleValue(), dt);
+    elevator += Elevator_Trim->filter(Elevator_Trim_Ctrl->getDoubleValue(), dt);
+    rudder += Rudder_Trim->filter(Rudder_Trim_Ctrl->getDoubleValue(), dt);
 
     double old_pitch = get_Theta();
     double pitch_rate = SGD_PI_4;  // assume I will be pitching up
@@ -32,19 +32,17 @@ private:
 
     class lowpass {
     private:
-        static double _dt;
         double _coeff;
         double _last;
         bool _initialized;
     public:
         lowpass(double coeff) : _coeff(coeff), _initialized(false) {}
-        static inline void set_delta(double dt) { _dt = dt; }
-        double filter(double value) {
+        double filter(double value, double dt) {
             if (!_initialized) {
                 _initialized = true;
                 return _last = value;
             }
-            double c = _dt / (_coeff + _dt);
+            double c = dt / (_coeff + dt);
             return _last = value * c + _last * (1.0 - c);
         }
     };
@@ -58,6 +56,18 @@ private:
     lowpass *Rudder_Trim;
     SGPropertyNode_ptr Speed_Max;
 
+    // the controls, read from the property tree rather than FGControls so
+    // that an FDM pool instance sees its own controls/ subtree
+    SGPropertyNode_ptr Throttle_Ctrl;
+    SGPropertyNode_ptr Brake_Left_Ctrl;
+    SGPropertyNode_ptr Brake_Right_Ctrl;
+    SGPropertyNode_ptr Aileron_Ctrl;
+    SGPropertyNode_ptr Elevator_Ctrl;
+    SGPropertyNode_ptr Rudder_Ctrl;
+    SGPropertyNode_ptr Aileron_Trim_Ctrl;
+    SGPropertyNode_ptr Elevator_Trim_Ctrl;
+    SGPropertyNode_ptr Rudder_Trim_Ctrl;
+
 public:
     FGUFO( double dt );
     ~FGUFO();
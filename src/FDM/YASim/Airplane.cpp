@@ -2,6 +2,9 @@
 #  include "config.h"
 #endif
 
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
 #include "Atmosphere.hpp"
 #include "ControlMap.hpp"
 #include "Gear.hpp"
@@ -32,6 +35,64 @@ const float STHRESH = 1;
 // oscillate.
 const float SOLVE_TWEAK = 0.3226;
 
+// Elevator step for the derivative of the approach pitching moment
+const float ELEVDIDDLE = 0.001f;
+
+// Runs the approach configuration of the solver on a twin airplane,
+// while the solving thread runs the cruise configuration.
+class ApproachThread : public SGThread {
+public:
+    ApproachThread(Airplane* twin)
+        : _twin(twin), _busy(false), _quit(false) {}
+
+    ~ApproachThread()
+    {
+        _mutex.lock();
+        _quit = true;
+        _request.signal();
+        _mutex.unlock();
+        join();
+    }
+
+    void post()
+    {
+        SGGuard<SGMutex> lock(_mutex);
+        _busy = true;
+        _request.signal();
+    }
+
+    void wait(Airplane::ApproachRuns* out)
+    {
+        SGGuard<SGMutex> lock(_mutex);
+        while(_busy) _done.wait(_mutex);
+        *out = _runs;
+    }
+
+protected:
+    virtual void run()
+    {
+        SGGuard<SGMutex> lock(_mutex);
+        while(1) {
+            while(!_busy && !_quit) _request.wait(_mutex);
+            if(_quit) return;
+            _mutex.unlock();
+            _twin->runApproaches(&_runs);
+            _mutex.lock();
+            _busy = false;
+            _done.signal();
+        }
+    }
+
+private:
+    Airplane* _twin;
+    Airplane::ApproachRuns _runs;
+    bool _busy;
+    bool _quit;
+    SGMutex _mutex;
+    SGWaitCondition _request;
+    SGWaitCondition _done;
+};
+
 Airplane::Airplane()
 {
     _emptyWeight = 0;
@@ -57,6 +118,10 @@ Airplane::Airplane()
     _tailIncidence = 0;
 
     _failureMsg = 0;
+
+    _solution = 0;
+    _solveTwin = 0;
+    _isTwin = false;
 }
 
 Airplane::~Airplane()
@@ -95,6 +160,7 @@ Airplane::~Airplane()
         delete (Wing*)_vstabs.get(i);
     for(i=0; i<_weights.size(); i++)
         delete (WeightRec*)_weights.get(i);
+    delete _solution;
 }
 
 void Airplane::iterate(float dt)
@@ -436,6 +502,31 @@ int Airplane::getSolutionIterations()
     return _solutionIterations;
 }
 
+bool Airplane::getSolution(Solution* out)
+{
+    if(!_wing || !_tail || _failureMsg)
+        return false;
+    out->dragFactor = _dragFactor;
+    out->liftRatio = _liftRatio;
+    out->cruiseAoA = _cruiseAoA;
+    out->tailIncidence = _tailIncidence;
+    out->approachElevator = _approachElevator.val;
+    out->iterations = _solutionIterations;
+    return true;
+}
+
+void Airplane::setSolution(Solution* s)
+{
+    delete _solution;
+    _solution = new Solution(*s);
+}
+
+void Airplane::setSolveTwin(Airplane* twin)
+{
+    _solveTwin = twin;
+    twin->_isTwin = true;
+}
+
 void Airplane::setupState(float aoa, float speed, float gla, State* s)
 {
     float cosAoA = Math::cos(aoa);
@@ -706,7 +797,13 @@ void Airplane::compile()
     if (_failureMsg) return;
 
     solveGear();
-    if(_wing && _tail) solve();
+    if(_isTwin) {
+        // Only runs the approach for the solver of its twin
+    }
+    else if(_wing && _tail) {
+        if(_solution) applySolution();
+        else solve();
+    }
     else
     {
        // The rotor(s) mass:
@@ -943,12 +1040,28 @@ void Airplane::solve()
     _solutionIterations = 0;
     _failureMsg = 0;
 
+    // With a twin, the approach runs go to a second thread
+    ApproachThread* approach = 0;
+    ApproachRuns runs;
+    if(_solveTwin) {
+        _solveTwin->compile();
+        approach = new ApproachThread(_solveTwin);
+        approach->start();
+    }
+
     while(1) {
         if(_solutionIterations++ > 10000) { 
             _failureMsg = "Solution failed to converge after 10000 iterations";
+            delete approach;
             return;
         }
 
+        if(approach) {
+            _solveTwin->_tail->setIncidence(_tailIncidence);
+            _solveTwin->_approachElevator.val = _approachElevator.val;
+            approach->post();
+        }
+
 	// Run an iteration at cruise, and extract the needed numbers:
 	runCruise();
 
@@ -965,15 +1078,19 @@ void Airplane::solve()
 	float pitch0 = tmp[1];
 
 	// Run an approach iteration, and do likewise
-	runApproach();
-
-	_model.getBody()->getAngularAccel(tmp);
-        Math::tmul33(_approachState.orient, tmp, tmp);
-	double apitch0 = tmp[1];
-
-	_model.getBody()->getAccel(tmp);
-        Math::tmul33(_approachState.orient, tmp, tmp);
-	float alift = _approachWeight * tmp[2];
+	double apitch0;
+	float alift;
+	if(!approach) {
+	    runApproach();
+
+	    _model.getBody()->getAngularAccel(tmp);
+	    Math::tmul33(_approachState.orient, tmp, tmp);
+	    apitch0 = tmp[1];
+
+	    _model.getBody()->getAccel(tmp);
+	    Math::tmul33(_approachState.orient, tmp, tmp);
+	    alift = _approachWeight * tmp[2];
+	}
 
 	// Modify the cruise AoA a bit to get a derivative
 	_cruiseAoA += ARCMIN;
@@ -993,6 +1110,12 @@ void Airplane::solve()
         Math::tmul33(_cruiseState.orient, tmp, tmp);
 	float pitch1 = tmp[1];
 
+	if(approach) {
+	    approach->wait(&runs);
+	    apitch0 = runs.apitch0;
+	    alift = runs.alift;
+	}
+
 	// Now calculate:
 	float awgt = 9.8f * _approachWeight;
 
@@ -1009,14 +1132,18 @@ void Airplane::solve()
         // like the tail incidence computation (it's solving for the
         // same thing -- pitching moment -- by diddling a different
         // variable).
-        const float ELEVDIDDLE = 0.001f;
-        _approachElevator.val += ELEVDIDDLE;
-        runApproach();
-        _approachElevator.val -= ELEVDIDDLE;
-
-	_model.getBody()->getAngularAccel(tmp);
-        Math::tmul33(_approachState.orient, tmp, tmp);
-	double apitch1 = tmp[1];
+        double apitch1;
+        if(approach) {
+            apitch1 = runs.apitch1;
+        } else {
+            _approachElevator.val += ELEVDIDDLE;
+            runApproach();
+            _approachElevator.val -= ELEVDIDDLE;
+
+            _model.getBody()->getAngularAccel(tmp);
+            Math::tmul33(_approachState.orient, tmp, tmp);
+            apitch1 = tmp[1];
+        }
         float elevDelta = -apitch0 * (ELEVDIDDLE/(apitch1-apitch0));
 
         // Now apply the values we just computed.  Note that the
@@ -1025,6 +1152,10 @@ void Airplane::solve()
 
 	applyDragFactor(dragFactor);
 	applyLiftRatio(liftFactor);
+        if(_solveTwin) {
+            _solveTwin->applyDragFactor(dragFactor);
+            _solveTwin->applyLiftRatio(liftFactor);
+        }
 
 	// DON'T do the following until the above are sane
 	if(normFactor(dragFactor) > STHRESH*1.0001
@@ -1058,6 +1189,14 @@ void Airplane::solve()
         }
     }
 
+    if(approach) {
+        delete approach;
+
+        // Leave the model in the approach configuration, like the
+        // serial solver does
+        runApproach();
+    }
+
     if(_dragFactor < 1e-06 || _dragFactor > 1e6) {
 	_failureMsg = "Drag factor beyond reasonable bounds.";
 	return;
@@ -1073,6 +1212,47 @@ void Airplane::solve()
     }
 }
 
+// The two approach runs of a solver iteration, on the twin
+void Airplane::runApproaches(ApproachRuns* out)
+{
+    float tmp[3];
+    runApproach();
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    out->apitch0 = tmp[1];
+
+    _model.getBody()->getAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    out->alift = _approachWeight * tmp[2];
+
+    _approachElevator.val += ELEVDIDDLE;
+    runApproach();
+    _approachElevator.val -= ELEVDIDDLE;
+
+    _model.getBody()->getAngularAccel(tmp);
+    Math::tmul33(_approachState.orient, tmp, tmp);
+    out->apitch1 = tmp[1];
+}
+
+// Restore a cached solve() result instead of solving again
+void Airplane::applySolution()
+{
+    _solutionIterations = _solution->iterations;
+    _failureMsg = 0;
+
+    applyDragFactor(Math::pow(_solution->dragFactor, 1/SOLVE_TWEAK));
+    applyLiftRatio(Math::pow(_solution->liftRatio, 1/SOLVE_TWEAK));
+    _cruiseAoA = _solution->cruiseAoA;
+    _tailIncidence = _solution->tailIncidence;
+    _tail->setIncidence(_tailIncidence);
+    _approachElevator.val = _solution->approachElevator;
+
+    // Leave the model as solve() does
+    runCruise();
+    runApproach();
+}
+
 void Airplane::solveHelicopter()
 {
     _solutionIterations = 0;
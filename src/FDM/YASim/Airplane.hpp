@@ -14,6 +14,7 @@ class Hook;
 class Launchbar;
 class Thruster;
 class Hitch;
+class ApproachThread;
 
 class Airplane {
 public:
@@ -80,6 +81,19 @@ public:
     float getTankCapacity(int tank);
 
     void compile(); // generate point masses & such, then solve
+
+    // The converged solver output, enough to skip the solver when the
+    // same airplane is compiled again.
+    struct Solution { float dragFactor, liftRatio, cruiseAoA,
+                      tailIncidence, approachElevator; int iterations; };
+    bool getSolution(Solution* out); // false if there is none
+    void setSolution(Solution* s); // call before compile()
+
+    // An identical airplane (parsed from the same file) on which the
+    // solver runs the approach configuration in a second thread,
+    // concurrently with the cruise runs.  Call before compile(); the
+    // twin can be deleted afterwards.
+    void setSolveTwin(Airplane* twin);
     void initEngines();
     void stabilizeThrust();
 
@@ -124,6 +138,11 @@ private:
     void updateGearState();
     void setupWeights(bool isApproach);
 
+    friend class ApproachThread;
+    struct ApproachRuns { float apitch0, alift, apitch1; };
+    void runApproaches(ApproachRuns* out);
+    void applySolution();
+
     Model _model;
     ControlMap _controls;
 
@@ -173,6 +192,10 @@ private:
     float _tailIncidence;
     Control _approachElevator;
     const char* _failureMsg;
+
+    Solution* _solution; // preset by setSolution()
+    Airplane* _solveTwin;
+    bool _isTwin;
 };
 
 }; // namespace yasim
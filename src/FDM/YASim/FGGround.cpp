@@ -51,6 +51,28 @@ void FGGround::getGroundPlane(const double pos[3],
     for(int i=0; i<3; i++) vel[i] = dvel[i];
 }
 
+void FGGround::getGroundPlanes(GroundQuery* queries, int count)
+{
+    // One pass through the ground cache for all the points.
+    _queries.resize(count);
+    int i, j;
+    for(i=0; i<count; i++)
+        _queries[i].pt = SGVec3d(queries[i].pos);
+    _iface->get_agl_m(_toff, 2, _queries);
+
+    for(i=0; i<count; i++) {
+        const FGGroundCache::AglQuery& a = _queries[i];
+        GroundQuery* q = &queries[i];
+        for(j=0; j<3; j++) {
+            q->plane[j] = a.normal[j];
+            q->vel[j] = a.linearVel[j];
+        }
+        // The plane below the actual contact point.
+        q->plane[3] = dot(a.normal, a.contact);
+        q->material = a.material;
+    }
+}
+
 bool FGGround::caughtWire(const double pos[4][3])
 {
     return _iface->caught_wire_m(_toff, pos);
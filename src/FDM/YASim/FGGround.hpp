@@ -1,6 +1,8 @@
 #ifndef _FGGROUND_HPP
 #define _FGGROUND_HPP
 
+#include <FDM/groundcache.hxx>
+
 #include "Ground.hpp"
 
 class FGInterface;
@@ -25,6 +27,8 @@ public:
                                 double plane[4], float vel[3],
                                 const simgear::BVHMaterial **material);
 
+    virtual void getGroundPlanes(GroundQuery* queries, int count);
+
     virtual bool caughtWire(const double pos[4][3]);
 
     virtual bool getWire(double end[2][3], float vel[2][3]);
@@ -39,6 +43,7 @@ public:
 private:
     FGInterface *_iface;
     double _toff;
+    FGGroundCache::AglQueryList _queries;
 };
 
 }; // namespace yasim
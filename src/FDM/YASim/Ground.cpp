@@ -40,6 +40,15 @@ void Ground::getGroundPlane(const double pos[3],
     getGroundPlane(pos,plane,vel);
 }
 
+void Ground::getGroundPlanes(GroundQuery* queries, int count)
+{
+    for(int i=0; i<count; i++) {
+        GroundQuery* q = &queries[i];
+        q->material = 0;
+        getGroundPlane(q->pos, q->plane, q->vel, &q->material);
+    }
+}
+
 bool Ground::caughtWire(const double pos[4][3])
 {
     return false;
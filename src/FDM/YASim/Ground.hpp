@@ -6,6 +6,14 @@ class BVHMaterial;
 }
 namespace yasim {
 
+// One point of a batched ground query, see Ground::getGroundPlanes().
+struct GroundQuery {
+    double pos[3];
+    double plane[4];
+    float vel[3];
+    const simgear::BVHMaterial* material;
+};
+
 class Ground {
 public:
     Ground();
@@ -18,6 +26,11 @@ public:
                                 double plane[4], float vel[3],
                                 const simgear::BVHMaterial **material);
 
+    // Ground planes for several points at once.  Implementations
+    // that can share work between the points should override this,
+    // the default just calls getGroundPlane() for each of them.
+    virtual void getGroundPlanes(GroundQuery* queries, int count);
+
     virtual bool caughtWire(const double pos[4][3]);
 
     virtual bool getWire(double end[2][3], float vel[2][3]);
@@ -61,6 +61,8 @@ Model::Model()
 
     _agl = 0;
     _crashed = false;
+    _referenceSurfaces = false;
+    _referenceRotors = false;
     _turb = 0;
     _ground_cb = new Ground();
     _hook = 0;
@@ -73,6 +75,9 @@ Model::Model()
     _global_ground[0] = 0; _global_ground[1] = 0; _global_ground[2] = 1;
     _global_ground[3] = -100000;
 
+    _groundQueries = 0;
+    _numGroundQueries = 0;
+
 }
 
 Model::~Model()
@@ -81,6 +86,7 @@ Model::~Model()
     delete _ground_cb;
     delete _hook;
     delete _launchbar;
+    delete[] _groundQueries;
     for(int i=0; i<_hitches.size();i++)
         delete (Hitch*)_hitches.get(i);
 
@@ -304,10 +310,21 @@ void Model::setWind(float* wind)
 void Model::updateGround(State* s)
 {
     float dummy[3];
-    _ground_cb->getGroundPlane(s->pos, _global_ground, dummy);
-
     int i;
-    // The landing gear
+
+    // The aircraft origin, the landing gear and the hitches all go
+    // into one batched ground query, so the ground cache needs to be
+    // walked only once.
+    int nq = 1 + _gears.size() + _hitches.size();
+    if(nq > _numGroundQueries) {
+        delete[] _groundQueries;
+        _groundQueries = new GroundQuery[nq];
+        _numGroundQueries = nq;
+    }
+
+    for(i=0; i<3; i++) _groundQueries[0].pos[i] = s->pos[i];
+
+    GroundQuery* gq = _groundQueries + 1;
     for(i=0; i<_gears.size(); i++) {
 	Gear* g = (Gear*)_gears.get(i);
 
@@ -320,17 +337,10 @@ void Model::updateGround(State* s)
 	Math::add3(cmpr, pos, pos);
         // Transform the local coordinates of the contact point to
         // global coordinates.
-        double pt[3];
-        s->posLocalToGlobal(pos, pt);
-
-        // Ask for the ground plane in the global coordinate system
-        double global_ground[4];
-        float global_vel[3];
-        const simgear::BVHMaterial* material;
-        _ground_cb->getGroundPlane(pt, global_ground, global_vel, &material);
-        g->setGlobalGround(global_ground, global_vel, pt[0], pt[1], material);
+        s->posLocalToGlobal(pos, gq[i].pos);
     }
 
+    GroundQuery* hq = gq + _gears.size();
     for(i=0; i<_hitches.size(); i++) {
         Hitch* h = (Hitch*)_hitches.get(i);
 
@@ -340,14 +350,24 @@ void Model::updateGround(State* s)
 
         // Transform the local coordinates of the contact point to
         // global coordinates.
-        double pt[3];
-        s->posLocalToGlobal(pos, pt);
+        s->posLocalToGlobal(pos, hq[i].pos);
+    }
 
-        // Ask for the ground plane in the global coordinate system
-        double global_ground[4];
-        float global_vel[3];
-        _ground_cb->getGroundPlane(pt, global_ground, global_vel);
-        h->setGlobalGround(global_ground, global_vel);
+    // Ask for the ground planes in the global coordinate system
+    _ground_cb->getGroundPlanes(_groundQueries, nq);
+
+    for(i=0; i<4; i++) _global_ground[i] = _groundQueries[0].plane[i];
+
+    // The landing gear
+    for(i=0; i<_gears.size(); i++) {
+	Gear* g = (Gear*)_gears.get(i);
+        g->setGlobalGround(gq[i].plane, gq[i].vel, gq[i].pos[0], gq[i].pos[1],
+                           gq[i].material);
+    }
+
+    for(i=0; i<_hitches.size(); i++) {
+        Hitch* h = (Hitch*)_hitches.get(i);
+        h->setGlobalGround(hq[i].plane, hq[i].vel);
     }
 
     for(i=0; i<_rotorgear.getRotors()->size(); i++) {
@@ -411,20 +431,38 @@ void Model::calcForces(State* s)
     // point is different due to rotation.
     float faero[3];
     faero[0] = faero[1] = faero[2] = 0;
-    for(i=0; i<_surfaces.size(); i++) {
-	Surface* sf = (Surface*)_surfaces.get(i);
+    if(_referenceSurfaces) {
+        for(i=0; i<_surfaces.size(); i++) {
+            Surface* sf = (Surface*)_surfaces.get(i);
 
-	// Vsurf = wind - velocity + (rot cross (cg - pos))
-	float vs[3], pos[3];
-	sf->getPosition(pos);
-        localWind(pos, s, vs, alt);
+            // Vsurf = wind - velocity + (rot cross (cg - pos))
+            float vs[3], pos[3];
+            sf->getPosition(pos);
+            localWind(pos, s, vs, alt);
 
-	float force[3], torque[3];
-	sf->calcForce(vs, _rho, force, torque);
-	Math::add3(faero, force, faero);
+            float force[3], torque[3];
+            sf->calcForce(vs, _rho, force, torque);
+            Math::add3(faero, force, faero);
 
-	_body.addForce(pos, force);
-	_body.addTorque(torque);
+            _body.addForce(pos, force);
+            _body.addTorque(torque);
+        }
+    } else {
+        // Same thing, with the forces of all surfaces computed in one
+        // batch and summed by the SurfaceArray.
+        _surfaceArray.update(&_surfaces);
+        for(i=0; i<_surfaceArray.size(); i++) {
+            float vs[3], pos[3];
+            _surfaceArray.getPosition(i, pos);
+            localWind(pos, s, vs, alt);
+            _surfaceArray.setWind(i, vs);
+        }
+
+        float cg[3], torque[3];
+        _body.getCG(cg);
+        _surfaceArray.calcForces(_rho, cg, faero, torque);
+        _body.addForce(faero);
+        _body.addTorque(torque);
     }
     for (j=0; j<_rotorgear.getRotors()->size();j++)
     {
@@ -436,21 +474,39 @@ void Model::calcForces(State* s)
         float tq=0; 
         // total torque of rotor (scalar) for calculating new rotor rpm
 
-        for(i=0; i<r->_rotorparts.size(); i++) {
-            float torque_scalar=0;
-            Rotorpart* rp = (Rotorpart*)r->_rotorparts.get(i);
-
-            // Vsurf = wind - velocity + (rot cross (cg - pos))
-            float vs[3], pos[3];
-            rp->getPosition(pos);
-            localWind(pos, s, vs, alt,true);
-
-            float force[3], torque[3];
-            rp->calcForce(vs, _rho, force, torque, &torque_scalar);
-            tq+=torque_scalar;
-            rp->getPositionForceAttac(pos);
-
-            _body.addForce(pos, force);
+        if(_referenceRotors) {
+            for(i=0; i<r->_rotorparts.size(); i++) {
+                float torque_scalar=0;
+                Rotorpart* rp = (Rotorpart*)r->_rotorparts.get(i);
+
+                // Vsurf = wind - velocity + (rot cross (cg - pos))
+                float vs[3], pos[3];
+                rp->getPosition(pos);
+                localWind(pos, s, vs, alt,true);
+
+                float force[3], torque[3];
+                rp->calcForce(vs, _rho, force, torque, &torque_scalar);
+                tq+=torque_scalar;
+                rp->getPositionForceAttac(pos);
+
+                _body.addForce(pos, force);
+                _body.addTorque(torque);
+            }
+        } else {
+            // All blade elements of the rotor in one batch
+            RotorpartArray* ra = r->getRotorpartArray();
+            ra->update(r);
+            for(i=0; i<ra->size(); i++) {
+                float vs[3], pos[3];
+                ra->getPosition(i, pos);
+                localWind(pos, s, vs, alt,true);
+                ra->setWind(i, vs);
+            }
+
+            float cg[3], force[3], torque[3];
+            _body.getCG(cg);
+            ra->calcForces(_rho, cg, force, torque, &tq);
+            _body.addForce(force);
             _body.addTorque(torque);
         }
         r->setTorque(tq);
@@ -7,6 +7,8 @@
 #include "Vector.hpp"
 #include "Turbulence.hpp"
 #include "Rotor.hpp"
+#include "Ground.hpp"
+#include "SurfaceArray.hpp"
 
 namespace yasim {
 
@@ -36,6 +38,13 @@ public:
 
     bool isCrashed();
     void setCrashed(bool crashed);
+
+    // Use Surface::calcForce() one surface at a time instead of the
+    // SurfaceArray kernel, for comparing the two.
+    void setReferenceSurfaces(bool ref) { _referenceSurfaces = ref; }
+
+    // Likewise Rotorpart::calcForce() instead of the RotorpartArray.
+    void setReferenceRotors(bool ref) { _referenceRotors = ref; }
     float getAGL();
 
     void iterate();
@@ -90,6 +99,9 @@ private:
 
     Vector _thrusters;
     Vector _surfaces;
+    SurfaceArray _surfaceArray;
+    bool _referenceSurfaces;
+    bool _referenceRotors;
     Rotorgear _rotorgear;
     Vector _gears;
     Hook* _hook;
@@ -102,6 +114,8 @@ private:
 
     Ground* _ground_cb;
     double _global_ground[4];
+    GroundQuery* _groundQueries;
+    int _numGroundQueries;
     float _pressure;
     float _temp;
     float _rho;
@@ -3,6 +3,7 @@
 
 #include "Vector.hpp"
 #include "Rotorpart.hpp"
+#include "RotorpartArray.hpp"
 #include "Integrator.hpp"
 #include "RigidBody.hpp"
 #include "BodyEnvironment.hpp"
@@ -16,6 +17,7 @@ const float rho_null=1.184f; //25DegC, 101325Pa
 
 class Rotor {
     friend std::ostream &  operator<<(std::ostream & out, /*const*/ Rotor& r);
+    friend class RotorpartArray;
 private:
     float _torque;
     float _omega,_omegan,_omegarel,_ddt_omega,_omegarelneu;
@@ -138,6 +140,7 @@ public:
         {if (_stall_v2sum !=0 ) return _stall_sum/_stall_v2sum; else return 0;}
     float getAirfoilIncidenceNoLift() {return _airfoil_incidence_no_lift;}
     Vector _rotorparts;
+    RotorpartArray* getRotorpartArray() { return &_rotorpartArray; }
     void findGroundEffectAltitude(Ground * ground_cb,State *s);
     float *getGravDirection() {return _grav_direction;}
     void writeInfo();
@@ -242,6 +245,7 @@ private:
     float _grav_direction[3];
     int _properties_tied;
     bool _directions_and_postions_dirty;
+    RotorpartArray _rotorpartArray;
 };
 std::ostream &  operator<<(std::ostream & out, /*const*/ Rotor& r);
 
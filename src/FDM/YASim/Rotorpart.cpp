@@ -446,6 +446,13 @@ float Rotorpart::calculateAlpha(float* v_rel_air, float rho,
             + lift * Math::sin(angle));
         if (returnlift!=NULL) *returnlift+=lift;
     }
+    return calcFlapAlpha(lift_moment,relgrav);
+}
+
+// The flapping angle at which the lift moment and the centripetal
+// force compensate each other
+float Rotorpart::calcFlapAlpha(float lift_moment, float relgrav)
+{
     //use 1st order approximation for alpha
     //float alpha=Math::atan2(lift_moment,_centripetalforce * _len); 
     float alpha;
@@ -502,11 +509,16 @@ void Rotorpart::calcForce(float* v, float rho,  float* out, float* torque,
         *torque_scalar=0;
         return;
     }
-    _centripetalforce=_mass*_len*_omega*_omega;
-    float vrel[3],vreldir[3];
-    Math::sub3(_speed,v,vrel);
     float scalar_torque=0;
-    Math::unit3(vrel,vreldir);//direction of blade-movement rel. to air
+    initForce();
+    float alpha=calculateAlpha(v,rho,_incidence,_cyclic,0,&scalar_torque);
+    applyAlpha(alpha,scalar_torque,out,torque,torque_scalar);
+}
+
+// The part of calcForce() before the flapping angle is known
+void Rotorpart::initForce()
+{
+    _centripetalforce=_mass*_len*_omega*_omega;
     //Angle of blade which would produce no vertical force (where the 
     //effective incidence is zero)
 
@@ -520,11 +532,17 @@ void Rotorpart::calcForce(float* v, float rho,  float* out, float* torque,
     //delta3 effect, see README.YASIM
     //float beta=_relamp*cyc+col; 
     //the incidence of the rotorblade which is used for the calculation
+}
 
-    float alpha,factor; //alpha is the flapping angle
+// The part of calcForce() after the flapping angle: alpha as
+// calculated by calculateAlpha() and the aerodynamic torque of the
+// blade elements
+void Rotorpart::applyAlpha(float alpha, float scalar_torque, float* out,
+    float* torque, float* torque_scalar)
+{
+    float factor; //alpha is the flapping angle
     //the new flapping angle will be the old flapping angle
     //+ factor *(alpha - "old flapping angle")
-    alpha=calculateAlpha(v,rho,_incidence,cyc,0,&scalar_torque);
     alpha=Math::clamp(alpha,_alphamin,_alphamax);
     //the incidence is a function of alpha (if _delta* != 0)
     //Therefore missing: wrap this function in an integrator
@@ -7,6 +7,7 @@ namespace yasim {
     class Rotorpart
     {
         friend std::ostream &  operator<<(std::ostream & out, const Rotorpart& rp);
+        friend class RotorpartArray;
     private:
         float _dt;
         float _last_torque[3];
@@ -79,6 +80,10 @@ namespace yasim {
 
     private:
         void strncpy(char *dest,const char *src,int maxlen);
+        void initForce();
+        float calcFlapAlpha(float lift_moment, float relgrav);
+        void applyAlpha(float alpha, float scalar_torque, float* out,
+            float* torque, float* torque_scalar);
         Rotorpart *_lastrp,*_nextrp,*_oppositerp,*_last90rp,*_next90rp;
         Rotor *_rotor;
 
@@ -0,0 +1,301 @@
+#include "Math.hpp"
+#include "Rotor.hpp"
+#include "Rotorpart.hpp"
+#include "RotorpartArray.hpp"
+namespace yasim {
+const float pi=3.14159;
+
+RotorpartArray::RotorpartArray()
+{
+    _rotor = 0;
+    _rotorparts = 0;
+    _n = _m = _nseg = 0;
+    _parts = 0;
+    _elements = 0;
+    _elementPart = 0;
+}
+
+RotorpartArray::~RotorpartArray()
+{
+    delete[] _rotorparts;
+    delete[] _parts;
+    delete[] _elements;
+    delete[] _elementPart;
+}
+
+// The segments are the same for all parts.  Mirrors the setup at the
+// top of the segment loop of Rotorpart::calculateAlpha().
+void RotorpartArray::update(Rotor* rotor)
+{
+    int n = rotor->_rotorparts.size();
+    if(rotor == _rotor && n == _n)
+        return;
+    _rotor = rotor;
+
+    delete[] _rotorparts;
+    delete[] _parts;
+    delete[] _elements;
+    delete[] _elementPart;
+    _rotorparts = 0;
+    _parts = _elements = 0;
+    _elementPart = 0;
+    _n = _m = _nseg = 0;
+
+    // Rotor::compile() makes a multiple of four parts
+    if(n < 4 || n % 4)
+        return;
+    Rotorpart* rp = (Rotorpart*)rotor->_rotorparts.get(0);
+    if(rp->_number_of_segments < 1)
+        return;
+
+    _n = n;
+    _m = n/4;
+    _nseg = rp->_number_of_segments;
+    _rotorparts = new Rotorpart*[_n];
+    for(int i=0; i<_n; i++)
+        _rotorparts[i] = (Rotorpart*)rotor->_rotorparts.get(i);
+    _parts = new float[NUM_PART_FIELDS*_n];
+    _elements = new float[NUM_ELEMENT_FIELDS*_m*_nseg];
+    _elementPart = new int[_m*_nseg];
+
+    float local_width=rp->_diameter*(1-rp->_rel_len_blade_start)/2.
+        /(float (_nseg));
+    for(int s=0; s<_nseg; s++) {
+        float rel = (s+.5)/(float (_nseg));
+        float r = rp->_diameter *0.5 *(rel*(1-rp->_rel_len_blade_start)
+            +rp->_rel_len_blade_start);
+        float twist = rp->_twist *rel -
+            rp->_twist *rp->_rel_len_where_incidence_is_measured;
+        float local_chord = rotor->getChord()*rel+rotor->getChord()
+            *rotor->getTaper()*(1-rel);
+        float prantl = -rotor->getNumberOfBlades()/2.*(1-rel);
+        for(int p=0; p<_m; p++) {
+            int e = p*_nseg + s;
+            element(R)[e] = r;
+            element(TWIST)[e] = twist;
+            element(AREA)[e] = local_chord * local_width;
+            element(PRANTL)[e] = prantl;
+            _elementPart[e] = p;
+        }
+    }
+}
+
+void RotorpartArray::getPosition(int i, float* out)
+{
+    _rotorparts[i]->getPosition(out);
+}
+
+void RotorpartArray::setWind(int i, float* v)
+{
+    part(WX)[i] = v[0];
+    part(WY)[i] = v[1];
+    part(WZ)[i] = v[2];
+}
+
+void RotorpartArray::calcForces(float rho, float* cg, float* forceOut,
+                                float* torqueOut, float* torqueScalarOut)
+{
+    float f[3] = { 0, 0, 0 }, t[3] = { 0, 0, 0 }, tq = 0;
+    int i;
+
+    // Nothing here changes while the parts are updated
+    float* grav = _rotor->getGravDirection();
+    for(i=0; i<_n; i++) {
+        Rotorpart* rp = _rotorparts[i];
+        rp->initForce();
+        part(MX)[i] = rp->_direction_of_movement[0];
+        part(MY)[i] = rp->_direction_of_movement[1];
+        part(MZ)[i] = rp->_direction_of_movement[2];
+        part(NX)[i] = rp->_normal[0];
+        part(NY)[i] = rp->_normal[1];
+        part(NZ)[i] = rp->_normal[2];
+        part(DX)[i] = rp->_directionofrotorpart[0];
+        part(DY)[i] = rp->_directionofrotorpart[1];
+        part(DZ)[i] = rp->_directionofrotorpart[2];
+        part(OMEGA)[i] = rp->_omega;
+        part(INCIDENCE)[i] = rp->_incidence;
+        part(CYCLIC)[i] = rp->_cyclic;
+        part(RELAMP)[i] = rp->_relamp;
+        part(RELGRAV)[i] = Math::dot3(rp->_normal, grav);
+    }
+
+    for(int q=0; q<4; q++) {
+        int first = q*_m;
+        for(i=first; i<first+_m; i++) {
+            Rotorpart* rp = _rotorparts[i];
+            part(FLAP)[i] = (rp->_next90rp->getrealAlpha()
+                -rp->_last90rp->getrealAlpha())*rp->_omega / pi;
+            part(LIFTMOMENT)[i] = -rp->_mass*rp->_len*9.81*part(RELGRAV)[i];
+            part(TORQUE)[i] = 0;
+        }
+
+        for(int e=0; e<_m*_nseg; e+=BLOCK) {
+            int n = _m*_nseg - e < BLOCK ? _m*_nseg - e : BLOCK;
+            calcBlock(first, e, n, rho);
+        }
+
+        // The rest of Rotorpart::calcForce(), in the order of the parts
+        for(i=first; i<first+_m; i++) {
+            Rotorpart* rp = _rotorparts[i];
+            float alpha = rp->calcFlapAlpha(part(LIFTMOMENT)[i],
+                                            part(RELGRAV)[i]);
+            float force[3], torque[3], torque_scalar, v[3], ft[3];
+            rp->applyAlpha(alpha, part(TORQUE)[i], force, torque,
+                           &torque_scalar);
+            tq += torque_scalar;
+
+            // F cross (C - X), as in RigidBody::addForce()
+            Math::sub3(cg, rp->_posforceattac, v);
+            Math::cross3(force, v, ft);
+            Math::add3(f, force, f);
+            Math::add3(t, torque, t);
+            Math::add3(t, ft, t);
+        }
+    }
+
+    Math::set3(f, forceOut);
+    Math::set3(t, torqueOut);
+    *torqueScalarOut = tq;
+}
+
+// The segment loop of Rotorpart::calculateAlpha() for the elements e0
+// to e0+n-1 of the quarter starting at part first, with the lift and
+// drag coefficients of Rotor::getLiftCoef() and getDragCoef().  The
+// loops without calls have no branches (only selects between values
+// already computed), so that they compile to vector code; the
+// trigonometry has loops of its own.
+void RotorpartArray::calcBlock(int first, int e0, int n, float rho)
+{
+    float vel[BLOCK], sn[BLOCK], prantl[BLOCK];
+    float ias[BLOCK], ias1[BLOCK], stall[BLOCK], stall1[BLOCK];
+    float sin2[BLOCK], sin21[BLOCK], sind[BLOCK], cosa[BLOCK], sina[BLOCK];
+    float liftMoment[BLOCK], torque[BLOCK];
+    int i;
+
+    const int* ep = _elementPart + e0;
+    const float* r = element(R) + e0;
+    const float* twist = element(TWIST) + e0;
+    const float* area = element(AREA) + e0;
+    const float* pk = element(PRANTL) + e0;
+
+    const float* wx = part(WX) + first; const float* wy = part(WY) + first;
+    const float* wz = part(WZ) + first;
+    const float* mx = part(MX) + first; const float* my = part(MY) + first;
+    const float* mz = part(MZ) + first;
+    const float* nx = part(NX) + first; const float* ny = part(NY) + first;
+    const float* nz = part(NZ) + first;
+    const float* dx = part(DX) + first; const float* dy = part(DY) + first;
+    const float* dz = part(DZ) + first;
+    const float* omega = part(OMEGA) + first;
+    const float* flap = part(FLAP) + first;
+    const float* incidence = part(INCIDENCE) + first;
+    const float* cyclic = part(CYCLIC) + first;
+    const float* relamp = part(RELAMP) + first;
+
+    // Airspeed of the element, without the component along the blade,
+    // and the sine of its incidence
+    for(i=0; i<n; i++) {
+        int p = ep[i];
+        float om = omega[p] * r[i], fl = flap[p] * r[i];
+        float vx = wx[p] - (fl*nx[p] + om*mx[p]);
+        float vy = wy[p] - (fl*ny[p] + om*my[p]);
+        float vz = wz[p] - (fl*nz[p] + om*mz[p]);
+        float along = vx*dx[p] + vy*dy[p] + vz*dz[p];
+        vx -= along*dx[p];
+        vy -= along*dy[p];
+        vz -= along*dz[p];
+        float v = Math::sqrt(vx*vx + vy*vy + vz*vz);
+        float inv = v != 0 ? 1/v : 0;
+        float s = (vx*inv)*nx[p] + (vy*inv)*ny[p] + (vz*inv)*nz[p];
+        vel[i] = v;
+        sn[i] = Math::clamp(s, -1, 1);
+    }
+
+    // The Prandtl factor takes sqrt(1+1/sqr(tan(pi/2-x))) of the
+    // incidence x, which is 1/cos(x), and cos(asin(s)) = sqrt(1-s*s)
+    for(i=0; i<n; i++) {
+        ias[i] = Math::asin(sn[i]);
+        prantl[i] = 2/pi*Math::acos(Math::exp(
+            pk[i]/Math::sqrt(1-sn[i]*sn[i])));
+    }
+
+    // Reduced incidence with and without the cyclic, and the stall
+    // of each (Rotor::calcStall())
+    float a0 = _rotor->_airfoil_incidence_no_lift;
+    float rcf = _rotorparts[first]->_rotor_correction_factor;
+    float stall0 = _rotor->_incidence_stall_zero_speed;
+    float stallv = (_rotor->_incidence_stall_half_sonic_speed - stall0)
+        / (343./2);
+    float changeOver = _rotor->_stall_change_over;
+    for(i=0; i<n; i++) {
+        int p = ep[i];
+        float x = (ias[i] + incidence[p] + twist[i] + a0)
+            *prantl[i]*rcf - a0;
+        float x1 = x - cyclic[p]*rcf*prantl[i];
+        ias[i] = x;
+        ias1[i] = x1;
+
+        float stallIncidence = stall0 + stallv*vel[i];
+        float a = Math::abs(x), a1 = Math::abs(x1);
+        a = a > pi/2 ? pi-a : a;
+        a1 = a1 > pi/2 ? pi-a1 : a1;
+        stall[i] = Math::clamp((a-stallIncidence)/changeOver, 0, 1);
+        stall1[i] = Math::clamp((a1-stallIncidence)/changeOver, 0, 1);
+    }
+
+    for(i=0; i<n; i++) {
+        float angle = ias[i] - incidence[ep[i]];
+        sin2[i] = stall[i] > 0 ? Math::sin(2*(ias[i]-a0)) : 0;
+        sin21[i] = stall1[i] > 0 ? Math::sin(2*(ias1[i]-a0)) : 0;
+        sind[i] = Math::abs(Math::sin(ias[i]-a0));
+        cosa[i] = Math::cos(angle);
+        sina[i] = Math::sin(angle);
+    }
+
+    // Lift and drag, and their moments about the hinge and the axis
+    float liftcoef = _rotor->_liftcoef;
+    float liftStall = liftcoef * _rotor->_lift_factor_stall;
+    float dragcoef0 = _rotor->_dragcoef0;
+    float dragcoef1 = _rotor->_dragcoef1;
+    float dragStall = _rotor->_drag_factor_stall;
+    for(i=0; i<n; i++) {
+        float x = ias[i], x1 = ias1[i];
+        float i2 = x > pi/2 ? x-pi : (x < -pi/2 ? x+pi : x);
+        float i21 = x1 > pi/2 ? x1-pi : (x1 < -pi/2 ? x1+pi : x1);
+        float cl = (1-stall[i])*((i2-a0)*liftcoef)
+            + stall[i]*(sin2[i]*liftStall);
+        float cl1 = (1-stall1[i])*((i21-a0)*liftcoef)
+            + stall1[i]*(sin21[i]*liftStall);
+        float cd = sind[i]*dragcoef1+dragcoef0;
+        cd = (1-stall[i])*cd + stall[i]*(cd*dragStall);
+
+        float q = vel[i] * vel[i] * area[i] * rho * 0.5f;
+        float liftWithoutCyclic = cl1 * q;
+        float lift = liftWithoutCyclic
+            + relamp[ep[i]]*(cl * q - liftWithoutCyclic);
+        float drag = -cd * q;
+        liftMoment[i] = r[i]*(lift * cosa[i] - drag * sina[i]);
+        torque[i] = r[i]*(drag * cosa[i] + lift * sina[i]);
+    }
+
+    // Sum up per part.  The stall sums get the same three terms per
+    // element as from the three coefficient lookups.
+    float* partLiftMoment = part(LIFTMOMENT) + first;
+    float* partTorque = part(TORQUE) + first;
+    float stallSum = _rotor->_stall_sum, v2Sum = _rotor->_stall_v2sum;
+    for(i=0; i<n; i++) {
+        float v2 = vel[i]*vel[i];
+        stallSum += stall1[i]*v2;
+        v2Sum += v2;
+        stallSum += stall[i]*v2;
+        v2Sum += v2;
+        stallSum += stall[i]*v2;
+        v2Sum += v2;
+        partLiftMoment[ep[i]] += liftMoment[i];
+        partTorque[ep[i]] += torque[i];
+    }
+    _rotor->_stall_sum = stallSum;
+    _rotor->_stall_v2sum = v2Sum;
+}
+
+}; // namespace yasim
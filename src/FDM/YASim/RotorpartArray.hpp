@@ -0,0 +1,90 @@
+#ifndef _ROTORPARTARRAY_HPP
+#define _ROTORPARTARRAY_HPP
+
+namespace yasim {
+
+class Rotor;
+class Rotorpart;
+
+// The blade elements of a Rotor (every segment of every Rotorpart),
+// stored field by field, so that the aerodynamics of all of them are
+// computed in a few tight loops over float arrays instead of one
+// Rotorpart::calculateAlpha() call per part.  Rotorpart::calcForce()
+// remains the reference for the physics; the results agree with it to
+// float rounding.
+//
+// A part's flapping depends on the current flapping angles of the
+// parts 90 degrees ahead and behind, which calcForce() updates one
+// part after the other.  No part of a quarter of the rotor depends on
+// another part of the same quarter, so the parts are batched quarter
+// by quarter, which keeps the order of the updates.
+class RotorpartArray
+{
+public:
+    RotorpartArray();
+    ~RotorpartArray();
+
+    // Pick up the parts of a compiled rotor.
+    void update(Rotor* rotor);
+
+    int size() { return _n; }
+    void getPosition(int i, float* out);
+
+    // Local wind at part i, in aircraft coordinates
+    void setWind(int i, float* v);
+
+    // Compute the forces of all parts for an air density rho, and sum
+    // them into a total force and a total torque about the c.g., like
+    // calling Rotorpart::calcForce() for each part.  torqueScalarOut
+    // gets the sum of the scalar torques, the rotor's drag torque.
+    void calcForces(float rho, float* cg, float* forceOut, float* torqueOut,
+                    float* torqueScalarOut);
+
+private:
+    // Per-part fields, each an array of _n floats
+    enum {
+        WX, WY, WZ,                     // local wind
+        MX, MY, MZ,                     // direction of movement
+        NX, NY, NZ,                     // normal
+        DX, DY, DZ,                     // direction of the rotor part
+        OMEGA,
+        FLAP,                           // flapping speed
+        INCIDENCE,
+        CYCLIC,
+        RELAMP,
+        RELGRAV,                        // normal dot gravity direction
+        LIFTMOMENT,                     // sums over the segments
+        TORQUE,
+        NUM_PART_FIELDS
+    };
+
+    // Per-element fields of one quarter, each an array of _m*_nseg
+    // floats: the segments of the first part, then of the second...
+    enum {
+        R,                              // distance from the axis
+        TWIST,                          // incidence added by the twist
+        AREA,
+        PRANTL,                         // exponent of the Prandtl factor
+        NUM_ELEMENT_FIELDS
+    };
+
+    // Elements per pass of calcBlock(), whose temporaries live on the
+    // stack
+    enum { BLOCK = 64 };
+
+    float* part(int f) { return _parts + f*_n; }
+    float* element(int f) { return _elements + f*_m*_nseg; }
+    void calcBlock(int first, int e0, int n, float rho);
+
+    Rotor* _rotor;
+    Rotorpart** _rotorparts;
+    int _n;                             // parts
+    int _m;                             // parts per quarter
+    int _nseg;                          // segments per part
+    float* _parts;
+    float* _elements;
+    int* _elementPart;                  // part in the quarter
+};
+
+}; // namespace yasim
+#endif // _ROTORPARTARRAY_HPP
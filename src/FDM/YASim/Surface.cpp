@@ -29,12 +29,15 @@ Surface::Surface()
     _slatAlpha = 0;
     _spoilerLift = 1;
     _inducedDrag = 1;
+
+    _modified = true;
 }
 
 void Surface::setPosition(float* p)
 {
     int i;
     for(i=0; i<3; i++) _pos[i] = p[i];
+    _modified = true;
 }
 
 void Surface::getPosition(float* out)
@@ -46,11 +49,13 @@ void Surface::getPosition(float* out)
 void Surface::setChord(float chord)
 {
     _chord = chord;
+    _modified = true;
 }
 
 void Surface::setTotalDrag(float c0)
 {
     _c0 = c0;
+    _modified = true;
 }
 
 float Surface::getTotalDrag()
@@ -61,36 +66,43 @@ float Surface::getTotalDrag()
 void Surface::setXDrag(float cx)
 {
     _cx = cx;
+    _modified = true;
 }
 
 void Surface::setYDrag(float cy)
 {
     _cy = cy;
+    _modified = true;
 }
 
 void Surface::setZDrag(float cz)
 {
     _cz = cz;
+    _modified = true;
 }
 
 void Surface::setBaseZDrag(float cz0)
 {
     _cz0 = cz0;
+    _modified = true;
 }
 
 void Surface::setStallPeak(int i, float peak)
 {
     _peaks[i] = peak;
+    _modified = true;
 }
 
 void Surface::setStall(int i, float alpha)
 {
     _stalls[i] = alpha;
+    _modified = true;
 }
 
 void Surface::setStallWidth(int i, float width)
 {
     _widths[i] = width;
+    _modified = true;
 }
 
 void Surface::setOrientation(float* o)
@@ -98,44 +110,52 @@ void Surface::setOrientation(float* o)
     int i;
     for(i=0; i<9; i++)
         _orient[i] = o[i];
+    _modified = true;
 }
 
 void Surface::setIncidence(float angle)
 {
     _incidence = angle;
+    _modified = true;
 }
 
 void Surface::setTwist(float angle)
 {
     _twist = angle;
+    _modified = true;
 }
 
 void Surface::setSlatParams(float stallDelta, float dragPenalty)
 {
     _slatAlpha = stallDelta;
     _slatDrag = dragPenalty;
+    _modified = true;
 }
 
 void Surface::setFlapParams(float liftAdd, float dragPenalty)
 {
     _flapLift = liftAdd;
     _flapDrag = dragPenalty;
+    _modified = true;
 }
 
 void Surface::setSpoilerParams(float liftPenalty, float dragPenalty)
 {
     _spoilerLift = liftPenalty;
     _spoilerDrag = dragPenalty;
+    _modified = true;
 }
 
 void Surface::setFlap(float pos)
 {
     _flapPos = pos;
+    _modified = true;
 }
 
 void Surface::setFlapEffectiveness(float effectiveness)
 {
     _flapEffectiveness = effectiveness;
+    _modified = true;
 }
 
 double Surface::getFlapEffectiveness()
@@ -147,11 +167,13 @@ double Surface::getFlapEffectiveness()
 void Surface::setSlat(float pos)
 {
     _slatPos = pos;
+    _modified = true;
 }
 
 void Surface::setSpoiler(float pos)
 {
     _spoilerPos = pos;
+    _modified = true;
 }
 
 // Calculate the aerodynamic force given a wind vector v (in the
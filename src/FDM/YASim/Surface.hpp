@@ -67,11 +67,13 @@ public:
     void setStallWidth(int i, float width);
 
     // Induced drag multiplier
-    void setInducedDrag(float mul) { _inducedDrag = mul; }
+    void setInducedDrag(float mul) { _inducedDrag = mul; _modified = true; }
 
     void calcForce(float* v, float rho, float* forceOut, float* torqueOut);
 
 private:
+    friend class SurfaceArray;
+
     float stallFunc(float* v);
     float flapLift(float alpha);
     float controlDrag(float lift, float drag);
@@ -102,6 +104,8 @@ private:
     float _incidence;
     float _twist;
     float _inducedDrag;
+
+    bool _modified;   // changed since SurfaceArray last copied it
 };
 
 }; // namespace yasim
@@ -0,0 +1,276 @@
+#include <string.h>
+
+#include "Math.hpp"
+#include "Surface.hpp"
+#include "SurfaceArray.hpp"
+namespace yasim {
+
+SurfaceArray::SurfaceArray()
+{
+    _n = 0;
+    _cap = 0;
+    _data = 0;
+}
+
+SurfaceArray::~SurfaceArray()
+{
+    delete[] _data;
+}
+
+void SurfaceArray::resize(int n)
+{
+    if(n > _cap) {
+        int cap = _cap ? _cap : 16;
+        while(cap < n) cap *= 2;
+        float* data = new float[NUM_FIELDS*cap];
+        memset(data, 0, NUM_FIELDS*cap*sizeof(float));
+        for(int f=0; f<NUM_FIELDS; f++)
+            memcpy(data + f*cap, _data + f*_cap, _n*sizeof(float));
+        delete[] _data;
+        _data = data;
+        _cap = cap;
+    }
+    _n = n;
+}
+
+void SurfaceArray::update(Vector* surfaces)
+{
+    int old = _n;
+    if(surfaces->size() != _n)
+        resize(surfaces->size());
+
+    for(int i=0; i<_n; i++) {
+        Surface* s = (Surface*)surfaces->get(i);
+        if(i >= old || s->_modified)
+            load(i, s);
+    }
+}
+
+// Copy a surface, folding everything which doesn't depend on the wind
+// into a few coefficients.  Mirrors the logic of Surface::calcForce(),
+// stallFunc(), flapLift() and controlDrag().
+void SurfaceArray::load(int i, Surface* s)
+{
+    s->_modified = false;
+
+    field(PX)[i] = s->_pos[0];
+    field(PY)[i] = s->_pos[1];
+    field(PZ)[i] = s->_pos[2];
+    for(int j=0; j<9; j++)
+        field(O0+j)[i] = s->_orient[j];
+
+    field(C0)[i] = s->_c0;
+    field(CX)[i] = s->_cx;
+    field(CY)[i] = s->_cy;
+    field(CZ)[i] = s->_cz;
+    field(LIFT0)[i] = s->_cz*s->_cz0;
+    field(INCIDENCE)[i] = s->_incidence + s->_twist;
+    field(TORQUEARM)[i] = 0.1667f * s->_chord;
+    field(SPOILERMUL)[i] = 1 + s->_spoilerPos * (s->_spoilerLift - 1);
+    field(INDUCED)[i] = s->_inducedDrag;
+    field(LIVE)[i] = (s->_cx == 0 && s->_cy == 0 && s->_cz == 0) ? 0 : 1;
+
+    // flapLift()
+    field(STALL0)[i] = s->_stalls[0];
+    field(WIDTH0)[i] = s->_widths[0];
+    if(s->_stalls[0] == 0)
+        field(FLAPLIFT)[i] = 0;
+    else
+        field(FLAPLIFT)[i] = s->_cz * s->_flapPos * (s->_flapLift-1)
+            * s->_flapEffectiveness;
+
+    // controlDrag()
+    float fp = s->_flapPos;
+    if(fp < 0) {
+        fp = -fp;
+        fp -= s->_cz0/(s->_flapLift-1);
+        if(fp < 0) fp = 0;
+    }
+    field(FLAPDRAG)[i] = (s->_flapLift - 1 - s->_cz0) * s->_stalls[0] * fp;
+    field(DRAGMUL)[i] = (1 + fp * (s->_flapDrag - 1))
+        * (1 + s->_spoilerPos * (s->_spoilerDrag - 1))
+        * (1 + s->_slatPos * (s->_slatDrag - 1));
+
+    // stallFunc(), by quadrant.  A surface without a stall angle gets a
+    // unity multiplier on every branch.
+    for(int q=0; q<4; q++) {
+        float stall = s->_stalls[q];
+        if(stall == 0) {
+            field(SA0+q)[i] = 0;
+            field(SW0+q)[i] = 1;
+            field(SS0+q)[i] = 1;
+        } else {
+            field(SA0+q)[i] = q == 0 ? stall + s->_slatAlpha : stall;
+            field(SW0+q)[i] = s->_widths[q];
+            field(SS0+q)[i] = 0.5f*s->_peaks[q>>1]/s->_stalls[q&2];
+        }
+    }
+}
+
+void SurfaceArray::getPosition(int i, float* out)
+{
+    out[0] = field(PX)[i];
+    out[1] = field(PY)[i];
+    out[2] = field(PZ)[i];
+}
+
+void SurfaceArray::setWind(int i, float* v)
+{
+    field(WX)[i] = v[0];
+    field(WY)[i] = v[1];
+    field(WZ)[i] = v[2];
+}
+
+void SurfaceArray::calcForces(float rho, float* cg, float* forceOut,
+                              float* torqueOut)
+{
+    float f[3] = { 0, 0, 0 }, t[3] = { 0, 0, 0 };
+    for(int i=0; i<_n; i+=BLOCK) {
+        int n = _n - i < BLOCK ? _n - i : BLOCK;
+        calcBlock(i, n, rho, cg, f, t);
+    }
+    Math::set3(f, forceOut);
+    Math::set3(t, torqueOut);
+}
+
+// Each pass is a loop without branches (only selects between values
+// already computed) over a handful of arrays, writing into local
+// arrays, so that it compiles to vector code.  See Surface::calcForce()
+// for the commented physics.
+void SurfaceArray::calcBlock(int first, int n, float rho, float* cg,
+                             float* forceSum, float* torqueSum)
+{
+    float sx[BLOCK], sy[BLOCK], sz[BLOCK], vel2[BLOCK];
+    float stallLift[BLOCK], flaps[BLOCK];
+    float fx[BLOCK], fy[BLOCK], fz[BLOCK];
+    float tx[BLOCK], ty[BLOCK], tz[BLOCK];
+    int i;
+
+    const float* o0 = field(O0) + first; const float* o1 = field(O1) + first;
+    const float* o2 = field(O2) + first; const float* o3 = field(O3) + first;
+    const float* o4 = field(O4) + first; const float* o5 = field(O5) + first;
+    const float* o6 = field(O6) + first; const float* o7 = field(O7) + first;
+    const float* o8 = field(O8) + first;
+    const float* incidence = field(INCIDENCE) + first;
+
+    // Unit wind in surface coordinates, "rotated" by the incidence.
+    // Zero wind stays zero, and makes zero force below.
+    const float* wx = field(WX) + first; const float* wy = field(WY) + first;
+    const float* wz = field(WZ) + first;
+    for(i=0; i<n; i++) {
+        float v2 = wx[i]*wx[i] + wy[i]*wy[i] + wz[i]*wz[i];
+        float inv = 1/Math::sqrt(v2);
+        inv = v2 > 0 ? inv : 0;
+        float ux = wx[i]*inv, uy = wy[i]*inv, uz = wz[i]*inv;
+        float x = o0[i]*ux + o1[i]*uy + o2[i]*uz;
+        sx[i] = x;
+        sy[i] = o3[i]*ux + o4[i]*uy + o5[i]*uz;
+        sz[i] = o6[i]*ux + o7[i]*uy + o8[i]*uz + incidence[i]*x;
+        vel2[i] = v2;
+    }
+
+    // Stall multiplier of the quadrant the wind comes from, as the
+    // extra lift it makes
+    const float* cz = field(CZ) + first;
+    const float* spoilerMul = field(SPOILERMUL) + first;
+    const float* sa0 = field(SA0) + first; const float* sa1 = field(SA1) + first;
+    const float* sa2 = field(SA2) + first; const float* sa3 = field(SA3) + first;
+    const float* sw0 = field(SW0) + first; const float* sw1 = field(SW1) + first;
+    const float* sw2 = field(SW2) + first; const float* sw3 = field(SW3) + first;
+    const float* ss0 = field(SS0) + first; const float* ss1 = field(SS1) + first;
+    const float* ss2 = field(SS2) + first; const float* ss3 = field(SS3) + first;
+    for(i=0; i<n; i++) {
+        float x = sx[i], z = sz[i];
+        bool back = x > 0, neg = z < 0;
+        float a0 = sa0[i], a1 = sa1[i], a2 = sa2[i], a3 = sa3[i];
+        float w0 = sw0[i], w1 = sw1[i], w2 = sw2[i], w3 = sw3[i];
+        float s0 = ss0[i], s1 = ss1[i], s2 = ss2[i], s3 = ss3[i];
+        float sa = back ? (neg ? a3 : a2) : (neg ? a1 : a0);
+        float sw = back ? (neg ? w3 : w2) : (neg ? w1 : w0);
+        float ss = back ? (neg ? s3 : s2) : (neg ? s1 : s0);
+
+        float alpha = Math::abs(z/x);
+        float frac = (alpha - sa) / sw;
+        frac = frac*frac*(3-2*frac);
+        float inside = ss*(1-frac) + frac;
+        float mul = alpha <= sa ? ss : inside;
+        mul = alpha > sa + sw ? 1 : mul;
+        mul = x == 0 ? 1 : mul;
+        stallLift[i] = (mul * spoilerMul[i] - 1) * cz[i] * z;
+    }
+
+    // Flap lift, faded out through the stall
+    const float* flapLift = field(FLAPLIFT) + first;
+    const float* stall0 = field(STALL0) + first;
+    const float* width0 = field(WIDTH0) + first;
+    for(i=0; i<n; i++) {
+        float alpha = Math::abs(sz[i]);
+        float lift = flapLift[i];
+        float frac = (alpha - stall0[i]) / width0[i];
+        frac = frac*frac*(3-2*frac);
+        float fade = lift * (1-frac);
+        fade = alpha > stall0[i] + width0[i] ? 0 : fade;
+        flaps[i] = alpha < stall0[i] ? lift : fade;
+    }
+
+    // Lift, drag and side force, back to aircraft coordinates with
+    // units
+    const float* c0 = field(C0) + first;
+    const float* cx = field(CX) + first;
+    const float* cy = field(CY) + first;
+    const float* lift0 = field(LIFT0) + first;
+    const float* torqueArm = field(TORQUEARM) + first;
+    const float* flapDrag = field(FLAPDRAG) + first;
+    const float* dragMul = field(DRAGMUL) + first;
+    const float* induced = field(INDUCED) + first;
+    const float* live = field(LIVE) + first;
+    for(i=0; i<n; i++) {
+        float lx = sx[i], ly = sy[i], lz = sz[i];
+        float oz = lz*cz[i] + lift0[i] + stallLift[i] + flaps[i];
+        float torque = torqueArm[i] * (flaps[i] - (lift0[i] + stallLift[i]));
+
+        // Control drag
+        float drag = cx[i] * lx;
+        float fd = Math::abs(oz * flapDrag[i]);
+        drag += drag < 0 ? -fd : fd;
+        float ox = drag * dragMul[i];
+        float oy = ly * cy[i];
+
+        // Induced drag
+        float k = -induced[i] * oz * lz;
+        ox += k * lx;
+        oy += k * ly;
+        oz += k * lz;
+
+        oz -= incidence[i] * ox;
+
+        float scale = 0.5f*rho*vel2[i]*c0[i]*live[i];
+        fx[i] = scale * (o0[i]*ox + o3[i]*oy + o6[i]*oz);
+        fy[i] = scale * (o1[i]*ox + o4[i]*oy + o7[i]*oz);
+        fz[i] = scale * (o2[i]*ox + o5[i]*oy + o8[i]*oz);
+        torque *= scale;
+        tx[i] = o3[i] * torque;
+        ty[i] = o4[i] * torque;
+        tz[i] = o5[i] * torque;
+    }
+
+    // Sum up, with the torque of each force about the c.g.:
+    // F cross (C - X), as in RigidBody::addForce()
+    const float* px = field(PX) + first;
+    const float* py = field(PY) + first;
+    const float* pz = field(PZ) + first;
+    float f0 = 0, f1 = 0, f2 = 0, t0 = 0, t1 = 0, t2 = 0;
+    for(i=0; i<n; i++) {
+        float dx = cg[0] - px[i], dy = cg[1] - py[i], dz = cg[2] - pz[i];
+        f0 += fx[i];
+        f1 += fy[i];
+        f2 += fz[i];
+        t0 += tx[i] + fy[i]*dz - dy*fz[i];
+        t1 += ty[i] + fz[i]*dx - dz*fx[i];
+        t2 += tz[i] + fx[i]*dy - dx*fy[i];
+    }
+    forceSum[0] += f0; forceSum[1] += f1; forceSum[2] += f2;
+    torqueSum[0] += t0; torqueSum[1] += t1; torqueSum[2] += t2;
+}
+
+}; // namespace yasim
@@ -0,0 +1,76 @@
+#ifndef _SURFACEARRAY_HPP
+#define _SURFACEARRAY_HPP
+
+#include "Vector.hpp"
+
+namespace yasim {
+
+class Surface;
+
+// The surfaces of a Model, stored field by field ("structure of
+// arrays") so that the aerodynamic forces of all of them are computed
+// in a few tight loops over float arrays, which the compiler can
+// vectorize.  Surface::calcForce() remains the reference for the
+// physics; the results agree with it to float rounding.
+//
+// The parameters are copied from the Surface objects, but only for the
+// surfaces whose setters were called since the last update().
+class SurfaceArray
+{
+public:
+    SurfaceArray();
+    ~SurfaceArray();
+
+    // Pick up new and changed surfaces from the Model's list.
+    void update(Vector* surfaces);
+
+    int size() { return _n; }
+    void getPosition(int i, float* out);
+
+    // Local wind at surface i, in aircraft coordinates
+    void setWind(int i, float* v);
+
+    // Compute the forces of all surfaces for an air density rho, and
+    // sum them into a total force and a total torque about the c.g.
+    void calcForces(float rho, float* cg, float* forceOut, float* torqueOut);
+
+private:
+    // Per-surface fields, each an array of _cap floats
+    enum {
+        PX, PY, PZ,                     // position
+        O0, O1, O2, O3, O4, O5, O6, O7, O8, // orientation matrix
+        WX, WY, WZ,                     // local wind
+        C0, CX, CY, CZ,
+        LIFT0,                          // cz*cz0, zero-alpha lift
+        INCIDENCE,                      // incidence + twist
+        TORQUEARM,                      // 0.1667 * chord
+        SPOILERMUL,                     // lift multiplier of the spoilers
+        FLAPLIFT,                       // flap lift below the stall
+        STALL0, WIDTH0,                 // forward stall for the flap lift
+        FLAPDRAG,                       // drag per lift from the flaps
+        DRAGMUL,                        // control drag multiplier
+        INDUCED,
+        LIVE,                           // 0 for surfaces with no force
+        SA0, SA1, SA2, SA3,             // stall angles, by quadrant
+        SW0, SW1, SW2, SW3,             // stall widths
+        SS0, SS1, SS2, SS3,             // pre-stall multipliers
+        NUM_FIELDS
+    };
+
+    // Surfaces per pass of calcBlock(), whose temporaries live on the
+    // stack
+    enum { BLOCK = 64 };
+
+    float* field(int f) { return _data + f*_cap; }
+    void resize(int n);
+    void load(int i, Surface* s);
+    void calcBlock(int first, int n, float rho, float* cg,
+                   float* forceSum, float* torqueSum);
+
+    int _n;
+    int _cap;
+    float* _data;
+};
+
+}; // namespace yasim
+#endif // _SURFACEARRAY_HPP
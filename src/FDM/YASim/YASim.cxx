@@ -5,10 +5,13 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <fstream>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 #include <simgear/misc/sg_path.hxx>
+#include <simgear/misc/sg_dir.hxx>
+#include <simgear/misc/stdint.hxx>
 #include <simgear/scene/model/placement.hxx>
 #include <simgear/xml/easyxml.hxx>
 
@@ -46,6 +49,74 @@ static const float W2HP = 1.3416e-3;
 static const float INHG2PA = 3386.389;
 static const float SLUG2KG = 14.59390;
 
+// Bump when a change to YASim alters the solver results, so that cached
+// solutions are not reused.
+static const int SOLUTION_VERSION = 1;
+
+// Where the solution for an aircraft file is cached: the file name
+// carries a hash of the file contents and of the version, so any edit
+// of the aircraft, or a new FlightGear, gets a fresh solve.
+static SGPath solutionCachePath(const SGPath& xml)
+{
+    std::ifstream in(xml.c_str(), std::ios::in | std::ios::binary);
+    if(!in)
+        return SGPath();
+
+    // 64 bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    char buf[4096];
+    while(in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+        for(std::streamsize i=0; i<in.gcount(); i++) {
+            hash ^= (unsigned char)buf[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    char key[64];
+    sprintf(key, "%s-%d", VERSION, SOLUTION_VERSION);
+    for(const char* c=key; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 1099511628211ULL;
+    }
+
+    sprintf(buf, "%08x%08x.solution", (unsigned int)(hash >> 32),
+            (unsigned int)(hash & 0xffffffff));
+    SGPath path(globals->get_fg_home());
+    path.append("YASim");
+    path.append(xml.file() + "-" + buf);
+    return path;
+}
+
+static bool readSolution(const SGPath& path, Airplane::Solution* s)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if(!f)
+        return false;
+    int n = fscanf(f, "%g %g %g %g %g %d", &s->dragFactor, &s->liftRatio,
+                   &s->cruiseAoA, &s->tailIncidence, &s->approachElevator,
+                   &s->iterations);
+    fclose(f);
+    return n == 6;
+}
+
+static void writeSolution(const SGPath& path, Airplane::Solution* s)
+{
+    SGPath dir(path.dir());
+    if(!dir.exists())
+        simgear::Dir(dir).create(0755);
+
+    // %.9g is exact for floats
+    FILE* f = fopen(path.c_str(), "w");
+    if(!f) {
+        SG_LOG(SG_FLIGHT, SG_WARN, "Cannot write YASim solution cache "
+               << path.str());
+        return;
+    }
+    fprintf(f, "%.9g %.9g %.9g %.9g %.9g %d\n", s->dragFactor, s->liftRatio,
+            s->cruiseAoA, s->tailIncidence, s->approachElevator,
+            s->iterations);
+    fclose(f);
+}
+
 YASim::YASim(double dt) :
     _simTime(0)
 {
@@ -146,6 +217,11 @@ void YASim::init()
     model->setCrashed(false);
     _crashed->setBoolValue(false);
 
+    // The per-surface force code is kept for cross-checking the
+    // batched one
+    model->setReferenceSurfaces(fgGetBool("/fdm/yasim/reference-surfaces", false));
+    model->setReferenceRotors(fgGetBool("/fdm/yasim/reference-rotors", false));
+
     // Figure out the initial speed type
     string speed_set = _speed_setprop->getStringValue();
     if ((speed_set == "") || (speed_set == "UVW"))
@@ -174,8 +250,36 @@ void YASim::init()
         throw e;
     }
 
+    // Reuse the solution of an earlier load of the same file.  Solving
+    // from scratch, let a second copy of the airplane run the approach
+    // configuration in parallel; hitches talk to the property tree, so
+    // those airplanes solve in one thread.
+    SGPath cache;
+    Airplane::Solution solution;
+    bool cached = false;
+    FGFDM* twin = 0;
+    if(fgGetBool("/fdm/yasim/solution-cache", true)) {
+        cache = solutionCachePath(f);
+        if(!cache.isNull() && readSolution(cache, &solution)) {
+            SG_LOG(SG_FLIGHT, SG_INFO, "Using cached YASim solution "
+                   << cache.str());
+            airplane->setSolution(&solution);
+            cached = true;
+        }
+    }
+    if(!cached && airplane->numHitches() == 0
+       && fgGetBool("/fdm/yasim/parallel-solve", true))
+    {
+        twin = new FGFDM();
+        readXML(f.str(), *twin);
+        airplane->setSolveTwin(twin->getAirplane());
+    }
+
     // Compile it into a real airplane, and tell the user what they got
     airplane->compile();
+    delete twin;
+    if(!cached && !cache.isNull() && airplane->getSolution(&solution))
+        writeSolution(cache, &solution);
     report();
 
     _fdm->init();
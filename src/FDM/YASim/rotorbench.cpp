@@ -0,0 +1,149 @@
+#include <stdio.h>
+
+#include <cstring>
+#include <cstdlib>
+
+#include <simgear/props/props.hxx>
+#include <simgear/xml/easyxml.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "Math.hpp"
+#include "FGFDM.hpp"
+#include "Atmosphere.hpp"
+#include "Airplane.hpp"
+
+using namespace yasim;
+
+// Times the rotor forces of a helicopter: the model is loaded twice,
+// one copy computes its rotors with Rotorpart::calcForce() part by
+// part, the other one with the RotorpartArray.  Both see the same
+// frames, so their accelerations show how far the two paths agree.
+
+// Stubs.  Not needed by a batch program, but required to link.
+bool fgSetFloat (const char * name, float val) { return false; }
+bool fgSetBool(char const * name, bool val) { return false; }
+bool fgGetBool(char const * name, bool def) { return false; }
+bool fgSetString(char const * name, char const * str) { return false; }
+SGPropertyNode* fgGetNode (const char * path, bool create) { return 0; }
+SGPropertyNode* fgGetNode (const char * path, int i, bool create) { return 0; }
+float fgGetFloat (const char * name, float defaultValue) { return 0; }
+double fgGetDouble (const char * name, double defaultValue = 0.0) { return 0; }
+bool fgSetDouble (const char * name, double defaultValue = 0.0) { return 0; }
+
+static const float DEG2RAD = 0.0174532925199;
+static const float KTS2MPS = 0.514444444444;
+static const float FT2M = 0.3048;
+
+static int usage()
+{
+    fprintf(stderr, "Usage: yasim-rotorbench <heli.xml> [-n frames] [-a alt-ft] [-s kts]\n");
+    return 1;
+}
+
+static bool load(FGFDM* fdm, const char* file)
+{
+    try {
+        readXML(file, *fdm);
+    } catch (const sg_exception &e) {
+        printf("XML parse error: %s (%s)\n",
+               e.getFormattedMessage().c_str(), e.getOrigin());
+        return false;
+    }
+    Airplane* a = fdm->getAirplane();
+    a->compile();
+    if(a->getFailureMsg()) {
+        printf("SOLUTION FAILURE: %s\n", a->getFailureMsg());
+        return false;
+    }
+    return true;
+}
+
+// One frame as the FDM runs it for the rotors: turn them, then the
+// forces of the four integrator steps
+static void frame(Model* m, State* s, float dt)
+{
+    float lrot[3] = { 0, 0, 0 };
+    m->getRotorgear()->initRotorIteration(lrot, dt);
+    for(int i=0; i<4; i++) {
+        m->getBody()->reset();
+        m->calcForces(s);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2) return usage();
+    int frames = 10000;
+    float alt = 1000, kts = 60;
+    for(int i=2; i<argc; i++) {
+        if     (std::strcmp(argv[i], "-n") == 0 && i+1 < argc) frames = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "-a") == 0 && i+1 < argc) alt = std::atof(argv[++i]);
+        else if(std::strcmp(argv[i], "-s") == 0 && i+1 < argc) kts = std::atof(argv[++i]);
+        else return usage();
+    }
+
+    FGFDM* fdm[2];
+    Model* m[2];
+    State s[2];
+    const float dt = 1/120.0f;
+    for(int k=0; k<2; k++) {
+        fdm[k] = new FGFDM();
+        if(!load(fdm[k], argv[1]))
+            return 1;
+        m[k] = fdm[k]->getAirplane()->getModel();
+        if(!m[k]->getRotorgear()->isInUse()) {
+            printf("%s has no rotors\n", argv[1]);
+            return 1;
+        }
+        m[k]->setReferenceRotors(k == 0);
+
+        float altm = alt * FT2M;
+        m[k]->setAir(Atmosphere::getStdPressure(altm),
+                     Atmosphere::getStdTemperature(altm),
+                     Atmosphere::getStdDensity(altm));
+        Airplane::setupState(2*DEG2RAD, kts * KTS2MPS, 0, &s[k]);
+        m[k]->setState(&s[k]);
+        m[k]->getIntegrator()->setInterval(dt);
+        m[k]->getBody()->recalc();
+
+        // Spinning at the nominal speed, held by the engine
+        Rotorgear* g = m[k]->getRotorgear();
+        g->setEngineOn(1);
+        g->getRotor(0)->setOmegaRelNeu(1);
+    }
+
+    int parts = 0;
+    for(int i=0; i<m[0]->getRotorgear()->getNumRotors(); i++)
+        parts += m[0]->getRotorgear()->getRotor(i)->numRotorparts();
+    printf("%d rotors, %d rotor parts, %d frames\n",
+           m[0]->getRotorgear()->getNumRotors(), parts, frames);
+
+    // Warm up, then time each path
+    double usec[2];
+    for(int k=0; k<2; k++) {
+        for(int f=0; f<100; f++)
+            frame(m[k], &s[k], dt);
+        SGTimeStamp t = SGTimeStamp::now();
+        for(int f=0; f<frames; f++)
+            frame(m[k], &s[k], dt);
+        usec[k] = (SGTimeStamp::now() - t).toUSecs() / frames;
+    }
+
+    float acc[2][3], rot[2][3], diff[3];
+    for(int k=0; k<2; k++) {
+        m[k]->getBody()->getAccel(acc[k]);
+        m[k]->getBody()->getAngularAccel(rot[k]);
+    }
+    printf("   Rotorpart: %8.2f us/frame\n", usec[0]);
+    printf("   Array:     %8.2f us/frame (%.2fx)\n", usec[1], usec[0]/usec[1]);
+    Math::sub3(acc[0], acc[1], diff);
+    printf("   Difference of the accelerations: %g m/s^2 (of %g)\n",
+           Math::mag3(diff), Math::mag3(acc[0]));
+    Math::sub3(rot[0], rot[1], diff);
+    printf("   Difference of the rotational accelerations: %g rad/s^2 (of %g)\n",
+           Math::mag3(diff), Math::mag3(rot[0]));
+
+    delete fdm[0];
+    delete fdm[1];
+    return 0;
+}
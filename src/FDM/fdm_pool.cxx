@@ -0,0 +1,446 @@
+// fdm_pool.cxx -- full flight models for AI and scripted aircraft
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "fdm_pool.hxx"
+
+#include <algorithm>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/props/props_io.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+#include <AIModel/AIAircraft.hxx>
+#include <AIModel/AIManager.hxx>
+#include <FDM/flight.hxx>
+#include <FDM/UFO.hxx>
+#include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
+#include <Scenery/scenery.hxx>
+
+#ifdef ENABLE_YASIM
+#include <FDM/YASim/YASim.hxx>
+#endif
+
+namespace {
+
+// properties of the global tree copied into each instance's tree every
+// frame; the FDMs read some of them directly
+const char* SHARED_PROPERTIES[] = {
+  "/sim/model-hz",
+  "/sim/speed-up",
+  "/environment/wind-from-north-fps",
+  "/environment/wind-from-east-fps",
+  "/environment/wind-from-down-fps",
+  "/environment/temperature-degc",
+  "/environment/pressure-inhg",
+  "/environment/density-slugft3",
+  "/environment/params/control-fdm-atmosphere",
+  "/environment/turbulence/magnitude-norm",
+  "/environment/turbulence/rate-hz",
+  0
+};
+
+} // of anonymous namespace
+
+class FDMPool::Instance
+{
+public:
+  Instance(SGPropertyNode* config) :
+    _config(config),
+    _root(new SGPropertyNode),
+    _impl(NULL),
+    _failed(false)
+  {
+    for (int i = 0; SHARED_PROPERTIES[i]; ++i) {
+      SGPropertyNode* src = globals->get_props()->getNode(SHARED_PROPERTIES[i], true);
+      _shared.push_back(SharedProperty(src, _root->getNode(SHARED_PROPERTIES[i], true)));
+    }
+
+    _controls = _config->getNode("controls", true);
+    _latitude = _config->getNode("position/latitude-deg", true);
+    _longitude = _config->getNode("position/longitude-deg", true);
+    _altitude = _config->getNode("position/altitude-ft", true);
+    _roll = _config->getNode("orientation/roll-deg", true);
+    _pitch = _config->getNode("orientation/pitch-deg", true);
+    _heading = _config->getNode("orientation/heading-deg", true);
+    _airspeed = _config->getNode("velocities/airspeed-kt", true);
+    _verticalSpeed = _config->getNode("velocities/vertical-speed-fps", true);
+  }
+
+  ~Instance()
+  {
+    release();
+  }
+
+  /**
+   * Create and initialise the FDM once its AI aircraft exists and the
+   * scenery around it is loaded. Returns true when the instance is ready
+   * to be stepped.
+   */
+  bool prepare()
+  {
+    if (_failed) {
+      return false;
+    }
+
+    std::string callsign = _config->getStringValue("callsign");
+    if (!callsign.empty()) {
+      if (_ai && _ai->getDie()) {
+        release();
+      }
+
+      if (!_ai) {
+        _ai = findAircraft(callsign);
+        if (!_ai) {
+          return false; // not (yet) there
+        }
+      }
+    }
+
+    if (!_impl) {
+      create();
+      if (!_impl) {
+        return false;
+      }
+    }
+
+    if (!_impl->get_inited()) {
+      SGGeod geod = SGGeod::fromDeg(_root->getDoubleValue("sim/presets/longitude-deg"),
+                                    _root->getDoubleValue("sim/presets/latitude-deg"));
+      if (!globals->get_scenery()->scenery_available(geod, 1000.0)) {
+        return false;
+      }
+
+      fgSetThreadPropertyRoot(_root);
+      _impl->init();
+      _impl->bind();
+      fgSetThreadPropertyRoot(0);
+      SG_LOG(SG_FLIGHT, SG_INFO, "FDM pool: initialized " << _config->getPath());
+    }
+
+    copyIn();
+    return true;
+  }
+
+  void step(double dt)
+  {
+    fgSetThreadPropertyRoot(_root);
+    _impl->update(dt);
+    fgSetThreadPropertyRoot(0);
+  }
+
+  void publish()
+  {
+    _latitude->setDoubleValue(_impl->get_Latitude_deg());
+    _longitude->setDoubleValue(_impl->get_Longitude_deg());
+    _altitude->setDoubleValue(_impl->get_Altitude());
+    _roll->setDoubleValue(_impl->get_Phi_deg());
+    _pitch->setDoubleValue(_impl->get_Theta_deg());
+    _heading->setDoubleValue(_impl->get_Psi_deg());
+    _airspeed->setDoubleValue(_impl->get_V_calibrated_kts());
+    _verticalSpeed->setDoubleValue(_impl->get_Climb_Rate());
+
+    if (_ai) {
+      SGGeod pos = SGGeod::fromDegFt(_impl->get_Longitude_deg(),
+                                     _impl->get_Latitude_deg(),
+                                     _impl->get_Altitude());
+      _ai->setExternalState(pos, _impl->get_Psi_deg(), _impl->get_Theta_deg(),
+                            _impl->get_Phi_deg(), _impl->get_V_true_kts(),
+                            _impl->get_Climb_Rate() * 60.0);
+    }
+  }
+
+private:
+  typedef std::pair<SGPropertyNode_ptr, SGPropertyNode_ptr> SharedProperty;
+
+  static FGAIAircraft* findAircraft(const std::string& callsign)
+  {
+    FGAIManager* aiMgr = (FGAIManager*)globals->get_subsystem("ai-model");
+    if (!aiMgr) {
+      return NULL;
+    }
+
+    FGAIManager::ai_list_const_iterator it;
+    for (it = aiMgr->get_ai_list().begin(); it != aiMgr->get_ai_list().end(); ++it) {
+      FGAIBase* base = *it;
+      if (base->isa(FGAIBase::otAircraft) && !base->getDie()
+          && (base->getCallSign() == callsign)) {
+        return static_cast<FGAIAircraft*>(base);
+      }
+    }
+
+    return NULL;
+  }
+
+  void create()
+  {
+    std::string model = _config->getStringValue("flight-model", "yasim");
+    _root->setStringValue("sim/flight-model", model);
+    _root->setStringValue("sim/aircraft-dir", _config->getStringValue("aircraft-dir"));
+    _root->setStringValue("sim/aero", _config->getStringValue("aero"));
+
+    SGPropertyNode* presets = _root->getNode("sim/presets", true);
+    SGPropertyNode* configPresets = _config->getNode("presets");
+    if (configPresets) {
+      copyProperties(configPresets, presets);
+    }
+
+    if (_ai) {
+      // start where the AI aircraft is
+      presets->setDoubleValue("latitude-deg", _ai->_getLatitude());
+      presets->setDoubleValue("longitude-deg", _ai->_getLongitude());
+      presets->setDoubleValue("altitude-ft", _ai->_getAltitude());
+      presets->setDoubleValue("heading-deg", _ai->_getHeading());
+      presets->setDoubleValue("pitch-deg", _ai->_getPitch());
+      presets->setDoubleValue("roll-deg", _ai->_getRoll());
+      presets->setStringValue("speed-set", "knots");
+      presets->setDoubleValue("airspeed-kt", _ai->_getSpeed());
+      presets->setBoolValue("onground", _ai->onGround());
+    }
+
+    for (size_t i = 0; i < _shared.size(); ++i) {
+      copyValue(_shared[i].first, _shared[i].second);
+    }
+
+    double dt = 1.0 / _root->getIntValue("sim/model-hz", 120);
+    fgSetThreadPropertyRoot(_root);
+    if (model == "ufo") {
+      _impl = new FGUFO(dt);
+    }
+#ifdef ENABLE_YASIM
+    else if (model == "yasim") {
+      _impl = new YASim(dt);
+    }
+#endif
+    fgSetThreadPropertyRoot(0);
+
+    if (!_impl) {
+      SG_LOG(SG_FLIGHT, SG_ALERT, "FDM pool: flight model '" << model
+             << "' is not available for " << _config->getPath());
+      _failed = true;
+    }
+  }
+
+  void release()
+  {
+    if (_ai) {
+      _ai->clearExternalState();
+      _ai.clear();
+    }
+
+    if (_impl) {
+      fgSetThreadPropertyRoot(_root);
+      if (_impl->get_bound()) {
+        _impl->unbind();
+      }
+      delete _impl;
+      fgSetThreadPropertyRoot(0);
+      _impl = NULL;
+    }
+  }
+
+  // the instance's input: controls and environment
+  void copyIn()
+  {
+    copyProperties(_controls, _root->getNode("controls", true));
+    for (size_t i = 0; i < _shared.size(); ++i) {
+      copyValue(_shared[i].first, _shared[i].second);
+    }
+
+    _impl->set_Velocities_Local_Airmass(
+          _root->getDoubleValue("environment/wind-from-north-fps"),
+          _root->getDoubleValue("environment/wind-from-east-fps"),
+          _root->getDoubleValue("environment/wind-from-down-fps"));
+
+    if (_root->getBoolValue("environment/params/control-fdm-atmosphere")) {
+      // as FDMShell::update()
+      double tempDegC = _root->getDoubleValue("environment/temperature-degc");
+      _impl->set_Static_temperature((9.0/5.0) * (tempDegC + 273.15));
+      double pressureInHg = _root->getDoubleValue("environment/pressure-inhg");
+      _impl->set_Static_pressure(pressureInHg * 70.726566);
+      _impl->set_Density(_root->getDoubleValue("environment/density-slugft3"));
+    }
+  }
+
+  static void copyValue(SGPropertyNode* src, SGPropertyNode* dst)
+  {
+    if (src->getType() == simgear::props::BOOL) {
+      dst->setBoolValue(src->getBoolValue());
+    } else {
+      dst->setDoubleValue(src->getDoubleValue());
+    }
+  }
+
+  SGPropertyNode_ptr _config;
+  SGPropertyNode_ptr _root; // private property tree of the FDM
+  FGInterface* _impl;
+  SGSharedPtr<FGAIAircraft> _ai;
+  bool _failed;
+
+  std::vector<SharedProperty> _shared;
+  SGPropertyNode_ptr _controls;
+  SGPropertyNode_ptr _latitude, _longitude, _altitude;
+  SGPropertyNode_ptr _roll, _pitch, _heading;
+  SGPropertyNode_ptr _airspeed, _verticalSpeed;
+};
+
+class FDMPool::Worker : public SGThread
+{
+public:
+  Worker(FDMPool* pool) :
+    _pool(pool)
+  {
+  }
+
+protected:
+  virtual void run()
+  {
+    _pool->workerLoop();
+  }
+
+private:
+  FDMPool* _pool;
+};
+
+FDMPool::FDMPool() :
+  _dt(0.0),
+  _next(0),
+  _busy(0),
+  _quit(false)
+{
+}
+
+FDMPool::~FDMPool()
+{
+  clear();
+}
+
+void FDMPool::init()
+{
+  clear();
+
+  _root = fgGetNode("/fdm/pool", true);
+  _threads = _root->getNode("threads", true);
+  if (!_threads->hasValue()) {
+    _threads->setIntValue(2);
+  }
+
+  simgear::PropertyList aircraft = _root->getChildren("aircraft");
+  for (size_t i = 0; i < aircraft.size(); ++i) {
+    _instances.push_back(new Instance(aircraft[i]));
+  }
+
+  unsigned int count = std::max(0, _threads->getIntValue());
+  for (unsigned int i = 0; i < count; ++i) {
+    Worker* w = new Worker(this);
+    w->start();
+    _workers.push_back(w);
+  }
+}
+
+void FDMPool::clear()
+{
+  if (!_workers.empty()) {
+    {
+      SGGuard<SGMutex> g(_lock);
+      _quit = true;
+      _workAvailable.broadcast();
+    }
+
+    for (size_t i = 0; i < _workers.size(); ++i) {
+      _workers[i]->join();
+      delete _workers[i];
+    }
+    _workers.clear();
+    _quit = false;
+  }
+
+  for (size_t i = 0; i < _instances.size(); ++i) {
+    delete _instances[i];
+  }
+  _instances.clear();
+}
+
+void FDMPool::beginUpdate(double dt)
+{
+  SGGuard<SGMutex> g(_lock);
+  _stepping.clear();
+  for (size_t i = 0; i < _instances.size(); ++i) {
+    if (_instances[i]->prepare()) {
+      _stepping.push_back(_instances[i]);
+    }
+  }
+
+  _dt = dt;
+  _next = 0;
+  if (!_stepping.empty()) {
+    _workAvailable.broadcast();
+  }
+}
+
+void FDMPool::endUpdate()
+{
+  {
+    SGGuard<SGMutex> g(_lock);
+    // without workers, or if they are still busy with something else,
+    // the main thread steps what is left
+    processInstances();
+    while (_busy > 0) {
+      _workDone.wait(_lock);
+    }
+  }
+
+  for (size_t i = 0; i < _stepping.size(); ++i) {
+    _stepping[i]->publish();
+  }
+  _stepping.clear();
+}
+
+void FDMPool::workerLoop()
+{
+  SGGuard<SGMutex> g(_lock);
+  while (!_quit) {
+    if (_next < _stepping.size()) {
+      processInstances();
+    } else {
+      _workAvailable.wait(_lock);
+    }
+  }
+}
+
+// called with _lock held, and returns with it held; the lock is released
+// while an instance is stepped
+void FDMPool::processInstances()
+{
+  while (_next < _stepping.size()) {
+    Instance* instance = _stepping[_next++];
+    double dt = _dt;
+    ++_busy;
+
+    _lock.unlock();
+    instance->step(dt);
+    _lock.lock();
+
+    --_busy;
+    if (_busy == 0) {
+      _workDone.signal();
+    }
+  }
+}
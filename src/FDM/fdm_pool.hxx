@@ -0,0 +1,99 @@
+// fdm_pool.hxx -- full flight models for AI and scripted aircraft
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_FDM_POOL_HXX
+#define FG_FDM_POOL_HXX
+
+#include <vector>
+
+#include <simgear/props/props.hxx>
+#include <simgear/threads/SGThread.hxx>
+
+/**
+ * Runs additional flight models, besides the one of the user's aircraft,
+ * each for an AI aircraft or a scripted aircraft. They are configured
+ * under /fdm/pool:
+ *
+ * @code
+ * /fdm/pool/threads          worker threads (default 2)
+ * /fdm/pool/aircraft[n]/
+ *   flight-model             yasim or ufo
+ *   aircraft-dir, aero       as /sim/aircraft-dir and /sim/aero
+ *   callsign                 AI aircraft to drive, if any
+ *   presets/                 initial state when not driving an AI aircraft,
+ *                            as /sim/presets
+ *   controls/                input, as /controls
+ *   position/, orientation/, velocities/
+ *                            output
+ * @endcode
+ *
+ * Nothing is shared between the instances: each one has a private property
+ * tree, its own ground cache, and is stepped on a worker thread with
+ * fgSetThreadPropertyRoot() pointing at its tree, while the main thread
+ * steps the user's FDM. The controls and the environment are copied in
+ * before the step, and the resulting state is copied out after it,
+ * including into the AI aircraft, which then follows it instead of its
+ * performance model.
+ *
+ * JSBSim instances are not supported, since JSBSim keeps the ground
+ * callback of its FGLocation in a process-wide static.
+ */
+class FDMPool
+{
+public:
+  FDMPool();
+  ~FDMPool();
+
+  /**
+   * (Re)create the instances from the configuration.
+   */
+  void init();
+
+  /**
+   * Start stepping the instances on the worker threads.
+   */
+  void beginUpdate(double dt);
+
+  /**
+   * Wait for the instances, and publish their state.
+   */
+  void endUpdate();
+
+private:
+  class Instance;
+  class Worker;
+
+  void clear();
+  void workerLoop();
+  void processInstances();
+
+  std::vector<Instance*> _instances;
+  SGPropertyNode_ptr _root, _threads;
+
+  SGMutex _lock;
+  SGWaitCondition _workAvailable;
+  SGWaitCondition _workDone;
+  std::vector<Worker*> _workers;
+
+  // the current batch, guarded by _lock
+  std::vector<Instance*> _stepping;
+  double _dt;
+  size_t _next;       // first instance not yet handed out
+  unsigned int _busy; // instances being stepped right now
+  bool _quit;
+};
+
+#endif // of FG_FDM_POOL_HXX
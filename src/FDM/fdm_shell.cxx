@@ -93,6 +93,7 @@ void FDMShell::init()
   _replay_master    = _props->getNode("/sim/freeze/replay-state",           true);
 
   createImplementation();
+  _pool.init();
 }
 
 void FDMShell::reinit()
@@ -183,8 +184,10 @@ void FDMShell::update(double dt)
   switch(_replay_master->getIntValue())
   {
       case 0:
-          // normal FDM operation
+          // normal FDM operation; the pool steps alongside
+          _pool.beginUpdate(dt);
           _impl->update(dt);
+          _pool.endUpdate();
           break;
       case 3:
           // resume FDM operation at current replay position
@@ -25,6 +25,7 @@
 
 #include <simgear/structure/subsystem_mgr.hxx>
 #include "TankProperties.hxx"
+#include "fdm_pool.hxx"
 
 // forward decls
 class FGInterface;
@@ -57,6 +58,7 @@ private:
   
   TankPropertiesList _tankProperties;
   FGInterface* _impl;
+  FDMPool _pool; // flight models of other aircraft
   SGPropertyNode_ptr _props; // root property tree for this FDM instance
   bool _dataLogging;
   
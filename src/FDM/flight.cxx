@@ -30,6 +30,8 @@
 #include <simgear/debug/logstream.hxx>
 #include <simgear/timing/timestamp.hxx>
 #include <simgear/scene/material/mat.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include <Scenery/scenery.hxx>
 #include <Main/globals.hxx>
@@ -37,6 +39,11 @@
 #include <FDM/groundcache.hxx>
 
 
+// The FDMs of the FDMPool step on worker threads, alongside the main FDM.
+// Building a ground cache walks the scene graph and may create its
+// bounding volume trees on demand, so only one is built at a time.
+static SGMutex ground_cache_lock;
+
 static inline void assign(double* ptr, const SGVec3d& vec)
 {
   ptr[0] = vec[0];
@@ -248,7 +255,7 @@ FGInterface::bind ()
 {
   bound = true;
 
-  _tiedProperties.setRoot(globals->get_props());
+  _tiedProperties.setRoot(fgGetPropertyRoot());
   // Aircraft position
   _tiedProperties.Tie("/position/latitude-deg", this,
                       &FGInterface::get_Latitude_deg,
@@ -613,6 +620,7 @@ bool
 FGInterface::prepare_ground_cache_m(double startSimTime, double endSimTime,
                                     const double pt[3], double rad)
 {
+  SGGuard<SGMutex> g(ground_cache_lock);
   return ground_cache.prepare_ground_cache(startSimTime, endSimTime,
                                            SGVec3d(pt), rad);
 }
@@ -623,6 +631,7 @@ FGInterface::prepare_ground_cache_ft(double startSimTime, double endSimTime,
 {
   // Convert units and do the real work.
   SGVec3d pt_ft = SG_FEET_TO_METER*SGVec3d(pt);
+  SGGuard<SGMutex> g(ground_cache_lock);
   return ground_cache.prepare_ground_cache(startSimTime, endSimTime,
                                            pt_ft, rad*SG_FEET_TO_METER);
 }
@@ -715,6 +724,24 @@ FGInterface::get_agl_m(double t, const double pt[3], double max_altoff,
   return ret;
 }
 
+unsigned
+FGInterface::get_agl_m(double t, double max_altoff,
+                       FGGroundCache::AglQueryList& queries)
+{
+  const SGVec3d& down = ground_cache.get_down();
+  for (unsigned i = 0; i < queries.size(); ++i)
+    queries[i].pt -= max_altoff*down;
+
+  unsigned ret = ground_cache.get_agl(t, queries);
+
+  // correct the linear velocities, see above
+  for (unsigned i = 0; i < queries.size(); ++i) {
+    FGGroundCache::AglQuery& query = queries[i];
+    query.linearVel += cross(query.angularVel, query.contact - query.pt);
+  }
+  return ret;
+}
+
 bool
 FGInterface::get_agl_ft(double t, const double pt[3], double max_altoff,
                         double contact[3], double normal[3],
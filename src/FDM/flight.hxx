@@ -702,6 +702,12 @@ public:
                     double contact[3], double normal[3], double linearVel[3],
                     double angularVel[3], simgear::BVHMaterial const*& material,
                     simgear::BVHNode::Id& id);
+    // Batched get_agl_m for all contact points of the vehicle at once.
+    // The query points are in meters; they are raised by max_altoff in place
+    // and the results are filled in as above. Returns the number of points
+    // with a valid result.
+    unsigned get_agl_m(double t, double max_altoff,
+                       FGGroundCache::AglQueryList& queries);
     double get_groundlevel_m(double lat, double lon, double alt);
     double get_groundlevel_m(const SGGeod& geod);
 
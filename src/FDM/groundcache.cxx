@@ -26,7 +26,10 @@
 
 #include "groundcache.hxx"
 
+#include <algorithm>
+#include <cmath>
 #include <utility>
+#include <vector>
 
 #include <osg/Drawable>
 #include <osg/Geode>
@@ -62,9 +65,9 @@
 
 #ifdef GROUNDCACHE_DEBUG
 #include <simgear/scene/model/BVHDebugCollectVisitor.hxx>
-#include <Main/fg_props.hxx>
 #endif
 
+#include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
 #include <Scenery/scenery.hxx>
 #include <Scenery/tilemgr.hxx>
@@ -73,6 +76,26 @@
 
 using namespace simgear;
 
+// Edge length of the cubic cache cells in meters.
+static const double CELL_SIZE = 250;
+// How far ahead along the current velocity cells are prefetched,
+// in seconds and at most in meters.
+static const double PREFETCH_TIME = 4;
+static const double MAX_PREFETCH_DISTANCE = 4000;
+// Number of cells that are not yet needed, but filled in advance,
+// per call to prepare_ground_cache.
+static const unsigned PREFETCH_CELLS_PER_STEP = 1;
+// Cells are refilled after that many seconds, to pick up scenery
+// that was loaded in the mean time. Empty cells are refilled sooner,
+// most likely the tile below was not yet loaded.
+static const double CELL_MAX_AGE = 30;
+static const double EMPTY_CELL_MAX_AGE = 2;
+// The models outside the terrain branch are collected for that many
+// seconds ahead, and for a sphere larger by at least that many meters,
+// or by the distance travelled in that time.
+static const double DYNAMIC_MAX_AGE = 0.5;
+static const double DYNAMIC_MIN_MARGIN = 50;
+
 class FGGroundCache::CacheFill : public osg::NodeVisitor {
 public:
     CacheFill(const SGVec3d& center, const SGVec3d& down, const double& radius,
@@ -86,10 +109,24 @@ public:
         _sceneryHit(0, 0, 0),
         _maxDown(SGGeod::fromCart(center).getElevationM() + 9999),
         _material(0),
-        _haveHit(false)
+        _haveHit(false),
+        _findGround(true),
+        _staticOnly(false)
     {
         setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
     }
+
+    // Do not look for the coarse ground level below the sphere,
+    // just collect what is within the sphere.
+    void disableFindGround()
+    {
+        _findGround = false;
+        _maxDown = 0;
+    }
+    // Skip everything below a transform with a velocity. Used for the
+    // cache cells which are kept across many fdm steps.
+    void setStaticOnly(bool staticOnly)
+    { _staticOnly = staticOnly; }
     virtual void apply(osg::Node& node)
     {
         if (!testBoundingSphere(node.getBound()))
@@ -145,6 +182,8 @@ public:
 
         // Look for a velocity note
         const SGSceneUserData::Velocity* velocity = getVelocity(transform);
+        if (velocity && _staticOnly)
+            return;
 
         SGVec3d center = _center;
         SGVec3d down = _down;
@@ -242,14 +281,16 @@ public:
             return;
 
         // Find a croase ground intersection 
-        SGLineSegmentd line(_center + _radius*_down, _center + _maxDown*_down);
-        simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, _startTime);
-        bvNode->accept(lineSegmentVisitor);
-        if (!lineSegmentVisitor.empty()) {
-            _sceneryHit = lineSegmentVisitor.getPoint();
-            _material = lineSegmentVisitor.getMaterial();
-            _maxDown = SGMiscd::max(_radius, dot(_down, _sceneryHit - _center));
-            _haveHit = true;
+        if (_findGround) {
+            SGLineSegmentd line(_center + _radius*_down, _center + _maxDown*_down);
+            simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, _startTime);
+            bvNode->accept(lineSegmentVisitor);
+            if (!lineSegmentVisitor.empty()) {
+                _sceneryHit = lineSegmentVisitor.getPoint();
+                _material = lineSegmentVisitor.getMaterial();
+                _maxDown = SGMiscd::max(_radius, dot(_down, _sceneryHit - _center));
+                _haveHit = true;
+            }
         }
 
         // Get that part of the local bv tree that intersects our sphere
@@ -291,6 +332,8 @@ private:
     double _maxDown;
     const simgear::BVHMaterial* _material;
     bool _haveHit;
+    bool _findGround;
+    bool _staticOnly;
 };
 
 FGGroundCache::FGGroundCache() :
@@ -302,7 +345,15 @@ FGGroundCache::FGGroundCache() :
     reference_wgs84_point(SGVec3d(0, 0, 0)),
     reference_vehicle_radius(0),
     down(0.0, 0.0, 0.0),
-    found_ground(false)
+    found_ground(false),
+    _incremental(fgGetBool("/fdm/groundcache-incremental", true)),
+    _lastPoint(0, 0, 0),
+    _lastTime(0),
+    _velocity(0, 0, 0),
+    _dynamicCenter(0, 0, 0),
+    _dynamicRadius(0),
+    _dynamicStartTime(0),
+    _dynamicEndTime(-1)
 {
 #ifdef GROUNDCACHE_DEBUG
     _lookupTime = SGTimeStamp::fromSec(0.0);
@@ -354,17 +405,48 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
     // Get the ground cache, that is a local collision tree of the environment
     startSimTime += cache_time_offset;
     endSimTime += cache_time_offset;
-    CacheFill subtreeCollector(pt, down, rad, startSimTime, endSimTime);
-    globals->get_scenery()->get_scene_graph()->accept(subtreeCollector);
-    _localBvhTree = subtreeCollector.getBVHNode();
-
-    if (subtreeCollector.getHaveElevationBelowCache()) {
-        // Use the altitude value below the cache that we gathered during
-        // cache collection
-        _altitude = subtreeCollector.getElevationBelowCache();
-        _material = subtreeCollector.getMaterialBelowCache();
-        found_ground = true;
-    } else if (_localBvhTree) {
+    if (_incremental) {
+        _localBvhTree = fill_incremental(startSimTime, endSimTime, pt, rad);
+
+        // Try if the cells around us already contain the ground below,
+        // else take the ground level the cell of the point has seen
+        // below its center when it was filled.
+        if (_localBvhTree) {
+            double maxDown = geodPt.getElevationM() + 9999;
+            SGLineSegmentd line(pt + rad*down, pt + maxDown*down);
+            simgear::BVHLineSegmentVisitor lineSegmentVisitor(line, startSimTime);
+            _localBvhTree->accept(lineSegmentVisitor);
+
+            if (!lineSegmentVisitor.empty()) {
+                SGGeod geodPt = SGGeod::fromCart(lineSegmentVisitor.getPoint());
+                _altitude = geodPt.getElevationM();
+                _material = lineSegmentVisitor.getMaterial();
+                found_ground = true;
+            }
+        }
+        if (!found_ground) {
+            CellMap::const_iterator it = _cells.find(cell_key(pt));
+            if (it != _cells.end() && it->second.haveGround) {
+                _altitude = it->second.groundElevation;
+                _material = it->second.groundMaterial;
+                found_ground = true;
+            }
+        }
+    } else {
+        CacheFill subtreeCollector(pt, down, rad, startSimTime, endSimTime);
+        globals->get_scenery()->get_scene_graph()->accept(subtreeCollector);
+        _localBvhTree = subtreeCollector.getBVHNode();
+
+        if (subtreeCollector.getHaveElevationBelowCache()) {
+            // Use the altitude value below the cache that we gathered during
+            // cache collection
+            _altitude = subtreeCollector.getElevationBelowCache();
+            _material = subtreeCollector.getMaterialBelowCache();
+            found_ground = true;
+        }
+    }
+
+    if (!found_ground && _localBvhTree) {
         // We have nothing below us, so try starting with the lowest point
         // upwards for a croase altitude value
         SGLineSegmentd line(pt + reference_vehicle_radius*down, pt - 1e3*down);
@@ -442,6 +524,232 @@ FGGroundCache::is_valid(double& ref_time, SGVec3d& pt, double& rad)
     return found_ground;
 }
 
+static SGVec3d
+cellCenter(int x, int y, int z)
+{
+    return SGVec3d((x + 0.5)*CELL_SIZE, (y + 0.5)*CELL_SIZE, (z + 0.5)*CELL_SIZE);
+}
+
+SGSharedPtr<BVHNode>
+FGGroundCache::fill_incremental(double startSimTime, double endSimTime,
+                                const SGVec3d& pt, double rad)
+{
+    // Estimate the vehicle velocity from the previous call. Jumps like
+    // they happen on reposition, or from ground level queries elsewhere,
+    // just disable the prefetch for this step.
+    double dt = startSimTime - _lastTime;
+    _velocity = SGVec3d::zeros();
+    if (0 < dt && dt < 1) {
+        SGVec3d velocity = (1/dt)*(pt - _lastPoint);
+        if (norm(velocity) < 2000)
+            _velocity = velocity;
+    }
+    _lastPoint = pt;
+    _lastTime = startSimTime;
+
+    // The cells needed for this step come first, they are filled
+    // right away if not yet cached.
+    std::vector<CellKey> keys;
+    add_cells(pt, rad, keys);
+    unsigned numNeeded = keys.size();
+
+    // Then the cells along the path ahead, nearest first.
+    double speed = norm(_velocity);
+    double lookahead = SGMiscd::min(PREFETCH_TIME*speed, MAX_PREFETCH_DISTANCE);
+    if (0 < lookahead) {
+        SGVec3d dir = (1/speed)*_velocity;
+        for (double s = 0.5*CELL_SIZE; s < lookahead + 0.5*CELL_SIZE;
+             s += 0.5*CELL_SIZE)
+            add_cells(pt + SGMiscd::min(s, lookahead)*dir, rad, keys);
+    }
+
+    // Missing cells ahead and stale cells share a small budget per step,
+    // stale cells keep serving queries until they are refilled.
+    SGSharedPtr<BVHGroup> group = new BVHGroup;
+    unsigned numFilled = 0;
+    unsigned numPrefetched = 0;
+    for (unsigned i = 0; i < keys.size(); ++i) {
+        bool needed = i < numNeeded;
+        CellMap::iterator it = _cells.find(keys[i]);
+        if (it == _cells.end()) {
+            if (!needed && PREFETCH_CELLS_PER_STEP <= numPrefetched)
+                continue;
+            it = _cells.insert(std::make_pair(keys[i], Cell())).first;
+            fill_cell(keys[i], it->second, startSimTime);
+            if (needed)
+                ++numFilled;
+            else
+                ++numPrefetched;
+        } else if (numPrefetched < PREFETCH_CELLS_PER_STEP
+                   && is_stale(it->second, startSimTime)) {
+            fill_cell(keys[i], it->second, startSimTime);
+            ++numPrefetched;
+        }
+        if (needed && it->second.node)
+            group->addChild(it->second.node.get());
+    }
+
+    // Drop the cells we left behind.
+    double keep = rad + lookahead + 2*CELL_SIZE;
+    CellMap::iterator it = _cells.begin();
+    while (it != _cells.end()) {
+        const CellKey& key = it->first;
+        if (keep*keep < distSqr(pt, cellCenter(key.x, key.y, key.z)))
+            _cells.erase(it++);
+        else
+            ++it;
+    }
+
+    if (numFilled)
+        SG_LOG(SG_FLIGHT, SG_DEBUG, "FGGroundCache: filled " << numFilled
+               << " cells on demand, " << _cells.size() << " cells cached");
+
+    SGSharedPtr<BVHNode> dynamicNode;
+    dynamicNode = collect_dynamic(startSimTime, endSimTime, pt, rad);
+    if (dynamicNode)
+        group->addChild(dynamicNode.get());
+
+    if (!group->getNumChildren())
+        return SGSharedPtr<BVHNode>();
+    return group.get();
+}
+
+void
+FGGroundCache::fill_cell(const CellKey& key, Cell& cell, double simTime)
+{
+    // Collect the static terrain within the sphere around the cell cube,
+    // and the coarse ground level below it
+    SGVec3d center = cellCenter(key.x, key.y, key.z);
+    double radius = 0.5*sqrt(3.0)*CELL_SIZE;
+    CacheFill subtreeCollector(center, down, radius, simTime, simTime);
+    subtreeCollector.setStaticOnly(true);
+    globals->get_scenery()->get_terrain_branch()->accept(subtreeCollector);
+    cell.node = subtreeCollector.getBVHNode();
+    cell.fillTime = simTime;
+    cell.haveGround = subtreeCollector.getHaveElevationBelowCache();
+    cell.groundElevation = 0;
+    cell.groundMaterial = 0;
+    if (cell.haveGround) {
+        cell.groundElevation = subtreeCollector.getElevationBelowCache();
+        cell.groundMaterial = subtreeCollector.getMaterialBelowCache();
+    }
+}
+
+FGGroundCache::CellKey
+FGGroundCache::cell_key(const SGVec3d& pt)
+{
+    CellKey key;
+    key.x = int(floor(pt[0]/CELL_SIZE));
+    key.y = int(floor(pt[1]/CELL_SIZE));
+    key.z = int(floor(pt[2]/CELL_SIZE));
+    return key;
+}
+
+SGSharedPtr<BVHNode>
+FGGroundCache::collect_dynamic(double startSimTime, double endSimTime,
+                               const SGVec3d& pt, double rad)
+{
+    // Everything outside of the terrain branch, mostly moving models like
+    // carriers. Their motion is extrapolated from the velocities recorded
+    // in the tree, so it is reused for a while as long as no model was
+    // added or removed and the vehicle stays within the collected sphere.
+    bool modelsChanged = update_dynamic_models();
+    if (!modelsChanged && _dynamicStartTime <= startSimTime
+        && endSimTime <= _dynamicEndTime
+        && dist(pt, _dynamicCenter) + rad <= _dynamicRadius)
+        return _dynamicNode;
+
+    double margin = SGMiscd::max(DYNAMIC_MIN_MARGIN,
+                                 DYNAMIC_MAX_AGE*norm(_velocity));
+    _dynamicCenter = pt;
+    _dynamicRadius = rad + margin;
+    _dynamicStartTime = startSimTime;
+    _dynamicEndTime = SGMiscd::max(endSimTime, startSimTime + DYNAMIC_MAX_AGE);
+
+    CacheFill dynamicCollector(pt, down, _dynamicRadius,
+                               _dynamicStartTime, _dynamicEndTime);
+    dynamicCollector.disableFindGround();
+    osg::Group* sceneGraph = globals->get_scenery()->get_scene_graph();
+    osg::Node* terrain = globals->get_scenery()->get_terrain_branch();
+    for (unsigned i = 0; i < sceneGraph->getNumChildren(); ++i) {
+        osg::Node* child = sceneGraph->getChild(i);
+        if (child != terrain)
+            child->accept(dynamicCollector);
+    }
+    _dynamicNode = dynamicCollector.getBVHNode();
+    return _dynamicNode;
+}
+
+bool
+FGGroundCache::update_dynamic_models()
+{
+    // The branches besides the terrain and their direct children, which
+    // are the models themselves
+    _currentModels.clear();
+    osg::Group* sceneGraph = globals->get_scenery()->get_scene_graph();
+    osg::Node* terrain = globals->get_scenery()->get_terrain_branch();
+    for (unsigned i = 0; i < sceneGraph->getNumChildren(); ++i) {
+        osg::Node* child = sceneGraph->getChild(i);
+        if (child == terrain)
+            continue;
+        _currentModels.push_back(child);
+        osg::Group* branch = child->asGroup();
+        if (!branch)
+            continue;
+        for (unsigned j = 0; j < branch->getNumChildren(); ++j)
+            _currentModels.push_back(branch->getChild(j));
+    }
+    if (_currentModels == _dynamicModels)
+        return false;
+    _dynamicModels.swap(_currentModels);
+    return true;
+}
+
+bool
+FGGroundCache::is_stale(const Cell& cell, double simTime) const
+{
+    // The simulation time may have been reset
+    if (simTime < cell.fillTime)
+        return true;
+    double maxAge = cell.node ? CELL_MAX_AGE : EMPTY_CELL_MAX_AGE;
+    return cell.fillTime + maxAge < simTime;
+}
+
+void
+FGGroundCache::add_cells(const SGVec3d& pt, double rad,
+                         std::vector<CellKey>& keys) const
+{
+    // Append all cells intersecting the sphere that are not yet listed
+    int lo[3], hi[3];
+    for (unsigned i = 0; i < 3; ++i) {
+        lo[i] = int(floor((pt[i] - rad)/CELL_SIZE));
+        hi[i] = int(floor((pt[i] + rad)/CELL_SIZE));
+    }
+    CellKey key;
+    for (key.x = lo[0]; key.x <= hi[0]; ++key.x) {
+        for (key.y = lo[1]; key.y <= hi[1]; ++key.y) {
+            for (key.z = lo[2]; key.z <= hi[2]; ++key.z) {
+                // Squared distance from the sphere center to the cube
+                int index[3] = { key.x, key.y, key.z };
+                double d2 = 0;
+                for (unsigned i = 0; i < 3; ++i) {
+                    double min = index[i]*CELL_SIZE;
+                    double max = min + CELL_SIZE;
+                    if (pt[i] < min)
+                        d2 += (min - pt[i])*(min - pt[i]);
+                    else if (max < pt[i])
+                        d2 += (pt[i] - max)*(pt[i] - max);
+                }
+                if (rad*rad < d2)
+                    continue;
+                if (std::find(keys.begin(), keys.end(), key) != keys.end())
+                    continue;
+                keys.push_back(key);
+            }
+        }
+    }
+}
+
 class FGGroundCache::BodyFinder : public BVHVisitor {
 public:
     BodyFinder(BVHNode::Id id, const double& t) :
@@ -741,6 +1049,320 @@ FGGroundCache::get_agl(double t, const SGVec3d& pt, SGVec3d& contact,
 }
 
 
+// Intersects a whole set of line segments with the cached tree in a single
+// traversal. The result is the same as running a BVHLineSegmentVisitor for
+// each segment, but every node is visited only once and is only tested
+// against the segments that made it through the parent node.
+class FGGroundCache::MultiLineSegmentVisitor : public BVHVisitor {
+public:
+    struct Segment {
+        SGLineSegmentd lineSegment;
+        SGVec3d normal;
+        SGVec3d linearVelocity;
+        SGVec3d angularVelocity;
+        const BVHMaterial* material;
+        BVHNode::Id id;
+        bool haveHit;
+    };
+
+    MultiLineSegmentVisitor(std::vector<Segment>& segments, const double& t) :
+        _segments(segments),
+        _begin(0),
+        _end(segments.size()),
+        _time(t)
+    {
+        // Indices of the segments still alive at the current node are kept
+        // on a stack, one range per tree level.
+        _active.reserve(4*segments.size());
+        for (unsigned i = 0; i < segments.size(); ++i)
+            _active.push_back(i);
+    }
+
+    virtual void apply(BVHGroup& group)
+    {
+        Frame frame;
+        if (!_push(group.getBoundingSphere(), frame))
+            return;
+        group.traverse(*this);
+        _pop(frame);
+    }
+    virtual void apply(BVHPageNode& node)
+    {
+        Frame frame;
+        if (!_push(node.getBoundingSphere(), frame))
+            return;
+        node.traverse(*this);
+        _pop(frame);
+    }
+    virtual void apply(BVHTransform& transform)
+    {
+        Frame frame;
+        if (!_push(transform.getBoundingSphere(), frame))
+            return;
+
+        std::vector<Segment> saved;
+        saved.reserve(_end - _begin);
+        for (unsigned i = _begin; i < _end; ++i) {
+            Segment& segment = _segments[_active[i]];
+            saved.push_back(segment);
+            segment.lineSegment = transform.lineSegmentToLocal(segment.lineSegment);
+            segment.haveHit = false;
+        }
+
+        transform.traverse(*this);
+
+        for (unsigned i = _begin; i < _end; ++i) {
+            Segment& segment = _segments[_active[i]];
+            const Segment& old = saved[i - _begin];
+            if (segment.haveHit) {
+                segment.linearVelocity = transform.vecToWorld(segment.linearVelocity);
+                segment.angularVelocity = transform.vecToWorld(segment.angularVelocity);
+                SGVec3d point(transform.ptToWorld(segment.lineSegment.getEnd()));
+                segment.lineSegment.set(old.lineSegment.getStart(), point);
+                segment.normal = transform.vecToWorld(segment.normal);
+            } else {
+                segment = old;
+            }
+        }
+        _pop(frame);
+    }
+    virtual void apply(BVHMotionTransform& transform)
+    {
+        Frame frame;
+        if (!_push(transform.getBoundingSphere(), frame))
+            return;
+
+        SGMatrixd toLocal = transform.getToLocalTransform(_time);
+        std::vector<Segment> saved;
+        saved.reserve(_end - _begin);
+        for (unsigned i = _begin; i < _end; ++i) {
+            Segment& segment = _segments[_active[i]];
+            saved.push_back(segment);
+            segment.lineSegment = segment.lineSegment.transform(toLocal);
+            segment.haveHit = false;
+        }
+
+        transform.traverse(*this);
+
+        SGMatrixd toWorld = transform.getToWorldTransform(_time);
+        for (unsigned i = _begin; i < _end; ++i) {
+            Segment& segment = _segments[_active[i]];
+            const Segment& old = saved[i - _begin];
+            if (segment.haveHit) {
+                SGVec3d localStart = segment.lineSegment.getStart();
+                segment.linearVelocity += transform.getLinearVelocityAt(localStart);
+                segment.angularVelocity += transform.getAngularVelocity();
+                segment.linearVelocity = toWorld.xformVec(segment.linearVelocity);
+                segment.angularVelocity = toWorld.xformVec(segment.angularVelocity);
+                SGVec3d localEnd = segment.lineSegment.getEnd();
+                segment.lineSegment.set(old.lineSegment.getStart(),
+                                        toWorld.xformPt(localEnd));
+                segment.normal = toWorld.xformVec(segment.normal);
+                if (!segment.id)
+                    segment.id = transform.getId();
+            } else {
+                segment = old;
+            }
+        }
+        _pop(frame);
+    }
+    virtual void apply(BVHLineGeometry&)
+    { }
+    virtual void apply(BVHStaticGeometry& node)
+    {
+        Frame frame;
+        if (!_push(node.getBoundingSphere(), frame))
+            return;
+        node.traverse(*this);
+        _pop(frame);
+    }
+
+    virtual void apply(const BVHStaticBinary& node, const BVHStaticData& data)
+    {
+        Frame frame;
+        if (!_push(node.getBoundingBox(), frame))
+            return;
+        // Enter the box the first segment starts in first. The segments
+        // are sorted by locality, so this is a good guess for most of them.
+        node.traverse(*this, data, _segments[_active[_begin]].lineSegment.getStart());
+        _pop(frame);
+    }
+    virtual void apply(const BVHStaticTriangle& triangle,
+                       const BVHStaticData& data)
+    {
+        SGTrianglef tri = triangle.getTriangle(data);
+        for (unsigned i = _begin; i < _end; ++i) {
+            Segment& segment = _segments[_active[i]];
+            SGVec3f point;
+            if (!intersects(point, tri, SGLineSegmentf(segment.lineSegment), 1e-4f))
+                continue;
+            segment.lineSegment.set(segment.lineSegment.getStart(), SGVec3d(point));
+            segment.normal = SGVec3d(tri.getNormal());
+            segment.linearVelocity = SGVec3d::zeros();
+            segment.angularVelocity = SGVec3d::zeros();
+            segment.material = data.getMaterial(triangle.getMaterialIndex());
+            segment.id = 0;
+            segment.haveHit = true;
+        }
+    }
+
+private:
+    struct Frame {
+        unsigned begin;
+        unsigned end;
+    };
+
+    static bool _intersects(const SGLineSegmentd& lineSegment,
+                            const SGSphered& sphere)
+    { return intersects(lineSegment, sphere); }
+    static bool _intersects(const SGLineSegmentd& lineSegment,
+                            const SGBoxf& box)
+    { return intersects(SGLineSegmentf(lineSegment), box); }
+
+    // Push the subset of the current segments that intersect the volume.
+    // Returns false, leaving the state untouched, if there is none.
+    template<typename T>
+    bool _push(const T& volume, Frame& frame)
+    {
+        unsigned top = _active.size();
+        for (unsigned i = _begin; i < _end; ++i) {
+            unsigned index = _active[i];
+            if (_intersects(_segments[index].lineSegment, volume))
+                _active.push_back(index);
+        }
+        if (_active.size() == top)
+            return false;
+
+        frame.begin = _begin;
+        frame.end = _end;
+        _begin = top;
+        _end = _active.size();
+        return true;
+    }
+    void _pop(const Frame& frame)
+    {
+        _active.resize(_begin);
+        _begin = frame.begin;
+        _end = frame.end;
+    }
+
+    std::vector<Segment>& _segments;
+    std::vector<unsigned> _active;
+    unsigned _begin;
+    unsigned _end;
+    double _time;
+};
+
+// Spread the lower 10 bits of x so that there are two zero bits
+// between each of them, for interleaving three coordinates.
+static unsigned
+spreadBits(unsigned x)
+{
+    x &= 0x3ff;
+    x = (x | (x << 16)) & 0x030000ff;
+    x = (x | (x << 8)) & 0x0300f00f;
+    x = (x | (x << 4)) & 0x030c30c3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+unsigned
+FGGroundCache::get_agl(double t, AglQueryList& queries)
+{
+    if (queries.empty())
+        return 0;
+
+#ifdef GROUNDCACHE_DEBUG
+    SGTimeStamp t0 = SGTimeStamp::now();
+#endif
+
+    // Order the points along a morton curve through their bounding box.
+    // Neighbouring segments then tend to take the same path through the
+    // tree, which keeps the active sets at each node small and coherent.
+    SGVec3d minPt = queries.front().pt;
+    SGVec3d maxPt = minPt;
+    for (unsigned i = 1; i < queries.size(); ++i) {
+        for (unsigned k = 0; k < 3; ++k) {
+            minPt[k] = SGMiscd::min(minPt[k], queries[i].pt[k]);
+            maxPt[k] = SGMiscd::max(maxPt[k], queries[i].pt[k]);
+        }
+    }
+    double extent = SGMiscd::max(maxPt[0] - minPt[0],
+                                 SGMiscd::max(maxPt[1] - minPt[1],
+                                              maxPt[2] - minPt[2]));
+    double scale = 0 < extent ? 1023/extent : 0;
+
+    std::vector<std::pair<unsigned, unsigned> > order;
+    order.reserve(queries.size());
+    for (unsigned i = 0; i < queries.size(); ++i) {
+        SGVec3d rel = scale*(queries[i].pt - minPt);
+        unsigned key = spreadBits(unsigned(rel[0]))
+            | (spreadBits(unsigned(rel[1])) << 1)
+            | (spreadBits(unsigned(rel[2])) << 2);
+        order.push_back(std::make_pair(key, i));
+    }
+    std::sort(order.begin(), order.end());
+
+    // Just set up a ground intersection query for each of the points
+    std::vector<MultiLineSegmentVisitor::Segment> segments(queries.size());
+    for (unsigned i = 0; i < order.size(); ++i) {
+        const SGVec3d& pt = queries[order[i].second].pt;
+        MultiLineSegmentVisitor::Segment& segment = segments[i];
+        segment.lineSegment.set(pt, pt + 10*reference_vehicle_radius*down);
+        segment.normal = SGVec3d::zeros();
+        segment.linearVelocity = SGVec3d::zeros();
+        segment.angularVelocity = SGVec3d::zeros();
+        segment.material = 0;
+        segment.id = 0;
+        segment.haveHit = false;
+    }
+
+    t += cache_time_offset;
+    MultiLineSegmentVisitor multiLineSegmentVisitor(segments, t);
+    if (_localBvhTree)
+        _localBvhTree->accept(multiLineSegmentVisitor);
+
+#ifdef GROUNDCACHE_DEBUG
+    t0 = SGTimeStamp::now() - t0;
+    _lookupTime += t0;
+    _lookupCount += queries.size();
+#endif
+
+    unsigned numValid = 0;
+    for (unsigned i = 0; i < order.size(); ++i) {
+        const MultiLineSegmentVisitor::Segment& segment = segments[i];
+        AglQuery& query = queries[order[i].second];
+        if (segment.haveHit) {
+            // Have an intersection
+            query.contact = segment.lineSegment.getEnd();
+            query.normal = segment.normal;
+            if (0 < dot(query.normal, down))
+                query.normal = -query.normal;
+            query.linearVel = segment.linearVelocity;
+            query.angularVel = segment.angularVelocity;
+            query.material = segment.material;
+            query.id = segment.id;
+            query.valid = true;
+        } else {
+            // Same fallback as for the single point query above.
+            SGGeod geodPt = SGGeod::fromCart(query.pt);
+            geodPt.setElevationM(_altitude);
+            query.contact = SGVec3d::fromGeod(geodPt);
+            query.normal = -down;
+            query.linearVel = SGVec3d(0, 0, 0);
+            query.angularVel = SGVec3d(0, 0, 0);
+            query.material = _material;
+            query.id = 0;
+            query.valid = found_ground;
+        }
+        if (query.valid)
+            ++numValid;
+    }
+
+    return numValid;
+}
+
+
 bool
 FGGroundCache::get_nearest(double t, const SGVec3d& pt, double maxDist,
                            SGVec3d& contact, SGVec3d& linearVel,
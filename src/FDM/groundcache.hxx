@@ -25,6 +25,10 @@
 
 #include <simgear/compiler.h>
 #include <simgear/constants.h>
+
+#include <map>
+#include <vector>
+
 #include <simgear/math/SGMath.hxx>
 #include <simgear/math/SGGeometry.hxx>
 #include <simgear/bvh/BVHNode.hxx>
@@ -37,6 +41,10 @@
 #include <simgear/timing/timestamp.hxx>
 #endif
 
+namespace osg {
+class Node;
+}
+
 namespace simgear {
 class BVHLineGeometry;
 class BVHMaterial;
@@ -92,6 +100,28 @@ public:
                  simgear::BVHNode::Id& id,
                  const simgear::BVHMaterial*& material);
 
+    // One point of a batched get_agl query.
+    // Only pt needs to be filled in by the caller, the remaining
+    // fields carry the result and have the same meaning as the
+    // reference arguments of the single point get_agl.
+    struct AglQuery {
+        SGVec3d pt;
+        SGVec3d contact;
+        SGVec3d normal;
+        SGVec3d linearVel;
+        SGVec3d angularVel;
+        simgear::BVHNode::Id id;
+        const simgear::BVHMaterial* material;
+        bool valid;
+    };
+    typedef std::vector<AglQuery> AglQueryList;
+
+    // Batched variant of the above for all contact points of a vehicle.
+    // The points are sorted for spatial locality and the cached tree is
+    // walked only once for all of them, instead of once per point.
+    // Returns the number of queries with a valid result.
+    unsigned get_agl(double t, AglQueryList& queries);
+
     bool get_nearest(double t, const SGVec3d& pt, double maxDist,
                      SGVec3d& contact, SGVec3d& linearVel, SGVec3d& angularVel,
                      simgear::BVHNode::Id& id,
@@ -117,6 +147,49 @@ private:
     class CatapultFinder;
     class WireIntersector;
     class WireFinder;
+    class MultiLineSegmentVisitor;
+
+    // The static part of the scenery is cached in cubic cells on a
+    // fixed cartesian grid. The cells around the vehicle, and ahead of
+    // it along its path, are kept across fdm steps so that only newly
+    // entered cells need a scene graph traversal.
+    struct CellKey {
+        int x, y, z;
+        bool operator<(const CellKey& other) const
+        {
+            if (x != other.x)
+                return x < other.x;
+            if (y != other.y)
+                return y < other.y;
+            return z < other.z;
+        }
+        bool operator==(const CellKey& other) const
+        { return x == other.x && y == other.y && z == other.z; }
+    };
+    struct Cell {
+        SGSharedPtr<simgear::BVHNode> node;
+        double fillTime;
+        // The coarse ground level below the cell center, looked for
+        // once when the cell is filled.
+        bool haveGround;
+        double groundElevation;
+        const simgear::BVHMaterial* groundMaterial;
+    };
+    typedef std::map<CellKey, Cell> CellMap;
+
+    SGSharedPtr<simgear::BVHNode>
+    fill_incremental(double startSimTime, double endSimTime,
+                     const SGVec3d& pt, double rad);
+    void fill_cell(const CellKey& key, Cell& cell, double simTime);
+    bool is_stale(const Cell& cell, double simTime) const;
+    void add_cells(const SGVec3d& pt, double rad,
+                   std::vector<CellKey>& keys) const;
+    static CellKey cell_key(const SGVec3d& pt);
+
+    SGSharedPtr<simgear::BVHNode>
+    collect_dynamic(double startSimTime, double endSimTime,
+                    const SGVec3d& pt, double rad);
+    bool update_dynamic_models();
 
     // Approximate ground radius.
     // In case the aircraft is too high above ground.
@@ -140,6 +213,24 @@ private:
 
     SGSharedPtr<simgear::BVHNode> _localBvhTree;
 
+    // Incremental cache state.
+    bool _incremental;
+    CellMap _cells;
+    SGVec3d _lastPoint;
+    double _lastTime;
+    SGVec3d _velocity;
+
+    // Everything outside the terrain branch, collected for a sphere and
+    // a time interval larger than one step needs, and reused while the
+    // steps stay within them and the set of models is unchanged.
+    SGSharedPtr<simgear::BVHNode> _dynamicNode;
+    SGVec3d _dynamicCenter;
+    double _dynamicRadius;
+    double _dynamicStartTime;
+    double _dynamicEndTime;
+    std::vector<osg::Node*> _dynamicModels;
+    std::vector<osg::Node*> _currentModels;
+
 #ifdef GROUNDCACHE_DEBUG
     SGTimeStamp _lookupTime;
     unsigned _lookupCount;
@@ -93,6 +93,7 @@
 #include <assert.h>
 #include <math.h>
 
+#include <set>
 #include <string>
 #include <sstream>
 
@@ -114,6 +115,7 @@ using std::string;
 
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
+#include <AIModel/AIManager.hxx>
 #include "instrument_mgr.hxx"
 #include "tcas.hxx"
 
@@ -145,6 +147,12 @@ TCAS::ThreatDetector::sensitivityLevels[] = {
    {0,               8,  {48,   1.30,    1200},  {35,   1.10,     700}}
 };
 
+/** Radius of the volume in which intruders are fully checked: 10nm range and
+ *  10000ft relative altitude, see ThreatDetector::checkThreat. Own altitude is
+ *  pressure altitude, so allow some slack for non-standard atmospheres. */
+static const double SurveillanceRangeM =
+    1.05 * (10 * SG_NM_TO_METER + 13000 * SG_FEET_TO_METER);
+
 ///////////////////////////////////////////////////////////////////////////////
 // helpers ////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -1288,13 +1296,36 @@ TCAS::update(double dt)
         {
             SGPropertyNode* pAi = fgGetNode("/ai/models", true);
 
+            /* Only aircraft within the surveillance volume need the full
+             * threat check, the others are either invisible or no threat
+             * (see ThreatDetector::checkThreat). */
+            std::set<const SGPropertyNode*> nearby;
+            FGAIManager* aiManager =
+                static_cast<FGAIManager*>(globals->get_subsystem("ai-model"));
+            if (aiManager)
+            {
+                FGAIBaseVec objects;
+                aiManager->findInRange(globals->get_aircraft_position_cart(),
+                                       SurveillanceRangeM, objects);
+                for (size_t j = 0; j < objects.size(); j++)
+                    nearby.insert(objects[j]->_getProps());
+            }
+
             // check all aircraft
             for (int i = pAi->nChildren() - 1; i >= -1; i--)
             {
                 SGPropertyNode* pModel = pAi->getChild(i);
                 if ((pModel)&&(pModel->nChildren()))
                 {
-                    int threatLevel = threatDetector.checkThreat(mode, pModel);
+                    int threatLevel;
+                    if ((!aiManager)||(nearby.count(pModel)))
+                        threatLevel = threatDetector.checkThreat(mode, pModel);
+                    else
+                    {
+                        float velocityKt = pModel->getDoubleValue("velocities/true-airspeed-kt");
+                        threatLevel = threatDetector.checkTransponder(pModel, velocityKt) ?
+                                      ThreatNone : ThreatInvisible;
+                    }
                     /* expose aircraft threat-level (to be used by other instruments,
                      * i.e. TCAS display) */
                     if (threatLevel==ThreatRA)
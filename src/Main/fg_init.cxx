@@ -484,6 +484,12 @@ fgInitNav ()
     }
   }
   
+  if (fgGetBool("/sim/navdb/snapshot/enabled", false)) {
+    if (!cache->useSnapshot()) {
+      SG_LOG(SG_GENERAL, SG_WARN, "navdata snapshot unavailable, using the cache directly");
+    }
+  }
+  
   FGTACANList *channellist = new FGTACANList;
   globals->set_channellist( channellist );
   
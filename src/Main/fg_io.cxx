@@ -40,6 +40,8 @@
 #include <simgear/math/sg_types.hxx>
 #include <simgear/timing/timestamp.hxx>
 #include <simgear/misc/strutils.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include <Network/protocol.hxx>
 #include <Network/ATC-Main.hxx>
@@ -77,7 +79,8 @@ using std::atoi;
 using std::string;
 
 
-FGIO::FGIO()
+FGIO::FGIO() :
+    _threaded(false)
 {
 }
 
@@ -88,6 +91,72 @@ FGIO::~FGIO()
 }
 
 
+// Runs the I/O of a threaded channel at the rate of the channel, so that
+// slow devices and peers do not hold up the frame.  The protocol exchanges
+// its property values on the main thread, in sync().
+class FGIO::ChannelThread : public SGThread
+{
+public:
+    ChannelThread( FGProtocol* protocol ) :
+        _protocol(protocol),
+        _quit(false)
+    {
+    }
+
+    FGProtocol* get_protocol() const { return _protocol; }
+
+    void stop()
+    {
+        {
+            SGGuard<SGMutex> g(_lock);
+            _quit = true;
+        }
+        join();
+    }
+
+protected:
+    virtual void run();
+
+private:
+    bool quitting()
+    {
+        SGGuard<SGMutex> g(_lock);
+        return _quit;
+    }
+
+    FGProtocol* _protocol;
+    SGMutex _lock;
+    bool _quit;
+};
+
+
+void
+FGIO::ChannelThread::run()
+{
+    SGTimeStamp period = SGTimeStamp::fromSec( 1 / _protocol->get_hz() );
+    // wake up at least this often, to notice stop()
+    SGTimeStamp slice = SGTimeStamp::fromSec( 0.1 );
+    SGTimeStamp next = SGTimeStamp::now();
+
+    while ( !quitting() ) {
+        SGTimeStamp now = SGTimeStamp::now();
+        if ( now < next ) {
+            SGTimeStamp::sleepUntil( next < now + slice ? next : now + slice );
+            continue;
+        }
+
+        _protocol->process();
+        _protocol->inc_count();
+
+        // after a stall, carry on at the normal rate rather than catch up
+        next += period;
+        if ( next < now ) {
+            next = now + period;
+        }
+    }
+}
+
+
 // configure a port based on the config string
 FGProtocol*
 FGIO::parse_port_config( const string& config )
@@ -352,6 +421,7 @@ FGIO::init()
     //         globals->get_channel_options_list()->size() << " requests." );
 
     _realDeltaTime = fgGetNode("/sim/time/delta-realtime-sec");
+    _threaded = fgGetBool("/sim/io/threaded", false);
 
     // we could almost do this in a single step except pushing a valid
     // port onto the port list copies the structure and destroys the
@@ -382,6 +452,16 @@ void FGIO::add_channel(const string& config)
         return;
     }
 
+    if ( _threaded && p->get_hz() > 0 && p->set_threaded( true ) ) {
+        // take the first snapshot of the properties before the thread
+        // can send from it
+        p->sync();
+        ChannelThread* thread = new ChannelThread( p );
+        io_threads.push_back( thread );
+        thread->start();
+        return;
+    }
+
     io_channels.push_back( p );
 }
 
@@ -399,6 +479,13 @@ FGIO::update( double /* delta_time_sec */ )
     // see http://code.google.com/p/flightgear-bugs/issues/detail?id=125
     double delta_time_sec = _realDeltaTime->getDoubleValue();
 
+    // the threaded channels only exchange their property values here
+    ThreadVec::iterator t = io_threads.begin();
+    ThreadVec::iterator t_end = io_threads.end();
+    for (; t != t_end; ++t ) {
+        (*t)->get_protocol()->sync();
+    }
+
     ProtocolVec::iterator i = io_channels.begin();
     ProtocolVec::iterator end = io_channels.end();
     for (; i != end; ++i ) {
@@ -422,6 +509,15 @@ FGIO::update( double /* delta_time_sec */ )
 void
 FGIO::shutdown()
 {
+    ThreadVec::iterator t = io_threads.begin();
+    ThreadVec::iterator t_end = io_threads.end();
+    for (; t != t_end; ++t ) {
+        (*t)->stop();
+        io_channels.push_back( (*t)->get_protocol() );
+        delete *t;
+    }
+    io_threads.clear();
+
     ProtocolVec::iterator i = io_channels.begin();
     ProtocolVec::iterator end = io_channels.end();
     for (; i != end; ++i )
@@ -50,6 +50,8 @@ public:
 
 private:
 
+    class ChannelThread;
+
     void add_channel(const std::string& config);
     FGProtocol* parse_port_config( const std::string& cfgstr );
 
@@ -60,6 +62,12 @@ private:
     
     typedef std::vector< FGProtocol* > ProtocolVec;
     ProtocolVec io_channels;
+
+    // The channels running on I/O threads of their own, when
+    // /sim/io/threaded is set and their protocol allows it
+    typedef std::vector< ChannelThread* > ThreadVec;
+    ThreadVec io_threads;
+    bool _threaded;
     
     SGPropertyNode_ptr _realDeltaTime;
 };
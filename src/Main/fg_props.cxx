@@ -636,16 +636,34 @@ fgLoadProps (const char * path, SGPropertyNode * props, bool in_fg_root, int def
 // Property convenience functions.
 ////////////////////////////////////////////////////////////////////////
 
+#ifdef _MSC_VER
+static __declspec(thread) SGPropertyNode * thread_property_root = 0;
+#else
+static __thread SGPropertyNode * thread_property_root = 0;
+#endif
+
+void
+fgSetThreadPropertyRoot (SGPropertyNode * root)
+{
+  thread_property_root = root;
+}
+
+SGPropertyNode *
+fgGetPropertyRoot ()
+{
+  return thread_property_root ? thread_property_root : globals->get_props();
+}
+
 SGPropertyNode *
 fgGetNode (const char * path, bool create)
 {
-  return globals->get_props()->getNode(path, create);
+  return fgGetPropertyRoot()->getNode(path, create);
 }
 
 SGPropertyNode * 
 fgGetNode (const char * path, int index, bool create)
 {
-  return globals->get_props()->getNode(path, index, create);
+  return fgGetPropertyRoot()->getNode(path, index, create);
 }
 
 bool
@@ -670,79 +688,79 @@ fgAddChangeListener (SGPropertyChangeListener * listener,
 bool
 fgGetBool (const char * name, bool defaultValue)
 {
-  return globals->get_props()->getBoolValue(name, defaultValue);
+  return fgGetPropertyRoot()->getBoolValue(name, defaultValue);
 }
 
 int
 fgGetInt (const char * name, int defaultValue)
 {
-  return globals->get_props()->getIntValue(name, defaultValue);
+  return fgGetPropertyRoot()->getIntValue(name, defaultValue);
 }
 
 long
 fgGetLong (const char * name, long defaultValue)
 {
-  return globals->get_props()->getLongValue(name, defaultValue);
+  return fgGetPropertyRoot()->getLongValue(name, defaultValue);
 }
 
 float
 fgGetFloat (const char * name, float defaultValue)
 {
-  return globals->get_props()->getFloatValue(name, defaultValue);
+  return fgGetPropertyRoot()->getFloatValue(name, defaultValue);
 }
 
 double
 fgGetDouble (const char * name, double defaultValue)
 {
-  return globals->get_props()->getDoubleValue(name, defaultValue);
+  return fgGetPropertyRoot()->getDoubleValue(name, defaultValue);
 }
 
 const char *
 fgGetString (const char * name, const char * defaultValue)
 {
-  return globals->get_props()->getStringValue(name, defaultValue);
+  return fgGetPropertyRoot()->getStringValue(name, defaultValue);
 }
 
 bool
 fgSetBool (const char * name, bool val)
 {
-  return globals->get_props()->setBoolValue(name, val);
+  return fgGetPropertyRoot()->setBoolValue(name, val);
 }
 
 bool
 fgSetInt (const char * name, int val)
 {
-  return globals->get_props()->setIntValue(name, val);
+  return fgGetPropertyRoot()->setIntValue(name, val);
 }
 
 bool
 fgSetLong (const char * name, long val)
 {
-  return globals->get_props()->setLongValue(name, val);
+  return fgGetPropertyRoot()->setLongValue(name, val);
 }
 
 bool
 fgSetFloat (const char * name, float val)
 {
-  return globals->get_props()->setFloatValue(name, val);
+  return fgGetPropertyRoot()->setFloatValue(name, val);
 }
 
 bool
 fgSetDouble (const char * name, double val)
 {
-  return globals->get_props()->setDoubleValue(name, val);
+  return fgGetPropertyRoot()->setDoubleValue(name, val);
 }
 
 bool
 fgSetString (const char * name, const char * val)
 {
-  return globals->get_props()->setStringValue(name, val);
+  return fgGetPropertyRoot()->setStringValue(name, val);
 }
 
 void
 fgSetArchivable (const char * name, bool state)
 {
-  SGPropertyNode * node = globals->get_props()->getNode(name);
+  SGPropertyNode * node = fgGetPropertyRoot()->getNode(name);
   if (node == 0)
     SG_LOG(SG_GENERAL, SG_DEBUG,
 	   "Attempt to set archive flag for non-existant property "
@@ -754,7 +772,7 @@ fgSetArchivable (const char * name, bool state)
 void
 fgSetReadable (const char * name, bool state)
 {
-  SGPropertyNode * node = globals->get_props()->getNode(name);
+  SGPropertyNode * node = fgGetPropertyRoot()->getNode(name);
   if (node == 0)
     SG_LOG(SG_GENERAL, SG_DEBUG,
 	   "Attempt to set read flag for non-existant property "
@@ -766,7 +784,7 @@ fgSetReadable (const char * name, bool state)
 void
 fgSetWritable (const char * name, bool state)
 {
-  SGPropertyNode * node = globals->get_props()->getNode(name);
+  SGPropertyNode * node = fgGetPropertyRoot()->getNode(name);
   if (node == 0)
     SG_LOG(SG_GENERAL, SG_DEBUG,
 	   "Attempt to set write flag for non-existant property "
@@ -778,7 +796,7 @@ fgSetWritable (const char * name, bool state)
 void
 fgUntie(const char * name)
 {
-  SGPropertyNode* node = globals->get_props()->getNode(name);
+  SGPropertyNode* node = fgGetPropertyRoot()->getNode(name);
   if (!node) {
     SG_LOG(SG_GENERAL, SG_WARN, "fgUntie: unknown property " << name);
     return;
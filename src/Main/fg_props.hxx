@@ -86,6 +86,28 @@ void setLoggingClasses (const char * c);
 void setLoggingPriority (const char * p);
 
 
+/**
+ * Set the root of the property tree for the calling thread.
+ *
+ * The convenience functions below (fgGetNode(), fgGetDouble(), fgTie()
+ * and so on) resolve their paths against this node in the calling
+ * thread, instead of against the global property tree. This lets code
+ * written for the global tree, such as an FDM, run against a private
+ * tree, for instance on a worker thread.
+ *
+ * @param root The new root, or 0 to return to the global tree.
+ */
+extern void fgSetThreadPropertyRoot (SGPropertyNode * root);
+
+/**
+ * Get the root of the property tree for the calling thread.
+ *
+ * @return The node set with fgSetThreadPropertyRoot(), or else the
+ *         root of the global property tree.
+ */
+extern SGPropertyNode * fgGetPropertyRoot ();
+
+
 ////////////////////////////////////////////////////////////////////////
 // Convenience functions for getting property values.
 ////////////////////////////////////////////////////////////////////////
@@ -730,7 +752,7 @@ inline void
 fgTie (const char * name, V (*getter)(), void (*setter)(V) = 0,
        bool useDefault = true)
 {
-  if (!globals->get_props()->tie(name, SGRawValueFunctions<V>(getter, setter),
+  if (!fgGetPropertyRoot()->tie(name, SGRawValueFunctions<V>(getter, setter),
 				 useDefault))
     SG_LOG(SG_GENERAL, SG_WARN,
 	   "Failed to tie property " << name << " to functions");
@@ -760,7 +782,7 @@ inline void
 fgTie (const char * name, int index, V (*getter)(int),
        void (*setter)(int, V) = 0, bool useDefault = true)
 {
-  if (!globals->get_props()->tie(name,
+  if (!fgGetPropertyRoot()->tie(name,
 				 SGRawValueFunctionsIndexed<V>(index,
 							       getter,
 							       setter),
@@ -794,7 +816,7 @@ inline void
 fgTie (const char * name, T * obj, V (T::*getter)() const,
        void (T::*setter)(V) = 0, bool useDefault = true)
 {
-  if (!globals->get_props()->tie(name,
+  if (!fgGetPropertyRoot()->tie(name,
 				 SGRawValueMethods<T,V>(*obj, getter, setter),
 				 useDefault))
     SG_LOG(SG_GENERAL, SG_WARN,
@@ -827,7 +849,7 @@ fgTie (const char * name, T * obj, int index,
        V (T::*getter)(int) const, void (T::*setter)(int, V) = 0,
        bool useDefault = true)
 {
-  if (!globals->get_props()->tie(name,
+  if (!fgGetPropertyRoot()->tie(name,
 				 SGRawValueMethodsIndexed<T,V>(*obj,
 							       index,
 							       getter,
@@ -35,6 +35,7 @@
 *
 ******************************************************************/
 
+#include <string>
 #include <vector>
 
 #include <simgear/compiler.h>
@@ -118,19 +119,17 @@ struct T_PositionMsg {
 struct FGPropertyData {
   unsigned id;
   
-  // While the type isn't transmitted, it is needed for the destructor
+  // While the type isn't transmitted, it is needed to decode the value
   simgear::props::Type type;
   union { 
     int int_value;
     float float_value;
-    char* string_value;
   }; 
-  
-  ~FGPropertyData() {
-    if ((type == simgear::props::STRING) || (type == simgear::props::UNSPECIFIED))
-    {
-      delete [] string_value;
-    }
+  std::string string_value;
+
+  FGPropertyData() :
+    id(0), type(simgear::props::NONE), int_value(0)
+  {
   }
 };
 
@@ -164,22 +163,10 @@ struct FGExternalMotionData {
   // the earth centered frame
   SGVec3f angularAccel;
   
-  // The set of properties received for this timeslot
-  std::vector<FGPropertyData*> properties;
-
-  ~FGExternalMotionData()
-  {
-      std::vector<FGPropertyData*>::const_iterator propIt;
-      std::vector<FGPropertyData*>::const_iterator propItEnd;
-      propIt = properties.begin();
-      propItEnd = properties.end();
-
-      while (propIt != propItEnd)
-      {
-        delete *propIt;
-        propIt++;
-      }
-  }
+  // The set of properties for this timeslot. A packet may only carry
+  // the properties which changed; the receiver completes it with the
+  // values it got before.
+  std::vector<FGPropertyData> properties;
 };
 
 #endif
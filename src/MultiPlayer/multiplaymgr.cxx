@@ -34,12 +34,15 @@
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <map>
 #include <errno.h>
 
 #include <simgear/misc/stdint.hxx>
 #include <simgear/timing/timestamp.hxx>
 #include <simgear/debug/logstream.hxx>
 #include <simgear/props/props.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include <AIModel/AIManager.hxx>
 #include <AIModel/AIMultiplayer.hxx>
@@ -237,12 +240,19 @@ static const IdPropertyList sIdPropertyList[] = {
   {10316, "sim/multiplay/generic/int[16]", simgear::props::INT},
   {10317, "sim/multiplay/generic/int[17]", simgear::props::INT},
   {10318, "sim/multiplay/generic/int[18]", simgear::props::INT},
-  {10319, "sim/multiplay/generic/int[19]", simgear::props::INT}
+  {10319, "sim/multiplay/generic/int[19]", simgear::props::INT},
+
+  // Sent by clients which understand property deltas, with every message.
+  // It must stay the last property of a message: older clients do not know
+  // the id, and read its value as the next id, which a float never matches.
+  {11000, "sim/multiplay/interest-range-nm", simgear::props::FLOAT}
 };
 
 const unsigned int numProperties = (sizeof(sIdPropertyList)
                                  / sizeof(sIdPropertyList[0]));
 
+const unsigned int INTEREST_RANGE_ID = 11000;
+
 // Look up a property ID using binary search.
 namespace
 {
@@ -344,6 +354,53 @@ namespace
     }
     return true;
   }
+
+  void readProperty(unsigned id, const SGPropertyNode* node,
+                    FGPropertyData& data)
+  {
+    using namespace simgear;
+    data.id = id;
+    data.type = node->getType();
+    switch (data.type) {
+      case props::INT:
+      case props::LONG:
+      case props::BOOL:
+        data.int_value = node->getIntValue();
+        break;
+      case props::FLOAT:
+      case props::DOUBLE:
+        data.float_value = node->getFloatValue();
+        break;
+      case props::STRING:
+      case props::UNSPECIFIED:
+        // FIXME: We assume unspecified are strings for the moment.
+        data.string_value = node->getStringValue();
+        break;
+      default:
+        // FIXME Currently default to a float. 
+        data.float_value = node->getFloatValue();
+        break;
+    }
+  }
+
+  // Whether two values of a property encode the same
+  bool sameValue(const FGPropertyData& lhs, const FGPropertyData& rhs)
+  {
+    using namespace simgear;
+    if (lhs.type != rhs.type)
+      return false;
+    switch (lhs.type) {
+      case props::INT:
+      case props::LONG:
+      case props::BOOL:
+        return lhs.int_value == rhs.int_value;
+      case props::STRING:
+      case props::UNSPECIFIED:
+        return lhs.string_value == rhs.string_value;
+      default:
+        return lhs.float_value == rhs.float_value;
+    }
+  }
 }
 
 class MPPropertyListener : public SGPropertyChangeListener
@@ -363,6 +420,538 @@ private:
   FGMultiplayMgr* _multiplay;
 };
 
+/**
+ * The buffer that holds a multi-player message, suitably aligned.
+ */
+union FGMultiplayMgr::MsgBuf
+{
+    MsgBuf()
+    {
+        memset(&Msg, 0, sizeof(Msg));
+    }
+
+    T_MsgHdr* msgHdr()
+    {
+        return &Header;
+    }
+
+    const T_MsgHdr* msgHdr() const
+    {
+        return reinterpret_cast<const T_MsgHdr*>(&Header);
+    }
+
+    T_PositionMsg* posMsg()
+    {
+        return reinterpret_cast<T_PositionMsg*>(Msg + sizeof(T_MsgHdr));
+    }
+
+    const T_PositionMsg* posMsg() const
+    {
+        return reinterpret_cast<const T_PositionMsg*>(Msg + sizeof(T_MsgHdr));
+    }
+
+    xdr_data_t* properties()
+    {
+        return reinterpret_cast<xdr_data_t*>(Msg + sizeof(T_MsgHdr)
+                                             + sizeof(T_PositionMsg));
+    }
+
+    const xdr_data_t* properties() const
+    {
+        return reinterpret_cast<const xdr_data_t*>(Msg + sizeof(T_MsgHdr)
+                                                   + sizeof(T_PositionMsg));
+    }
+    /**
+     * The end of the properties buffer.
+     */
+    xdr_data_t* propsEnd()
+    {
+        return reinterpret_cast<xdr_data_t*>(Msg + MAX_PACKET_SIZE);
+    };
+
+    const xdr_data_t* propsEnd() const
+    {
+        return reinterpret_cast<const xdr_data_t*>(Msg + MAX_PACKET_SIZE);
+    };
+    /**
+     * The end of properties actually in the buffer. This assumes that
+     * the message header is valid.
+     */
+    xdr_data_t* propsRecvdEnd()
+    {
+        return reinterpret_cast<xdr_data_t*>(Msg + Header.MsgLen);
+    }
+
+    const xdr_data_t* propsRecvdEnd() const
+    {
+        return reinterpret_cast<const xdr_data_t*>(Msg + Header.MsgLen);
+    }
+    
+    xdr_data2_t double_val;
+    char Msg[MAX_PACKET_SIZE];
+    T_MsgHdr Header;
+};
+
+bool
+FGMultiplayMgr::isSane(const FGExternalMotionData& motionInfo)
+{
+    // check for corrupted data (NaNs)
+    bool isCorrupted = false;
+    isCorrupted |= ((SGMisc<double>::isNaN(motionInfo.time           )) ||
+                    (SGMisc<double>::isNaN(motionInfo.lag            )) ||
+                    (osg::isNaN(motionInfo.orientation(3) )));
+    for (unsigned i = 0; (i < 3)&&(!isCorrupted); ++i)
+    {
+        isCorrupted |= ((osg::isNaN(motionInfo.position(i)      ))||
+                        (osg::isNaN(motionInfo.orientation(i)   ))||
+                        (osg::isNaN(motionInfo.linearVel(i))    )||
+                        (osg::isNaN(motionInfo.angularVel(i))   )||
+                        (osg::isNaN(motionInfo.linearAccel(i))  )||
+                        (osg::isNaN(motionInfo.angularAccel(i)) ));
+    }
+    return !isCorrupted;
+}
+
+//////////////////////////////////////////////////////////////////////
+//
+//  Description: Receives and decodes the messages of the other players
+//  on its own thread, so that bursts of packets do not stall the frame.
+//
+//////////////////////////////////////////////////////////////////////
+
+// Seconds without messages after which a player is dropped
+const long EXPIRY_SECONDS = 10;
+
+/**
+ * A message decoded by the receiver, ready to be applied.
+ */
+struct FGMultiplayMgr::Message
+{
+  int id;                       // CHAT_MSG_ID or POS_DATA_ID
+  std::string callsign;
+  std::string text;             // model path, or chat text
+  FGExternalMotionData motionInfo;
+  bool announced;
+  double interestRange;         // m
+  long stamp;                   // arrival, for expiry
+};
+
+/**
+ * The receiver thread drains the socket, checks and decodes the messages,
+ * and completes the properties of each position message with the values
+ * received before. The decoded messages go to a ring of preallocated
+ * messages, read by the main thread in update(); when the ring is full,
+ * the new packets are still decoded, so that later messages are completed
+ * with the values they carry, and then dropped. The lock only guards the
+ * ring indices, the messages themselves are filled and read outside of it.
+ */
+class FGMultiplayMgr::Receiver : public SGThread
+{
+public:
+  Receiver(simgear::Socket* socket) :
+    _socket(socket), _head(0), _tail(0), _quit(false), _dropped(0)
+  {
+    _ring.resize(RING_SIZE);
+  }
+
+  void stop()
+  {
+    {
+      SGGuard<SGMutex> g(_lock);
+      _quit = true;
+    }
+    join();
+  }
+
+  /// The oldest decoded message, or 0 if there is none
+  Message* front()
+  {
+    SGGuard<SGMutex> g(_lock);
+    if (_tail == _head)
+      return 0;
+    return &_ring[_tail];
+  }
+
+  /// Release the message returned by front()
+  void pop()
+  {
+    SGGuard<SGMutex> g(_lock);
+    _tail = (_tail + 1) % RING_SIZE;
+  }
+
+protected:
+  virtual void run();
+
+private:
+  enum { RING_SIZE = 256 };
+
+  /// What the receiver keeps of each sender
+  struct Sender {
+    /// The latest value of each property, indexed as the property list,
+    /// or with a 0 id while not received yet
+    std::vector<FGPropertyData> propertySlots;
+    bool announced;
+    double interestRange;
+    long stamp;
+  };
+  typedef std::map<std::string, Sender> SenderMap;
+
+  bool quitting()
+  {
+    SGGuard<SGMutex> g(_lock);
+    return _quit;
+  }
+  bool receive();
+  bool decodeChatMsg(const MsgBuf& Msg, Message& message);
+  bool decodePosMsg(const MsgBuf& Msg, Message& message);
+
+  simgear::Socket* _socket;
+  SenderMap _senders; // only used by the receiver thread
+
+  std::vector<Message> _ring;
+  Message _overflow; // decoded into when the ring is full
+  SGMutex _lock;
+  unsigned _head; // next message to fill, guarded by _lock
+  unsigned _tail; // next message to apply, guarded by _lock
+  bool _quit;     // guarded by _lock
+  unsigned _dropped;
+};
+
+void
+FGMultiplayMgr::Receiver::run()
+{
+  long lastExpiry = SGTimeStamp::now().getSeconds();
+  while (!quitting()) {
+    // wait for data, for at most 100 ms so that stop() is noticed
+    simgear::Socket* reads[2] = { _socket, 0 };
+    simgear::Socket* writes[1] = { 0 };
+    if (simgear::Socket::select(reads, writes, 100) <= 0)
+      continue;
+
+    while (receive())
+      ;
+
+    long stamp = SGTimeStamp::now().getSeconds();
+    if (stamp != lastExpiry) {
+      lastExpiry = stamp;
+      SenderMap::iterator it = _senders.begin();
+      while (it != _senders.end()) {
+        if (it->second.stamp + EXPIRY_SECONDS < stamp)
+          _senders.erase(it++);
+        else
+          ++it;
+      }
+    }
+  }
+}
+
+// Receive one packet, false when there is none
+bool
+FGMultiplayMgr::Receiver::receive()
+{
+  MsgBuf msgBuf;
+  //////////////////////////////////////////////////
+  //  Although the recv call asks for 
+  //  MAX_PACKET_SIZE of data, the number of bytes
+  //  returned will only be that of the next
+  //  packet waiting to be processed.
+  //////////////////////////////////////////////////
+  simgear::IPAddress SenderAddress;
+  int RecvStatus = _socket->recvfrom(msgBuf.Msg, sizeof(msgBuf.Msg), 0,
+                                     &SenderAddress);
+  //////////////////////////////////////////////////
+  //  no Data received
+  //////////////////////////////////////////////////
+  if (RecvStatus == 0)
+    return false;
+
+  // socket error reported?
+  // errno isn't thread-safe - so only check its value when
+  // socket return status < 0 really indicates a failure.
+  if ((RecvStatus < 0)&&
+      ((errno == EAGAIN) || (errno == 0))) // MSVC output "NoError" otherwise
+  {
+    // ignore "normal" errors
+    return false;
+  }
+
+  if (RecvStatus<0)
+  {
+    SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - Unable to receive data. "
+           << strerror(errno) << "(errno " << errno << ")");
+    return false;
+  }
+
+  // status is positive: bytes received
+  ssize_t bytes = (ssize_t) RecvStatus;
+  if (bytes <= static_cast<ssize_t>(sizeof(T_MsgHdr))) {
+    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+            << "received message with insufficient data" );
+    return true;
+  }
+  //////////////////////////////////////////////////
+  //  Read header
+  //////////////////////////////////////////////////
+  T_MsgHdr* MsgHdr = msgBuf.msgHdr();
+  MsgHdr->Magic       = XDR_decode_uint32 (MsgHdr->Magic);
+  MsgHdr->Version     = XDR_decode_uint32 (MsgHdr->Version);
+  MsgHdr->MsgId       = XDR_decode_uint32 (MsgHdr->MsgId);
+  MsgHdr->MsgLen      = XDR_decode_uint32 (MsgHdr->MsgLen);
+  MsgHdr->ReplyPort   = XDR_decode_uint32 (MsgHdr->ReplyPort);
+  MsgHdr->Callsign[MAX_CALLSIGN_LEN -1] = '\0';
+  if (MsgHdr->Magic != MSG_MAGIC) {
+    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+            << "message has invalid magic number!" );
+    return true;
+  }
+  if (MsgHdr->Version != PROTO_VER) {
+    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+            << "message has invalid protocol number!" );
+    return true;
+  }
+  if (static_cast<ssize_t>(MsgHdr->MsgLen) != bytes) {
+    SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+           << "message from " << MsgHdr->Callsign << " has invalid length!");
+    return true;
+  }
+
+  if ((MsgHdr->MsgId != CHAT_MSG_ID) && (MsgHdr->MsgId != POS_DATA_ID)) {
+    if ((MsgHdr->MsgId != UNUSABLE_POS_DATA_ID)
+        && (MsgHdr->MsgId != OLD_OLD_POS_DATA_ID)
+        && (MsgHdr->MsgId != OLD_PROP_MSG_ID)
+        && (MsgHdr->MsgId != OLD_POS_DATA_ID))
+      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+              << "Unknown message Id received: " << MsgHdr->MsgId );
+    return true;
+  }
+
+  unsigned head;
+  bool full;
+  {
+    SGGuard<SGMutex> g(_lock);
+    head = _head;
+    full = (head + 1) % RING_SIZE == _tail;
+  }
+
+  //////////////////////////////////////////////////
+  //  Decode messages
+  //////////////////////////////////////////////////
+  // When the main loop lags behind, the message is dropped once decoded:
+  // the queued messages are kept, and the property values it carries
+  // still complete the next messages of its sender.
+  Message& message = full ? _overflow : _ring[head];
+  message.id = MsgHdr->MsgId;
+  message.callsign = MsgHdr->Callsign;
+  message.stamp = SGTimeStamp::now().getSeconds();
+  bool decoded;
+  if (message.id == CHAT_MSG_ID)
+    decoded = decodeChatMsg(msgBuf, message);
+  else
+    decoded = decodePosMsg(msgBuf, message);
+
+  if (full) {
+    if ((_dropped++ % RING_SIZE) == 0)
+      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+             << "receive queue full, " << _dropped << " messages dropped");
+  } else if (decoded) {
+    SGGuard<SGMutex> g(_lock);
+    _head = (head + 1) % RING_SIZE;
+  }
+  return true;
+}
+
+bool
+FGMultiplayMgr::Receiver::decodeChatMsg(const MsgBuf& Msg, Message& message)
+{
+  const T_MsgHdr* MsgHdr = Msg.msgHdr();
+  if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + 1) {
+    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+            << "Chat message received with insufficient data" );
+    return false;
+  }
+
+  const char* chatStr = Msg.Msg + sizeof(T_MsgHdr);
+  const char* chatEnd = chatStr + MsgHdr->MsgLen - sizeof(T_MsgHdr) - 1;
+  message.text.assign(chatStr, std::find(chatStr, chatEnd, '\0'));
+  return true;
+}
+
+bool
+FGMultiplayMgr::Receiver::decodePosMsg(const MsgBuf& Msg, Message& message)
+{
+  const T_MsgHdr* MsgHdr = Msg.msgHdr();
+  if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + sizeof(T_PositionMsg)) {
+    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
+            << "Position message received with insufficient data" );
+    return false;
+  }
+  const T_PositionMsg* PosMsg = Msg.posMsg();
+  FGExternalMotionData& motionInfo = message.motionInfo;
+  motionInfo.properties.clear();
+  motionInfo.time = XDR_decode_double(PosMsg->time);
+  motionInfo.lag = XDR_decode_double(PosMsg->lag);
+  for (unsigned i = 0; i < 3; ++i)
+    motionInfo.position(i) = XDR_decode_double(PosMsg->position[i]);
+  SGVec3f angleAxis;
+  for (unsigned i = 0; i < 3; ++i)
+    angleAxis(i) = XDR_decode_float(PosMsg->orientation[i]);
+  motionInfo.orientation = SGQuatf::fromAngleAxis(angleAxis);
+  for (unsigned i = 0; i < 3; ++i)
+    motionInfo.linearVel(i) = XDR_decode_float(PosMsg->linearVel[i]);
+  for (unsigned i = 0; i < 3; ++i)
+    motionInfo.angularVel(i) = XDR_decode_float(PosMsg->angularVel[i]);
+  for (unsigned i = 0; i < 3; ++i)
+    motionInfo.linearAccel(i) = XDR_decode_float(PosMsg->linearAccel[i]);
+  for (unsigned i = 0; i < 3; ++i)
+    motionInfo.angularAccel(i) = XDR_decode_float(PosMsg->angularAccel[i]);
+
+  // sanity check: do not allow injection of corrupted data (NaNs)
+  if (!isSane(motionInfo))
+  {
+      // drop this message, keep old position until receiving valid data
+      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::ProcessPosMsg - "
+              << "Position message with invalid data (NaN) received from "
+              << MsgHdr->Callsign);
+      return false;
+  }
+
+  message.text.assign(PosMsg->Model,
+                      std::find(PosMsg->Model,
+                                PosMsg->Model + MAX_MODEL_NAME_LEN, '\0'));
+
+  Sender& sender = _senders[message.callsign];
+  if (sender.propertySlots.empty()) {
+    sender.propertySlots.resize(numProperties);
+    sender.announced = false;
+    sender.interestRange = 0.0;
+  }
+  sender.stamp = message.stamp;
+
+  //cout << "INPUT MESSAGE\n";
+
+  // There was a bug in 1.9.0 and before: T_PositionMsg was 196 bytes
+  // on 32 bit architectures and 200 bytes on 64 bit, and this
+  // structure is put directly on the wire. By looking at the padding,
+  // we can sort through the mess, mostly:
+  // If padding is 0 (which is not a valid property type), then the
+  // message was produced by a new client or an old 64 bit client that
+  // happened to have 0 on the stack;
+  // Else if the property list starting with the padding word is
+  // well-formed, then the client is probably an old 32 bit client and
+  // we'll go with that;
+  // Else it is an old 64-bit client and properties start after the
+  // padding.
+  // There is a chance that we could be fooled by garbage in the
+  // padding looking like a valid property, so verifyProperties() is
+  // strict about the validity of the property values.
+  const xdr_data_t* xdr = Msg.properties();
+  if (PosMsg->pad != 0) {
+    if (verifyProperties(&PosMsg->pad, Msg.propsRecvdEnd()))
+      xdr = &PosMsg->pad;
+    else if (!verifyProperties(xdr, Msg.propsRecvdEnd()))
+      xdr = Msg.propsRecvdEnd();
+  }
+  while (xdr < Msg.propsRecvdEnd()) {
+    // simgear::props::Type type = simgear::props::UNSPECIFIED;
+    
+    // First element is always the ID
+    unsigned id = XDR_decode_uint32(*xdr);
+    //cout << pData->id << " ";
+    xdr++;
+    
+    // Check the ID actually exists and get the type
+    const IdPropertyList* plist = findProperty(id);
+    
+    if (plist)
+    {
+      // The values go to the slot of the property, where they stay until
+      // the next change.
+      FGPropertyData* pData = &sender.propertySlots[plist - sIdPropertyList];
+      pData->id = id;
+      pData->type = plist->type;
+      // How we decode the remainder of the property depends on the type
+      switch (pData->type) {
+        case simgear::props::INT:
+        case simgear::props::BOOL:
+        case simgear::props::LONG:
+          pData->int_value = XDR_decode_uint32(*xdr);
+          xdr++;
+          //cout << pData->int_value << "\n";
+          break;
+        case simgear::props::FLOAT:
+        case simgear::props::DOUBLE:
+          pData->float_value = XDR_decode_float(*xdr);
+          xdr++;
+          //cout << pData->float_value << "\n";
+          break;
+        case simgear::props::STRING:
+        case simgear::props::UNSPECIFIED:
+          {
+            // String is complicated. It consists of
+            // The length of the string
+            // The string itself
+            // Padding to the nearest 4-bytes.    
+            uint32_t length = XDR_decode_uint32(*xdr);
+            xdr++;
+            //cout << length << " ";
+            // Old versions truncated the string but left the length unadjusted.
+            if (length > MAX_TEXT_SIZE)
+              length = MAX_TEXT_SIZE;
+            pData->string_value.resize(length);
+            //cout << " String: ";
+            for (unsigned i = 0; i < length; i++)
+              {
+                pData->string_value[i] = (char) XDR_decode_int8(*xdr);
+                xdr++;
+                //cout << pData->string_value[i];
+              }
+
+            // Now handle the padding
+            while ((length % 4) != 0)
+              {
+                xdr++;
+                length++;
+                //cout << "0";
+              }
+            //cout << "\n";
+          }
+          break;
+
+        default:
+          pData->float_value = XDR_decode_float(*xdr);
+          SG_LOG(SG_NETWORK, SG_DEBUG, "Unknown Prop type " << pData->id << " " << pData->type);
+          xdr++;
+          break;
+      }
+
+      if (id == INTEREST_RANGE_ID) {
+        sender.announced = true;
+        sender.interestRange
+          = SGMiscd::max(pData->float_value*SG_NM_TO_METER, 0.0);
+      }
+    }
+    else
+    {
+      // We failed to find the property. We'll try the next packet immediately.
+      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::ProcessPosMsg - "
+             "message from " << MsgHdr->Callsign << " has unknown property id "
+             << id); 
+    }
+  }
+
+  // Hand over the latest value of every property received so far, in the
+  // order of the property list.
+  std::vector<FGPropertyData>::const_iterator slot;
+  for (slot = sender.propertySlots.begin();
+       slot != sender.propertySlots.end(); ++slot) {
+    if (slot->id != 0)
+      motionInfo.properties.push_back(*slot);
+  }
+  message.announced = sender.announced;
+  message.interestRange = sender.interestRange;
+  return true;
+}
+
 //////////////////////////////////////////////////////////////////////
 //
 //  MultiplayMgr constructor
@@ -373,6 +962,7 @@ FGMultiplayMgr::FGMultiplayMgr()
   mInitialised   = false;
   mHaveServer    = false;
   mListener = NULL;
+  mReceiver = NULL;
 } // FGMultiplayMgr::FGMultiplayMgr()
 //////////////////////////////////////////////////////////////////////
 
@@ -422,6 +1012,17 @@ FGMultiplayMgr::init (void)
   
   mDt = 1.0 / hz;
   mTimeUntilSend = 0.0;
+
+  mKeyframeInterval = fgGetDouble("/sim/multiplay/keyframe-interval-sec", 2.0);
+  mTimeUntilKeyframe = 0.0;
+  mPropertiesSent = false;
+
+  // Announced with every message: the range beyond which we do not need the
+  // properties of the other players, 0 for no limit.
+  SGPropertyNode* interestRange
+    = fgGetNode("/sim/multiplay/interest-range-nm", true);
+  if (!interestRange->hasValue())
+    interestRange->setFloatValue(0.0);
   
   mCallsign = fgGetString("/sim/multiplay/callsign");
   if ((!txAddress.empty()) && (txAddress!="0")) {
@@ -470,6 +1071,9 @@ FGMultiplayMgr::init (void)
     return;
   }
   
+  mReceiver = new Receiver(mSocket.get());
+  mReceiver->start();
+
   mPropertiesChanged = true;
   mListener = new MPPropertyListener(this);
   globals->get_props()->addChangeListener(mListener, false);
@@ -498,133 +1102,47 @@ FGMultiplayMgr::shutdown (void)
 {
   fgSetBool("/sim/multiplay/online", false);
   
-  if (mSocket.get()) {
-    mSocket->close();
-    mSocket.reset(); 
+  if (mReceiver) {
+    mReceiver->stop();
+    delete mReceiver;
+    mReceiver = NULL;
   }
-  
-  MultiPlayerMap::iterator it = mMultiPlayerMap.begin(),
-    end = mMultiPlayerMap.end();
-  for (; it != end; ++it) {
-    it->second->setDie(true);
-  }
-  mMultiPlayerMap.clear();
-  
-  if (mListener) {
-    globals->get_props()->removeChangeListener(mListener);
-    delete mListener;
-    mListener = NULL;
-  }
-  
-  mInitialised = false;
-} // FGMultiplayMgr::Close(void)
-//////////////////////////////////////////////////////////////////////
-
-void
-FGMultiplayMgr::reinit()
-{
-  shutdown();
-  init();
-}
-
-//////////////////////////////////////////////////////////////////////
-//
-//  Description: Sends the position data for the local position.
-//
-//////////////////////////////////////////////////////////////////////
-
-/**
- * The buffer that holds a multi-player message, suitably aligned.
- */
-union FGMultiplayMgr::MsgBuf
-{
-    MsgBuf()
-    {
-        memset(&Msg, 0, sizeof(Msg));
-    }
-
-    T_MsgHdr* msgHdr()
-    {
-        return &Header;
-    }
-
-    const T_MsgHdr* msgHdr() const
-    {
-        return reinterpret_cast<const T_MsgHdr*>(&Header);
-    }
-
-    T_PositionMsg* posMsg()
-    {
-        return reinterpret_cast<T_PositionMsg*>(Msg + sizeof(T_MsgHdr));
-    }
-
-    const T_PositionMsg* posMsg() const
-    {
-        return reinterpret_cast<const T_PositionMsg*>(Msg + sizeof(T_MsgHdr));
-    }
-
-    xdr_data_t* properties()
-    {
-        return reinterpret_cast<xdr_data_t*>(Msg + sizeof(T_MsgHdr)
-                                             + sizeof(T_PositionMsg));
-    }
-
-    const xdr_data_t* properties() const
-    {
-        return reinterpret_cast<const xdr_data_t*>(Msg + sizeof(T_MsgHdr)
-                                                   + sizeof(T_PositionMsg));
-    }
-    /**
-     * The end of the properties buffer.
-     */
-    xdr_data_t* propsEnd()
-    {
-        return reinterpret_cast<xdr_data_t*>(Msg + MAX_PACKET_SIZE);
-    };
-
-    const xdr_data_t* propsEnd() const
-    {
-        return reinterpret_cast<const xdr_data_t*>(Msg + MAX_PACKET_SIZE);
-    };
-    /**
-     * The end of properties actually in the buffer. This assumes that
-     * the message header is valid.
-     */
-    xdr_data_t* propsRecvdEnd()
-    {
-        return reinterpret_cast<xdr_data_t*>(Msg + Header.MsgLen);
-    }
-
-    const xdr_data_t* propsRecvdEnd() const
-    {
-        return reinterpret_cast<const xdr_data_t*>(Msg + Header.MsgLen);
-    }
-    
-    xdr_data2_t double_val;
-    char Msg[MAX_PACKET_SIZE];
-    T_MsgHdr Header;
-};
 
-bool
-FGMultiplayMgr::isSane(const FGExternalMotionData& motionInfo)
+  if (mSocket.get()) {
+    mSocket->close();
+    mSocket.reset(); 
+  }
+  
+  MultiPlayerMap::iterator it = mMultiPlayerMap.begin(),
+    end = mMultiPlayerMap.end();
+  for (; it != end; ++it) {
+    it->second.aircraft->setDie(true);
+  }
+  mMultiPlayerMap.clear();
+  
+  if (mListener) {
+    globals->get_props()->removeChangeListener(mListener);
+    delete mListener;
+    mListener = NULL;
+  }
+  
+  mInitialised = false;
+} // FGMultiplayMgr::Close(void)
+//////////////////////////////////////////////////////////////////////
+
+void
+FGMultiplayMgr::reinit()
 {
-    // check for corrupted data (NaNs)
-    bool isCorrupted = false;
-    isCorrupted |= ((SGMisc<double>::isNaN(motionInfo.time           )) ||
-                    (SGMisc<double>::isNaN(motionInfo.lag            )) ||
-                    (osg::isNaN(motionInfo.orientation(3) )));
-    for (unsigned i = 0; (i < 3)&&(!isCorrupted); ++i)
-    {
-        isCorrupted |= ((osg::isNaN(motionInfo.position(i)      ))||
-                        (osg::isNaN(motionInfo.orientation(i)   ))||
-                        (osg::isNaN(motionInfo.linearVel(i))    )||
-                        (osg::isNaN(motionInfo.angularVel(i))   )||
-                        (osg::isNaN(motionInfo.linearAccel(i))  )||
-                        (osg::isNaN(motionInfo.angularAccel(i)) ));
-    }
-    return !isCorrupted;
+  shutdown();
+  init();
 }
 
+//////////////////////////////////////////////////////////////////////
+//
+//  Description: Sends the position data for the local position.
+//
+//////////////////////////////////////////////////////////////////////
+
 void
 FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
 {
@@ -685,7 +1203,7 @@ FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
         PosMsg->angularAccel[i] = XDR_encode_float (motionInfo.angularAccel(i));
 
       xdr_data_t* ptr = msgBuf.properties();
-      std::vector<FGPropertyData*>::const_iterator it;
+      std::vector<FGPropertyData>::const_iterator it;
       it = motionInfo.properties.begin();
       //cout << "OUTPUT PROPERTIES\n";
       xdr_data_t* msgEnd = msgBuf.propsEnd();
@@ -693,21 +1211,21 @@ FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
         
         // First element is the ID. Write it out when we know we have room for
         // the whole property.
-        xdr_data_t id =  XDR_encode_uint32((*it)->id);
+        xdr_data_t id =  XDR_encode_uint32(it->id);
         // The actual data representation depends on the type
-        switch ((*it)->type) {
+        switch (it->type) {
           case simgear::props::INT:
           case simgear::props::BOOL:
           case simgear::props::LONG:
             *ptr++ = id;
-            *ptr++ = XDR_encode_uint32((*it)->int_value);
-            //cout << "Prop:" << (*it)->id << " " << (*it)->type << " "<< (*it)->int_value << "\n";
+            *ptr++ = XDR_encode_uint32(it->int_value);
+            //cout << "Prop:" << it->id << " " << it->type << " "<< it->int_value << "\n";
             break;
           case simgear::props::FLOAT:
           case simgear::props::DOUBLE:
             *ptr++ = id;
-            *ptr++ = XDR_encode_float((*it)->float_value);
-            //cout << "Prop:" << (*it)->id << " " << (*it)->type << " "<< (*it)->float_value << "\n";
+            *ptr++ = XDR_encode_float(it->float_value);
+            //cout << "Prop:" << it->id << " " << it->type << " "<< it->float_value << "\n";
             break;
           case simgear::props::STRING:
           case simgear::props::UNSPECIFIED:
@@ -716,9 +1234,9 @@ FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
               // The length of the string
               // The string itself
               // Padding to the nearest 4-bytes.        
-              const char* lcharptr = (*it)->string_value;
+              const char* lcharptr = it->string_value.c_str();
               
-              if (lcharptr != 0)
+              if (!it->string_value.empty())
               {
                 // Add the length         
                 ////cout << "String length: " << strlen(lcharptr) << "\n";
@@ -745,7 +1263,7 @@ FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
                     lcount++;          
                   }
     
-                  //cout << "Prop:" << (*it)->id << " " << (*it)->type << " " << len << " " << (*it)->string_value;
+                  //cout << "Prop:" << it->id << " " << it->type << " " << len << " " << it->string_value;
     
                   // Now pad if required
                   while ((lcount % 4) != 0)
@@ -763,16 +1281,16 @@ FGMultiplayMgr::SendMyPosition(const FGExternalMotionData& motionInfo)
                 // Nothing to encode
                 *ptr++ = id;
                 *ptr++ = XDR_encode_uint32(0);
-                //cout << "Prop:" << (*it)->id << " " << (*it)->type << " 0\n";
+                //cout << "Prop:" << it->id << " " << it->type << " 0\n";
               }
             }
             break;
             
           default:
-            //cout << " Unknown Type: " << (*it)->type << "\n";
+            //cout << " Unknown Type: " << it->type << "\n";
             *ptr++ = id;
-            *ptr++ = XDR_encode_float((*it)->float_value);;
-            //cout << "Prop:" << (*it)->id << " " << (*it)->type << " "<< (*it)->float_value << "\n";
+            *ptr++ = XDR_encode_float(it->float_value);;
+            //cout << "Prop:" << it->id << " " << it->type << " "<< it->float_value << "\n";
             break;
         }
             
@@ -854,103 +1372,27 @@ FGMultiplayMgr::update(double dt)
   }
 
   //////////////////////////////////////////////////
-  //  Read the receive socket and process any data
+  //  Apply the messages decoded by the receiver
   //////////////////////////////////////////////////
-  ssize_t bytes;
-  do {
-    MsgBuf msgBuf;
-    //////////////////////////////////////////////////
-    //  Although the recv call asks for 
-    //  MAX_PACKET_SIZE of data, the number of bytes
-    //  returned will only be that of the next
-    //  packet waiting to be processed.
-    //////////////////////////////////////////////////
-    simgear::IPAddress SenderAddress;
-    int RecvStatus = mSocket->recvfrom(msgBuf.Msg, sizeof(msgBuf.Msg), 0,
-                              &SenderAddress);
-    //////////////////////////////////////////////////
-    //  no Data received
-    //////////////////////////////////////////////////
-    if (RecvStatus == 0)
-        break;
-
-    // socket error reported?
-    // errno isn't thread-safe - so only check its value when
-    // socket return status < 0 really indicates a failure.
-    if ((RecvStatus < 0)&&
-        ((errno == EAGAIN) || (errno == 0))) // MSVC output "NoError" otherwise
-    {
-        // ignore "normal" errors
-        break;
-    }
-
-    if (RecvStatus<0)
-    {
-        SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - Unable to receive data. "
-               << strerror(errno) << "(errno " << errno << ")");
-        break;
-    }
-
-    // status is positive: bytes received
-    bytes = (ssize_t) RecvStatus;
-    if (bytes <= static_cast<ssize_t>(sizeof(T_MsgHdr))) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "received message with insufficient data" );
-      break;
-    }
-    //////////////////////////////////////////////////
-    //  Read header
-    //////////////////////////////////////////////////
-    T_MsgHdr* MsgHdr = msgBuf.msgHdr();
-    MsgHdr->Magic       = XDR_decode_uint32 (MsgHdr->Magic);
-    MsgHdr->Version     = XDR_decode_uint32 (MsgHdr->Version);
-    MsgHdr->MsgId       = XDR_decode_uint32 (MsgHdr->MsgId);
-    MsgHdr->MsgLen      = XDR_decode_uint32 (MsgHdr->MsgLen);
-    MsgHdr->ReplyPort   = XDR_decode_uint32 (MsgHdr->ReplyPort);
-    MsgHdr->Callsign[MAX_CALLSIGN_LEN -1] = '\0';
-    if (MsgHdr->Magic != MSG_MAGIC) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "message has invalid magic number!" );
-      break;
-    }
-    if (MsgHdr->Version != PROTO_VER) {
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "message has invalid protocol number!" );
-      break;
-    }
-    if (static_cast<ssize_t>(MsgHdr->MsgLen) != bytes) {
-      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-             << "message from " << MsgHdr->Callsign << " has invalid length!");
-      break;
-    }
-    //////////////////////////////////////////////////
-    //  Process messages
-    //////////////////////////////////////////////////
-    switch (MsgHdr->MsgId) {
+  Message* message;
+  while ((message = mReceiver->front()) != 0) {
+    switch (message->id) {
     case CHAT_MSG_ID:
-      ProcessChatMsg(msgBuf, SenderAddress);
+      ProcessChatMsg(*message);
       break;
     case POS_DATA_ID:
-      ProcessPosMsg(msgBuf, SenderAddress, stamp);
-      break;
-    case UNUSABLE_POS_DATA_ID:
-    case OLD_OLD_POS_DATA_ID:
-    case OLD_PROP_MSG_ID:
-    case OLD_POS_DATA_ID:
-      break;
-    default:
-      SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-              << "Unknown message Id received: " << MsgHdr->MsgId );
+      ProcessPosMsg(*message);
       break;
     }
-  } while (bytes > 0);
+    mReceiver->pop();
+  }
 
   // check for expiry
   MultiPlayerMap::iterator it = mMultiPlayerMap.begin();
   while (it != mMultiPlayerMap.end()) {
-    if (it->second->getLastTimestamp() + 10 < stamp) {
+    if (it->second.aircraft->getLastTimestamp() + EXPIRY_SECONDS < stamp) {
       std::string name = it->first;
-      it->second->setDie(true);
+      it->second.aircraft->setDie(true);
       mMultiPlayerMap.erase(it);
       it = mMultiPlayerMap.upper_bound(name);
     } else
@@ -1040,54 +1482,37 @@ FGMultiplayMgr::Send()
       motionInfo.angularAccel = SGVec3f::zeros();
     }
 
-    // now send the properties
+    // now send the properties. When every player we know of understands
+    // deltas, only the changed ones are sent between the keyframes. None are
+    // sent when we are out of the interest range of all the players.
+    bool wanted = propertiesWanted(motionInfo.position);
+    mTimeUntilKeyframe -= mDt;
+    bool keyframe = (wanted && !mPropertiesSent) || (mTimeUntilKeyframe <= 0.0)
+      || !deltasUnderstood();
+    if (mTimeUntilKeyframe <= 0.0)
+      mTimeUntilKeyframe = mKeyframeInterval;
+
     PropertyMap::iterator it;
     for (it = mPropertyMap.begin(); it != mPropertyMap.end(); ++it) {
-      FGPropertyData* pData = new FGPropertyData;
-      pData->id = it->first;
-      pData->type = it->second->getType();
+      FGPropertyData data;
+      readProperty(it->first, it->second.node, data);
       
-      switch (pData->type) {
-        case props::INT:
-        case props::LONG:
-        case props::BOOL:
-          pData->int_value = it->second->getIntValue();
-          break;
-        case props::FLOAT:
-        case props::DOUBLE:
-          pData->float_value = it->second->getFloatValue();
-          break;
-        case props::STRING:
-        case props::UNSPECIFIED:
-          {
-            // FIXME: We assume unspecified are strings for the moment.
-
-            const char* cstr = it->second->getStringValue();
-            int len = strlen(cstr);
-            
-            if (len > 0)
-            {            
-              pData->string_value = new char[len + 1];
-              strcpy(pData->string_value, cstr);
-            }
-            else
-            {
-              // Size 0 - ignore
-              pData->string_value = 0;            
-            }
-
-            //cout << " Sending property " << pData->id << " " << pData->type << " " <<  pData->string_value << "\n";
-            break;        
-          }
-        default:
-          // FIXME Currently default to a float. 
-          //cout << "Unknown type when iterating through props: " << pData->type << "\n";
-          pData->float_value = it->second->getFloatValue();
-          break;
+      if (it->first == INTEREST_RANGE_ID) {
+        // whatever the type of the node, see the property list
+        data.type = props::FLOAT;
+        data.float_value = it->second.node->getFloatValue();
+      } else {
+        if (!wanted)
+          continue;
+        FGPropertyData& lastSent = it->second.lastSent;
+        if (!keyframe && (lastSent.id != 0) && sameValue(data, lastSent))
+          continue;
+        lastSent = data;
       }
       
-      motionInfo.properties.push_back(pData);
+      motionInfo.properties.push_back(data);
     }
+    mPropertiesSent = wanted;
 
     SendMyPosition(motionInfo);
 }
@@ -1099,156 +1524,15 @@ FGMultiplayMgr::Send()
 //
 //////////////////////////////////////////////////////////////////////
 void
-FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
-                              const simgear::IPAddress& SenderAddress, long stamp)
+FGMultiplayMgr::ProcessPosMsg(Message& message)
 {
-  const T_MsgHdr* MsgHdr = Msg.msgHdr();
-  if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + sizeof(T_PositionMsg)) {
-    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-            << "Position message received with insufficient data" );
-    return;
-  }
-  const T_PositionMsg* PosMsg = Msg.posMsg();
-  FGExternalMotionData motionInfo;
-  motionInfo.time = XDR_decode_double(PosMsg->time);
-  motionInfo.lag = XDR_decode_double(PosMsg->lag);
-  for (unsigned i = 0; i < 3; ++i)
-    motionInfo.position(i) = XDR_decode_double(PosMsg->position[i]);
-  SGVec3f angleAxis;
-  for (unsigned i = 0; i < 3; ++i)
-    angleAxis(i) = XDR_decode_float(PosMsg->orientation[i]);
-  motionInfo.orientation = SGQuatf::fromAngleAxis(angleAxis);
-  for (unsigned i = 0; i < 3; ++i)
-    motionInfo.linearVel(i) = XDR_decode_float(PosMsg->linearVel[i]);
-  for (unsigned i = 0; i < 3; ++i)
-    motionInfo.angularVel(i) = XDR_decode_float(PosMsg->angularVel[i]);
-  for (unsigned i = 0; i < 3; ++i)
-    motionInfo.linearAccel(i) = XDR_decode_float(PosMsg->linearAccel[i]);
-  for (unsigned i = 0; i < 3; ++i)
-    motionInfo.angularAccel(i) = XDR_decode_float(PosMsg->angularAccel[i]);
-
-  // sanity check: do not allow injection of corrupted data (NaNs)
-  if (!isSane(motionInfo))
-  {
-      // drop this message, keep old position until receiving valid data
-      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::ProcessPosMsg - "
-              << "Position message with invalid data (NaN) received from "
-              << MsgHdr->Callsign);
-      return;
-  }
-
-  //cout << "INPUT MESSAGE\n";
-
-  // There was a bug in 1.9.0 and before: T_PositionMsg was 196 bytes
-  // on 32 bit architectures and 200 bytes on 64 bit, and this
-  // structure is put directly on the wire. By looking at the padding,
-  // we can sort through the mess, mostly:
-  // If padding is 0 (which is not a valid property type), then the
-  // message was produced by a new client or an old 64 bit client that
-  // happened to have 0 on the stack;
-  // Else if the property list starting with the padding word is
-  // well-formed, then the client is probably an old 32 bit client and
-  // we'll go with that;
-  // Else it is an old 64-bit client and properties start after the
-  // padding.
-  // There is a chance that we could be fooled by garbage in the
-  // padding looking like a valid property, so verifyProperties() is
-  // strict about the validity of the property values.
-  const xdr_data_t* xdr = Msg.properties();
-  if (PosMsg->pad != 0) {
-    if (verifyProperties(&PosMsg->pad, Msg.propsRecvdEnd()))
-      xdr = &PosMsg->pad;
-    else if (!verifyProperties(xdr, Msg.propsRecvdEnd()))
-      goto noprops;
-  }
-  while (xdr < Msg.propsRecvdEnd()) {
-    // simgear::props::Type type = simgear::props::UNSPECIFIED;
-    
-    // First element is always the ID
-    unsigned id = XDR_decode_uint32(*xdr);
-    //cout << pData->id << " ";
-    xdr++;
-    
-    // Check the ID actually exists and get the type
-    const IdPropertyList* plist = findProperty(id);
-    
-    if (plist)
-    {
-      FGPropertyData* pData = new FGPropertyData;
-      pData->id = id;
-      pData->type = plist->type;
-      // How we decode the remainder of the property depends on the type
-      switch (pData->type) {
-        case simgear::props::INT:
-        case simgear::props::BOOL:
-        case simgear::props::LONG:
-          pData->int_value = XDR_decode_uint32(*xdr);
-          xdr++;
-          //cout << pData->int_value << "\n";
-          break;
-        case simgear::props::FLOAT:
-        case simgear::props::DOUBLE:
-          pData->float_value = XDR_decode_float(*xdr);
-          xdr++;
-          //cout << pData->float_value << "\n";
-          break;
-        case simgear::props::STRING:
-        case simgear::props::UNSPECIFIED:
-          {
-            // String is complicated. It consists of
-            // The length of the string
-            // The string itself
-            // Padding to the nearest 4-bytes.    
-            uint32_t length = XDR_decode_uint32(*xdr);
-            xdr++;
-            //cout << length << " ";
-            // Old versions truncated the string but left the length unadjusted.
-            if (length > MAX_TEXT_SIZE)
-              length = MAX_TEXT_SIZE;
-            pData->string_value = new char[length + 1];
-            //cout << " String: ";
-            for (unsigned i = 0; i < length; i++)
-              {
-                pData->string_value[i] = (char) XDR_decode_int8(*xdr);
-                xdr++;
-                //cout << pData->string_value[i];
-              }
-
-            pData->string_value[length] = '\0';
-
-            // Now handle the padding
-            while ((length % 4) != 0)
-              {
-                xdr++;
-                length++;
-                //cout << "0";
-              }
-            //cout << "\n";
-          }
-          break;
-
-        default:
-          pData->float_value = XDR_decode_float(*xdr);
-          SG_LOG(SG_NETWORK, SG_DEBUG, "Unknown Prop type " << pData->id << " " << pData->type);
-          xdr++;
-          break;
-      }
-
-      motionInfo.properties.push_back(pData);
-    }
-    else
-    {
-      // We failed to find the property. We'll try the next packet immediately.
-      SG_LOG(SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::ProcessPosMsg - "
-             "message from " << MsgHdr->Callsign << " has unknown property id "
-             << id); 
-    }
-  }
- noprops:
-  FGAIMultiplayer* mp = getMultiplayer(MsgHdr->Callsign);
-  if (!mp)
-    mp = addMultiplayer(MsgHdr->Callsign, PosMsg->Model);
-  mp->addMotionInfo(motionInfo, stamp);
+  Player* player = getMultiplayer(message.callsign);
+  if (!player)
+    player = addMultiplayer(message.callsign, message.text);
+  player->position = message.motionInfo.position;
+  player->announced = message.announced;
+  player->interestRange = message.interestRange;
+  player->aircraft->addMotionInfo(message.motionInfo, message.stamp);
 } // FGMultiplayMgr::ProcessPosMsg()
 //////////////////////////////////////////////////////////////////////
 
@@ -1259,27 +1543,10 @@ FGMultiplayMgr::ProcessPosMsg(const FGMultiplayMgr::MsgBuf& Msg,
 //
 //////////////////////////////////////////////////////////////////////
 void
-FGMultiplayMgr::ProcessChatMsg(const MsgBuf& Msg,
-                               const simgear::IPAddress& SenderAddress)
+FGMultiplayMgr::ProcessChatMsg(const Message& message)
 {
-  const T_MsgHdr* MsgHdr = Msg.msgHdr();
-  if (MsgHdr->MsgLen < sizeof(T_MsgHdr) + 1) {
-    SG_LOG( SG_NETWORK, SG_DEBUG, "FGMultiplayMgr::MP_ProcessData - "
-            << "Chat message received with insufficient data" );
-    return;
-  }
-  
-  char *chatStr = new char[MsgHdr->MsgLen - sizeof(T_MsgHdr)];
-  const T_ChatMsg* ChatMsg
-      = reinterpret_cast<const T_ChatMsg *>(Msg.Msg + sizeof(T_MsgHdr));
-  strncpy(chatStr, ChatMsg->Text,
-          MsgHdr->MsgLen - sizeof(T_MsgHdr));
-  chatStr[MsgHdr->MsgLen - sizeof(T_MsgHdr) - 1] = '\0';
-  
-  SG_LOG (SG_NETWORK, SG_WARN, "Chat [" << MsgHdr->Callsign << "]"
-           << " " << chatStr);
-
-  delete [] chatStr;
+  SG_LOG (SG_NETWORK, SG_WARN, "Chat [" << message.callsign << "]"
+           << " " << message.text);
 } // FGMultiplayMgr::ProcessChatMsg ()
 //////////////////////////////////////////////////////////////////////
 
@@ -1308,39 +1575,77 @@ FGMultiplayMgr::FillMsgHdr(T_MsgHdr *MsgHdr, int MsgId, unsigned _len)
   MsgHdr->Callsign[MAX_CALLSIGN_LEN - 1] = '\0';
 }
 
-FGAIMultiplayer*
+FGMultiplayMgr::Player*
 FGMultiplayMgr::addMultiplayer(const std::string& callsign,
                                const std::string& modelName)
 {
-  if (0 < mMultiPlayerMap.count(callsign))
-    return mMultiPlayerMap[callsign].get();
-
-  FGAIMultiplayer* mp = new FGAIMultiplayer;
-  mp->setPath(modelName.c_str());
-  mp->setCallSign(callsign);
-  mMultiPlayerMap[callsign] = mp;
+  MultiPlayerMap::iterator it = mMultiPlayerMap.find(callsign);
+  if (it != mMultiPlayerMap.end())
+    return &it->second;
+
+  Player& player = mMultiPlayerMap[callsign];
+  player.aircraft = new FGAIMultiplayer;
+  player.aircraft->setPath(modelName.c_str());
+  player.aircraft->setCallSign(callsign);
+  player.position = SGVec3d::zeros();
+  player.announced = false;
+  player.interestRange = 0.0;
 
   FGAIManager *aiMgr = (FGAIManager*)globals->get_subsystem("ai-model");
   if (aiMgr) {
-    aiMgr->attach(mp);
+    aiMgr->attach(player.aircraft);
 
     /// FIXME: that must follow the attach ATM ...
     for (unsigned i = 0; i < numProperties; ++i)
-      mp->addPropertyId(sIdPropertyList[i].id, sIdPropertyList[i].name);
+      player.aircraft->addPropertyId(sIdPropertyList[i].id, sIdPropertyList[i].name);
   }
 
-  return mp;
+  // the newcomer needs all our properties
+  mTimeUntilKeyframe = 0.0;
+
+  return &player;
 }
 
-FGAIMultiplayer*
+FGMultiplayMgr::Player*
 FGMultiplayMgr::getMultiplayer(const std::string& callsign)
 {
-  if (0 < mMultiPlayerMap.count(callsign))
-    return mMultiPlayerMap[callsign].get();
+  MultiPlayerMap::iterator it = mMultiPlayerMap.find(callsign);
+  if (it != mMultiPlayerMap.end())
+    return &it->second;
   else
     return 0;
 }
 
+bool
+FGMultiplayMgr::propertiesWanted(const SGVec3d& position) const
+{
+  // We may be seen by players we have not heard of yet
+  if (mMultiPlayerMap.empty())
+    return true;
+
+  MultiPlayerMap::const_iterator it;
+  for (it = mMultiPlayerMap.begin(); it != mMultiPlayerMap.end(); ++it) {
+    const Player& player = it->second;
+    if (!player.announced || (player.interestRange <= 0.0))
+      return true;
+    if (distSqr(player.position, position)
+        <= player.interestRange*player.interestRange)
+      return true;
+  }
+  return false;
+}
+
+bool
+FGMultiplayMgr::deltasUnderstood() const
+{
+  MultiPlayerMap::const_iterator it;
+  for (it = mMultiPlayerMap.begin(); it != mMultiPlayerMap.end(); ++it) {
+    if (!it->second.announced)
+      return false;
+  }
+  return true;
+}
+
 void
 FGMultiplayMgr::findProperties()
 {
@@ -1362,7 +1667,7 @@ FGMultiplayMgr::findProperties()
         continue; // already activated
       }
       
-      mPropertyMap[id] = pNode;
+      mPropertyMap[id].node = pNode;
       SG_LOG(SG_NETWORK, SG_DEBUG, "activating MP property:" << pNode->getPath());
     }
 }
@@ -32,6 +32,7 @@
 #define MULTIPLAYTXMGR_HID "$Id$"
 
 
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -41,9 +42,9 @@
 #include <simgear/io/raw_socket.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
 
-struct FGExternalMotionData;
+#include "mpmessages.hxx"
+
 class MPPropertyListener;
-struct T_MsgHdr;
 class FGAIMultiplayer;
 
 class FGMultiplayMgr : public SGSubsystem
@@ -75,30 +76,50 @@ private:
   
   void Send();
   void SendMyPosition(const FGExternalMotionData& motionInfo);
+  bool propertiesWanted(const SGVec3d& position) const;
+  bool deltasUnderstood() const;
 
   union MsgBuf;
-  FGAIMultiplayer* addMultiplayer(const std::string& callsign,
-                                  const std::string& modelName);
-  FGAIMultiplayer* getMultiplayer(const std::string& callsign);
+  struct Message;
+  class Receiver;
+  struct Player;
+  Player* addMultiplayer(const std::string& callsign,
+                         const std::string& modelName);
+  Player* getMultiplayer(const std::string& callsign);
   void FillMsgHdr(T_MsgHdr *MsgHdr, int iMsgId, unsigned _len = 0u);
-  void ProcessPosMsg(const MsgBuf& Msg, const simgear::IPAddress& SenderAddress,
-                     long stamp);
-  void ProcessChatMsg(const MsgBuf& Msg, const simgear::IPAddress& SenderAddress);
-  bool isSane(const FGExternalMotionData& motionInfo);
+  void ProcessPosMsg(Message& message);
+  void ProcessChatMsg(const Message& message);
+  static bool isSane(const FGExternalMotionData& motionInfo);
+
+  /// What we know of a remote player
+  struct Player {
+    SGSharedPtr<FGAIMultiplayer> aircraft;
+    /// The position in the latest message
+    SGVec3d position;
+    /// The player understands property deltas and declares its interest
+    bool announced;
+    double interestRange; // m, 0 when unlimited
+  };
 
-  /// maps from the callsign string to the FGAIMultiplayer
-  typedef std::map<std::string, SGSharedPtr<FGAIMultiplayer> > MultiPlayerMap;
+  /// maps from the callsign string to the player
+  typedef std::map<std::string, Player> MultiPlayerMap;
   MultiPlayerMap mMultiPlayerMap;
 
   std::auto_ptr<simgear::Socket> mSocket;
+  /// Receives and decodes the messages on its own thread
+  Receiver* mReceiver;
   simgear::IPAddress mServer;
   bool mHaveServer;
   bool mInitialised;
   std::string mCallsign;
   
   // Map between the property id's from the multiplayers network packets
-  // and the property nodes
-  typedef std::map<unsigned int, SGSharedPtr<SGPropertyNode> > PropertyMap;
+  // and the property nodes, with the value we sent last
+  struct LocalProperty {
+    SGSharedPtr<SGPropertyNode> node;
+    FGPropertyData lastSent;
+  };
+  typedef std::map<unsigned int, LocalProperty> PropertyMap;
   PropertyMap mPropertyMap;
   
   bool mPropertiesChanged;
@@ -106,6 +127,10 @@ private:
   
   double mDt; // reciprocal of /sim/multiplay/tx-rate-hz
   double mTimeUntilSend;
+
+  double mKeyframeInterval; // /sim/multiplay/keyframe-interval-sec
+  double mTimeUntilKeyframe;
+  bool mPropertiesSent; // the last message carried the properties
 };
 
 #endif
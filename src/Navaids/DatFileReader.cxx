@@ -0,0 +1,224 @@
+// DatFileReader.cxx - decompress and tokenize a (gzipped) .dat file on a
+// background thread, handing batches of records to a single consumer.
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DatFileReader.hxx"
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sgstream.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+namespace {
+
+// records per batch handed to the consumer, and the maximum number of
+// batches a reader may queue up before blocking.
+const size_t BATCH_SIZE = 2048;
+const size_t MAX_QUEUED_BATCHES = 8;
+
+} // anonymous namespace
+
+namespace flightgear
+{
+
+DatFileReader::DatFileReader(const SGPath& path, unsigned int headerLines,
+                             int maxSplit) :
+  _path(path),
+  _stream(new sg_gzifstream(path.str())),
+  _headerLines(headerLines),
+  _maxSplit(maxSplit),
+  _started(false),
+  _done(false),
+  _cancelled(false),
+  _parseMSec(0),
+  _recordCount(0),
+  _current(NULL),
+  _currentIndex(0)
+{
+  if (!_stream->is_open()) {
+    _done = true;
+  }
+}
+
+DatFileReader::~DatFileReader()
+{
+  cancel();
+  delete _current;
+  while (!_queue.empty()) {
+    delete _queue.front();
+    _queue.pop_front();
+  }
+}
+
+bool DatFileReader::isOpen() const
+{
+  return _stream->is_open();
+}
+
+void DatFileReader::startReading()
+{
+  if (_started || !_stream->is_open()) {
+    return;
+  }
+
+  _started = true;
+  start();
+}
+
+void DatFileReader::cancel()
+{
+  {
+    SGGuard<SGMutex> g(_lock);
+    _cancelled = true;
+    _queueChanged.broadcast();
+  }
+
+  if (_started) {
+    join();
+    _started = false;
+  }
+}
+
+int DatFileReader::parseMSec() const
+{
+  SGGuard<SGMutex> g(_lock);
+  return _parseMSec;
+}
+
+unsigned int DatFileReader::recordCount() const
+{
+  SGGuard<SGMutex> g(_lock);
+  return _recordCount;
+}
+
+const DatRecord* DatFileReader::next()
+{
+  if (_current && (_currentIndex < _current->size())) {
+    return &(*_current)[_currentIndex++];
+  }
+
+  delete _current;
+  _current = NULL;
+  _currentIndex = 0;
+
+  startReading();
+  SGGuard<SGMutex> g(_lock);
+  while (_queue.empty() && !_done) {
+    _queueChanged.wait(_lock);
+  }
+
+  if (_queue.empty()) {
+    return NULL; // end of file
+  }
+
+  _current = _queue.front();
+  _queue.pop_front();
+  _queueChanged.signal(); // wake the reader if it was blocked on a full queue
+  return &(*_current)[_currentIndex++];
+}
+
+void DatFileReader::pushBatch(DatRecordBatch* batch)
+{
+  SGGuard<SGMutex> g(_lock);
+  while ((_queue.size() >= MAX_QUEUED_BATCHES) && !_cancelled) {
+    _queueChanged.wait(_lock);
+  }
+
+  if (_cancelled) {
+    delete batch;
+    return;
+  }
+
+  _recordCount += batch->size();
+  _queue.push_back(batch);
+  _queueChanged.signal();
+}
+
+void DatFileReader::run()
+{
+  SGTimeStamp st;
+  st.stamp();
+  int blockedMSec = 0;
+
+  unsigned int lineNum = 0;
+  std::string line;
+  DatRecordBatch* batch = new DatRecordBatch;
+  batch->reserve(BATCH_SIZE);
+
+  while (std::getline(*_stream, line)) {
+    ++lineNum;
+    if (lineNum <= _headerLines) {
+      continue;
+    }
+
+    if (!line.empty() && (line[line.size() - 1] == '\r')) {
+      line.erase(line.size() - 1);
+    }
+
+    // fix.dat right-aligns its latitudes, so only whitespace-only lines are
+    // blank; indented lines are kept, and split() drops the indentation.
+    std::string::size_type first = line.find_first_not_of(" \t\r\n\f\v");
+    if ((first == std::string::npos) || (line[first] == '#')) {
+      continue;
+    }
+
+    batch->push_back(DatRecord());
+    DatRecord& rec(batch->back());
+    rec.lineNum = lineNum;
+    rec.line.swap(line);
+    rec.tokens = simgear::strutils::split(rec.line, 0, _maxSplit);
+    if (_maxSplit && (rec.tokens.size() > (size_t) _maxSplit)) {
+      rec.tokens.back() = simgear::strutils::strip(rec.tokens.back());
+    }
+
+    if (batch->size() >= BATCH_SIZE) {
+      SGTimeStamp wait;
+      wait.stamp();
+      pushBatch(batch);
+      blockedMSec += wait.elapsedMSec();
+
+      {
+        SGGuard<SGMutex> g(_lock);
+        if (_cancelled) {
+          return;
+        }
+      }
+
+      batch = new DatRecordBatch;
+      batch->reserve(BATCH_SIZE);
+    }
+  } // of line iteration
+
+  if (batch->empty()) {
+    delete batch;
+  } else {
+    pushBatch(batch);
+  }
+
+  SG_LOG(SG_NAVAID, SG_DEBUG, "DatFileReader: " << _path << " read "
+         << lineNum << " lines");
+
+  SGGuard<SGMutex> g(_lock);
+  _parseMSec = st.elapsedMSec() - blockedMSec;
+  _done = true;
+  _queueChanged.broadcast();
+}
+
+} // of namespace flightgear
@@ -0,0 +1,140 @@
+/**
+ * DatFileReader - decompress and tokenize a (gzipped) .dat file on a
+ * background thread, handing batches of records to a single consumer.
+ */
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_DAT_FILE_READER_HXX
+#define FG_DAT_FILE_READER_HXX
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/misc/strutils.hxx> // for string_list
+#include <simgear/threads/SGThread.hxx>
+
+class sg_gzifstream;
+
+namespace flightgear
+{
+
+/**
+ * A single non-empty, non-comment line from a .dat file, together with
+ * its whitespace-separated tokens.
+ */
+struct DatRecord
+{
+  unsigned int lineNum;
+  std::string line;
+  string_list tokens;
+};
+
+typedef std::vector<DatRecord> DatRecordBatch;
+
+/**
+ * The parser stage of the NavDataCache rebuild. Each reader owns one file,
+ * and does the decompression, line splitting and tokenizing on its own
+ * thread, so several files can be prepared concurrently while the cache
+ * writer thread works through them one at a time (in dependency order).
+ *
+ * Records are handed over in batches through a bounded queue, so a reader
+ * which gets far ahead of the writer will block rather than holding an
+ * entire apt.dat in memory. The thread is only started by startReading(),
+ * so the consumer can keep just the next file or two in flight.
+ */
+class DatFileReader : public SGThread
+{
+public:
+  /**
+   * @param headerLines - number of lines to discard at the start of the file
+   * @param maxSplit - if non-zero, stop tokenizing after this many tokens;
+   * the remainder of the line is returned (stripped) as the last token. This
+   * matches the semantics of simgear::strutils::split.
+   */
+  DatFileReader(const SGPath& path, unsigned int headerLines = 0,
+                int maxSplit = 0);
+  virtual ~DatFileReader();
+
+  const SGPath& path() const
+  { return _path; }
+
+  /**
+   * was the file opened successfully? Valid as soon as the reader is
+   * constructed, no need to wait for the thread to run.
+   */
+  bool isOpen() const;
+
+  /**
+   * start the reader thread, unless it is running already or the file
+   * could not be opened. next() starts it at the latest.
+   */
+  void startReading();
+
+  /**
+   * was the reader thread started?
+   */
+  bool started() const
+  { return _started; }
+
+  /**
+   * retrieve the next record, blocking until one is available. Returns NULL
+   * once the end of the file is reached. The returned pointer is valid until
+   * the next call.
+   */
+  const DatRecord* next();
+
+  /**
+   * wall-clock time the reader thread spent decompressing and tokenizing,
+   * excluding time spent blocked on a full queue. Only valid once next()
+   * has returned NULL.
+   */
+  int parseMSec() const;
+
+  unsigned int recordCount() const;
+
+  /**
+   * request the reader thread to stop early, and wait for it to finish.
+   * Used if the consumer abandons the file, eg due to an exception.
+   */
+  void cancel();
+protected:
+  virtual void run();
+private:
+  void pushBatch(DatRecordBatch* batch);
+
+  SGPath _path;
+  std::auto_ptr<sg_gzifstream> _stream;
+  unsigned int _headerLines;
+  int _maxSplit;
+
+  mutable SGMutex _lock;
+  SGWaitCondition _queueChanged;
+  std::deque<DatRecordBatch*> _queue;
+  bool _started, _done, _cancelled;
+  int _parseMSec;
+  unsigned int _recordCount;
+
+  // consumer-side state, only touched by the thread calling next()
+  DatRecordBatch* _current;
+  size_t _currentIndex;
+};
+
+} // of namespace flightgear
+
+#endif // of FG_DAT_FILE_READER_HXX
@@ -32,6 +32,8 @@
 
 // std
 #include <map>
+#include <algorithm>
+#include <iterator>
 #include <cassert>
 #include <stdint.h> // for int64_t
 // boost
@@ -49,6 +51,7 @@
 #include <simgear/threads/SGGuard.hxx>
 
 #include <Main/globals.hxx>
+#include <Main/fg_props.hxx>
 #include "markerbeacon.hxx"
 #include "navrecord.hxx"
 #include <Airports/airport.hxx>
@@ -61,18 +64,19 @@
 #include <Airports/apt_loader.hxx>
 #include <Navaids/airways.hxx>
 #include "poidb.hxx"
+#include "DatFileReader.hxx"
+#include "NavDataSnapshot.hxx"
 #include <Airports/parking.hxx>
 #include <Airports/gnnode.hxx>
 
 using std::string;
 
 #define SG_NAVCACHE SG_NAVAID
-//#define LAZY_OCTREE_UPDATES 1
 
 namespace {
 
 const int MAX_RETRIES = 10;
-const int SCHEMA_VERSION = 8;
+const int SCHEMA_VERSION = 9;
 const int CACHE_SIZE_KBYTES= 16000;
     
 // bind a std::string to a sqlite statement. The std::string must live the
@@ -132,6 +136,102 @@ static string cleanRunwayNo(const string& aRwyNo)
   
   return result;
 }
+
+/// the upper limit on entries returned to the AirportList dialog
+const unsigned int MAX_AIRPORT_SEARCH_RESULTS = 500;
+
+/// candidates of a trigram search loaded per query
+const unsigned int TEXT_CHECK_BATCH = 100;
+
+/// rows written per INSERT while rebuilding; a positioned row has twelve
+/// columns, which keeps us below the default limit of 999 parameters
+const unsigned int BULK_INSERT_ROWS = 64;
+
+/**
+ * types whose idents and names are covered by the trigram index. Fixes are
+ * left out deliberately: there are a great many of them, they have no
+ * names, and their idents are always searched by prefix, which the
+ * positioned ident index already handles.
+ */
+bool isTextIndexed(int ty)
+{
+  return ((ty >= FGPositioned::AIRPORT) && (ty <= FGPositioned::SEAPORT)) ||
+    ((ty >= FGPositioned::NDB) && (ty <= FGPositioned::MOBILE_TACAN)) ||
+    ((ty >= FGPositioned::COUNTRY) && (ty <= FGPositioned::VILLAGE));
+}
+
+string asciiLower(const string& s)
+{
+  string r(s);
+  for (unsigned int i=0; i<r.size(); ++i) {
+    r[i] = tolower((unsigned char) r[i]);
+  }
+  return r;
+}
+
+// pack three (lower-cased) bytes into an int; non-ASCII bytes from UTF-8
+// text simply become part of the key.
+void appendTrigrams(const string& lowerText, std::vector<uint32_t>& result)
+{
+  for (unsigned int i=0; i+2 < lowerText.size(); ++i) {
+    result.push_back(((unsigned char) lowerText[i] << 16) |
+                     ((unsigned char) lowerText[i+1] << 8) |
+                     (unsigned char) lowerText[i+2]);
+  }
+}
+
+/**
+ * match quality of a text search hit, lower is better; -1 for no match.
+ * All strings must already be lower-cased.
+ */
+int textMatchRank(const string& query, const string& ident, const string& name)
+{
+  if (ident == query) {
+    return 0;
+  }
+  
+  if (ident.compare(0, query.size(), query) == 0) {
+    return 1;
+  }
+  
+  if (name.compare(0, query.size(), query) == 0) {
+    return 2;
+  }
+  
+  bool substring = (ident.find(query) != string::npos);
+  for (string::size_type p = name.find(query); p != string::npos;
+       p = name.find(query, p + 1))
+  {
+    if (!isalnum((unsigned char) name[p - 1])) {
+      return 3; // start of a word in the name
+    }
+    substring = true;
+  }
+  
+  return substring ? 4 : -1;
+}
+
+struct TextMatch
+{
+  PositionedID guid;
+  int rank;
+  string ident, name;
+  
+  bool operator<(const TextMatch& other) const
+  {
+    if (rank != other.rank) {
+      return rank < other.rank;
+    }
+    
+    if (ident.size() != other.ident.size()) {
+      return ident.size() < other.ident.size(); // 'EGLL' before 'EGLL1'
+    }
+    
+    return ident < other.ident;
+  }
+};
+
+typedef std::vector<TextMatch> TextMatchVec;
   
 } // anonymous namespace
 
@@ -143,7 +243,9 @@ namespace flightgear
  * the rebuild - we must still wait until completion before doing other
  * startup, since many things rely on a complete cache. The thread is used
  * so we don't block the main event loop for an unacceptable duration,
- * which causes 'not responding' / spinning beachballs on Windows & Mac
+ * which causes 'not responding' / spinning beachballs on Windows & Mac.
+ * (The parsing of the individual input files is parallelised separately,
+ * see DatFileReader)
  */
 class RebuildThread : public SGThread
 {
@@ -180,6 +282,10 @@ private:
 ////////////////////////////////////////////////////////////////////////////
   
 typedef std::map<PositionedID, FGPositionedRef> PositionedCache;
+
+/// timings (and record counts) of the stages of the most recent rebuild,
+/// keyed by their path below /sim/navdb/rebuild
+typedef std::map<string, int> RebuildTimings;
   
 class AirportTower : public FGPositioned
 {
@@ -201,7 +307,12 @@ public:
     cacheHits(0),
     cacheMisses(0),
     transactionLevel(0),
-    transactionAborted(false)
+    transactionAborted(false),
+    deferOctreeUpdates(false),
+    nextPositionedId(0),
+    flushingBulkInserts(false),
+    snapshotTextComplete(false),
+    snapshotKeyInvalidated(false)
   {
   }
   
@@ -259,6 +370,7 @@ public:
   
   void close()
   {
+    closeSnapshot();
     BOOST_FOREACH(sqlite3_stmt_ptr stmt, prepared) {
       sqlite3_finalize(stmt);
     }
@@ -354,6 +466,11 @@ public:
   
   bool stepSelect(sqlite3_stmt_ptr stmt)
   {
+    // anything else may read or update the rows still buffered
+    if (bulkPositioned.get() && !flushingBulkInserts) {
+      flushBulkInserts();
+    }
+    
     int retries = 0;
     int result;
     while (retries < MAX_RETRIES) {
@@ -523,6 +640,13 @@ public:
     
     runSQL("CREATE INDEX groundnet_edge_airport ON groundnet_edge(airport)");
     runSQL("CREATE INDEX groundnet_edge_from ON groundnet_edge(a)");
+    
+  // trigram index over idents and names, for substring searches. Each row
+  // is a packed, sorted array of PositionedIDs containing that trigram.
+    runSQL("CREATE TABLE text_trigram ("
+           "trigram INTEGER PRIMARY KEY,"
+           "items BLOB"
+           ")");
   }
   
   void prepareQueries()
@@ -604,21 +728,29 @@ public:
   // described as a bit-mask
     getOctreeChildren = prepare("SELECT children FROM octree WHERE rowid=?1");
     
-#ifdef LAZY_OCTREE_UPDATES
-    updateOctreeChildren = prepare("UPDATE octree SET children=?2 WHERE rowid=?1");
-#else
   // mask the new child value into the existing one
     updateOctreeChildren = prepare("UPDATE octree SET children=(?2 | children) WHERE rowid=?1");
-#endif
+  // replace the children mask, used when flushing deferred updates
+    setOctreeChildren = prepare("UPDATE octree SET children=?2 WHERE rowid=?1");
     
   // define a new octree node (with no children)
     insertOctree = prepare("INSERT INTO octree (rowid, children) VALUES (?1, 0)");
     
     getOctreeLeafChildren = prepare("SELECT rowid, type FROM positioned WHERE octree_node=?1");
     
-    searchAirports = prepare("SELECT ident, name FROM positioned WHERE (name LIKE ?1 OR ident LIKE ?1) " AND_TYPED);
-    sqlite3_bind_int(searchAirports, 2, FGPositioned::AIRPORT);
-    sqlite3_bind_int(searchAirports, 3, FGPositioned::SEAPORT);
+    searchText = prepare("SELECT rowid, ident, name FROM positioned WHERE "
+                         "(name LIKE ?1 OR ident LIKE ?1) " AND_TYPED);
+    getTrigramItems = prepare("SELECT items FROM text_trigram WHERE trigram=?1");
+    insertTrigram = prepare("INSERT OR REPLACE INTO text_trigram (trigram, items) VALUES (?1, ?2)");
+    
+  // unused slots are bound to rowid 0, which never exists
+    std::ostringstream textFieldsSql;
+    textFieldsSql << "SELECT rowid, type, ident, name FROM positioned WHERE rowid IN (";
+    for (unsigned int i=1; i<=TEXT_CHECK_BATCH; ++i) {
+      textFieldsSql << (i > 1 ? ",?" : "?") << i;
+    }
+    textFieldsSql << ")";
+    loadTextFields = prepare(textFieldsSql.str());
     
     getAirportItemByIdent = prepare("SELECT rowid FROM positioned WHERE airport=?1 AND ident=?2 AND type=?3");
     
@@ -839,6 +971,10 @@ public:
   {
     SGVec3d cartPos(SGVec3d::fromGeod(pos));
     
+    if (bulkPositioned.get()) {
+      return insertPositionedBulk(ty, ident, name, pos, cartPos, apt, spatialIndex);
+    }
+    
     sqlite3_bind_int(insertPositionedQuery, 1, ty);
     sqlite_bind_stdstring(insertPositionedQuery, 2, ident);
     sqlite_bind_stdstring(insertPositionedQuery, 3, name);
@@ -851,6 +987,7 @@ public:
       Octree::Leaf* octreeLeaf = Octree::global_spatialOctree->findLeafForPos(cartPos);
       assert(intersects(octreeLeaf->bbox(), cartPos));
       sqlite3_bind_int64(insertPositionedQuery, 8, octreeLeaf->guid());
+      markSnapshotOctreeDirty(octreeLeaf->guid());
     } else {
       sqlite3_bind_null(insertPositionedQuery, 8);
     }
@@ -859,13 +996,70 @@ public:
     sqlite3_bind_double(insertPositionedQuery, 10, cartPos.y());
     sqlite3_bind_double(insertPositionedQuery, 11, cartPos.z());
     
-    PositionedID r = execInsert(insertPositionedQuery);    
+    PositionedID r = execInsert(insertPositionedQuery);
+    positionedInserted(r, ty, ident, name);
+    return r;
+  }
+  
+  /// the rebuild variant of insertPositioned: the rowid is assigned here,
+  /// and the row buffered, see BulkInsert
+  PositionedID insertPositionedBulk(FGPositioned::Type ty, const string& ident,
+                                    const string& name, const SGGeod& pos,
+                                    const SGVec3d& cartPos, PositionedID apt,
+                                    bool spatialIndex)
+  {
+    PositionedID r = nextPositionedId++;
+    BulkInsert& row(*bulkPositioned);
+    row.addInt(r);
+    row.addInt(ty);
+    row.addText(ident);
+    row.addText(name);
+    row.addInt(apt);
+    row.addDouble(pos.getLongitudeDeg());
+    row.addDouble(pos.getLatitudeDeg());
+    row.addDouble(pos.getElevationM());
+    
+    if (spatialIndex) {
+      Octree::Leaf* octreeLeaf = Octree::global_spatialOctree->findLeafForPos(cartPos);
+      assert(intersects(octreeLeaf->bbox(), cartPos));
+      row.addInt(octreeLeaf->guid());
+      markSnapshotOctreeDirty(octreeLeaf->guid());
+    } else {
+      row.addNull();
+    }
+    
+    row.addDouble(cartPos.x());
+    row.addDouble(cartPos.y());
+    row.addDouble(cartPos.z());
+    row.endRow();
+    
+    positionedInserted(r, ty, ident, name);
     return r;
   }
   
+  void positionedInserted(PositionedID r, FGPositioned::Type ty,
+                          const string& ident, const string& name)
+  {
+  // a rebuild indexes everything at the end; afterwards, items such as POIs
+  // and user waypoints are added to the index as they are created
+    if (!rebuilder.get() && isTextIndexed(ty)) {
+      addToTextIndex(r, ident, name);
+    }
+  // parking positions and taxi nodes are not part of the snapshot
+    if ((ty != FGPositioned::PARKING) && (ty != FGPositioned::TAXI_NODE)) {
+    // the snapshot text indices no longer cover everything
+      snapshotTextComplete = false;
+      invalidateSnapshotKey();
+    }
+  }
+  
   FGPositionedList findAllByString(const string& s, const string& column,
                                      FGPositioned::Filter* filter, bool exact)
   {
+    if (canSearchSnapshot(filter)) {
+      return findAllInSnapshot(s, column, filter, exact);
+    }
+    
     string query = s;
     if (!exact) query += "%";
     
@@ -927,13 +1121,270 @@ public:
   void flushDeferredOctreeUpdates()
   {
     BOOST_FOREACH(Octree::Branch* nd, deferredOctreeUpdates) {
-      sqlite3_bind_int64(updateOctreeChildren, 1, nd->guid());
-      sqlite3_bind_int(updateOctreeChildren, 2, nd->childMask());
-      execUpdate(updateOctreeChildren);
+      sqlite3_bind_int64(setOctreeChildren, 1, nd->guid());
+      sqlite3_bind_int(setOctreeChildren, 2, nd->childMask());
+      execUpdate(setOctreeChildren);
     }
     
     deferredOctreeUpdates.clear();
   }
+  
+  /**
+   * relax durability while bulk-loading a fresh cache file: if we crash
+   * part-way, the file stamps are missing and the next start-up rebuilds
+   * from scratch anyway.
+   */
+  void setBulkLoading(bool bulk)
+  {
+    if (bulk) {
+      runSQL("PRAGMA synchronous=OFF");
+      runSQL("PRAGMA journal_mode=MEMORY");
+    } else {
+      runSQL("PRAGMA synchronous=FULL");
+      runSQL("PRAGMA journal_mode=DELETE");
+    }
+  }
+  
+  /**
+   * bulk-load mode for the lifetime of a rebuild, also left when the
+   * rebuild fails. Must outlive the rebuild's Transaction, since sqlite
+   * does not change the journal mode inside a transaction.
+   */
+  class BulkLoadingGuard
+  {
+  public:
+    BulkLoadingGuard(NavDataCachePrivate* d) :
+      _d(d)
+    {
+      _d->setBulkLoading(true);
+    }
+    
+    ~BulkLoadingGuard()
+    {
+      try {
+        _d->setBulkLoading(false);
+      } catch (sg_exception& e) {
+        SG_LOG(SG_NAVCACHE, SG_ALERT, "failed to leave bulk-loading mode:" << e.what());
+      }
+    }
+  private:
+    NavDataCachePrivate* _d;
+  };
+  
+  /**
+   * rows for one table, buffered while rebuilding and written
+   * BULK_INSERT_ROWS at a time with a single multi-row INSERT. Rows left
+   * over when flushed are written one by one. Both statements are prepared
+   * once, and finalized along with all the others by close().
+   */
+  class BulkInsert
+  {
+  public:
+    BulkInsert(NavDataCachePrivate* d, const string& table,
+               const string& columns, unsigned int numColumns) :
+      _d(d),
+      _numColumns(numColumns)
+    {
+      string row = "(?";
+      for (unsigned int i=1; i<numColumns; ++i) {
+        row += ",?";
+      }
+      row += ")";
+      
+      string sql = "INSERT INTO " + table + " (" + columns + ") VALUES ";
+      _insertRow = d->prepare(sql + row);
+      
+      string rows = row;
+      for (unsigned int i=1; i<BULK_INSERT_ROWS; ++i) {
+        rows += "," + row;
+      }
+      _insertRows = d->prepare(sql + rows);
+      _values.reserve(numColumns * BULK_INSERT_ROWS);
+    }
+    
+    void addInt(sqlite3_int64 i)
+    {
+      _values.push_back(Value(SQLITE_INTEGER));
+      _values.back().i = i;
+    }
+    
+    void addDouble(double d)
+    {
+      _values.push_back(Value(SQLITE_FLOAT));
+      _values.back().d = d;
+    }
+    
+    void addText(const string& s)
+    {
+      _values.push_back(Value(SQLITE_TEXT));
+      _values.back().s = s;
+    }
+    
+    void addNull()
+    {
+      _values.push_back(Value(SQLITE_NULL));
+    }
+    
+    /// complete the current row, writing the buffered ones once there are
+    /// enough of them
+    void endRow()
+    {
+      assert((_values.size() % _numColumns) == 0);
+      if (_values.size() < _numColumns * BULK_INSERT_ROWS) {
+        return;
+      }
+      
+      write(_insertRows, 0, _values.size());
+      _values.clear();
+    }
+    
+    void flush()
+    {
+      for (size_t i=0; i<_values.size(); i += _numColumns) {
+        write(_insertRow, i, _numColumns);
+      }
+      _values.clear();
+    }
+  private:
+    struct Value
+    {
+      Value(int aType) : type(aType), i(0), d(0.0) { }
+      
+      int type;
+      sqlite3_int64 i;
+      double d;
+      string s;
+    };
+    
+    void write(sqlite3_stmt_ptr stmt, size_t first, size_t count)
+    {
+      for (size_t i=0; i<count; ++i) {
+        const Value& v(_values[first + i]);
+        int param = i + 1;
+        switch (v.type) {
+        case SQLITE_INTEGER: sqlite3_bind_int64(stmt, param, v.i); break;
+        case SQLITE_FLOAT: sqlite3_bind_double(stmt, param, v.d); break;
+        case SQLITE_TEXT: sqlite_bind_stdstring(stmt, param, v.s); break;
+        default: sqlite3_bind_null(stmt, param); break;
+        }
+      }
+      
+      // the buffers of the other tables may stay as they are
+      bool wasFlushing = _d->flushingBulkInserts;
+      _d->flushingBulkInserts = true;
+      _d->execUpdate(stmt);
+      _d->flushingBulkInserts = wasFlushing;
+    }
+    
+    NavDataCachePrivate* _d;
+    unsigned int _numColumns;
+    sqlite3_stmt_ptr _insertRow, _insertRows;
+    std::vector<Value> _values;
+  };
+  
+  /// buffer the rows of the bulk tables from here on, see BulkInsert
+  void beginBulkInserts()
+  {
+    flushingBulkInserts = false;
+    sqlite3_stmt_ptr maxRowId = prepare("SELECT MAX(rowid) FROM positioned");
+    execSelect1(maxRowId);
+    nextPositionedId = sqlite3_column_int64(maxRowId, 0) + 1;
+    finalize(maxRowId);
+    
+    bulkPositioned.reset(new BulkInsert(this, "positioned",
+                                        "rowid, type, ident, name, airport, lon, lat, elev_m, "
+                                        "octree_node, cart_x, cart_y, cart_z", 12));
+    bulkAirport.reset(new BulkInsert(this, "airport", "rowid, has_metar", 2));
+    bulkRunway.reset(new BulkInsert(this, "runway",
+                                    "rowid, heading, length_ft, width_m, surface, "
+                                    "displaced_threshold, stopway, reciprocal", 8));
+    bulkNavaid.reset(new BulkInsert(this, "navaid",
+                                    "rowid, freq, range_nm, multiuse, runway, colocated", 6));
+    bulkComm.reset(new BulkInsert(this, "comm", "rowid, freq_khz, range_nm", 3));
+    bulkOctree.reset(new BulkInsert(this, "octree", "rowid, children", 2));
+  }
+  
+  void flushBulkInserts()
+  {
+    flushingBulkInserts = true;
+    try {
+      bulkPositioned->flush();
+      bulkAirport->flush();
+      bulkRunway->flush();
+      bulkNavaid->flush();
+      bulkComm->flush();
+      bulkOctree->flush();
+    } catch (sg_exception&) {
+      flushingBulkInserts = false;
+      throw;
+    }
+    flushingBulkInserts = false;
+  }
+  
+  /// write what is left, if asked to, and go back to inserting directly
+  void endBulkInserts(bool write)
+  {
+    if (!bulkPositioned.get()) {
+      return;
+    }
+    
+    if (write) {
+      flushBulkInserts();
+    }
+    
+    bulkPositioned.reset();
+    bulkAirport.reset();
+    bulkRunway.reset();
+    bulkNavaid.reset();
+    bulkComm.reset();
+    bulkOctree.reset();
+  }
+  
+  /**
+   * bulk inserts for the lifetime of a rebuild's stages. Must be released
+   * before the rebuild's Transaction, so a failed rebuild rolls back
+   * without trying to write the rows still buffered.
+   */
+  class BulkInsertGuard
+  {
+  public:
+    BulkInsertGuard(NavDataCachePrivate* d) :
+      _d(d)
+    {
+      _d->beginBulkInserts();
+    }
+    
+    ~BulkInsertGuard()
+    {
+      _d->endBulkInserts(false);
+    }
+    
+    void finish()
+    {
+      _d->endBulkInserts(true);
+    }
+  private:
+    NavDataCachePrivate* _d;
+  };
+  
+  void recordRebuildStage(const string& stage, int writeMSec, DatFileReader& reader)
+  {
+    rebuildTimings[stage + "/write-msec"] = writeMSec;
+    rebuildTimings[stage + "/parse-msec"] = reader.parseMSec();
+    rebuildTimings[stage + "/records"] = reader.recordCount();
+    SG_LOG(SG_NAVCACHE, SG_INFO, reader.path().file() << " load took:" << writeMSec
+           << " (parser thread:" << reader.parseMSec() << ")");
+  }
+  
+  /// must be called from the main thread, once the rebuild thread is done
+  void publishRebuildTimings()
+  {
+    SGPropertyNode* root = fgGetNode("/sim/navdb/rebuild", true);
+    RebuildTimings::const_iterator it;
+    for (it = rebuildTimings.begin(); it != rebuildTimings.end(); ++it) {
+      root->setIntValue(it->first.c_str(), it->second);
+    }
+  }
     
   void removePositionedWithIdent(FGPositioned::Type ty, const std::string& aIdent)
   {
@@ -943,6 +1394,387 @@ public:
     reset(removePOIQuery);
   }
   
+  /**
+   * build a flat snapshot of the cache contents (see NavDataSnapshot) from
+   * the DB. Groundnet items (parking and taxi-nodes) are excluded, since
+   * they are dropped and re-created as airports are visited.
+   */
+  bool exportSnapshot(const SGPath& snapshotPath, const string& key)
+  {
+    SGTimeStamp st;
+    st.stamp();
+    NavDataSnapshotWriter writer;
+    
+    sqlite3_stmt_ptr q = prepare("SELECT positioned.rowid, type, ident, name, airport, "
+      "lon, lat, elev_m, octree_node, cart_x, cart_y, cart_z, "
+      "has_metar, "
+      "heading, length_ft, width_m, surface, displaced_threshold, stopway, reciprocal, ils, "
+      "freq, navaid.range_nm, multiuse, runway, colocated, "
+      "freq_khz, comm.range_nm "
+      "FROM positioned "
+      "LEFT JOIN airport ON airport.rowid=positioned.rowid "
+      "LEFT JOIN runway ON runway.rowid=positioned.rowid "
+      "LEFT JOIN navaid ON navaid.rowid=positioned.rowid "
+      "LEFT JOIN comm ON comm.rowid=positioned.rowid "
+      "WHERE type<>?1 AND type<>?2 ORDER BY positioned.rowid");
+    sqlite3_bind_int(q, 1, FGPositioned::PARKING);
+    sqlite3_bind_int(q, 2, FGPositioned::TAXI_NODE);
+    
+    while (stepSelect(q)) {
+      Snapshot::Record r;
+      memset(&r, 0, sizeof(r));
+      r.guid = sqlite3_column_int64(q, 0);
+      r.type = sqlite3_column_int(q, 1);
+      const char* ident = (const char*) sqlite3_column_text(q, 2);
+      const char* name = (const char*) sqlite3_column_text(q, 3);
+      r.airport = sqlite3_column_int64(q, 4);
+      r.lon = sqlite3_column_double(q, 5);
+      r.lat = sqlite3_column_double(q, 6);
+      r.elevM = sqlite3_column_double(q, 7);
+      r.octreeNode = sqlite3_column_int64(q, 8);
+      for (int c=0; c<3; ++c) {
+        r.cart[c] = sqlite3_column_double(q, 9 + c);
+      }
+      
+      FGPositioned::Type ty = static_cast<FGPositioned::Type>(r.type);
+      if ((ty >= FGPositioned::AIRPORT) && (ty <= FGPositioned::SEAPORT)) {
+        r.i[0] = sqlite3_column_int(q, 12);
+      } else if ((ty >= FGPositioned::RUNWAY) && (ty <= FGPositioned::TAXIWAY)) {
+        r.d[0] = sqlite3_column_double(q, 13);
+      // read as an int, to match loadRunway
+        r.d[1] = sqlite3_column_int(q, 14);
+        r.d[2] = sqlite3_column_double(q, 15);
+        r.i[0] = sqlite3_column_int(q, 16);
+        r.d[3] = sqlite3_column_double(q, 17);
+        r.d[4] = sqlite3_column_double(q, 18);
+        r.ref[0] = sqlite3_column_int64(q, 19);
+        r.ref[1] = sqlite3_column_int64(q, 20);
+      } else if (sqlite3_column_type(q, 21) != SQLITE_NULL) { // navaid
+        r.i[0] = sqlite3_column_int(q, 21);
+        r.i[1] = sqlite3_column_int(q, 22);
+        r.d[0] = sqlite3_column_double(q, 23);
+        r.ref[0] = sqlite3_column_int64(q, 24);
+        r.ref[1] = sqlite3_column_int64(q, 25);
+      } else if (sqlite3_column_type(q, 26) != SQLITE_NULL) { // comm
+        r.i[0] = sqlite3_column_int(q, 26);
+        r.i[1] = sqlite3_column_int(q, 27);
+      }
+      
+      writer.addRecord(r, ident ? ident : "", name ? name : "");
+    }
+    finalize(q);
+    
+    q = prepare("SELECT rowid, children FROM octree");
+    while (stepSelect(q)) {
+      writer.addBranch(sqlite3_column_int64(q, 0), sqlite3_column_int(q, 1));
+    }
+    finalize(q);
+    
+    bool ok = writer.write(snapshotPath, key, SCHEMA_VERSION);
+    SG_LOG(SG_NAVCACHE, SG_INFO, "NavCache: snapshot export took:" << st.elapsedMSec());
+    return ok;
+  }
+  
+  void closeSnapshot()
+  {
+    snapshot.close();
+    snapshotDirtyItems.clear();
+    snapshotDirtyOctreeNodes.clear();
+    snapshotTextComplete = false;
+  }
+  
+  /**
+   * the snapshot record for an item, or NULL if there is no snapshot, the
+   * item is not in it, or it has been modified since the snapshot was made.
+   */
+  const Snapshot::Record* snapshotRecord(PositionedID guid) const
+  {
+    if (!snapshot.isOpen() || snapshotDirtyItems.count(guid)) {
+      return NULL;
+    }
+    
+    return snapshot.findById(guid);
+  }
+  
+  bool isSnapshotOctreeNodeValid(int64_t octreeNodeId) const
+  {
+    return snapshot.isOpen() && (snapshotDirtyOctreeNodes.count(octreeNodeId) == 0);
+  }
+  
+  /**
+   * the DB contents are diverging from the snapshot: route further queries
+   * about this item (and the octree leaf it lives in) to the DB, and make
+   * sure the snapshot is rebuilt next time. The updates from the scenery
+   * (thresholds, ILS headings, towers) are stamped and only written once,
+   * so the next snapshot must carry them, whether or not one is open now.
+   */
+  void markSnapshotDirty(PositionedID guid)
+  {
+    invalidateSnapshotKey();
+    if (!snapshot.isOpen()) {
+      return;
+    }
+    
+    snapshotDirtyItems.insert(guid);
+    const Snapshot::Record* r = snapshot.findById(guid);
+    if (r && r->octreeNode) {
+      snapshotDirtyOctreeNodes.insert(r->octreeNode);
+    }
+  }
+  
+  void markSnapshotOctreeDirty(int64_t octreeNodeId)
+  {
+    invalidateSnapshotKey();
+    if (snapshot.isOpen()) {
+      snapshotDirtyOctreeNodes.insert(octreeNodeId);
+    }
+  }
+  
+  /**
+   * the DB contents changed: make sure the snapshot is rebuilt next time.
+   * The key is stored in the DB, so this holds for writes made while no
+   * snapshot is open as well.
+   */
+  void invalidateSnapshotKey()
+  {
+    if (snapshotKeyInvalidated || rebuilder.get()) {
+      return; // rebuild always assigns a fresh key
+    }
+    
+    snapshotKeyInvalidated = true;
+    outer->writeStringProperty("snapshot-key", newSnapshotKey());
+  }
+  
+  static string newSnapshotKey()
+  {
+    SGTimeStamp now = SGTimeStamp::now();
+    std::ostringstream os;
+    os << SCHEMA_VERSION << "-" << now.getSeconds() << "-" << now.getNanoSeconds();
+    return os.str().substr(0, Snapshot::KEY_LENGTH);
+  }
+  
+  FGPositioned* loadFromSnapshot(const Snapshot::Record& r);
+  
+  FGPositionedList findAllInSnapshot(const string& s, const string& column,
+                                     FGPositioned::Filter* filter, bool exact)
+  {
+    std::vector<const Snapshot::Record*> recs = (column == "ident") ?
+      snapshot.findByIdent(s, filter->minType(), filter->maxType(), exact) :
+      snapshot.findByName(s, filter->minType(), filter->maxType(), exact);
+    
+    FGPositionedList result;
+    BOOST_FOREACH(const Snapshot::Record* r, recs) {
+      FGPositioned* pos = outer->loadById(r->guid);
+      if (!filter->pass(pos)) {
+        continue;
+      }
+      
+      result.push_back(pos);
+    }
+    
+    return result;
+  }
+  
+  /**
+   * can a findAllByString query be answered from the snapshot? Only if
+   * the snapshot holds every candidate type, and no items which might match
+   * were created since it was made.
+   */
+  bool canSearchSnapshot(FGPositioned::Filter* filter) const
+  {
+    if (!snapshot.isOpen() || !snapshotTextComplete || !filter) {
+      return false;
+    }
+    
+    return (filter->maxType() < FGPositioned::PARKING) ||
+      (filter->minType() > FGPositioned::TAXI_NODE);
+  }
+  
+  /**
+   * build the trigram index from the positioned table. Returns the number
+   * of distinct trigrams.
+   */
+  int buildTextIndex()
+  {
+    typedef std::map<uint32_t, PositionedIDVec> TrigramMap;
+    TrigramMap index;
+    
+    sqlite3_stmt_ptr q = prepare("SELECT rowid, type, ident, name FROM positioned ORDER BY rowid");
+    std::vector<uint32_t> trigrams;
+    while (stepSelect(q)) {
+      if (!isTextIndexed(sqlite3_column_int(q, 1))) {
+        continue;
+      }
+      
+      trigrams.clear();
+      appendTrigrams(asciiLower(columnText(q, 2)), trigrams);
+      appendTrigrams(asciiLower(columnText(q, 3)), trigrams);
+      std::sort(trigrams.begin(), trigrams.end());
+      trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+      
+      PositionedID guid = sqlite3_column_int64(q, 0);
+      BOOST_FOREACH(uint32_t t, trigrams) {
+        index[t].push_back(guid); // rows are visited in order, so stays sorted
+      }
+    }
+    finalize(q);
+    
+    TrigramMap::const_iterator it;
+    for (it = index.begin(); it != index.end(); ++it) {
+      sqlite3_bind_int64(insertTrigram, 1, it->first);
+      sqlite3_bind_blob(insertTrigram, 2, &it->second.front(),
+                        it->second.size() * sizeof(PositionedID), SQLITE_STATIC);
+      execInsert(insertTrigram);
+    }
+    
+    return index.size();
+  }
+  
+  void addToTextIndex(PositionedID guid, const string& ident, const string& name)
+  {
+    std::vector<uint32_t> trigrams;
+    appendTrigrams(asciiLower(ident), trigrams);
+    appendTrigrams(asciiLower(name), trigrams);
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    
+    PositionedIDVec items;
+    BOOST_FOREACH(uint32_t t, trigrams) {
+      items.clear();
+      trigramItems(t, items);
+      PositionedIDVec::iterator it = std::lower_bound(items.begin(), items.end(), guid);
+      if ((it != items.end()) && (*it == guid)) {
+        continue;
+      }
+      
+      items.insert(it, guid);
+      sqlite3_bind_int64(insertTrigram, 1, t);
+      sqlite3_bind_blob(insertTrigram, 2, &items.front(),
+                        items.size() * sizeof(PositionedID), SQLITE_STATIC);
+      execInsert(insertTrigram);
+    }
+  }
+  
+  bool trigramItems(uint32_t trigram, PositionedIDVec& result)
+  {
+    sqlite3_bind_int64(getTrigramItems, 1, trigram);
+    bool found = execSelect(getTrigramItems);
+    if (found) {
+      const PositionedID* items = (const PositionedID*) sqlite3_column_blob(getTrigramItems, 0);
+      int count = sqlite3_column_bytes(getTrigramItems, 0) / sizeof(PositionedID);
+      result.assign(items, items + count);
+    }
+    
+    reset(getTrigramItems);
+    return found;
+  }
+  
+  /**
+   * ranked search of idents and names. Queries of three or more characters
+   * over indexed types use the trigram index, shorter ones are matched
+   * against the start of the ident or name using the sqlite indices. Only
+   * searches including unindexed types fall back to a table scan.
+   */
+  TextMatchVec findText(const string& aQuery, int minTy, int maxTy,
+                        unsigned int maxResults)
+  {
+    string query = asciiLower(aQuery);
+    bool covered = true;
+    for (int ty = minTy; covered && (ty <= maxTy); ++ty) {
+      covered = isTextIndexed(ty);
+    }
+    
+    TextMatchVec result;
+    if (covered && (query.size() >= 3)) {
+      std::vector<uint32_t> trigrams;
+      appendTrigrams(query, trigrams);
+      std::sort(trigrams.begin(), trigrams.end());
+      trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+      
+    // intersect the posting lists, starting from the shortest
+      std::vector<PositionedIDVec> lists(trigrams.size());
+      std::vector<std::pair<size_t, unsigned int> > bySize;
+      for (unsigned int i=0; i<trigrams.size(); ++i) {
+        if (!trigramItems(trigrams[i], lists[i])) {
+          return result; // some trigram appears nowhere
+        }
+        bySize.push_back(std::make_pair(lists[i].size(), i));
+      }
+      
+      std::sort(bySize.begin(), bySize.end());
+      PositionedIDVec candidates, merged;
+      candidates.swap(lists[bySize.front().second]);
+      for (unsigned int i=1; (i < bySize.size()) && !candidates.empty(); ++i) {
+        const PositionedIDVec& l(lists[bySize[i].second]);
+        merged.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              l.begin(), l.end(), std::back_inserter(merged));
+        candidates.swap(merged);
+      }
+      
+    // trigrams can match out of order, so check the candidates for real,
+    // a batch at a time. Items removed since they were indexed are simply
+    // not returned.
+      for (size_t i=0; i<candidates.size(); i += TEXT_CHECK_BATCH) {
+        for (unsigned int j=0; j<TEXT_CHECK_BATCH; ++j) {
+          PositionedID guid = (i + j < candidates.size()) ? candidates[i + j] : 0;
+          sqlite3_bind_int64(loadTextFields, j + 1, guid);
+        }
+        
+        while (stepSelect(loadTextFields)) {
+          int ty = sqlite3_column_int(loadTextFields, 1);
+          if ((ty >= minTy) && (ty <= maxTy)) {
+            addTextMatch(query, sqlite3_column_int64(loadTextFields, 0),
+                         columnText(loadTextFields, 2),
+                         columnText(loadTextFields, 3), result);
+          }
+        }
+        reset(loadTextFields);
+      }
+    } else {
+      string pattern = covered ? query + "%" : "%" + query + "%";
+      sqlite_bind_stdstring(searchText, 1, pattern);
+      sqlite3_bind_int(searchText, 2, minTy);
+      sqlite3_bind_int(searchText, 3, maxTy);
+      while (stepSelect(searchText)) {
+        addTextMatch(query, sqlite3_column_int64(searchText, 0),
+                     columnText(searchText, 1), columnText(searchText, 2), result);
+      }
+      reset(searchText);
+    }
+    
+    if ((maxResults > 0) && (result.size() > maxResults)) {
+      std::partial_sort(result.begin(), result.begin() + maxResults, result.end());
+      result.resize(maxResults);
+    } else {
+      std::sort(result.begin(), result.end());
+    }
+    
+    return result;
+  }
+  
+  void addTextMatch(const string& lowerQuery, PositionedID guid,
+                    const string& ident, const string& name, TextMatchVec& result)
+  {
+    int rank = textMatchRank(lowerQuery, asciiLower(ident), asciiLower(name));
+    if (rank < 0) {
+      return;
+    }
+    
+    TextMatch m;
+    m.guid = guid;
+    m.rank = rank;
+    m.ident = ident;
+    m.name = name;
+    result.push_back(m);
+  }
+  
+  static string columnText(sqlite3_stmt_ptr stmt, int col)
+  {
+    const char* text = (const char*) sqlite3_column_text(stmt, col);
+    return text ? string(text) : string();
+  }
+  
   NavDataCache* outer;
   sqlite3* db;
   SGPath path;
@@ -978,9 +1810,9 @@ public:
   sqlite3_stmt_ptr findClosestWithIdent;
 // octree (spatial index) related queries
   sqlite3_stmt_ptr getOctreeChildren, insertOctree, updateOctreeChildren,
-    getOctreeLeafChildren;
+    setOctreeChildren, getOctreeLeafChildren;
 
-  sqlite3_stmt_ptr searchAirports;
+  sqlite3_stmt_ptr searchText, getTrigramItems, insertTrigram, loadTextFields;
   sqlite3_stmt_ptr findCommByFreq, findNavsByFreq,
   findNavsByFreqNoPos, findNavaidForRunway;
   sqlite3_stmt_ptr getAirportItems, getAirportItemByIdent;
@@ -1007,8 +1839,27 @@ public:
   typedef std::vector<sqlite3_stmt_ptr> StmtVec;
   StmtVec prepared;
   
+  /// while rebuilding, octree child masks are accumulated in memory and
+  /// written once per branch at the end, instead of once per new node
+  bool deferOctreeUpdates;
   std::set<Octree::Branch*> deferredOctreeUpdates;
   
+  /// while rebuilding, new rows are buffered and written in batches
+  std::auto_ptr<BulkInsert> bulkPositioned, bulkAirport, bulkRunway,
+    bulkNavaid, bulkComm, bulkOctree;
+  sqlite3_int64 nextPositionedId;
+  bool flushingBulkInserts;
+  
+  RebuildTimings rebuildTimings;
+  
+  /// optional read-only snapshot of the cache, see useSnapshot()
+  NavDataSnapshot snapshot;
+  /// items and octree nodes modified since the snapshot was made, which
+  /// must be read from the DB instead
+  std::set<PositionedID> snapshotDirtyItems;
+  std::set<int64_t> snapshotDirtyOctreeNodes;
+  bool snapshotTextComplete, snapshotKeyInvalidated;
+  
   // if we're performing a rebuild, the thread that is doing the work.
   // otherwise, NULL
   std::auto_ptr<RebuildThread> rebuilder;
@@ -1018,6 +1869,10 @@ public:
   
 FGPositioned* NavDataCache::NavDataCachePrivate::loadById(sqlite3_int64 rowid)
 {
+  const Snapshot::Record* rec = snapshotRecord(rowid);
+  if (rec) {
+    return loadFromSnapshot(*rec);
+  }
   
   sqlite3_bind_int64(loadPositioned, 1, rowid);
   execSelect1(loadPositioned);
@@ -1109,6 +1964,113 @@ FGPositioned* NavDataCache::NavDataCachePrivate::loadById(sqlite3_int64 rowid)
 }
 
   
+/**
+ * the equivalent of loadById, but constructing the item directly from a
+ * snapshot record, with no DB access at all.
+ */
+FGPositioned*
+NavDataCache::NavDataCachePrivate::loadFromSnapshot(const Snapshot::Record& r)
+{
+  FGPositioned::Type ty = static_cast<FGPositioned::Type>(r.type);
+  string ident = snapshot.stringAt(r.ident);
+  string name = snapshot.stringAt(r.name);
+  SGGeod pos = SGGeod::fromDegM(r.lon, r.lat, r.elevM);
+  
+  switch (ty) {
+    case FGPositioned::AIRPORT:
+    case FGPositioned::SEAPORT:
+    case FGPositioned::HELIPORT:
+      return new FGAirport(r.guid, ident, pos, name, r.i[0] > 0, ty);
+      
+    case FGPositioned::TOWER:
+      return new AirportTower(r.guid, r.airport, ident, pos);
+      
+    case FGPositioned::TAXIWAY:
+      return new FGTaxiway(r.guid, ident, pos, r.d[0], r.d[1], r.d[2], r.i[0]);
+      
+    case FGPositioned::HELIPAD:
+      return new FGHelipad(r.guid, r.airport, ident, pos, r.d[0], r.d[1], r.d[2], r.i[0]);
+      
+    case FGPositioned::RUNWAY:
+    {
+      FGRunway* rwy = new FGRunway(r.guid, r.airport, ident, pos, r.d[0], r.d[1], r.d[2],
+                                   r.d[3], r.d[4], r.i[0]);
+      if (r.ref[0] > 0) {
+        rwy->setReciprocalRunway(r.ref[0]);
+      }
+      
+      if (r.ref[1] > 0) {
+        rwy->setILS(r.ref[1]);
+      }
+      
+      return rwy;
+    }
+      
+    case FGPositioned::LOC:
+    case FGPositioned::VOR:
+    case FGPositioned::GS:
+    case FGPositioned::ILS:
+    case FGPositioned::NDB:
+    case FGPositioned::OM:
+    case FGPositioned::MM:
+    case FGPositioned::IM:
+    case FGPositioned::DME:
+    case FGPositioned::TACAN:
+    case FGPositioned::MOBILE_TACAN:
+    {
+      if (r.airport > 0) {
+        FGAirport* apt = FGPositioned::loadById<FGAirport>(r.airport);
+        if (apt->validateILSData()) {
+          SG_LOG(SG_NAVCACHE, SG_INFO, "re-loaded ILS data for " << apt->ident());
+          // go around again; any updated records now come from the DB
+          return outer->loadById(r.guid);
+        }
+      }
+      
+      if ((ty == FGPositioned::OM) || (ty == FGPositioned::IM) ||
+          (ty == FGPositioned::MM))
+      {
+        return new FGMarkerBeaconRecord(r.guid, ty, r.ref[0], pos);
+      }
+      
+      FGNavRecord* n = new FGNavRecord(r.guid, ty, ident, name, pos, r.i[0], r.i[1],
+                                       r.d[0], r.ref[0]);
+      if (r.ref[1]) {
+        n->setColocatedDME(r.ref[1]);
+      }
+      
+      return n;
+    }
+      
+    case FGPositioned::FIX:
+      return new FGFix(r.guid, ident, pos);
+      
+    case FGPositioned::WAYPOINT:
+    case FGPositioned::COUNTRY:
+    case FGPositioned::CITY:
+    case FGPositioned::TOWN:
+    case FGPositioned::VILLAGE:
+      return new FGPositioned(r.guid, ty, ident, pos);
+      
+    case FGPositioned::FREQ_GROUND:
+    case FGPositioned::FREQ_TOWER:
+    case FGPositioned::FREQ_ATIS:
+    case FGPositioned::FREQ_AWOS:
+    case FGPositioned::FREQ_APP_DEP:
+    case FGPositioned::FREQ_ENROUTE:
+    case FGPositioned::FREQ_CLEARANCE:
+    case FGPositioned::FREQ_UNICOM:
+    {
+      CommStation* c = new CommStation(r.guid, name, ty, pos, r.i[1], r.i[0]);
+      c->setAirport(r.airport);
+      return c;
+    }
+      
+    default:
+      return NULL;
+  }
+}
+  
 static NavDataCache* static_instance = NULL;
         
 NavDataCache::NavDataCache()
@@ -1219,6 +2181,7 @@ bool NavDataCache::rebuild()
   bool fin = d->rebuilder->isFinished();
   if (fin) {
     d->rebuilder.reset(); // all done!
+    d->publishRebuildTimings();
   }
   return fin;
 }
@@ -1226,58 +2189,162 @@ bool NavDataCache::rebuild()
 void NavDataCache::doRebuild()
 {
   try {
+    SGTimeStamp total;
+    total.stamp();
+    d->rebuildTimings.clear();
+    
     d->close(); // completely close the sqlite object
     d->path.remove(); // remove the file on disk
     d->init(); // star again from scratch
     
+  // parser stage: each input file is decompressed and tokenized on its own
+  // thread, while this thread is the single writer into the DB. The files
+  // must still be consumed in dependency order (navaids reference runways,
+  // airways reference fixes and navaids). Each reader is started one stage
+  // ahead of us, so at most two files are in flight at any time.
+    DatFileReader aptReader(d->aptDatPath),
+      metarReader(d->metarDatPath),
+      fixReader(d->fixDatPath, FIX_DAT_HEADER_LINES),
+      navReader(d->navDatPath, NAV_DAT_HEADER_LINES, NAV_DAT_MAX_SPLIT),
+      poiReader(d->poiDatPath, 0, POI_DAT_MAX_SPLIT),
+      carrierReader(d->carrierDatPath, 0, NAV_DAT_MAX_SPLIT),
+      airwayReader(d->airwayDatPath, AWY_DAT_HEADER_LINES);
+    DatFileReader* readers[] = {
+      &aptReader, &metarReader, &fixReader, &navReader, &poiReader,
+      &carrierReader, &airwayReader
+    };
+    const unsigned int numReaders = sizeof(readers) / sizeof(readers[0]);
+    aptReader.startReading();
+    
+    NavDataCachePrivate::BulkLoadingGuard bulkLoading(d.get());
     Transaction txn(this);
   // initialise the root octree node
     d->runSQL("INSERT INTO octree (rowid, children) VALUES (1, 0)");
+    d->deferOctreeUpdates = true;
+    NavDataCachePrivate::BulkInsertGuard bulkInserts(d.get());
     
     SGTimeStamp st;
     st.stamp();
+    metarReader.startReading();
+    airportDBLoad(aptReader);
+    d->recordRebuildStage("apt-dat", st.elapsedMSec(), aptReader);
     
-    airportDBLoad(d->aptDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "apt.dat load took:" << st.elapsedMSec());
-    
-    metarDataLoad(d->metarDatPath);
+    st.stamp();
+    fixReader.startReading();
+    metarDataLoad(metarReader);
     stampCacheFile(d->aptDatPath);
     stampCacheFile(d->metarDatPath);
+    d->recordRebuildStage("metar-dat", st.elapsedMSec(), metarReader);
     
     st.stamp();
-    loadFixes(d->fixDatPath);
+    navReader.startReading();
+    loadFixes(fixReader);
     stampCacheFile(d->fixDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "fix.dat load took:" << st.elapsedMSec());
+    d->recordRebuildStage("fix-dat", st.elapsedMSec(), fixReader);
     
     st.stamp();
-    navDBInit(d->navDatPath);
+    poiReader.startReading();
+    navDBInit(navReader);
     stampCacheFile(d->navDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "nav.dat load took:" << st.elapsedMSec());
+    d->recordRebuildStage("nav-dat", st.elapsedMSec(), navReader);
 
     st.stamp();
-    poiDBInit(d->poiDatPath);
+    carrierReader.startReading();
+    poiDBInit(poiReader);
     stampCacheFile(d->poiDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "poi.dat load took:" << st.elapsedMSec());
+    d->recordRebuildStage("poi-dat", st.elapsedMSec(), poiReader);
     
-    loadCarrierNav(d->carrierDatPath);
+    st.stamp();
+    airwayReader.startReading();
+    loadCarrierNav(carrierReader);
     stampCacheFile(d->carrierDatPath);
+    d->recordRebuildStage("carrier-dat", st.elapsedMSec(), carrierReader);
     
     st.stamp();
-    Airway::load(d->airwayDatPath);
+    Airway::load(airwayReader);
     stampCacheFile(d->airwayDatPath);
-    SG_LOG(SG_NAVCACHE, SG_INFO, "awy.dat load took:" << st.elapsedMSec());
+    d->recordRebuildStage("awy-dat", st.elapsedMSec(), airwayReader);
     
+    unsigned int parserThreads = 0;
+    for (unsigned int i=0; i<numReaders; ++i) {
+      if (readers[i]->started()) {
+        ++parserThreads;
+      }
+    }
+    d->rebuildTimings["parser-threads"] = parserThreads;
+    
+    bulkInserts.finish();
+    
+    st.stamp();
+    d->rebuildTimings["text-index/trigrams"] = d->buildTextIndex();
+    d->rebuildTimings["text-index/write-msec"] = st.elapsedMSec();
+    
+  // octree stage: write each branch's final child mask exactly once
+    st.stamp();
+    d->rebuildTimings["octree/branches"] = d->deferredOctreeUpdates.size();
     d->flushDeferredOctreeUpdates();
+    d->deferOctreeUpdates = false;
+    d->rebuildTimings["octree/write-msec"] = st.elapsedMSec();
+    SG_LOG(SG_NAVCACHE, SG_INFO, "octree update took:" << st.elapsedMSec());
     
     string sceneryPaths = simgear::strutils::join(globals->get_fg_scenery(), ";");
     writeStringProperty("scenery_paths", sceneryPaths);
+    writeStringProperty("snapshot-key", NavDataCachePrivate::newSnapshotKey());
     
+    st.stamp();
     txn.commit();
+    d->rebuildTimings["commit-msec"] = st.elapsedMSec();
+    d->rebuildTimings["total-msec"] = total.elapsedMSec();
   } catch (sg_exception& e) {
     SG_LOG(SG_NAVCACHE, SG_ALERT, "caught exception rebuilding navCache:" << e.what());
+    d->deferOctreeUpdates = false;
+    d->deferredOctreeUpdates.clear();
   }
 }
   
+SGPath NavDataCache::snapshotPath() const
+{
+  return SGPath(d->path.base() + ".snapshot");
+}
+  
+bool NavDataCache::exportSnapshot(const SGPath& path)
+{
+  string key = readStringProperty("snapshot-key");
+  if (key.empty()) {
+    key = NavDataCachePrivate::newSnapshotKey();
+    writeStringProperty("snapshot-key", key);
+  }
+  
+  return d->exportSnapshot(path, key);
+}
+  
+bool NavDataCache::useSnapshot()
+{
+  if (d->snapshot.isOpen()) {
+    return true;
+  }
+  
+  SGPath path(snapshotPath());
+  string key = readStringProperty("snapshot-key");
+  if (key.empty() || !d->snapshot.open(path, key, SCHEMA_VERSION)) {
+    // missing or stale, make a fresh one from the DB
+    if (!exportSnapshot(path)) {
+      return false;
+    }
+    
+    key = readStringProperty("snapshot-key");
+    if (!d->snapshot.open(path, key, SCHEMA_VERSION)) {
+      return false;
+    }
+  }
+  
+  d->snapshotDirtyItems.clear();
+  d->snapshotDirtyOctreeNodes.clear();
+  d->snapshotTextComplete = true;
+  d->snapshotKeyInvalidated = false;
+  return true;
+}
+  
 int NavDataCache::readIntProperty(const string& key)
 {
   sqlite_bind_stdstring(d->readPropertyQuery, 1, key);
@@ -1511,6 +2578,13 @@ PositionedID NavDataCache::insertAirport(FGPositioned::Type ty, const string& id
                                             0 /* airport */,
                                             false /* spatial index */);
   
+  if (d->bulkAirport.get()) {
+    d->bulkAirport->addInt(rowId);
+    d->bulkAirport->addNull();
+    d->bulkAirport->endRow();
+    return rowId;
+  }
+  
   sqlite3_bind_int64(d->insertAirport, 1, rowId);
   d->execInsert(d->insertAirport);
   
@@ -1519,6 +2593,7 @@ PositionedID NavDataCache::insertAirport(FGPositioned::Type ty, const string& id
   
 void NavDataCache::updatePosition(PositionedID item, const SGGeod &pos)
 {
+  d->markSnapshotDirty(item);
   if (d->cache.find(item) != d->cache.end()) {
     SG_LOG(SG_NAVCACHE, SG_DEBUG, "updating position of an item in the cache");
     d->cache[item]->modifyPosition(pos);
@@ -1541,6 +2616,7 @@ void NavDataCache::updatePosition(PositionedID item, const SGGeod &pos)
 // which was updated above.
   Octree::Leaf* octreeLeaf = Octree::global_spatialOctree->findLeafForPos(cartPos);
   sqlite3_bind_int64(d->setAirportPos, 5, octreeLeaf->guid());
+  d->markSnapshotOctreeDirty(octreeLeaf->guid());
   
   sqlite3_bind_double(d->setAirportPos, 6, cartPos.x());
   sqlite3_bind_double(d->setAirportPos, 7, cartPos.y());
@@ -1568,6 +2644,20 @@ NavDataCache::insertRunway(FGPositioned::Type ty, const string& ident,
   
   sqlite3_int64 rowId = d->insertPositioned(ty, cleanRunwayNo(ident), "", pos, apt,
                                             spatialIndex);
+  if (d->bulkRunway.get()) {
+    NavDataCachePrivate::BulkInsert& row(*d->bulkRunway);
+    row.addInt(rowId);
+    row.addDouble(heading);
+    row.addDouble(length);
+    row.addDouble(width);
+    row.addInt(surfaceCode);
+    row.addDouble(displacedThreshold);
+    row.addDouble(stopway);
+    row.addNull();
+    row.endRow();
+    return rowId;
+  }
+  
   sqlite3_bind_int64(d->insertRunway, 1, rowId);
   sqlite3_bind_double(d->insertRunway, 2, heading);
   sqlite3_bind_double(d->insertRunway, 3, length);
@@ -1581,6 +2671,8 @@ NavDataCache::insertRunway(FGPositioned::Type ty, const string& ident,
 
 void NavDataCache::setRunwayReciprocal(PositionedID runway, PositionedID recip)
 {
+  d->markSnapshotDirty(runway);
+  d->markSnapshotDirty(recip);
   sqlite3_bind_int64(d->setRunwayReciprocal, 1, runway);
   sqlite3_bind_int64(d->setRunwayReciprocal, 2, recip);
   d->execUpdate(d->setRunwayReciprocal);
@@ -1593,6 +2685,7 @@ void NavDataCache::setRunwayReciprocal(PositionedID runway, PositionedID recip)
 
 void NavDataCache::setRunwayILS(PositionedID runway, PositionedID ils)
 {
+  d->markSnapshotDirty(runway);
   sqlite3_bind_int64(d->setRunwayILS, 1, runway);
   sqlite3_bind_int64(d->setRunwayILS, 2, ils);
   d->execUpdate(d->setRunwayILS);
@@ -1608,6 +2701,7 @@ void NavDataCache::updateRunwayThreshold(PositionedID runwayID, const SGGeod &aT
                                   double aHeading, double aDisplacedThreshold,
                                   double aStopway)
 {
+  d->markSnapshotDirty(runwayID);
 // update the runway information
   sqlite3_bind_int64(d->updateRunwayThreshold, 1, runwayID);
   sqlite3_bind_double(d->updateRunwayThreshold, 2, aHeading);
@@ -1632,6 +2726,18 @@ NavDataCache::insertNavaid(FGPositioned::Type ty, const string& ident,
   
   sqlite3_int64 rowId = d->insertPositioned(ty, ident, name, pos, apt,
                                             spatialIndex);
+  if (d->bulkNavaid.get()) {
+    NavDataCachePrivate::BulkInsert& row(*d->bulkNavaid);
+    row.addInt(rowId);
+    row.addInt(freq);
+    row.addInt(range);
+    row.addDouble(multiuse);
+    row.addInt(runway);
+    row.addInt(0);
+    row.endRow();
+    return rowId;
+  }
+  
   sqlite3_bind_int64(d->insertNavaid, 1, rowId);
   sqlite3_bind_int(d->insertNavaid, 2, freq);
   sqlite3_bind_int(d->insertNavaid, 3, range);
@@ -1643,6 +2749,7 @@ NavDataCache::insertNavaid(FGPositioned::Type ty, const string& ident,
 
 void NavDataCache::setNavaidColocated(PositionedID navaid, PositionedID colocatedDME)
 {
+  d->markSnapshotDirty(navaid);
   // Update DB entries...
   sqlite3_bind_int64(d->setNavaidColocated, 1, navaid);
   sqlite3_bind_int64(d->setNavaidColocated, 2, colocatedDME);
@@ -1657,6 +2764,7 @@ void NavDataCache::setNavaidColocated(PositionedID navaid, PositionedID colocate
 
 void NavDataCache::updateILS(PositionedID ils, const SGGeod& newPos, double aHdg)
 {
+  d->markSnapshotDirty(ils);
   sqlite3_bind_int64(d->updateILS, 1, ils);
   sqlite3_bind_double(d->updateILS, 2, aHdg);
   d->execUpdate(d->updateILS);
@@ -1668,6 +2776,14 @@ PositionedID NavDataCache::insertCommStation(FGPositioned::Type ty,
                                              PositionedID apt)
 {
   sqlite3_int64 rowId = d->insertPositioned(ty, "", name, pos, apt, true);
+  if (d->bulkComm.get()) {
+    d->bulkComm->addInt(rowId);
+    d->bulkComm->addInt(freq);
+    d->bulkComm->addInt(range);
+    d->bulkComm->endRow();
+    return rowId;
+  }
+  
   sqlite3_bind_int64(d->insertCommStation, 1, rowId);
   sqlite3_bind_int(d->insertCommStation, 2, freq);
   sqlite3_bind_int(d->insertCommStation, 3, range);
@@ -1689,10 +2805,21 @@ void NavDataCache::removePOI(FGPositioned::Type ty, const std::string& aIdent)
 {
   d->removePositionedWithIdent(ty, aIdent);
   // should remove from the live cache too?
+  
+  // we don't know which items were removed, so stop using the snapshot
+  if (d->snapshot.isOpen()) {
+    SG_LOG(SG_NAVCACHE, SG_INFO, "NavCache: POI removed, no longer using snapshot");
+    d->closeSnapshot();
+  }
+  d->invalidateSnapshotKey();
 }
   
 void NavDataCache::setAirportMetar(const string& icao, bool hasMetar)
 {
+  if (d->snapshot.isOpen()) {
+    d->closeSnapshot(); // only happens during a rebuild in practice
+  }
+  d->invalidateSnapshotKey();
   sqlite_bind_stdstring(d->setAirportMetar, 1, icao);
   sqlite3_bind_int(d->setAirportMetar, 2, hasMetar);
   d->execUpdate(d->setAirportMetar);
@@ -1752,6 +2879,13 @@ FGPositionedRef NavDataCache::findClosestWithIdent( const string& aIdent,
   
 int NavDataCache::getOctreeBranchChildren(int64_t octreeNodeId)
 {
+  if (d->isSnapshotOctreeNodeValid(octreeNodeId)) {
+    int children = d->snapshot.octreeBranchChildren(octreeNodeId);
+    if (children >= 0) {
+      return children;
+    }
+  }
+  
   sqlite3_bind_int64(d->getOctreeChildren, 1, octreeNodeId);
   d->execSelect1(d->getOctreeChildren);
   int children = sqlite3_column_int(d->getOctreeChildren, 0);
@@ -1761,12 +2895,21 @@ int NavDataCache::getOctreeBranchChildren(int64_t octreeNodeId)
 
 void NavDataCache::defineOctreeNode(Octree::Branch* pr, Octree::Node* nd)
 {
-  sqlite3_bind_int64(d->insertOctree, 1, nd->guid());
-  d->execInsert(d->insertOctree);
+  if (d->bulkOctree.get()) {
+    d->bulkOctree->addInt(nd->guid());
+    d->bulkOctree->addInt(0);
+    d->bulkOctree->endRow();
+  } else {
+    sqlite3_bind_int64(d->insertOctree, 1, nd->guid());
+    d->execInsert(d->insertOctree);
+  }
+  d->markSnapshotOctreeDirty(pr->guid());
+  
+  if (d->deferOctreeUpdates) {
+    d->deferredOctreeUpdates.insert(pr);
+    return;
+  }
   
-#ifdef LAZY_OCTREE_UPDATES
-  d->deferredOctreeUpdates.insert(pr);
-#else
   // lowest three bits of node ID are 0..7 index of the child in the parent
   int childIndex = nd->guid() & 0x07;
   
@@ -1775,12 +2918,23 @@ void NavDataCache::defineOctreeNode(Octree::Branch* pr, Octree::Node* nd)
   int childMask = 1 << childIndex;
   sqlite3_bind_int(d->updateOctreeChildren, 2, childMask);
   d->execUpdate(d->updateOctreeChildren);
-#endif
 }
   
 TypedPositionedVec
 NavDataCache::getOctreeLeafChildren(int64_t octreeNodeId)
 {
+  std::vector<const Snapshot::Record*> recs;
+  if (d->isSnapshotOctreeNodeValid(octreeNodeId) &&
+      d->snapshot.octreeLeafChildren(octreeNodeId, recs))
+  {
+    TypedPositionedVec r;
+    r.reserve(recs.size());
+    BOOST_FOREACH(const Snapshot::Record* rec, recs) {
+      r.push_back(std::make_pair(static_cast<FGPositioned::Type>(rec->type), rec->guid));
+    }
+    return r;
+  }
+  
   sqlite3_bind_int64(d->getOctreeLeafChildren, 1, octreeNodeId);
   
   TypedPositionedVec r;
@@ -1803,22 +2957,13 @@ NavDataCache::getOctreeLeafChildren(int64_t octreeNodeId)
  */
 char** NavDataCache::searchAirportNamesAndIdents(const std::string& aFilter)
 {
-  string s = "%" + aFilter + "%";
-  sqlite_bind_stdstring(d->searchAirports, 1, s);
+  TextMatchVec matches = d->findText(aFilter, FGPositioned::AIRPORT,
+                                     FGPositioned::SEAPORT,
+                                     MAX_AIRPORT_SEARCH_RESULTS);
   
-  unsigned int numMatches = 0, numAllocated = 16;
-  char** result = (char**) malloc(sizeof(char*) * numAllocated);
-  
-  while (d->stepSelect(d->searchAirports)) {
-    if ((numMatches + 1) >= numAllocated) {
-      numAllocated <<= 1; // double in size!
-    // reallocate results array
-      char** nresult = (char**) malloc(sizeof(char*) * numAllocated);
-      memcpy(nresult, result, sizeof(char*) * numMatches);
-      free(result);
-      result = nresult;
-    }
-    
+  char** result = (char**) malloc(sizeof(char*) * (matches.size() + 1));
+  unsigned int numMatches = 0;
+  BOOST_FOREACH(const TextMatch& m, matches) {
     // nasty code to avoid excessive string copying and allocations.
     // We format results as follows (note whitespace!):
     //   ' name-of-airport-chars   (ident)'
@@ -1827,18 +2972,18 @@ char** NavDataCache::searchAirportNamesAndIdents(const std::string& aFilter)
     // which gives a grand total of 7 + name-length + icao-length.
     // note the ident can be three letters (non-ICAO local strip), four
     // (default ICAO) or more (extended format ICAO)
-    int nameLength = sqlite3_column_bytes(d->searchAirports, 1);
-    int icaoLength = sqlite3_column_bytes(d->searchAirports, 0);
+    int nameLength = m.name.size();
+    int icaoLength = m.ident.size();
     char* entry = (char*) malloc(7 + nameLength + icaoLength);
     char* dst = entry;
     *dst++ = ' ';
-    memcpy(dst, sqlite3_column_text(d->searchAirports, 1), nameLength);
+    memcpy(dst, m.name.c_str(), nameLength);
     dst += nameLength;
     *dst++ = ' ';
     *dst++ = ' ';
     *dst++ = ' ';
     *dst++ = '(';
-    memcpy(dst, sqlite3_column_text(d->searchAirports, 0), icaoLength);
+    memcpy(dst, m.ident.c_str(), icaoLength);
     dst += icaoLength;
     *dst++ = ')';
     *dst++ = 0;
@@ -1847,7 +2992,24 @@ char** NavDataCache::searchAirportNamesAndIdents(const std::string& aFilter)
   }
   
   result[numMatches] = NULL; // end of list marker
-  d->reset(d->searchAirports);
+  return result;
+}
+
+PositionedIDVec
+NavDataCache::searchNamesAndIdents(const std::string& aQuery,
+                                   FGPositioned::Filter* aFilter,
+                                   unsigned int aMaxResults)
+{
+  int minTy = aFilter ? aFilter->minType() : FGPositioned::INVALID;
+  int maxTy = aFilter ? aFilter->maxType() : FGPositioned::LAST_TYPE;
+  TextMatchVec matches = d->findText(aQuery, minTy, maxTy, aMaxResults);
+  
+  PositionedIDVec result;
+  result.reserve(matches.size());
+  BOOST_FOREACH(const TextMatch& m, matches) {
+    result.push_back(m.guid);
+  }
+  
   return result;
 }
   
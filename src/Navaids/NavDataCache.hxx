@@ -71,6 +71,22 @@ public:
    */
   bool rebuild();
   
+  /**
+   * write a flat, read-only snapshot of the cache contents to a file, which
+   * can be memory-mapped and shared by several processes.
+   */
+  bool exportSnapshot(const SGPath& path);
+  
+  /**
+   * serve loadById, octree and ident / name queries from the snapshot
+   * beside the cache file, exporting it first if it is missing or stale.
+   * Items modified after this call are transparently read from the DB.
+   * Returns false (and keeps using the DB) if the snapshot can't be used.
+   */
+  bool useSnapshot();
+  
+  SGPath snapshotPath() const;
+  
   bool isCachedFileModified(const SGPath& path) const;
   void stampCacheFile(const SGPath& path);
   
@@ -160,10 +176,20 @@ public:
   /**
    * Helper to implement the AirportSearch widget. Optimised text search of
    * airport names and idents, returning a list suitable for passing directly
-   * to PLIB.
+   * to PLIB. Results are ranked by match quality, and capped.
    */
   char** searchAirportNamesAndIdents(const std::string& aFilter);
   
+  /**
+   * Ranked substring search of idents and names: exact ident matches first,
+   * then ident prefixes, name prefixes, word starts and finally any other
+   * substring. Only the type range of the filter is considered. Pass zero
+   * for aMaxResults to return all matches.
+   */
+  PositionedIDVec searchNamesAndIdents(const std::string& aQuery,
+                                       FGPositioned::Filter* aFilter,
+                                       unsigned int aMaxResults);
+  
   /**
    * Find the closest matching comm-station on a frequency, to a position.
    * The filter with be used for both type ranging and to validate the result
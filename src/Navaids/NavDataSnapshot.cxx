@@ -0,0 +1,571 @@
+// NavDataSnapshot.cxx - a flat, read-only, memory-mapped image of the
+// NavDataCache contents, for fast start-up and sharing between processes.
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "NavDataSnapshot.hxx"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include <cctype>
+#include <map>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <simgear/debug/logstream.hxx>
+
+using std::string;
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = { 'F', 'G', 'N', 'A', 'V', 'S', 'N', 'P' };
+
+// ASCII case-insensitive comparison, matching sqlite's 'collate nocase'
+int compareNoCase(const char* a, const char* b)
+{
+  for (;; ++a, ++b) {
+    int ca = tolower((unsigned char) *a), cb = tolower((unsigned char) *b);
+    if ((ca != cb) || (ca == 0)) {
+      return ca - cb;
+    }
+  }
+}
+
+// compare only the first prefixLen characters of a against prefix
+int comparePrefixNoCase(const char* a, const char* prefix, size_t prefixLen)
+{
+  for (size_t i=0; i<prefixLen; ++i) {
+    int ca = tolower((unsigned char) a[i]), cb = tolower((unsigned char) prefix[i]);
+    if ((ca != cb) || (ca == 0)) {
+      return ca - cb;
+    }
+  }
+
+  return 0;
+}
+
+bool isValidRange(uint64_t offset, uint64_t count, size_t elementSize, size_t fileSize)
+{
+  uint64_t end = offset + (count * elementSize);
+  return (offset <= fileSize) && (end <= fileSize) && (end >= offset);
+}
+
+/// orders index entries (record indices) by the nocase ident or name
+class IndexOrder
+{
+public:
+  IndexOrder(const std::vector<flightgear::Snapshot::Record>& recs,
+             const std::vector<char>& strings, bool byName) :
+    _recs(recs), _strings(strings), _byName(byName)
+  { }
+
+  bool operator()(uint32_t a, uint32_t b) const
+  {
+    int c = compareNoCase(key(a), key(b));
+    if (c != 0) {
+      return c < 0;
+    }
+
+    return _recs[a].type < _recs[b].type;
+  }
+private:
+  const char* key(uint32_t i) const
+  {
+    const flightgear::Snapshot::Record& r(_recs[i]);
+    return &_strings[_byName ? r.name : r.ident];
+  }
+
+  const std::vector<flightgear::Snapshot::Record>& _recs;
+  const std::vector<char>& _strings;
+  bool _byName;
+};
+
+bool recordGuidLess(const flightgear::Snapshot::Record& r, int64_t guid)
+{
+  return r.guid < guid;
+}
+
+bool branchGuidLess(const flightgear::Snapshot::Branch& b, int64_t guid)
+{
+  return b.guid < guid;
+}
+
+bool leafGuidLess(const flightgear::Snapshot::Leaf& l, int64_t guid)
+{
+  return l.guid < guid;
+}
+
+bool branchOrder(const flightgear::Snapshot::Branch& a, const flightgear::Snapshot::Branch& b)
+{
+  return a.guid < b.guid;
+}
+
+template <class T>
+void writeArray(FILE* f, const std::vector<T>& v)
+{
+  if (!v.empty()) {
+    fwrite(&v.front(), sizeof(T), v.size(), f);
+  }
+}
+
+} // anonymous namespace
+
+namespace flightgear
+{
+
+NavDataSnapshot::NavDataSnapshot() :
+  _base(NULL),
+  _size(0),
+#ifdef _WIN32
+  _fileHandle(INVALID_HANDLE_VALUE),
+  _mappingHandle(NULL),
+#else
+  _fd(-1),
+#endif
+  _header(NULL),
+  _records(NULL),
+  _strings(NULL),
+  _identIndex(NULL),
+  _nameIndex(NULL),
+  _branches(NULL),
+  _leaves(NULL),
+  _leafItems(NULL)
+{
+}
+
+NavDataSnapshot::~NavDataSnapshot()
+{
+  close();
+}
+
+bool NavDataSnapshot::open(const SGPath& path, const string& key, int schemaVersion)
+{
+  close();
+  if (!path.exists()) {
+    return false;
+  }
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  _fileHandle = file;
+  _size = GetFileSize(file, NULL);
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) {
+    close();
+    return false;
+  }
+
+  _mappingHandle = mapping;
+  _base = (char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+  _fd = ::open(path.c_str(), O_RDONLY);
+  if (_fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(_fd, &st) != 0) {
+    close();
+    return false;
+  }
+
+  _size = st.st_size;
+  void* p = mmap(NULL, _size, PROT_READ, MAP_SHARED, _fd, 0);
+  _base = (p == MAP_FAILED) ? NULL : (char*) p;
+#endif
+
+  if (!_base || (_size < sizeof(Snapshot::Header))) {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: unable to map " << path);
+    close();
+    return false;
+  }
+
+  _header = reinterpret_cast<const Snapshot::Header*>(_base);
+  const Snapshot::Header& h(*_header);
+  if (memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) ||
+      (h.byteOrder != Snapshot::BYTE_ORDER_MARK) ||
+      (h.formatVersion != Snapshot::FORMAT_VERSION) ||
+      (h.schemaVersion != (uint32_t) schemaVersion))
+  {
+    SG_LOG(SG_NAVAID, SG_INFO, "NavDataSnapshot: " << path << " has a different format, ignoring");
+    close();
+    return false;
+  }
+
+  if (strncmp(h.key, key.c_str(), Snapshot::KEY_LENGTH)) {
+    SG_LOG(SG_NAVAID, SG_INFO, "NavDataSnapshot: " << path << " is stale, ignoring");
+    close();
+    return false;
+  }
+
+  if (!isValidRange(h.recordsOffset, h.recordCount, sizeof(Snapshot::Record), _size) ||
+      !isValidRange(h.stringsOffset, h.stringsSize, 1, _size) ||
+      !isValidRange(h.identIndexOffset, h.identIndexCount, sizeof(uint32_t), _size) ||
+      !isValidRange(h.nameIndexOffset, h.nameIndexCount, sizeof(uint32_t), _size) ||
+      !isValidRange(h.branchesOffset, h.branchCount, sizeof(Snapshot::Branch), _size) ||
+      !isValidRange(h.leavesOffset, h.leafCount, sizeof(Snapshot::Leaf), _size) ||
+      !isValidRange(h.leafItemsOffset, h.leafItemCount, sizeof(uint32_t), _size))
+  {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: " << path << " is truncated or damaged");
+    close();
+    return false;
+  }
+
+  // stringAt() relies on the last string of the table being terminated
+  if ((h.stringsSize == 0) || (_base[h.stringsOffset + h.stringsSize - 1] != 0)) {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: " << path << " has a damaged string table");
+    close();
+    return false;
+  }
+
+  _records = reinterpret_cast<const Snapshot::Record*>(_base + h.recordsOffset);
+  _strings = _base + h.stringsOffset;
+  _identIndex = reinterpret_cast<const uint32_t*>(_base + h.identIndexOffset);
+  _nameIndex = reinterpret_cast<const uint32_t*>(_base + h.nameIndexOffset);
+  _branches = reinterpret_cast<const Snapshot::Branch*>(_base + h.branchesOffset);
+  _leaves = reinterpret_cast<const Snapshot::Leaf*>(_base + h.leavesOffset);
+  _leafItems = reinterpret_cast<const uint32_t*>(_base + h.leafItemsOffset);
+
+  SG_LOG(SG_NAVAID, SG_INFO, "NavDataSnapshot: mapped " << path << ", "
+         << h.recordCount << " records");
+  return true;
+}
+
+void NavDataSnapshot::close()
+{
+#ifdef _WIN32
+  if (_base) {
+    UnmapViewOfFile(_base);
+  }
+
+  if (_mappingHandle) {
+    CloseHandle((HANDLE) _mappingHandle);
+    _mappingHandle = NULL;
+  }
+
+  if (_fileHandle != INVALID_HANDLE_VALUE) {
+    CloseHandle((HANDLE) _fileHandle);
+    _fileHandle = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (_base) {
+    munmap(_base, _size);
+  }
+
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+#endif
+
+  _base = NULL;
+  _size = 0;
+  _header = NULL;
+}
+
+const Snapshot::Record* NavDataSnapshot::findById(int64_t guid) const
+{
+  if (!_base) {
+    return NULL;
+  }
+
+  const Snapshot::Record* end = _records + _header->recordCount;
+  const Snapshot::Record* it = std::lower_bound(_records, end, guid, recordGuidLess);
+  if ((it == end) || (it->guid != guid)) {
+    return NULL;
+  }
+
+  return it;
+}
+
+int64_t NavDataSnapshot::maxGuid() const
+{
+  if (!_base || (_header->recordCount == 0)) {
+    return 0;
+  }
+
+  return _records[_header->recordCount - 1].guid;
+}
+
+std::vector<const Snapshot::Record*>
+NavDataSnapshot::findByIdent(const string& s, int minType, int maxType, bool exact) const
+{
+  if (!_base) {
+    return std::vector<const Snapshot::Record*>();
+  }
+
+  return findInIndex(_identIndex, _header->identIndexCount, false, s,
+                     minType, maxType, exact);
+}
+
+std::vector<const Snapshot::Record*>
+NavDataSnapshot::findByName(const string& s, int minType, int maxType, bool exact) const
+{
+  if (!_base) {
+    return std::vector<const Snapshot::Record*>();
+  }
+
+  return findInIndex(_nameIndex, _header->nameIndexCount, true, s,
+                     minType, maxType, exact);
+}
+
+std::vector<const Snapshot::Record*>
+NavDataSnapshot::findInIndex(const uint32_t* index, uint32_t count, bool byName,
+                             const string& s, int minType, int maxType,
+                             bool exact) const
+{
+  std::vector<const Snapshot::Record*> result;
+  const char* key = s.c_str();
+  size_t keyLen = s.size();
+
+// binary search for the first entry not less than the key. For both exact
+// and prefix matches, every candidate sorts at or after this point.
+  uint32_t lo = 0, hi = count;
+  while (lo < hi) {
+    uint32_t mid = lo + ((hi - lo) >> 1);
+    if (compareNoCase(indexKey(_records[index[mid]], byName), key) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  for (; lo < count; ++lo) {
+    const Snapshot::Record& r(_records[index[lo]]);
+    const char* k = indexKey(r, byName);
+    int c = exact ? compareNoCase(k, key) : comparePrefixNoCase(k, key, keyLen);
+    if (c != 0) {
+      break; // past the matching range
+    }
+
+    if ((r.type >= minType) && (r.type <= maxType)) {
+      result.push_back(&r);
+    }
+  }
+
+  return result;
+}
+
+int NavDataSnapshot::octreeBranchChildren(int64_t guid) const
+{
+  if (!_base) {
+    return -1;
+  }
+
+  const Snapshot::Branch* end = _branches + _header->branchCount;
+  const Snapshot::Branch* it = std::lower_bound(_branches, end, guid, branchGuidLess);
+  if ((it == end) || (it->guid != guid)) {
+    return -1;
+  }
+
+  return it->childMask;
+}
+
+bool NavDataSnapshot::octreeLeafChildren(int64_t guid,
+                                         std::vector<const Snapshot::Record*>& result) const
+{
+  if (!_base) {
+    return false;
+  }
+
+  const Snapshot::Leaf* end = _leaves + _header->leafCount;
+  const Snapshot::Leaf* it = std::lower_bound(_leaves, end, guid, leafGuidLess);
+  if ((it == end) || (it->guid != guid)) {
+    // a leaf which exists in the octree, but has no items, is not stored
+    return (octreeBranchChildren(guid) >= 0);
+  }
+
+  if ((uint64_t) it->firstItem + it->itemCount > _header->leafItemCount) {
+    return false;
+  }
+
+  result.reserve(result.size() + it->itemCount);
+  for (uint32_t i=0; i < it->itemCount; ++i) {
+    result.push_back(_records + _leafItems[it->firstItem + i]);
+  }
+
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+NavDataSnapshotWriter::NavDataSnapshotWriter()
+{
+  // offset zero is always the empty string
+  _strings.push_back(0);
+}
+
+uint32_t NavDataSnapshotWriter::addString(const string& s)
+{
+  if (s.empty()) {
+    return 0;
+  }
+
+  uint32_t offset = _strings.size();
+  _strings.insert(_strings.end(), s.begin(), s.end());
+  _strings.push_back(0);
+  return offset;
+}
+
+void NavDataSnapshotWriter::addRecord(const Snapshot::Record& r,
+                                      const string& ident, const string& name)
+{
+  assert(_records.empty() || (_records.back().guid < r.guid));
+  _records.push_back(r);
+  _records.back().ident = addString(ident);
+  _records.back().name = addString(name);
+  _records.back().reserved = 0;
+}
+
+void NavDataSnapshotWriter::addBranch(int64_t guid, int childMask)
+{
+  Snapshot::Branch b;
+  b.guid = guid;
+  b.childMask = childMask;
+  b.reserved = 0;
+  _branches.push_back(b);
+}
+
+bool NavDataSnapshotWriter::write(const SGPath& path, const string& key, int schemaVersion)
+{
+// build the text indices
+  std::vector<uint32_t> identIndex, nameIndex;
+  for (uint32_t i=0; i<_records.size(); ++i) {
+    if (_records[i].ident) identIndex.push_back(i);
+    if (_records[i].name) nameIndex.push_back(i);
+  }
+
+  std::sort(identIndex.begin(), identIndex.end(), IndexOrder(_records, _strings, false));
+  std::sort(nameIndex.begin(), nameIndex.end(), IndexOrder(_records, _strings, true));
+
+// group spatially indexed records by octree leaf
+  typedef std::map<int64_t, std::vector<uint32_t> > LeafMap;
+  LeafMap leafMap;
+  for (uint32_t i=0; i<_records.size(); ++i) {
+    if (_records[i].octreeNode) {
+      leafMap[_records[i].octreeNode].push_back(i);
+    }
+  }
+
+  std::vector<Snapshot::Leaf> leaves;
+  std::vector<uint32_t> leafItems;
+  for (LeafMap::const_iterator it = leafMap.begin(); it != leafMap.end(); ++it) {
+    Snapshot::Leaf l;
+    l.guid = it->first;
+    l.firstItem = leafItems.size();
+    l.itemCount = it->second.size();
+    leaves.push_back(l);
+    leafItems.insert(leafItems.end(), it->second.begin(), it->second.end());
+  }
+
+  std::sort(_branches.begin(), _branches.end(), branchOrder);
+
+// lay out the file; all sections are 8-byte aligned since records contain
+// doubles and int64s
+  Snapshot::Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  h.byteOrder = Snapshot::BYTE_ORDER_MARK;
+  h.formatVersion = Snapshot::FORMAT_VERSION;
+  h.schemaVersion = schemaVersion;
+  strncpy(h.key, key.c_str(), Snapshot::KEY_LENGTH);
+
+  while (_strings.size() % 8) {
+    _strings.push_back(0);
+  }
+
+  h.recordCount = _records.size();
+  h.identIndexCount = identIndex.size();
+  h.nameIndexCount = nameIndex.size();
+  h.branchCount = _branches.size();
+  h.leafCount = leaves.size();
+  h.leafItemCount = leafItems.size();
+
+  uint64_t offset = sizeof(Snapshot::Header);
+  h.recordsOffset = offset;
+  offset += _records.size() * sizeof(Snapshot::Record);
+  h.stringsOffset = offset;
+  h.stringsSize = _strings.size();
+  offset += _strings.size();
+  h.branchesOffset = offset;
+  offset += _branches.size() * sizeof(Snapshot::Branch);
+  h.leavesOffset = offset;
+  offset += leaves.size() * sizeof(Snapshot::Leaf);
+// the uint32 arrays go last, so they do not disturb alignment
+  h.identIndexOffset = offset;
+  offset += identIndex.size() * sizeof(uint32_t);
+  h.nameIndexOffset = offset;
+  offset += nameIndex.size() * sizeof(uint32_t);
+  h.leafItemsOffset = offset;
+
+  string tempPath = path.str() + ".tmp";
+  FILE* f = fopen(tempPath.c_str(), "wb");
+  if (!f) {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: unable to write " << tempPath);
+    return false;
+  }
+
+  fwrite(&h, sizeof(h), 1, f);
+  writeArray(f, _records);
+  writeArray(f, _strings);
+  writeArray(f, _branches);
+  writeArray(f, leaves);
+  writeArray(f, identIndex);
+  writeArray(f, nameIndex);
+  writeArray(f, leafItems);
+
+  bool ok = (ferror(f) == 0);
+  ok &= (fclose(f) == 0);
+  if (!ok) {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: error writing " << tempPath);
+    remove(tempPath.c_str());
+    return false;
+  }
+
+#ifdef _WIN32
+  // rename() does not replace an existing file on Windows
+  remove(path.c_str());
+#endif
+  if (rename(tempPath.c_str(), path.c_str()) != 0) {
+    SG_LOG(SG_NAVAID, SG_WARN, "NavDataSnapshot: unable to rename " << tempPath);
+    remove(tempPath.c_str());
+    return false;
+  }
+
+  SG_LOG(SG_NAVAID, SG_INFO, "NavDataSnapshot: wrote " << path << ", "
+         << _records.size() << " records");
+  return true;
+}
+
+} // of namespace flightgear
@@ -0,0 +1,211 @@
+/**
+ * NavDataSnapshot - a flat, read-only, memory-mapped image of the
+ * NavDataCache contents, for fast start-up and sharing between processes.
+ */
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_NAVDATA_SNAPSHOT_HXX
+#define FG_NAVDATA_SNAPSHOT_HXX
+
+#include <string>
+#include <vector>
+#include <stdint.h> // for int64_t
+
+#include <simgear/misc/sg_path.hxx>
+
+namespace flightgear
+{
+
+namespace Snapshot
+{
+  /// bump this whenever the layout of any of the structures below changes
+  const uint32_t FORMAT_VERSION = 1;
+
+  /// written in native byte order; used to reject files from another host
+  const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  const unsigned int KEY_LENGTH = 32;
+
+  struct Header
+  {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t formatVersion;
+    uint32_t schemaVersion;
+    uint32_t recordCount;
+    char key[KEY_LENGTH]; ///< identifies the cache build the snapshot was made from
+
+    uint32_t identIndexCount, nameIndexCount;
+    uint32_t branchCount, leafCount, leafItemCount;
+    uint32_t reserved;
+
+    uint64_t recordsOffset;
+    uint64_t stringsOffset, stringsSize;
+    uint64_t identIndexOffset, nameIndexOffset;
+    uint64_t branchesOffset, leavesOffset, leafItemsOffset;
+  };
+
+  /**
+   * One positioned item, plus the fields of its type-specific table. Which
+   * payload slots are meaningful depends on the type:
+   *   airport: i[0] has-metar
+   *   runway, helipad, taxiway: d[0..4] heading, length, width, displaced
+   *      threshold, stopway; i[0] surface; ref[0..1] reciprocal, ILS
+   *   navaid: d[0] multiuse; i[0..1] freq, range; ref[0..1] runway, colocated
+   *   comm: i[0..1] freq (kHz), range
+   */
+  struct Record
+  {
+    int64_t guid;
+    int64_t airport;
+    int64_t octreeNode; ///< 0 if not spatially indexed
+    int64_t ref[2];
+    double lon, lat, elevM;
+    double cart[3];
+    double d[5];
+    int32_t type;
+    uint32_t ident; ///< offsets into the string pool
+    uint32_t name;
+    int32_t i[2];
+    uint32_t reserved;
+  };
+
+  struct Branch
+  {
+    int64_t guid;
+    int32_t childMask;
+    uint32_t reserved;
+  };
+
+  struct Leaf
+  {
+    int64_t guid;
+    uint32_t firstItem; ///< index into the leaf-items array
+    uint32_t itemCount;
+  };
+} // of namespace Snapshot
+
+/**
+ * Read-only view of a snapshot file. The file is mapped shared and
+ * read-only, so several processes using the same snapshot share the
+ * physical pages. All lookups are binary searches over pre-sorted arrays
+ * in the mapping; nothing is parsed or copied at open time beyond
+ * validating the header.
+ */
+class NavDataSnapshot
+{
+public:
+  NavDataSnapshot();
+  ~NavDataSnapshot();
+
+  /**
+   * map the file at path. Fails (returning false) if the file is missing,
+   * truncated, from a different format version, or does not match the
+   * supplied cache key and schema version.
+   */
+  bool open(const SGPath& path, const std::string& key, int schemaVersion);
+  void close();
+
+  bool isOpen() const
+  { return _base != NULL; }
+
+  const Snapshot::Record* findById(int64_t guid) const;
+
+  /**
+   * all records whose ident (or name) matches, case-insensitively, within
+   * the inclusive type range. If exact is false, match as a prefix.
+   */
+  std::vector<const Snapshot::Record*> findByIdent(const std::string& s,
+                                                   int minType, int maxType,
+                                                   bool exact) const;
+  std::vector<const Snapshot::Record*> findByName(const std::string& s,
+                                                  int minType, int maxType,
+                                                  bool exact) const;
+
+  /// returns -1 if the branch is unknown
+  int octreeBranchChildren(int64_t guid) const;
+
+  /// returns false if the leaf is unknown
+  bool octreeLeafChildren(int64_t guid, std::vector<const Snapshot::Record*>& result) const;
+
+  /// the empty string if offset is outside the string table
+  const char* stringAt(uint32_t offset) const
+  { return (offset < _header->stringsSize) ? _strings + offset : ""; }
+
+  int64_t maxGuid() const;
+private:
+  std::vector<const Snapshot::Record*> findInIndex(const uint32_t* index,
+                                                   uint32_t count, bool byName,
+                                                   const std::string& s,
+                                                   int minType, int maxType,
+                                                   bool exact) const;
+
+  const char* indexKey(const Snapshot::Record& r, bool byName) const
+  { return stringAt(byName ? r.name : r.ident); }
+
+  char* _base;
+  size_t _size;
+#ifdef _WIN32
+  void* _fileHandle;
+  void* _mappingHandle;
+#else
+  int _fd;
+#endif
+
+  const Snapshot::Header* _header;
+  const Snapshot::Record* _records;
+  const char* _strings;
+  const uint32_t* _identIndex;
+  const uint32_t* _nameIndex;
+  const Snapshot::Branch* _branches;
+  const Snapshot::Leaf* _leaves;
+  const uint32_t* _leafItems;
+};
+
+/**
+ * Accumulates the contents of a snapshot in memory, and writes it out.
+ * Records must be added in ascending guid order.
+ */
+class NavDataSnapshotWriter
+{
+public:
+  NavDataSnapshotWriter();
+
+  /**
+   * add a record; the ident and name string fields are filled in from the
+   * supplied strings, any values already in the record are ignored.
+   */
+  void addRecord(const Snapshot::Record& r, const std::string& ident,
+                 const std::string& name);
+
+  void addBranch(int64_t guid, int childMask);
+
+  /**
+   * write the file, via a temporary file which is renamed into place, so
+   * processes concurrently opening the snapshot never see a partial file.
+   */
+  bool write(const SGPath& path, const std::string& key, int schemaVersion);
+private:
+  uint32_t addString(const std::string& s);
+
+  std::vector<Snapshot::Record> _records;
+  std::vector<char> _strings;
+  std::vector<Snapshot::Branch> _branches;
+};
+
+} // of namespace flightgear
+
+#endif // of FG_NAVDATA_SNAPSHOT_HXX
@@ -24,11 +24,11 @@
 #include "airways.hxx"
 
 #include <algorithm>
+#include <cstdlib>
 #include <set>
 
 #include <simgear/sg_inlines.h>
 #include <simgear/structure/exception.hxx>
-#include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/sg_path.hxx>
 
 #include <boost/foreach.hpp>
@@ -38,6 +38,7 @@
 #include <Navaids/positioned.hxx>
 #include <Navaids/waypoint.hxx>
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 
 using std::make_pair;
 using std::string;
@@ -123,31 +124,41 @@ Airway::Airway(const std::string& aIdent, double aTop, double aBottom) :
 
 void Airway::load(const SGPath& path)
 {
-  std::string identStart, identEnd, name;
-  double latStart, lonStart, latEnd, lonEnd;
-  int type, base, top;
-  //int airwayIndex = 0;
-  //FGNode *n;
-
-  sg_gzifstream in( path.str() );
-  if ( !in.is_open() ) {
-    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
-    throw sg_io_exception("Could not open airways data", sg_location(path.str()));
+  DatFileReader reader(path, AWY_DAT_HEADER_LINES);
+  load(reader);
+}
+
+void Airway::load(DatFileReader& reader)
+{
+  if ( !reader.isOpen() ) {
+    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << reader.path().str() );
+    throw sg_io_exception("Could not open airways data", sg_location(reader.path().str()));
   }
-// toss the first two lines of the file
-  in >> skipeol;
-  in >> skipeol;
 
 // read in each remaining line of the file
-  while (!in.eof()) {
-    in >> identStart;
+  for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+    const string_list& token(rec->tokens);
+    const std::string& identStart(token[0]);
 
     if (identStart == "99") {
       break;
     }
     
-    in >> latStart >> lonStart >> identEnd >> latEnd >> lonEnd >> type >> base >> top >> name;
-    in >> skipeol;
+    if (token.size() < 10) {
+      SG_LOG(SG_NAVAID, SG_WARN, "awy.dat: malformed line " << rec->lineNum
+             << ":" << rec->line);
+      continue;
+    }
+    
+    double latStart = atof(token[1].c_str()),
+      lonStart = atof(token[2].c_str());
+    const std::string& identEnd(token[3]);
+    double latEnd = atof(token[4].c_str()),
+      lonEnd = atof(token[5].c_str());
+    int type = atoi(token[6].c_str()),
+      base = atoi(token[7].c_str()),
+      top = atoi(token[8].c_str());
+    const std::string& name(token[9]);
 
     // type = 1; low-altitude
     // type = 2; high-altitude
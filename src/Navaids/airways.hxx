@@ -35,6 +35,9 @@ namespace flightgear {
 struct SearchContext;
 class AdjacentWaypoint;
 class InAirwayFilter;
+class DatFileReader;
+
+const unsigned int AWY_DAT_HEADER_LINES = 2;
 
 class Airway
 {
@@ -43,6 +46,9 @@ public:
   { return _ident; }
   
   static void load(const SGPath& path);
+
+  /// variant of the above, consuming records from an already running reader
+  static void load(DatFileReader& reader);
   
   /**
    * Track a network of airways
@@ -26,15 +26,16 @@
 #endif
 
 #include <algorithm>
+#include <cstdlib>
 
 #include <simgear/debug/logstream.hxx>
-#include <simgear/misc/sgstream.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 
 #include "fixlist.hxx"
 #include <Navaids/fix.hxx>
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 
 FGFix::FGFix(PositionedID aGuid, const std::string& aIdent, const SGGeod& aPos) :
   FGPositioned(aGuid, FIX, aIdent, aPos)
@@ -47,27 +48,27 @@ namespace flightgear
   
 void loadFixes(const SGPath& path)
 {
-  sg_gzifstream in( path.str() );
-  if ( !in.is_open() ) {
-    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+  DatFileReader reader(path, FIX_DAT_HEADER_LINES);
+  loadFixes(reader);
+}
+  
+void loadFixes(DatFileReader& reader)
+{
+  if ( !reader.isOpen() ) {
+    SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << reader.path().str() );
     exit(-1);
   }
   
-  // toss the first two lines of the file
-  in >> skipeol;
-  in >> skipeol;
-  
   NavDataCache* cache = NavDataCache::instance();
   
   // read in each remaining line of the file
-  while ( ! in.eof() ) {
-    double lat, lon;
-    std::string ident;
-    in >> lat >> lon >> ident;
-    if (lat > 95) break;
+  for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+    const string_list& token(rec->tokens);
+    double lat = atof(token[0].c_str());
+    if ((lat > 95) || (token.size() < 3)) break;
     
-    cache->insertFix(ident, SGGeod::fromDeg(lon, lat));
-    in >> skipcomment;
+    double lon = atof(token[1].c_str());
+    cache->insertFix(token[2], SGGeod::fromDeg(lon, lat));
   }
 
 }
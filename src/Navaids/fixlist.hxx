@@ -32,7 +32,14 @@ class SGPath;
 namespace flightgear
 {
   
+  class DatFileReader;
+
+  const unsigned int FIX_DAT_HEADER_LINES = 2;
+
   void loadFixes(const SGPath& path);
+
+  /// variant of the above, consuming records from an already running reader
+  void loadFixes(DatFileReader& reader);
   
 }
 
@@ -26,6 +26,8 @@
 
 #include "navdb.hxx"
 
+#include <cstdlib>
+
 #include <simgear/compiler.h>
 #include <simgear/debug/logstream.hxx>
 #include <simgear/math/sg_geodesy.hxx>
@@ -45,6 +47,7 @@
 #include <Airports/xmlloader.hxx>
 #include <Main/fg_props.hxx>
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 
 using std::string;
 using std::vector;
@@ -127,25 +130,38 @@ static double defaultNavRange(const string& ident, FGPositioned::Type type)
 namespace flightgear
 {
 
-static PositionedID readNavFromStream(std::istream& aStream,
-                                        FGPositioned::Type type = FGPositioned::INVALID)
+static PositionedID readNavFromRecord(const DatRecord& aRec,
+                                      FGPositioned::Type type = FGPositioned::INVALID)
 {
   NavDataCache* cache = NavDataCache::instance();
+  const string_list& token(aRec.tokens);
   
-  int rawType;
-  aStream >> rawType;
-  if (aStream.eof() || (rawType == 99)) {
+  int rawType = atoi(token[0].c_str());
+  if (rawType == 99) {
     return 0; // happens with, eg, carrier_nav.dat
   }
   
-  double lat, lon, elev_ft, multiuse;
-  int freq, range;
-  std::string name, ident;
-  aStream >> lat >> lon >> elev_ft >> freq >> range >> multiuse >> ident;
-  getline(aStream, name);
+  if (token.size() < 8) {
+    SG_LOG(SG_NAVAID, SG_WARN, "nav.dat: malformed line " << aRec.lineNum
+           << ":" << aRec.line);
+    return 0;
+  }
+  
+  double lat = atof(token[1].c_str()),
+    lon = atof(token[2].c_str()),
+    elev_ft = atof(token[3].c_str()),
+    multiuse = atof(token[6].c_str());
+  int freq = atoi(token[4].c_str()),
+    range = atoi(token[5].c_str());
+  const std::string& ident(token[7]);
+  // the reader splits at most NAV_DAT_MAX_SPLIT times, so the final token
+  // is the (stripped) remainder of the line
+  std::string name;
+  if (token.size() > 8) {
+    name = token[8];
+  }
   
   SGGeod pos(SGGeod::fromDegFt(lon, lat, elev_ft));
-  name = simgear::strutils::strip(name);
   
 // the type can be forced by our caller, but normally we use th value
 // supplied in the .dat file
@@ -249,23 +265,23 @@ static PositionedID readNavFromStream(std::istream& aStream,
 // load and initialize the navigational databases
 bool navDBInit(const SGPath& path)
 {
-    sg_gzifstream in( path.str() );
-    if ( !in.is_open() ) {
-        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+  DatFileReader reader(path, NAV_DAT_HEADER_LINES, NAV_DAT_MAX_SPLIT);
+  return navDBInit(reader);
+}
+  
+bool navDBInit(DatFileReader& reader)
+{
+    if ( !reader.isOpen() ) {
+        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << reader.path().str() );
       return false;
     }
   
   autoAlignLocalizers = fgGetBool("/sim/navdb/localizers/auto-align", true);
   autoAlignThreshold = fgGetDouble( "/sim/navdb/localizers/auto-align-threshold-deg", 5.0 );
 
-    // skip first two lines
-    in >> skipeol;
-    in >> skipeol;
-
-    while (!in.eof()) {
-      readNavFromStream(in);
-      in >> skipcomment;
-    } // of stream data loop
+    for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+      readNavFromRecord(*rec);
+    } // of record loop
   
   return true;
 }
@@ -274,16 +290,20 @@ bool navDBInit(const SGPath& path)
 bool loadCarrierNav(const SGPath& path)
 {    
     SG_LOG( SG_NAVAID, SG_INFO, "opening file: " << path.str() );    
-    sg_gzifstream incarrier( path.str() );
-    
-    if ( !incarrier.is_open() ) {
-        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+    DatFileReader reader(path, 0, NAV_DAT_MAX_SPLIT);
+    return loadCarrierNav(reader);
+}
+  
+bool loadCarrierNav(DatFileReader& reader)
+{
+    if ( !reader.isOpen() ) {
+        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << reader.path().str() );
       return false;
     }
     
-    while ( ! incarrier.eof() ) {
+    for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
       // force the type to be MOBILE_TACAN
-      readNavFromStream(incarrier, FGPositioned::MOBILE_TACAN);
+      readNavFromRecord(*rec, FGPositioned::MOBILE_TACAN);
     } // end while
 
   return true;
@@ -36,11 +36,23 @@ class FGRunway;
 
 namespace flightgear
 {
+
+class DatFileReader;
+
+/// nav.dat (and carrier_nav.dat) records are split into at most this many
+/// tokens plus the remainder of the line, which is the navaid name.
+const int NAV_DAT_MAX_SPLIT = 8;
+const unsigned int NAV_DAT_HEADER_LINES = 2;
   
 // load and initialize the navigational databases
 bool navDBInit(const SGPath& path);
+
+/// variant of the above, consuming records from an already running reader
+bool navDBInit(DatFileReader& reader);
   
 bool loadCarrierNav(const SGPath& path);
+
+bool loadCarrierNav(DatFileReader& reader);
   
 bool loadTacan(const SGPath& path, FGTACANList *channellist);
 
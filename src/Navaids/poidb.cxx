@@ -22,14 +22,17 @@
 #  include "config.h"
 #endif
 
+#include <cstdlib>
+
 #include <simgear/compiler.h>
 #include <simgear/debug/logstream.hxx>
 #include <simgear/math/sg_geodesy.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/structure/exception.hxx>
-#include <simgear/misc/sgstream.hxx>
+#include <simgear/misc/strutils.hxx>
 
 #include <Navaids/NavDataCache.hxx>
+#include <Navaids/DatFileReader.hxx>
 #include "poidb.hxx"
 
 using std::string;
@@ -52,24 +55,26 @@ mapPOITypeToFGPType(int aTy)
 namespace flightgear
 {
 
-static PositionedID readPOIFromStream(std::istream& aStream,
-                                        FGPositioned::Type type = FGPositioned::INVALID)
+static PositionedID readPOIFromRecord(const DatRecord& aRec,
+                                      FGPositioned::Type type = FGPositioned::INVALID)
 {
   NavDataCache* cache = NavDataCache::instance();
-
-  int rawType;
-  aStream >> rawType;
-  if (aStream.eof() || (rawType == '#')) {
+  const string_list& token(aRec.tokens);
+  if (token.size() < 3) {
     return 0;
   }
 
-  double lat, lon;
+  int rawType = atoi(token[0].c_str());
+  double lat = atof(token[1].c_str()),
+    lon = atof(token[2].c_str());
+  // the reader splits at most POI_DAT_MAX_SPLIT times, so the final token
+  // is the (stripped) remainder of the line
   std::string name;
-  aStream >> lat >> lon;
-  getline(aStream, name);
+  if (token.size() > 3) {
+    name = token[3];
+  }
 
   SGGeod pos(SGGeod::fromDeg(lon, lat));
-  name = simgear::strutils::strip(name);
 
   // the type can be forced by our caller, but normally we use the value
   // supplied in the .dat file
@@ -87,18 +92,20 @@ static PositionedID readPOIFromStream(std::istream& aStream,
 // load and initialize the POI database
 bool poiDBInit(const SGPath& path)
 {
-    sg_gzifstream in( path.str() );
-    if ( !in.is_open() ) {
-        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << path.str() );
+  DatFileReader reader(path, 0, POI_DAT_MAX_SPLIT);
+  return poiDBInit(reader);
+}
+
+bool poiDBInit(DatFileReader& reader)
+{
+    if ( !reader.isOpen() ) {
+        SG_LOG( SG_NAVAID, SG_ALERT, "Cannot open file: " << reader.path().str() );
       return false;
     }
 
-    in >> skipcomment;
-
-    while (!in.eof()) {
-      readPOIFromStream(in);
-      in >> skipcomment;
-    } // of stream data loop
+    for (const DatRecord* rec = reader.next(); rec; rec = reader.next()) {
+      readPOIFromRecord(*rec);
+    } // of record loop
 
   return true;
 }
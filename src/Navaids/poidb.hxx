@@ -33,8 +33,17 @@ namespace flightgear
 {
 
 // load and initialize the POI database
+class DatFileReader;
+
+/// poi.dat records are split into at most this many tokens plus the
+/// remainder of the line, which is the POI name.
+const int POI_DAT_MAX_SPLIT = 3;
+
 bool poiDBInit(const SGPath& path);
 
+/// variant of the above, consuming records from an already running reader
+bool poiDBInit(DatFileReader& reader);
+
 } // of namespace flightgear
 
 #endif // _FG_NAVDB_HXX
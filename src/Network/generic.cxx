@@ -25,7 +25,7 @@
 #endif
 
 #include <string.h>                // strstr()
-#include <stdlib.h>                // strtod(), atoi()
+#include <stdlib.h>                // strtod(), atof()
 #include <cstdio>
 
 #include <simgear/debug/logstream.hxx>
@@ -36,6 +36,7 @@
 #include <simgear/props/props.hxx>
 #include <simgear/props/props_io.hxx>
 #include <simgear/math/SGMath.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 #include <Main/globals.hxx>
 #include <Main/fg_props.hxx>
@@ -43,7 +44,13 @@
 #include <Main/util.hxx>
 #include "generic.hxx"
 
-FGGeneric::FGGeneric(vector<string> tokens) : exitOnError(false), initOk(false)
+FGGeneric::FGGeneric(vector<string> tokens) :
+    exitOnError(false),
+    initOk(false),
+    threaded(false),
+    _in_pending(0),
+    _in_overflow(false),
+    _exit_requested(false)
 {
     size_t configToken;
     if (tokens[1] == "socket") {
@@ -76,6 +83,9 @@ FGGeneric::FGGeneric(vector<string> tokens) : exitOnError(false), initOk(false)
 FGGeneric::~FGGeneric() {
 }
 
+// records parsed by a threaded channel and not yet applied, at most
+static const size_t MAX_PENDING_RECORDS = 256;
+
 union u32 {
     uint32_t intVal;
     float floatVal;
@@ -98,7 +108,7 @@ bool FGGeneric::gen_message_binary() {
         case FG_INT:
         {
             val = _out_message[i].offset +
-                  _out_message[i].prop->getIntValue() * _out_message[i].factor;
+                  _out_values[i].num * _out_message[i].factor;
             int32_t intVal = val;
             if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
                 intVal = (int32_t) sg_bswap_32((uint32_t)intVal);
@@ -109,14 +119,14 @@ bool FGGeneric::gen_message_binary() {
         }
 
         case FG_BOOL:
-            buf[length] = (char) (_out_message[i].prop->getBoolValue() ? true : false);
+            buf[length] = (char) (_out_values[i].num != 0.0);
             length += 1;
             break;
 
         case FG_FIXED:
         {
             val = _out_message[i].offset +
-                 _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+                 _out_values[i].num * _out_message[i].factor;
 
             int32_t fixed = (int)(val * 65536.0f);
             if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
@@ -130,7 +140,7 @@ bool FGGeneric::gen_message_binary() {
         case FG_FLOAT:
         {
             val = _out_message[i].offset +
-                 _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+                 _out_values[i].num * _out_message[i].factor;
             u32 tmpun32;
             tmpun32.floatVal = static_cast<float>(val);
 
@@ -145,7 +155,7 @@ bool FGGeneric::gen_message_binary() {
         case FG_DOUBLE:
         {
             val = _out_message[i].offset +
-                 _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
+                 _out_values[i].num * _out_message[i].factor;
             u64 tmpun64;
             tmpun64.doubleVal = val;
 
@@ -158,7 +168,7 @@ bool FGGeneric::gen_message_binary() {
         }
 
         default: // SG_STRING
-            const char *strdata = _out_message[i].prop->getStringValue();
+            const char *strdata = _out_values[i].str.c_str();
             int32_t strlength = strlen(strdata);
 
             if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
@@ -205,68 +215,80 @@ bool FGGeneric::gen_message_binary() {
     return true;
 }
 
+// Append len bytes of str to the message, as far as they fit
+static int append(char *buf, int length, const char *str, size_t len) {
+    size_t room = FG_MAX_MSG_SIZE - length;
+    if (len > room) {
+        len = room;
+    }
+    memcpy(buf + length, str, len);
+    return length + len;
+}
+
+// The message is written straight into buf, each chunk through its
+// compiled format, at most 254 characters of it as before.
 bool FGGeneric::gen_message_ascii() {
-    string generic_sentence;
     char tmp[255];
     length = 0;
 
     double val;
     for (unsigned int i = 0; i < _out_message.size(); i++) {
+        const _serial_prot& chunk = _out_message[i];
+        const _value& value = _out_values[i];
+        size_t len;
 
         if (i > 0) {
-            generic_sentence += var_separator;
+            length = append(buf, length, var_separator.data(),
+                            var_separator.size());
         }
 
-        switch (_out_message[i].type) {
+        switch (chunk.type) {
         case FG_INT:
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getIntValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (int)val);
+            val = chunk.offset + value.num * chunk.factor;
+            len = chunk.compiled_format.format(tmp, sizeof(tmp), (int)val);
             break;
 
         case FG_BOOL:
-            snprintf(tmp, 255, _out_message[i].format.c_str(),
-                               _out_message[i].prop->getBoolValue());
+            len = chunk.compiled_format.format(tmp, sizeof(tmp),
+                                               (int)(value.num != 0.0));
             break;
 
         case FG_FIXED:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (float)val);
-            break;
-
         case FG_FLOAT:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (float)val);
+            val = chunk.offset + value.num * chunk.factor;
+            len = chunk.compiled_format.format(tmp, sizeof(tmp),
+                                               (double)(float)val);
             break;
 
         case FG_DOUBLE:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
-            snprintf(tmp, 255, _out_message[i].format.c_str(), (double)val);
+            val = chunk.offset + value.num * chunk.factor;
+            len = chunk.compiled_format.format(tmp, sizeof(tmp), val);
             break;
 
         default: // SG_STRING
-            snprintf(tmp, 255, _out_message[i].format.c_str(),
-                                   _out_message[i].prop->getStringValue());
+            len = chunk.compiled_format.format(tmp, sizeof(tmp),
+                                               value.str.c_str());
         }
 
-        generic_sentence += tmp;
+        length = append(buf, length, tmp, len);
     }
 
     /* After each lot of variables has been added, put the line separator
      * char/string
      */
-    generic_sentence += line_separator;
-
-    length =  generic_sentence.length();
-    strncpy( buf, generic_sentence.c_str(), length );
+    length = append(buf, length, line_separator.data(), line_separator.size());
 
     return true;
 }
 
 bool FGGeneric::gen_message() {
+    if (threaded) {
+        SGGuard<SGMutex> g(_lock);
+        _out_values = _out_snapshot;
+    } else {
+        read_values(_out_values);
+    }
+
     if (binary_mode) {
         return gen_message_binary();
     } else {
@@ -289,12 +311,12 @@ bool FGGeneric::parse_message_binary(int length) {
             } else {
                 tmp32 = *(int32_t *)p1;
             }
-            updateValue(_in_message[i], (int)tmp32);
+            _in_record.values[i].num = (int)tmp32;
             p1 += sizeof(int32_t);
             break;
 
         case FG_BOOL:
-            updateValue(_in_message[i], p1[0] != 0);
+            _in_record.values[i].num = (p1[0] != 0);
             p1 += 1;
             break;
 
@@ -304,7 +326,7 @@ bool FGGeneric::parse_message_binary(int length) {
             } else {
                 tmp32 = *(int32_t *)p1;
             }
-            updateValue(_in_message[i], (float)tmp32 / 65536.0f);
+            _in_record.values[i].num = (float)tmp32 / 65536.0f;
             p1 += sizeof(int32_t);
             break;
 
@@ -315,7 +337,7 @@ bool FGGeneric::parse_message_binary(int length) {
             } else {
                 tmpun32.floatVal = *(float *)p1;
             }
-            updateValue(_in_message[i], tmpun32.floatVal);
+            _in_record.values[i].num = tmpun32.floatVal;
             p1 += sizeof(int32_t);
             break;
 
@@ -326,7 +348,7 @@ bool FGGeneric::parse_message_binary(int length) {
             } else {
                 tmpun64.doubleVal = *(double *)p1;
             }
-            updateValue(_in_message[i], tmpun64.doubleVal);
+            _in_record.values[i].num = tmpun64.doubleVal;
             p1 += sizeof(int64_t);
             break;
 
@@ -336,7 +358,8 @@ bool FGGeneric::parse_message_binary(int length) {
             break;
         }
     }
-    
+    _in_record.count = i;
+
     return true;
 }
 
@@ -359,7 +382,15 @@ bool FGGeneric::parse_message_ascii(int length) {
     while ((++i < chunks) && p1) {
         char* p2 = NULL;
 
-        if (varsep_len > 0)
+        if (varsep_len == 1)
+        {
+            p2 = strchr(p1, var_separator[0]);
+            if (p2) {
+                *p2 = 0;
+                p2 += varsep_len;
+            }
+        }
+        else if (varsep_len > 0)
         {
             p2 = strstr(p1, var_separator.c_str());
             if (p2) {
@@ -370,38 +401,119 @@ bool FGGeneric::parse_message_ascii(int length) {
 
         switch (_in_message[i].type) {
         case FG_INT:
-            updateValue(_in_message[i], atoi(p1));
+            _in_record.values[i].num = FGGenericFormat::parseInt(p1);
             break;
 
         case FG_BOOL:
-            updateValue(_in_message[i], atof(p1) != 0.0);
+            _in_record.values[i].num = (atof(p1) != 0.0);
             break;
 
         case FG_FIXED:
         case FG_FLOAT:
-            updateValue(_in_message[i], (float)strtod(p1, 0));
+            _in_record.values[i].num = (float)strtod(p1, 0);
             break;
 
         case FG_DOUBLE:
-            updateValue(_in_message[i], (double)strtod(p1, 0));
+            _in_record.values[i].num = strtod(p1, 0);
             break;
 
         default: // SG_STRING
-            _in_message[i].prop->setStringValue(p1);
+            _in_record.values[i].str = p1;
             break;
         }
 
         p1 = p2;
     }
+    _in_record.count = i;
 
     return true;
 }
 
 bool FGGeneric::parse_message_len(int length) {
+    bool result;
     if (binary_mode) {
-        return parse_message_binary(length);
+        result = parse_message_binary(length);
     } else {
-        return parse_message_ascii(length);
+        result = parse_message_ascii(length);
+    }
+
+    if (!threaded) {
+        apply_values(_in_record);
+        return result;
+    }
+
+    // hand the values over to sync(), unless too many are waiting already
+    SGGuard<SGMutex> g(_lock);
+    if (_in_pending < _in_records.size()) {
+        _in_records[_in_pending++] = _in_record;
+    } else if (_in_pending < MAX_PENDING_RECORDS) {
+        _in_records.push_back(_in_record);
+        _in_pending++;
+    } else {
+        _in_overflow = true;
+    }
+    return result;
+}
+
+// read the values to send from the properties
+void FGGeneric::read_values(vector<_value> &values) {
+    for (unsigned int i = 0; i < _out_message.size(); i++) {
+        SGPropertyNode *prop = _out_message[i].prop;
+
+        switch (_out_message[i].type) {
+        case FG_INT:
+            values[i].num = prop->getIntValue();
+            break;
+
+        case FG_BOOL:
+            values[i].num = prop->getBoolValue();
+            break;
+
+        case FG_FIXED:
+        case FG_FLOAT:
+            values[i].num = prop->getFloatValue();
+            break;
+
+        case FG_DOUBLE:
+            values[i].num = prop->getDoubleValue();
+            break;
+
+        default: // SG_STRING
+            values[i].str = prop->getStringValue();
+            break;
+        }
+    }
+}
+
+// set the properties to the values received
+void FGGeneric::apply_values(const _record &record) {
+    for (unsigned int i = 0; i < record.count; i++) {
+        const _value &value = record.values[i];
+
+        switch (_in_message[i].type) {
+        case FG_INT:
+            updateValue(_in_message[i], (int)value.num);
+            break;
+
+        case FG_BOOL:
+            updateValue(_in_message[i], value.num != 0.0);
+            break;
+
+        case FG_FIXED:
+        case FG_FLOAT:
+            updateValue(_in_message[i], (float)value.num);
+            break;
+
+        case FG_DOUBLE:
+            updateValue(_in_message[i], value.num);
+            break;
+
+        default: // SG_STRING, not read in binary mode
+            if (!binary_mode) {
+                _in_message[i].prop->setStringValue(value.str.c_str());
+            }
+            break;
+        }
     }
 }
 
@@ -496,6 +608,12 @@ bool FGGeneric::process() {
     return true;
 error_out:
     if (exitOnError) {
+        if (threaded) {
+            // exit from the main thread, in sync()
+            SGGuard<SGMutex> g(_lock);
+            _exit_requested = true;
+            return false;
+        }
         fgOSExit(1);
         return true; // should not get there, but please the compiler
     } else
@@ -503,6 +621,40 @@ error_out:
 }
 
 
+// run process() on an I/O thread, and exchange the values in sync()
+bool FGGeneric::set_threaded(bool val) {
+    threaded = val;
+    return true;
+}
+
+
+// called on the main thread of a threaded channel: take a snapshot of
+// the values to send, and apply the ones received
+void FGGeneric::sync() {
+    bool exit_requested;
+    {
+        SGGuard<SGMutex> g(_lock);
+        read_values(_out_snapshot);
+        for (size_t i = 0; i < _in_pending; i++) {
+            apply_values(_in_records[i]);
+        }
+        _in_pending = 0;
+
+        if (_in_overflow) {
+            SG_LOG( SG_IO, SG_WARN, "Generic protocol: "
+                    "input records dropped, more arrived than "
+                    << MAX_PENDING_RECORDS << " within a frame.");
+            _in_overflow = false;
+        }
+        exit_requested = _exit_requested;
+    }
+
+    if (exit_requested) {
+        fgOSExit(1);
+    }
+}
+
+
 // close the channel
 bool FGGeneric::close() {
     SGIOChannel *io = get_io_channel();
@@ -574,6 +726,11 @@ FGGeneric::reinit()
         }
     }
 
+    _out_values.resize(_out_message.size());
+    _out_snapshot.resize(_out_message.size());
+    _in_record.values.resize(_in_message.size());
+    _in_record.count = 0;
+
     initOk = true;
 }
 
@@ -696,6 +853,7 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
         chunk.prop = fgGetNode(node.c_str(), true);
 
         string type = chunks[i]->getStringValue("type");
+        FGGenericFormat::e_arg arg = FGGenericFormat::ARG_INT;
 
         // Note: officially the type is called 'bool' but for backward
         //       compatibility 'boolean' will also be supported.
@@ -704,19 +862,28 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
             record_length += 1;
         } else if (type == "float") {
             chunk.type = FG_FLOAT;
+            arg = FGGenericFormat::ARG_DOUBLE;
             record_length += sizeof(int32_t);
         } else if (type == "double") {
             chunk.type = FG_DOUBLE;
+            arg = FGGenericFormat::ARG_DOUBLE;
             record_length += sizeof(int64_t);
         } else if (type == "fixed") {
             chunk.type = FG_FIXED;
+            arg = FGGenericFormat::ARG_DOUBLE;
             record_length += sizeof(int32_t);
-        } else if (type == "string")
+        } else if (type == "string") {
             chunk.type = FG_STRING;
-        else {
+            arg = FGGenericFormat::ARG_STRING;
+        } else {
             chunk.type = FG_INT;
             record_length += sizeof(int32_t);
         }
+
+        // Analyse the format once, rather than on each message
+        if (!binary_mode) {
+            chunk.compiled_format = FGGenericFormat(chunk.format, arg);
+        }
         msg.push_back(chunk);
 
     }
@@ -29,7 +29,10 @@
 
 #include <string>
 
+#include <simgear/threads/SGThread.hxx>
+
 #include "protocol.hxx"
+#include "generic_format.hxx"
 
 using std::string;
 
@@ -55,6 +58,10 @@ public:
     // close the channel
     bool close();
 
+    // run process() on an I/O thread, see FGProtocol
+    bool set_threaded(bool val);
+    void sync();
+
     void setExitOnError(bool val) { exitOnError = val; }
     bool getExitOnError() { return exitOnError; }
     bool getInitOk(void) { return initOk; }
@@ -65,6 +72,7 @@ protected:
     typedef struct {
      // string name;
         string format;
+        FGGenericFormat compiled_format; // ASCII only
         e_type type;
         double offset;
         double factor;
@@ -74,6 +82,18 @@ protected:
         SGPropertyNode_ptr prop;
     } _serial_prot;
 
+    // The value of a chunk, as read from or for its property
+    typedef struct {
+        double num;
+        string str;
+    } _value;
+
+    // The values of a message, set for its first count chunks
+    typedef struct {
+        vector<_value> values;
+        size_t count;
+    } _record;
+
 private:
 
     string file_name;
@@ -104,6 +124,25 @@ private:
     bool read_config(SGPropertyNode *root, vector<_serial_prot> &msg);
     bool exitOnError;
     bool initOk;
+
+    // The values of the message being generated, and of the one being
+    // parsed.  They are read from and applied to the properties right
+    // away, unless the channel is threaded.
+    vector<_value> _out_values;
+    _record _in_record;
+
+    void read_values(vector<_value> &values);
+    void apply_values(const _record &record);
+
+    // Threaded channels exchange their values with the main thread in
+    // sync(), through these, guarded by _lock.
+    bool threaded;
+    SGMutex _lock;
+    vector<_value> _out_snapshot;  // the outgoing values
+    vector<_record> _in_records;   // parsed records, not yet applied
+    size_t _in_pending;
+    bool _in_overflow;
+    bool _exit_requested;
     
     template<class T>
     static void updateValue(_serial_prot& prot, const T& val)
@@ -0,0 +1,252 @@
+// generic_format.cxx -- compiled chunk formats of the generic protocol
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <cstdio>
+
+#include <simgear/misc/stdint.hxx>
+
+#include "generic_format.hxx"
+
+namespace {
+
+// The %f precisions written directly
+const int MAX_PRECISION = 9;
+
+const uint64_t powersOfTen[MAX_PRECISION + 1] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u,
+    100000000u, 1000000000u
+};
+
+// Writes to a buffer of limited size, truncating as snprintf does
+class Output {
+public:
+    Output(char* out, size_t size) :
+        _begin(out), _p(out), _end(size > 0 ? out + size - 1 : out),
+        _terminate(size > 0)
+    {
+    }
+
+    void put(char c)
+    {
+        if (_p < _end)
+            *_p++ = c;
+    }
+
+    void put(const char* str, size_t len)
+    {
+        size_t room = _end - _p;
+        if (len > room)
+            len = room;
+        memcpy(_p, str, len);
+        _p += len;
+    }
+
+    void put(const std::string& str) { put(str.data(), str.size()); }
+
+    // Write the digits of val, at least width of them
+    void putDigits(uint64_t val, int width = 1)
+    {
+        char digits[24];
+        int n = 0;
+        do {
+            digits[n++] = '0' + (char)(val % 10);
+            val /= 10;
+        } while (val != 0 || n < width);
+        while (n > 0)
+            put(digits[--n]);
+    }
+
+    size_t finish()
+    {
+        if (_terminate)
+            *_p = 0;
+        return _p - _begin;
+    }
+
+private:
+    char* _begin;
+    char* _p;
+    char* _end;
+    bool _terminate;
+};
+
+}
+
+FGGenericFormat::FGGenericFormat() :
+    _format("%d"),
+    _kind(FMT_INT),
+    _precision(0)
+{
+}
+
+FGGenericFormat::FGGenericFormat(const std::string& format, e_arg arg) :
+    _format(format),
+    _kind(FMT_PRINTF),
+    _precision(6)
+{
+    // Only a conversion without flags nor width, between two literal texts
+    std::string::size_type percent = format.find('%');
+    if (percent == std::string::npos)
+        return;
+
+    std::string::size_type i = percent + 1;
+    int precision = -1;
+    if (i < format.size() && format[i] == '.') {
+        precision = 0;
+        for (++i; i < format.size() && isdigit(format[i]); ++i) {
+            precision = 10*precision + (format[i] - '0');
+            if (precision > MAX_PRECISION)
+                return;
+        }
+    }
+    if (i >= format.size())
+        return;
+
+    char conversion = format[i];
+    std::string suffix = format.substr(i + 1);
+    if (suffix.find('%') != std::string::npos)
+        return;
+
+    e_kind kind;
+    if ((conversion == 'd' || conversion == 'i')
+        && precision < 0 && arg == ARG_INT) {
+        kind = FMT_INT;
+    } else if ((conversion == 'f' || conversion == 'F')
+               && arg == ARG_DOUBLE) {
+        kind = FMT_FIXED_POINT;
+        if (precision >= 0)
+            _precision = precision;
+    } else if (conversion == 's' && precision < 0 && arg == ARG_STRING) {
+        kind = FMT_STRING;
+    } else {
+        return;
+    }
+
+    _prefix = format.substr(0, percent);
+    _suffix = suffix;
+    _kind = kind;
+}
+
+size_t FGGenericFormat::format(char* out, size_t size, int val) const
+{
+    if (_kind != FMT_INT)
+        return fallback(out, size, val);
+
+    Output o(out, size);
+    o.put(_prefix);
+    uint32_t magnitude = (uint32_t)val;
+    if (val < 0) {
+        o.put('-');
+        magnitude = 0u - magnitude;
+    }
+    o.putDigits(magnitude);
+    o.put(_suffix);
+    return o.finish();
+}
+
+size_t FGGenericFormat::format(char* out, size_t size, double val) const
+{
+    if (_kind != FMT_FIXED_POINT)
+        return fallback(out, size, val);
+
+    // -0.0 is printed with its sign as well
+    bool negative = val < 0.0 || (val == 0.0 && 1.0/val < 0.0);
+    double scaled = fabs(val)*powersOfTen[_precision];
+
+    // Up to 1e12 the product is exact enough to round it; the test also
+    // sends NaN and the infinities to snprintf.
+    if (!(scaled < 1e12))
+        return fallback(out, size, val);
+
+    // snprintf rounds the exact binary value, which a halfway product
+    // does not tell
+    double whole = floor(scaled);
+    double fraction = scaled - whole;
+    if (fabs(fraction - 0.5) < 1e-3)
+        return fallback(out, size, val);
+
+    uint64_t digits = (uint64_t)whole + (fraction > 0.5 ? 1 : 0);
+    uint64_t scale = powersOfTen[_precision];
+
+    Output o(out, size);
+    o.put(_prefix);
+    if (negative)
+        o.put('-');
+    o.putDigits(digits / scale);
+    if (_precision > 0) {
+        o.put('.');
+        o.putDigits(digits % scale, _precision);
+    }
+    o.put(_suffix);
+    return o.finish();
+}
+
+size_t FGGenericFormat::format(char* out, size_t size, const char* val) const
+{
+    if (_kind != FMT_STRING)
+        return fallback(out, size, val);
+
+    Output o(out, size);
+    o.put(_prefix);
+    o.put(val, strlen(val));
+    o.put(_suffix);
+    return o.finish();
+}
+
+int FGGenericFormat::parseInt(const char* str)
+{
+    while (isspace(*str))
+        ++str;
+
+    bool negative = false;
+    if (*str == '-' || *str == '+')
+        negative = (*str++ == '-');
+
+    uint32_t val = 0;
+    for (; *str >= '0' && *str <= '9'; ++str)
+        val = 10*val + (*str - '0');
+    return (int)(negative ? 0u - val : val);
+}
+
+// The snprintf return value is the length the text would have had
+static size_t written(int len, size_t size)
+{
+    if (len < 0 || size == 0)
+        return 0;
+    return (size_t)len < size ? (size_t)len : size - 1;
+}
+
+size_t FGGenericFormat::fallback(char* out, size_t size, int val) const
+{
+    return written(snprintf(out, size, _format.c_str(), val), size);
+}
+
+size_t FGGenericFormat::fallback(char* out, size_t size, double val) const
+{
+    return written(snprintf(out, size, _format.c_str(), val), size);
+}
+
+size_t FGGenericFormat::fallback(char* out, size_t size, const char* val) const
+{
+    return written(snprintf(out, size, _format.c_str(), val), size);
+}
@@ -0,0 +1,80 @@
+// generic_format.hxx -- compiled chunk formats of the generic protocol
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+
+#ifndef _FG_GENERIC_FORMAT_HXX
+#define _FG_GENERIC_FORMAT_HXX
+
+
+#include <stddef.h>
+
+#include <string>
+
+
+/**
+ * The printf format of an ASCII chunk, analysed once when the protocol is
+ * read. The formats used by nearly all protocols, a literal text around
+ * one of %d, %i, %f, %.<n>f or %s, are then written directly; any other
+ * format is handed to snprintf.
+ *
+ * The output is the same as the one of snprintf, including the truncation
+ * to the size of the buffer. A %f value which is very large, not a number,
+ * or about halfway between two roundings, also goes through snprintf.
+ */
+class FGGenericFormat {
+
+public:
+
+    /// What the format is given
+    enum e_arg { ARG_INT, ARG_DOUBLE, ARG_STRING };
+
+    FGGenericFormat();
+    FGGenericFormat(const std::string& format, e_arg arg);
+
+    /**
+     * Like snprintf(out, size, format, val): write at most size - 1
+     * characters and a terminating 0, and return the number of characters
+     * written, without the 0.
+     */
+    size_t format(char* out, size_t size, int val) const;
+    size_t format(char* out, size_t size, double val) const;
+    size_t format(char* out, size_t size, const char* val) const;
+
+    /// false if the format is handed to snprintf
+    bool isCompiled() const { return _kind != FMT_PRINTF; }
+
+    /**
+     * Read an integer as atoi() does, for a value in the int range.
+     */
+    static int parseInt(const char* str);
+
+private:
+
+    enum e_kind { FMT_PRINTF, FMT_INT, FMT_FIXED_POINT, FMT_STRING };
+
+    size_t fallback(char* out, size_t size, int val) const;
+    size_t fallback(char* out, size_t size, double val) const;
+    size_t fallback(char* out, size_t size, const char* val) const;
+
+    std::string _format;
+    std::string _prefix;
+    std::string _suffix;
+    e_kind _kind;
+    int _precision;
+};
+
+
+#endif // _FG_GENERIC_FORMAT_HXX
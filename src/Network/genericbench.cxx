@@ -0,0 +1,281 @@
+// genericbench.cxx -- time the ASCII chunk formats of a generic protocol
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+// Generates the lines of the <output> of a generic protocol definition,
+// with varying values, once with snprintf into a std::string as FGGeneric
+// used to, and once with the compiled formats into a fixed buffer.  The
+// two must give the same text.  The lines are then split and read back
+// as FGGeneric does.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <simgear/props/props.hxx>
+#include <simgear/props/props_io.hxx>
+#include <simgear/structure/exception.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "generic_format.hxx"
+
+#define MAX_MSG_SIZE 16384
+
+struct Chunk {
+    std::string format;
+    FGGenericFormat compiled;
+    FGGenericFormat::e_arg arg;
+    double offset;
+    double factor;
+};
+
+static int usage()
+{
+    fprintf(stderr, "Usage: generic-bench <protocol.xml> [-n lines]\n");
+    return 1;
+}
+
+static std::string separator(const std::string& sep)
+{
+    if (sep == "newline")        return "\n";
+    if (sep == "tab")            return "\t";
+    if (sep == "space")          return " ";
+    if (sep == "formfeed")       return "\f";
+    if (sep == "carriagereturn") return "\r";
+    if (sep == "verticaltab")    return "\v";
+    return sep;
+}
+
+// The value of a chunk in a line, different for each line and chunk
+static double value(int line, unsigned chunk)
+{
+    return 1000.0*sin(0.001*line + chunk) + 0.37*chunk;
+}
+
+// The line as FGGeneric::gen_message_ascii() used to build it
+static size_t reference(const std::vector<Chunk>& chunks,
+                        const std::string& var_sep,
+                        const std::string& line_sep,
+                        int line, char* buf)
+{
+    std::string sentence;
+    char tmp[255];
+    for (unsigned i = 0; i < chunks.size(); i++) {
+        const Chunk& c = chunks[i];
+        if (i > 0)
+            sentence += var_sep;
+        double val = c.offset + value(line, i)*c.factor;
+        switch (c.arg) {
+        case FGGenericFormat::ARG_INT:
+            snprintf(tmp, 255, c.format.c_str(), (int)val);
+            break;
+        case FGGenericFormat::ARG_DOUBLE:
+            snprintf(tmp, 255, c.format.c_str(), (double)(float)val);
+            break;
+        default:
+            snprintf(tmp, 255, c.format.c_str(), "generic");
+            break;
+        }
+        sentence += tmp;
+    }
+    sentence += line_sep;
+    size_t length = sentence.length();
+    if (length > MAX_MSG_SIZE)
+        length = MAX_MSG_SIZE;
+    memcpy(buf, sentence.data(), length);
+    return length;
+}
+
+// The line with the compiled formats
+static size_t compiled(const std::vector<Chunk>& chunks,
+                       const std::string& var_sep,
+                       const std::string& line_sep,
+                       int line, char* buf)
+{
+    char tmp[255];
+    char* p = buf;
+    char* end = buf + MAX_MSG_SIZE;
+    for (unsigned i = 0; i < chunks.size(); i++) {
+        const Chunk& c = chunks[i];
+        if (i > 0 && p + var_sep.size() <= end) {
+            memcpy(p, var_sep.data(), var_sep.size());
+            p += var_sep.size();
+        }
+        double val = c.offset + value(line, i)*c.factor;
+        size_t len;
+        switch (c.arg) {
+        case FGGenericFormat::ARG_INT:
+            len = c.compiled.format(tmp, sizeof(tmp), (int)val);
+            break;
+        case FGGenericFormat::ARG_DOUBLE:
+            len = c.compiled.format(tmp, sizeof(tmp), (double)(float)val);
+            break;
+        default:
+            len = c.compiled.format(tmp, sizeof(tmp), "generic");
+            break;
+        }
+        if (len > (size_t)(end - p))
+            len = end - p;
+        memcpy(p, tmp, len);
+        p += len;
+    }
+    if (p + line_sep.size() <= end) {
+        memcpy(p, line_sep.data(), line_sep.size());
+        p += line_sep.size();
+    }
+    return p - buf;
+}
+
+// Split and read a line as FGGeneric::parse_message_ascii() does, either
+// with strstr and atoi or with strchr and parseInt
+static double parse(const std::vector<Chunk>& chunks,
+                    const std::string& var_sep, char* line, bool fast)
+{
+    double sum = 0;
+    char* p1 = line;
+    for (unsigned i = 0; i < chunks.size() && p1; i++) {
+        char* p2 = 0;
+        if (fast && var_sep.size() == 1)
+            p2 = strchr(p1, var_sep[0]);
+        else if (!var_sep.empty())
+            p2 = strstr(p1, var_sep.c_str());
+        if (p2) {
+            *p2 = 0;
+            p2 += var_sep.size();
+        }
+        switch (chunks[i].arg) {
+        case FGGenericFormat::ARG_INT:
+            sum += fast ? FGGenericFormat::parseInt(p1) : atoi(p1);
+            break;
+        case FGGenericFormat::ARG_DOUBLE:
+            sum += strtod(p1, 0);
+            break;
+        default:
+            break;
+        }
+        p1 = p2;
+    }
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+        return usage();
+    int lines = 100000;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+            lines = atoi(argv[++i]);
+        else
+            return usage();
+    }
+
+    SGPropertyNode root;
+    try {
+        readProperties(argv[1], &root);
+    } catch (const sg_exception& e) {
+        fprintf(stderr, "%s: %s\n", argv[1], e.getFormattedMessage().c_str());
+        return 1;
+    }
+    SGPropertyNode* output = root.getNode("generic/output");
+    if (!output || output->getBoolValue("binary_mode")) {
+        fprintf(stderr, "%s has no ASCII output\n", argv[1]);
+        return 1;
+    }
+
+    std::string var_sep = separator(output->getStringValue("var_separator"));
+    std::string line_sep = separator(output->getStringValue("line_separator"));
+    std::vector<Chunk> chunks;
+    int compiledChunks = 0;
+    std::vector<SGPropertyNode_ptr> nodes = output->getChildren("chunk");
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        Chunk c;
+        c.format = nodes[i]->getStringValue("format", "%d");
+        c.offset = nodes[i]->getDoubleValue("offset");
+        c.factor = nodes[i]->getDoubleValue("factor", 1.0);
+        std::string type = nodes[i]->getStringValue("type");
+        if (type == "float" || type == "double" || type == "fixed")
+            c.arg = FGGenericFormat::ARG_DOUBLE;
+        else if (type == "string")
+            c.arg = FGGenericFormat::ARG_STRING;
+        else
+            c.arg = FGGenericFormat::ARG_INT;
+        c.compiled = FGGenericFormat(c.format, c.arg);
+        if (c.compiled.isCompiled())
+            compiledChunks++;
+        chunks.push_back(c);
+    }
+    printf("%d chunks, %d of them compiled, %d lines\n",
+           (int)chunks.size(), compiledChunks, lines);
+
+    // Both paths must write the same lines
+    static char buf[2][MAX_MSG_SIZE + 1];
+    int mismatches = 0;
+    for (int l = 0; l < lines; l++) {
+        size_t len0 = reference(chunks, var_sep, line_sep, l, buf[0]);
+        size_t len1 = compiled(chunks, var_sep, line_sep, l, buf[1]);
+        if (len0 != len1 || memcmp(buf[0], buf[1], len0) != 0) {
+            if (mismatches++ < 5) {
+                buf[0][len0] = buf[1][len1] = 0;
+                printf("   line %d differs:\n   snprintf: %s   compiled: %s",
+                       l, buf[0], buf[1]);
+            }
+        }
+    }
+
+    double usec[4];
+    volatile size_t total = 0;
+    SGTimeStamp t = SGTimeStamp::now();
+    for (int l = 0; l < lines; l++)
+        total += reference(chunks, var_sep, line_sep, l, buf[0]);
+    usec[0] = (SGTimeStamp::now() - t).toUSecs() / lines;
+
+    t = SGTimeStamp::now();
+    for (int l = 0; l < lines; l++)
+        total += compiled(chunks, var_sep, line_sep, l, buf[1]);
+    usec[1] = (SGTimeStamp::now() - t).toUSecs() / lines;
+
+    // Read back a line, restored before each pass since parse() cuts it
+    size_t len = compiled(chunks, var_sep, line_sep, 0, buf[0]);
+    if (len >= line_sep.size())
+        len -= line_sep.size();
+    buf[0][len] = 0;
+    volatile double sum = 0;
+    for (int k = 0; k < 2; k++) {
+        t = SGTimeStamp::now();
+        for (int l = 0; l < lines; l++) {
+            memcpy(buf[1], buf[0], len + 1);
+            sum += parse(chunks, var_sep, buf[1], k == 1);
+        }
+        usec[2 + k] = (SGTimeStamp::now() - t).toUSecs() / lines;
+    }
+
+    printf("   generate, snprintf: %8.3f us/line\n", usec[0]);
+    printf("   generate, compiled: %8.3f us/line (%.2fx)\n",
+           usec[1], usec[0]/usec[1]);
+    printf("   parse, strstr/atoi: %8.3f us/line\n", usec[2]);
+    printf("   parse, strchr/parseInt: %8.3f us/line (%.2fx)\n",
+           usec[3], usec[2]/usec[3]);
+    printf("   %d lines differ\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -99,6 +99,16 @@ bool FGProtocol::parse_message() {
 }
 
 
+// by default, a protocol runs on the main thread only
+bool FGProtocol::set_threaded( bool threaded ) {
+    return !threaded;
+}
+
+
+void FGProtocol::sync() {
+}
+
+
 void FGProtocol::set_direction( const string& d ) {
     if ( d == "in" ) {
 	dir = SG_IO_IN;
@@ -80,6 +80,13 @@ public:
     virtual bool gen_message();
     virtual bool parse_message();
 
+    // A protocol may run its process() on an I/O thread of its own.  It
+    // then exchanges its property values in sync(), called on the main
+    // thread at each frame.  Returns false if the protocol can only run
+    // on the main thread.
+    virtual bool set_threaded( bool threaded );
+    virtual void sync();
+
     // inline string get_protocol() const { return protocol_str; }
     // inline void set_protocol( const string& str ) { protocol_str = str; }
 
@@ -297,12 +297,12 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 	
 
 	double elevation_under_pilot = 0.0;
-	if (scenery->get_elevation_m( max_own_pos, elevation_under_pilot, NULL )) {
+	if (scenery->get_cached_elevation_m( max_own_pos, elevation_under_pilot, NULL )) {
 		receiver_height = own_alt - elevation_under_pilot; 
 	}
 
 	double elevation_under_sender = 0.0;
-	if (scenery->get_elevation_m( max_sender_pos, elevation_under_sender, NULL )) {
+	if (scenery->get_cached_elevation_m( max_sender_pos, elevation_under_sender, NULL )) {
 		transmitter_height = sender_alt - elevation_under_sender;
 	}
 	else {
@@ -320,13 +320,19 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 	
 	unsigned int e_size = (deque<unsigned>::size_type)max_points;
 	
-	while (elevations.size() <= e_size) {
+	// look up the whole terrain profile in one go
+	FGScenery::ElevationQueryList probes(e_size + 1);
+	for (unsigned int i = 0; i < probes.size(); i++) {
 		probe_distance += point_distance;
-		SGGeod probe = SGGeod::fromGeoc(center.advanceRadM( course, probe_distance ));
-		const simgear::BVHMaterial *material = 0;
-		double elevation_m = 0.0;
+		probes[i].pos = SGGeod::fromGeoc(center.advanceRadM( course, probe_distance ));
+	}
+	scenery->get_cached_elevations_m(probes);
+	
+	for (unsigned int i = 0; i < probes.size(); i++) {
+		const simgear::BVHMaterial *material = probes[i].material;
+		double elevation_m = probes[i].elevationM;
 	
-		if (scenery->get_elevation_m( probe, elevation_m, &material )) {
+		if (probes[i].valid) {
                         const SGMaterial *mat;
                         mat = dynamic_cast<const SGMaterial*>(material);
 			if((transmission_type == 3) || (transmission_type == 4)) {
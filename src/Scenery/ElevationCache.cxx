@@ -0,0 +1,180 @@
+// ElevationCache.cxx -- grid cache of terrain elevations
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+// $Id$
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "ElevationCache.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <simgear/constants.h>
+
+namespace flightgear
+{
+
+namespace
+{
+  // grid resolution; 4096 cells per degree are about 27m of latitude
+  const double CELLS_PER_DEGREE = 4096.0;
+
+  // cells in each of the two generations, about 6MB each
+  const size_t MAX_GENERATION_SIZE = 64 * 1024;
+
+  // the vertical through a point is sampled between these, see elevationAt
+  const double LINE_TOP_M = 10000.0;
+
+  // surfaces steeper than about 78 degrees are not approximated by a plane
+  const double MIN_VERTICAL_COSINE = 0.2;
+} // of anonymous namespace
+
+ElevationCache::ElevationCache()
+{
+}
+
+int ElevationCache::latIndex(double lat)
+{
+  double i = floor((lat + 90.0) * CELLS_PER_DEGREE);
+  return (int) SGMiscd::clip(i, 0.0, 180.0 * CELLS_PER_DEGREE);
+}
+
+int ElevationCache::lonIndex(double lon)
+{
+  lon = SGMiscd::normalizePeriodic(-180.0, 180.0, lon);
+  double i = floor((lon + 180.0) * CELLS_PER_DEGREE);
+  return (int) SGMiscd::clip(i, 0.0, 360.0 * CELLS_PER_DEGREE - 1);
+}
+
+uint64_t ElevationCache::key(int latIndex, int lonIndex)
+{
+  return ((uint64_t) latIndex << 32) | (uint32_t) lonIndex;
+}
+
+uint64_t ElevationCache::key(const SGGeod& pos)
+{
+  return key(latIndex(pos.getLatitudeDeg()), lonIndex(pos.getLongitudeDeg()));
+}
+
+SGGeod ElevationCache::cellCenter(const SGGeod& pos)
+{
+  double lat = (latIndex(pos.getLatitudeDeg()) + 0.5) / CELLS_PER_DEGREE - 90.0;
+  double lon = (lonIndex(pos.getLongitudeDeg()) + 0.5) / CELLS_PER_DEGREE - 180.0;
+  return SGGeod::fromDegM(lon, lat, SG_MAX_ELEVATION_M);
+}
+
+const ElevationCache::Cell* ElevationCache::find(const SGGeod& pos)
+{
+  uint64_t k = key(pos);
+  CellMap::iterator it = _current.find(k);
+  if (it != _current.end()) {
+    return &it->second;
+  }
+
+  it = _previous.find(k);
+  if (it == _previous.end()) {
+    return NULL;
+  }
+
+  // still in use, promote it
+  Cell cell = it->second;
+  _previous.erase(it);
+  insert(pos, cell);
+  return &_current[k];
+}
+
+void ElevationCache::insert(const SGGeod& pos, const Cell& cell)
+{
+  if (_current.size() >= MAX_GENERATION_SIZE) {
+    _previous.swap(_current);
+    _current.clear();
+  }
+
+  _current[key(pos)] = cell;
+}
+
+bool ElevationCache::elevationAt(const Cell& cell, const SGGeod& pos,
+                                 double& elevationM)
+{
+  // altitude is linear along the geodetic vertical, so intersect the
+  // cell plane with the vertical through pos and interpolate
+  SGVec3d top = SGVec3d::fromGeod(SGGeod::fromGeodM(pos, LINE_TOP_M));
+  SGVec3d down = SGVec3d::fromGeod(SGGeod::fromGeodM(pos, 0.0)) - top;
+
+  double denom = dot(down, cell.normal);
+  if (fabs(denom) < MIN_VERTICAL_COSINE * LINE_TOP_M) {
+    return false;
+  }
+
+  double t = dot(cell.point - top, cell.normal) / denom;
+  elevationM = LINE_TOP_M * (1.0 - t);
+  return true;
+}
+
+void ElevationCache::invalidate(double minLat, double minLon,
+                                double maxLat, double maxLon)
+{
+  // one extra cell all round, since cells are sampled at their centre
+  int lat0 = latIndex(minLat) - 1;
+  int lat1 = latIndex(maxLat) + 1;
+
+  if (maxLon - minLon >= 360.0) {
+    invalidate(_current, lat0, 0, lat1, std::numeric_limits<int>::max());
+    invalidate(_previous, lat0, 0, lat1, std::numeric_limits<int>::max());
+    return;
+  }
+
+  int lon0 = lonIndex(minLon) - 1;
+  int lon1 = lonIndex(maxLon) + 1;
+  if (lon0 <= lon1) {
+    invalidate(_current, lat0, lon0, lat1, lon1);
+    invalidate(_previous, lat0, lon0, lat1, lon1);
+  } else {
+    // the area crosses the anti-meridian
+    invalidate(_current, lat0, lon0, lat1, std::numeric_limits<int>::max());
+    invalidate(_previous, lat0, lon0, lat1, std::numeric_limits<int>::max());
+    invalidate(_current, lat0, 0, lat1, lon1);
+    invalidate(_previous, lat0, 0, lat1, lon1);
+  }
+}
+
+void ElevationCache::invalidate(CellMap& cells, int minLat, int minLon,
+                                int maxLat, int maxLon)
+{
+  if (cells.empty()) {
+    return;
+  }
+
+  minLat = std::max(minLat, 0);
+  minLon = std::max(minLon, 0);
+  for (int lat = minLat; lat <= maxLat; ++lat) {
+    CellMap::iterator begin = cells.lower_bound(key(lat, minLon));
+    CellMap::iterator end = cells.upper_bound(key(lat, maxLon));
+    cells.erase(begin, end);
+  }
+}
+
+void ElevationCache::clear()
+{
+  _current.clear();
+  _previous.clear();
+}
+
+} // of namespace flightgear
@@ -0,0 +1,99 @@
+// ElevationCache.hxx -- grid cache of terrain elevations
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+// $Id$
+
+#ifndef FLIGHTGEAR_ELEVATIONCACHE_HXX
+#define FLIGHTGEAR_ELEVATIONCACHE_HXX 1
+
+#include <map>
+#include <stdint.h>
+
+#include <simgear/math/SGMath.hxx>
+
+namespace simgear {
+class BVHMaterial;
+}
+
+namespace flightgear
+{
+
+/**
+ * Terrain elevations on a regular lat/lon grid of roughly 25m cells. Each
+ * cell remembers where a vertical line through its centre first hits the
+ * terrain, together with the surface normal there, so a point elsewhere
+ * in the cell is answered by intersecting with that plane. That is exact
+ * on the same terrain triangle, and a close approximation across edges.
+ *
+ * Only the static terrain belongs in here; the tile manager invalidates
+ * the cells of each tile as it is loaded, refreshed or dropped. The most
+ * recently used cells are kept, up to a fixed number. Main thread only.
+ */
+class ElevationCache
+{
+public:
+    struct Cell
+    {
+        SGVec3d point;  ///< terrain hit below the cell centre, cartesian
+        SGVec3d normal; ///< unit surface normal at the hit, cartesian
+        const simgear::BVHMaterial* material;
+    };
+
+    ElevationCache();
+
+    /**
+     * the cell containing pos, or NULL if it has not been sampled. The
+     * pointer is valid until the cache is next modified.
+     */
+    const Cell* find(const SGGeod& pos);
+
+    /// identifies the cell containing pos, equal for all points in it
+    static uint64_t key(const SGGeod& pos);
+
+    /// where the cell containing pos should be sampled from
+    static SGGeod cellCenter(const SGGeod& pos);
+
+    void insert(const SGGeod& pos, const Cell& cell);
+
+    /**
+     * elevation of the cell's surface plane below pos. Fails where the
+     * plane is too steep to be a useful approximation.
+     */
+    static bool elevationAt(const Cell& cell, const SGGeod& pos,
+                            double& elevationM);
+
+    /// drop all cells overlapping the given area, in degrees
+    void invalidate(double minLat, double minLon, double maxLat, double maxLon);
+    void clear();
+private:
+    typedef std::map<uint64_t, Cell> CellMap;
+
+    static int latIndex(double lat);
+    static int lonIndex(double lon);
+    static uint64_t key(int latIndex, int lonIndex);
+    static void invalidate(CellMap& cells, int minLat, int minLon,
+                           int maxLat, int maxLon);
+
+    // two generations, for a cheap approximation of least-recently-used:
+    // lookups promote cells from the previous into the current one, and
+    // once the current one is full it becomes the previous one.
+    CellMap _current;
+    CellMap _previous;
+};
+
+} // of namespace flightgear
+
+#endif // of FLIGHTGEAR_ELEVATIONCACHE_HXX
@@ -28,6 +28,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <utility>
+
 #include <osg/Camera>
 #include <osg/Transform>
 #include <osg/MatrixTransform>
@@ -48,6 +51,7 @@
 #include <simgear/bvh/BVHNode.hxx>
 #include <simgear/bvh/BVHLineSegmentVisitor.hxx>
 #include <simgear/structure/commands.hxx>
+#include <simgear/bucket/newbucket.hxx>
 
 #include <Viewer/renderer.hxx>
 #include <Main/fg_props.hxx>
@@ -92,6 +96,7 @@ public:
         _lineSegment(lineSegment),
         _skipNode(skipNode),
         _material(0),
+        _normal(SGVec3d::zeros()),
         _haveHit(false)
     { }
 
@@ -101,6 +106,8 @@ public:
     { return _lineSegment; }
     const simgear::BVHMaterial* getMaterial() const
     { return _material; }
+    const SGVec3d& getNormal() const
+    { return _normal; }
 
     virtual void apply(osg::Node& node)
     {
@@ -160,6 +167,7 @@ private:
         SGLineSegmentd lineSegment = _lineSegment;
         bool haveHit = _haveHit;
         const simgear::BVHMaterial* material = _material;
+        SGVec3d normal = _normal;
 
         _haveHit = false;
         _lineSegment = lineSegment.transform(SGMatrixd(inverseMatrix.ptr()));
@@ -169,9 +177,11 @@ private:
 
         if (_haveHit) {
             _lineSegment = _lineSegment.transform(SGMatrixd(matrix.ptr()));
+            _normal = SGMatrixd(matrix.ptr()).xformVec(_normal);
         } else {
             _lineSegment = lineSegment;
             _material = material;
+            _normal = normal;
             _haveHit = haveHit;
         }
     }
@@ -196,6 +206,7 @@ private:
         if (!lineSegmentVisitor.empty()) {
             _lineSegment = lineSegmentVisitor.getLineSegment();
             _material = lineSegmentVisitor.getMaterial();
+            _normal = lineSegmentVisitor.getNormal();
             _haveHit = true;
         }
     }
@@ -213,11 +224,14 @@ private:
     const osg::Node* _skipNode;
 
     const simgear::BVHMaterial* _material;
+    SGVec3d _normal;
     bool _haveHit;
 };
 
 // Scenery Management system
-FGScenery::FGScenery()
+FGScenery::FGScenery() :
+    _dynamicModelsFrame(0),
+    _dynamicModelsValid(false)
 {
     SG_LOG( SG_TERRAIN, SG_INFO, "Initializing scenery subsystem" );
     // keep reference to pager singleton, so it cannot be destroyed while FGScenery lives
@@ -307,6 +321,183 @@ FGScenery::get_elevation_m(const SGGeod& geod, double& alt,
   return true;
 }
 
+bool
+FGScenery::get_cached_elevation_m(const SGGeod& geod, double& alt,
+                                  const simgear::BVHMaterial** material,
+                                  const osg::Node* butNotFrom)
+{
+  return get_cached_elevation_m(get_terrain_cell(geod), geod, alt, material,
+                                butNotFrom);
+}
+
+unsigned
+FGScenery::get_cached_elevations_m(ElevationQueryList& queries,
+                                   const osg::Node* butNotFrom)
+{
+  // sort the queries by cache cell, so each cell is found once
+  typedef std::pair<uint64_t, size_t> KeyIndex;
+  std::vector<KeyIndex> order(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i)
+    order[i] = KeyIndex(ElevationCache::key(queries[i].pos), i);
+  std::sort(order.begin(), order.end());
+
+  unsigned count = 0;
+  const ElevationCache::Cell* cell = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    ElevationQuery& q = queries[order[i].second];
+    if ((i == 0) || (order[i].first != order[i - 1].first))
+      cell = get_terrain_cell(q.pos);
+
+    q.material = 0;
+    q.valid = get_cached_elevation_m(cell, q.pos, q.elevationM, &q.material,
+                                     butNotFrom);
+    if (q.valid)
+      ++count;
+  }
+  return count;
+}
+
+bool
+FGScenery::get_cached_elevation_m(const ElevationCache::Cell* cell,
+                                  const SGGeod& geod, double& alt,
+                                  const simgear::BVHMaterial** material,
+                                  const osg::Node* butNotFrom)
+{
+  // fall back to the full query where the cache has nothing, and where the
+  // query starts below the cached surface, eg underneath a bridge
+  double terrainAlt;
+  if (!cell || !ElevationCache::elevationAt(*cell, geod, terrainAlt) ||
+      (terrainAlt > geod.getElevationM()))
+    return get_elevation_m(geod, alt, material, butNotFrom);
+
+  if (!get_dynamic_elevation_m(geod, terrainAlt, alt, material, butNotFrom)) {
+    alt = terrainAlt;
+    if (material)
+      *material = cell->material;
+  }
+  return true;
+}
+
+// the cache cell of the static terrain below geod; samples the cell on a
+// miss. The pointer is valid until the cache is next modified.
+const ElevationCache::Cell*
+FGScenery::get_terrain_cell(const SGGeod& geod)
+{
+  const ElevationCache::Cell* cell = _elevationCache.find(geod);
+  if (!cell) {
+    SGGeod center = ElevationCache::cellCenter(geod);
+    SGVec3d start = SGVec3d::fromGeod(center);
+    SGVec3d end = SGVec3d::fromGeod(SGGeod::fromGeodM(center, -10000));
+
+    FGSceneryIntersect intersectVisitor(SGLineSegmentd(start, end), 0);
+    intersectVisitor.setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
+    get_terrain_branch()->accept(intersectVisitor);
+
+    // misses are not cached, the tile may just not be loaded yet
+    if (!intersectVisitor.getHaveHit())
+      return 0;
+    double len = norm(intersectVisitor.getNormal());
+    if (!(len > 0))
+      return 0;
+
+    ElevationCache::Cell newCell;
+    newCell.point = intersectVisitor.getLineSegment().getEnd();
+    newCell.normal = intersectVisitor.getNormal() / len;
+    newCell.material = intersectVisitor.getMaterial();
+    _elevationCache.insert(geod, newCell);
+    cell = _elevationCache.find(geod);
+  }
+  return cell;
+}
+
+// anything outside the terrain branch between geod and the terrain below;
+// carriers and other models which can be stood on
+bool
+FGScenery::get_dynamic_elevation_m(const SGGeod& geod, double terrainAlt,
+                                   double& alt,
+                                   const simgear::BVHMaterial** material,
+                                   const osg::Node* butNotFrom)
+{
+  const NodeList& models = get_dynamic_models();
+  if (models.empty())
+    return false;
+
+  SGVec3d start = SGVec3d::fromGeod(geod);
+  SGVec3d end = SGVec3d::fromGeod(SGGeod::fromGeodM(geod, terrainAlt));
+  SGLineSegmentd lineSegment(start, end);
+
+  // only walk into the models the line gets near to; usually none
+  FGSceneryIntersect intersectVisitor(lineSegment, butNotFrom);
+  intersectVisitor.setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
+  for (size_t i = 0; i < models.size(); ++i) {
+    const osg::BoundingSphere& bound = models[i]->getBound();
+    if (!bound.valid())
+      continue;
+    SGSphered sphere(toVec3d(toSG(bound._center)), bound._radius);
+    if (intersects(lineSegment, sphere))
+      models[i]->accept(intersectVisitor);
+  }
+
+  if (!intersectVisitor.getHaveHit())
+    return false;
+
+  alt = SGGeod::fromCart(intersectVisitor.getLineSegment().getEnd()).getElevationM();
+  if (material)
+    *material = intersectVisitor.getMaterial();
+  return true;
+}
+
+// the branches besides the terrain, or rather their children where the
+// branch is a plain group. The list is gathered once per frame, their
+// bounds are looked at on each query as the models move.
+const FGScenery::NodeList&
+FGScenery::get_dynamic_models()
+{
+  osg::FrameStamp* framestamp = 0;
+  if (globals->get_renderer() && globals->get_renderer()->getViewer())
+    framestamp = globals->get_renderer()->getViewer()->getFrameStamp();
+  unsigned frame = framestamp ? framestamp->getFrameNumber() : 0;
+  if (framestamp && _dynamicModelsValid && (frame == _dynamicModelsFrame))
+    return _dynamicModels;
+
+  _dynamicModels.clear();
+  for (unsigned i = 0; i < scene_graph->getNumChildren(); ++i) {
+    osg::Node* child = scene_graph->getChild(i);
+    if (child == terrain_branch.get())
+      continue;
+    osg::Group* branch = child->asGroup();
+    if (!branch || branch->asTransform()) {
+      _dynamicModels.push_back(child);
+      continue;
+    }
+    for (unsigned j = 0; j < branch->getNumChildren(); ++j)
+      _dynamicModels.push_back(branch->getChild(j));
+  }
+  _dynamicModelsFrame = frame;
+  _dynamicModelsValid = true;
+  return _dynamicModels;
+}
+
+void
+FGScenery::invalidate_elevations(const SGBucket& bucket)
+{
+  // tiles are not cut exactly at the bucket edges, and airports in
+  // particular can reach well into their neighbours
+  const double margin = 0.05;
+  double halfWidth = bucket.get_width() * 0.5 + margin;
+  double halfHeight = bucket.get_height() * 0.5 + margin;
+  _elevationCache.invalidate(bucket.get_center_lat() - halfHeight,
+                             bucket.get_center_lon() - halfWidth,
+                             bucket.get_center_lat() + halfHeight,
+                             bucket.get_center_lon() + halfWidth);
+}
+
+void
+FGScenery::clear_elevation_cache()
+{
+  _elevationCache.clear();
+}
+
 bool
 FGScenery::get_cart_ground_intersection(const SGVec3d& pos, const SGVec3d& dir,
                                         SGVec3d& nearestHit,
@@ -29,6 +29,8 @@
 # error This library requires C++
 #endif                                   
 
+#include <vector>
+
 #include <osg/ref_ptr>
 #include <osg/Group>
 
@@ -37,11 +39,14 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 
 #include "SceneryPager.hxx"
+#include "ElevationCache.hxx"
 
 namespace simgear {
 class BVHMaterial;
 }
 
+class SGBucket;
+
 // Define a structure containing global scenery parameters
 class FGScenery : public SGSubsystem {
 
@@ -51,8 +56,35 @@ class FGScenery : public SGSubsystem {
     osg::ref_ptr<osg::Group> models_branch;
     osg::ref_ptr<osg::Group> aircraft_branch;
     osg::ref_ptr<flightgear::SceneryPager> _pager;
+    flightgear::ElevationCache _elevationCache;
+
+    // the models outside the terrain branch, gathered once per frame
+    typedef std::vector<osg::ref_ptr<osg::Node> > NodeList;
+    NodeList _dynamicModels;
+    unsigned _dynamicModelsFrame;
+    bool _dynamicModelsValid;
+
+    const flightgear::ElevationCache::Cell*
+    get_terrain_cell(const SGGeod& geod);
+    bool get_cached_elevation_m(const flightgear::ElevationCache::Cell* cell,
+                                const SGGeod& geod, double& alt,
+                                const simgear::BVHMaterial** material,
+                                const osg::Node* butNotFrom);
+    bool get_dynamic_elevation_m(const SGGeod& geod, double terrainAlt,
+                                 double& alt,
+                                 const simgear::BVHMaterial** material,
+                                 const osg::Node* butNotFrom);
+    const NodeList& get_dynamic_models();
 
 public:
+    struct ElevationQuery
+    {
+        SGGeod pos;         ///< the point to look down from
+        double elevationM;  ///< results, only meaningful if valid is set
+        const simgear::BVHMaterial* material;
+        bool valid;
+    };
+    typedef std::vector<ElevationQuery> ElevationQueryList;
 
     FGScenery();
     ~FGScenery();
@@ -77,6 +109,28 @@ public:
                          const simgear::BVHMaterial** material,
                          const osg::Node* butNotFrom = 0);
 
+    /// As get_elevation_m, but the static terrain is answered from a grid
+    /// cache where possible (see flightgear::ElevationCache), so repeated
+    /// queries in the same area are cheap. Moving models are still looked
+    /// at on every call, but only those whose bounds the query line
+    /// crosses. The cache approximates the terrain of a cell by the plane
+    /// of the triangle below its centre, so results may differ from
+    /// get_elevation_m wherever the terrain is not flat across the cell.
+    bool get_cached_elevation_m(const SGGeod& geod, double& alt,
+                                const simgear::BVHMaterial** material,
+                                const osg::Node* butNotFrom = 0);
+
+    /// Batched get_cached_elevation_m. The queries are grouped by cache
+    /// cell, so each cell is looked up, or sampled, once per call.
+    /// Returns the number of queries for which scenery was available.
+    unsigned get_cached_elevations_m(ElevationQueryList& queries,
+                                     const osg::Node* butNotFrom = 0);
+
+    /// Forget cached elevations around a tile; called by the tile manager
+    /// whenever a tile is loaded, refreshed or dropped.
+    void invalidate_elevations(const SGBucket& bucket);
+    void clear_elevation_cache();
+
     /// Compute the elevation of the scenery below the cartesian point pos.
     /// you the returned scenery altitude is not higher than the position
     /// pos plus an offset given with max_altoff.
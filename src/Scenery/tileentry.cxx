@@ -44,7 +44,8 @@ TileEntry::TileEntry ( const SGBucket& b )
       _node( new osg::LOD ),
       _priority(-FLT_MAX),
       _current_view(false),
-      _time_expired(-1.0)
+      _time_expired(-1.0),
+  _was_loaded(false)
 {
     tileFileName += ".stg";
     _node->setName(tileFileName);
@@ -60,7 +61,8 @@ TileEntry::TileEntry( const TileEntry& t )
   _node( new osg::LOD ),
   _priority(t._priority),
   _current_view(t._current_view),
-  _time_expired(t._time_expired)
+  _time_expired(t._time_expired),
+  _was_loaded(false)
 {
     _node->setName(tileFileName);
     // Give a default LOD range so that traversals that traverse
@@ -85,6 +87,15 @@ void TileEntry::prep_ssg_node(float vis) {
     _node->setRange( 0, 0, vis + bounding_radius );
 }
 
+bool
+TileEntry::loadStateChanged()
+{
+    bool loaded = is_loaded();
+    bool changed = (loaded != _was_loaded);
+    _was_loaded = loaded;
+    return changed;
+}
+
 void
 TileEntry::addToSceneGraph(osg::Group *terrain_branch)
 {
@@ -71,6 +71,8 @@ private:
     bool _current_view;
     /** Time when tile expires. */ 
     double _time_expired;
+    /** Load state seen by the last loadStateChanged() call. */
+    bool _was_loaded;
 
 public:
 
@@ -99,6 +101,12 @@ public:
         return _node->getNumChildren() > 0;
     }
 
+    /**
+     * Return true if the tile has been loaded or unloaded since the
+     * last call.
+     */
+    bool loadStateChanged();
+
     /**
      * Return the "bucket" for this tile
      */
@@ -100,7 +100,11 @@ void FGTileMgr::init() {
 
 void FGTileMgr::refresh_tile(void* tileMgr, long tileIndex)
 {
-    ((FGTileMgr*) tileMgr)->tile_cache.refresh_tile(tileIndex);
+    TileCache& cache = ((FGTileMgr*) tileMgr)->tile_cache;
+    TileEntry* t = cache.get_tile(tileIndex);
+    if (t)
+        globals->get_scenery()->invalidate_elevations(t->get_tile_bucket());
+    cache.refresh_tile(tileIndex);
 }
 
 void FGTileMgr::reinit()
@@ -123,6 +127,7 @@ void FGTileMgr::reinit()
     osg::Group* group = globals->get_scenery()->get_terrain_branch();
     group->removeChildren(0, group->getNumChildren());
     tile_cache.init();
+    globals->get_scenery()->clear_elevation_cache();
     
     // clear OSG cache, except on initial start-up
     if (state != Start)
@@ -262,6 +267,10 @@ void FGTileMgr::update_queues()
             // based on current visibilty
             e->prep_ssg_node(vis);
 
+            // the pager has merged (or the tile has lost) its subgraph
+            if (e->loadStateChanged())
+                globals->get_scenery()->invalidate_elevations(e->get_tile_bucket());
+
             if (( !e->is_loaded() )&&
                 ((!e->is_expired(current_time))||
                   e->is_current_view() ))
@@ -295,6 +304,7 @@ void FGTileMgr::update_queues()
             tile_cache.clear_entry(drop_index);
             
             osg::ref_ptr<osg::Object> subgraph = old->getNode();
+            globals->get_scenery()->invalidate_elevations(old->get_tile_bucket());
             old->removeFromSceneGraph();
             delete old;
             // zeros out subgraph ref_ptr, so subgraph is owned by
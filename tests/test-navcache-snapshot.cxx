@@ -0,0 +1,103 @@
+// check that a stamped ILS update survives reopening the nav cache and
+// its snapshot
+//
+// Usage: test-navcache-snapshot <fg-root> <ils-ident>
+//
+// The cache is built in a scratch FG_HOME below the current directory.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <simgear/compiler.h>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include <simgear/misc/sg_path.hxx>
+
+#include <Main/globals.hxx>
+#include <Navaids/NavDataCache.hxx>
+#include <Navaids/navrecord.hxx>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using flightgear::NavDataCache;
+
+static FGNavRecord* findILS(NavDataCache* cache, const std::string& ident)
+{
+    FGPositioned::TypeFilter filter(FGPositioned::ILS);
+    FGPositionedList ils = cache->findAllWithIdent(ident, &filter, true);
+    if (ils.empty())
+        return NULL;
+    return static_cast<FGNavRecord*>(ils.front().ptr());
+}
+
+static NavDataCache* openCache()
+{
+    NavDataCache* cache = NavDataCache::instance();
+    if (cache->isRebuildRequired()) {
+        while (!cache->rebuild())
+            ;
+    }
+    if (!cache->useSnapshot())
+        cerr << "no snapshot, reading from the DB" << endl;
+    return cache;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        cerr << "Usage: " << argv[0] << " <fg-root> <ils-ident>" << endl;
+        return 1;
+    }
+
+    SGPath home("test-navcache-home");
+    globals = new FGGlobals;
+    globals->set_fg_root(argv[1]);
+    globals->set_fg_home(home.str());
+
+    // stands for the scenery file the update comes from
+    SGPath stampFile(home);
+    stampFile.append("ils.xml");
+    stampFile.create_dir(0755);
+    FILE* f = fopen(stampFile.c_str(), "w");
+    if (f)
+        fclose(f);
+
+    NavDataCache* cache = openCache();
+    FGNavRecord* ils = findILS(cache, argv[2]);
+    if (!ils) {
+        cerr << "no ILS " << argv[2] << endl;
+        return 1;
+    }
+
+    PositionedID guid = ils->guid();
+    double heading = fmod(ils->get_multiuse() + 1.5, 360.0);
+    {
+        NavDataCache::Transaction txn(cache);
+        cache->updateILS(guid, ils->geod(), heading);
+        cache->stampCacheFile(stampFile);
+        txn.commit();
+    }
+
+    // a new session: the update is stamped, so it is not applied again
+    delete cache;
+    cache = openCache();
+    if (cache->isCachedFileModified(stampFile)) {
+        cerr << "FAILED: the update was not stamped" << endl;
+        return 1;
+    }
+
+    ils = static_cast<FGNavRecord*>(cache->loadById(guid).ptr());
+    cout << argv[2] << " heading " << ils->get_multiuse()
+         << ", expected " << heading << endl;
+    if (fabs(ils->get_multiuse() - heading) > 1e-6) {
+        cerr << "FAILED: the snapshot serves the old heading" << endl;
+        return 1;
+    }
+
+    cout << "passed" << endl;
+    return 0;
+}
@@ -21,8 +21,17 @@
 #endif
 
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
 #include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 #include <osg/ArgumentParser>
 #include <osg/Image>
@@ -31,6 +40,7 @@
 #include <simgear/props/props_io.hxx>
 #include <simgear/misc/sg_path.hxx>
 #include <simgear/misc/ResourceManager.hxx>
+#include <simgear/bucket/newbucket.hxx>
 #include <simgear/bvh/BVHNode.hxx>
 #include <simgear/bvh/BVHLineSegmentVisitor.hxx>
 #include <simgear/bvh/BVHPager.hxx>
@@ -41,25 +51,37 @@
 #include <simgear/scene/util/SGReaderWriterOptions.hxx>
 #include <simgear/scene/util/OptionsReadFileCallback.hxx>
 #include <simgear/scene/tgdb/userdata.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
 
 namespace sg = simgear;
 
 class Visitor : public sg::BVHLineSegmentVisitor {
 public:
-    Visitor(const SGLineSegmentd& lineSegment, sg::BVHPager& pager) :
+    Visitor(const SGLineSegmentd& lineSegment, sg::BVHPager& pager,
+            SGMutex* pagerMutex) :
         BVHLineSegmentVisitor(lineSegment, 0),
-        _pager(pager)
+        _pager(pager),
+        _pagerMutex(pagerMutex)
     { }
     virtual ~Visitor()
     { }
     virtual void apply(sg::BVHPageNode& node)
     {
         // we have a non threaded pager so load just right here.
-        _pager.use(node);
+        // With several threads querying, only one of them may page at a
+        // time; the rest of the tree is only read.
+        if (_pagerMutex) {
+            SGGuard<SGMutex> guard(*_pagerMutex);
+            _pager.use(node);
+        } else {
+            _pager.use(node);
+        }
         BVHLineSegmentVisitor::apply(node);
     }
 private:
     sg::BVHPager& _pager;
+    SGMutex* _pagerMutex;
 };
 
 // Short circuit reading image files.
@@ -73,11 +95,11 @@ public:
 };
 
 static bool
-intersect(sg::BVHNode& node, sg::BVHPager& pager,
+intersect(sg::BVHNode& node, sg::BVHPager& pager, SGMutex* pagerMutex,
           const SGVec3d& start, SGVec3d& end, double offset)
 {
     SGVec3d perp = offset*perpendicular(start - end);
-    Visitor visitor(SGLineSegmentd(start + perp, end + perp), pager);
+    Visitor visitor(SGLineSegmentd(start + perp, end + perp), pager, pagerMutex);
     node.accept(visitor);
     if (visitor.empty())
         return false;
@@ -85,6 +107,223 @@ intersect(sg::BVHNode& node, sg::BVHPager& pager,
     return true;
 }
 
+// Elevation at the given position. When the vertical hits a hole in the
+// terrain, nearby lines are tried; holeScale tells how far off the hit was.
+static bool
+elevation(sg::BVHNode& node, sg::BVHPager& pager, SGMutex* pagerMutex,
+          double lon, double lat, double& elevationM, double& holeScale)
+{
+    SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, 10000));
+    SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, -1000));
+
+    // Try to find an intersection
+    bool found = intersect(node, pager, pagerMutex, start, end, 0);
+    double scale = 1e-5;
+    while (!found && scale <= 1) {
+        found = intersect(node, pager, pagerMutex, start, end, scale);
+        scale *= 2;
+    }
+    holeScale = scale;
+    if (found)
+        elevationM = SGGeod::fromCart(end).getElevationM();
+    return found;
+}
+
+static void
+reportHole(double scale, double lon, double lat)
+{
+    if (1e-5 < scale)
+        std::cerr << "Found hole of minimum diameter "
+                  << scale << "m at lon = " << lon
+                  << "deg lat = " << lat << "deg" << std::endl;
+}
+
+/// One point of a batch.
+struct Query {
+    std::string id;
+    double lon;
+    double lat;
+    long tile;
+    bool found;
+    double elevationM;
+    double holeScale;
+};
+
+/// Orders queries by scenery tile, to page each tile in just once.
+struct TileLess {
+    TileLess(const std::vector<Query>& queries) : _queries(queries) {}
+    bool operator()(size_t a, size_t b) const
+    { return _queries[a].tile < _queries[b].tile; }
+    const std::vector<Query>& _queries;
+};
+
+// A block of queries, computed by all threads which call process(). The
+// queries are handed out in tile order, a small run at a time, so each
+// thread tends to stay on the tiles it has just paged in.
+class Batch {
+public:
+    Batch(sg::BVHNode& node, sg::BVHPager& pager, std::vector<Query>& queries) :
+        _node(node),
+        _pager(pager),
+        _queries(queries),
+        _order(queries.size()),
+        _next(0)
+    {
+        for (size_t i = 0; i < queries.size(); ++i) {
+            queries[i].tile = SGBucket(queries[i].lon, queries[i].lat).gen_index();
+            _order[i] = i;
+        }
+        std::stable_sort(_order.begin(), _order.end(), TileLess(queries));
+    }
+
+    void process()
+    {
+        // queries handed to a thread at a time
+        const size_t chunkSize = 64;
+        for (;;) {
+            size_t begin, end;
+            {
+                SGGuard<SGMutex> guard(_mutex);
+                begin = _next;
+                end = std::min(begin + chunkSize, _order.size());
+                _next = end;
+            }
+            if (begin == end)
+                return;
+
+            for (size_t i = begin; i < end; ++i) {
+                Query& query = _queries[_order[i]];
+                query.found = elevation(_node, _pager, &_pagerMutex,
+                                        query.lon, query.lat,
+                                        query.elevationM, query.holeScale);
+            }
+        }
+    }
+
+private:
+    sg::BVHNode& _node;
+    sg::BVHPager& _pager;
+    std::vector<Query>& _queries;
+    std::vector<size_t> _order;
+    size_t _next;
+    SGMutex _mutex;
+    SGMutex _pagerMutex;
+};
+
+class Worker : public SGThread {
+public:
+    Worker(Batch& batch) :
+        _batch(batch)
+    { }
+protected:
+    virtual void run()
+    { _batch.process(); }
+private:
+    Batch& _batch;
+};
+
+// Read up to count queries, as "id lon lat" lines or, in binary mode, as
+// pairs of native doubles lon, lat. Returns false on malformed input.
+static bool
+readQueries(std::vector<Query>& queries, size_t count, bool binary)
+{
+    queries.clear();
+    if (binary) {
+        std::vector<double> buffer(2*count);
+        size_t n = std::fread(&buffer[0], 2*sizeof(double), count, stdin);
+        queries.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            queries[i].lon = buffer[2*i];
+            queries[i].lat = buffer[2*i + 1];
+        }
+        return !std::ferror(stdin);
+    }
+
+    while (queries.size() < count) {
+        Query query;
+        std::cin >> query.id >> query.lon >> query.lat;
+        if (std::cin.fail())
+            return std::cin.eof() && query.id.empty();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        queries.push_back(query);
+    }
+    return true;
+}
+
+// Write the results in input order: "id: elevation" lines or, in binary
+// mode, one native double per query. Points without terrain get -1000.
+static void
+writeResults(const std::vector<Query>& queries, bool binary)
+{
+    if (binary) {
+        std::vector<double> buffer(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+            buffer[i] = queries[i].found ? queries[i].elevationM : -1000;
+        if (!buffer.empty())
+            std::fwrite(&buffer[0], sizeof(double), buffer.size(), stdout);
+        std::fflush(stdout);
+        return;
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        std::cout << queries[i].id << ": ";
+        if (!queries[i].found) {
+            std::cout << "-1000" << '\n';
+        } else {
+            std::cout << std::fixed << std::setprecision(3) << queries[i].elevationM << '\n';
+        }
+    }
+    std::cout.flush();
+}
+
+// Answer the queries block by block, with the given number of threads.
+static int
+runBatches(sg::BVHNode& node, sg::BVHPager& pager, size_t batchSize,
+           unsigned threads, bool binary)
+{
+#ifdef _WIN32
+    if (binary) {
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    std::vector<Query> queries;
+    for (;;) {
+        bool ok = readQueries(queries, batchSize, binary);
+        if (queries.empty())
+            return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+
+        // Everything in a batch shares one paging stamp
+        pager.setUseStamp(1 + pager.getUseStamp());
+
+        {
+            Batch batch(node, pager, queries);
+            std::vector<Worker*> workers;
+            for (unsigned i = 1; i < threads; ++i) {
+                workers.push_back(new Worker(batch));
+                workers.back()->start();
+            }
+            batch.process();
+            for (size_t i = 0; i < workers.size(); ++i) {
+                workers[i]->join();
+                delete workers[i];
+            }
+        }
+
+        for (size_t i = 0; i < queries.size(); ++i)
+            reportHole(queries[i].holeScale, queries[i].lon, queries[i].lat);
+        writeResults(queries, binary);
+
+        // expire everything not accessed by the past two batches; the pager
+        // is not in use by any thread now
+        pager.update(2);
+
+        if (!ok)
+            return EXIT_FAILURE;
+    }
+}
+
 int
 main(int argc, char** argv)
 {
@@ -101,6 +340,20 @@ main(int argc, char** argv)
         fg_root = PKGLIBDIR;
     }
 
+    // Batch mode: answer blocks of queries at once, on several threads
+    int batchSize = 1;
+    arguments.read("--batch-size", batchSize);
+    int threads = 1;
+    arguments.read("--threads", threads);
+    bool binary = arguments.read("--binary");
+    if (threads < 1)
+        threads = 1;
+    if (1 < threads || binary) {
+        // a batch for the threads to share
+        if (batchSize <= 1)
+            batchSize = 64*1024;
+    }
+
     std::string fg_scenery;
     if (arguments.read("--fg-scenery", fg_scenery)) {
     } else if (const char *fg_scenery_env = std::getenv("FG_SCENERY")) {
@@ -180,6 +433,9 @@ main(int argc, char** argv)
     // We assume that the above is a paged database.
     sg::BVHPager pager;
 
+    if (1 < batchSize)
+        return runBatches(*node, pager, batchSize, threads, binary);
+
     while (std::cin.good()) {
         // Increment the paging relevant number
         pager.setUseStamp(1 + pager.getUseStamp());
@@ -194,27 +450,15 @@ main(int argc, char** argv)
             return EXIT_FAILURE;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-        SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, 10000));
-        SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, -1000));
-
-        // Try to find an intersection
-        bool found = intersect(*node, pager, start, end, 0);
-        double scale = 1e-5;
-        while (!found && scale <= 1) {
-            found = intersect(*node, pager, start, end, scale);
-            scale *= 2;
-        }
-        if (1e-5 < scale)
-            std::cerr << "Found hole of minimum diameter "
-                      << scale << "m at lon = " << lon
-                      << "deg lat = " << lat << "deg" << std::endl;
+        double elevationM, scale;
+        bool found = elevation(*node, pager, 0, lon, lat, elevationM, scale);
+        reportHole(scale, lon, lat);
 
         std::cout << id << ": ";
         if (!found) {
             std::cout << "-1000" << std::endl;
         } else {
-            SGGeod geod = SGGeod::fromCart(end);
-            std::cout << std::fixed << std::setprecision(3) << geod.getElevationM() << std::endl;
+            std::cout << std::fixed << std::setprecision(3) << elevationM << std::endl;
         }
     }
 
@@ -0,0 +1,514 @@
+// jsbbatch.cxx -- run many JSBSim cases of one aircraft in parallel
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+// Usage:
+//
+//   jsbbatch --aircraft <name> --cases <file> --output <file>
+//            [--root <dir>] [--duration <sec>] [--dt <sec>] [--rate <hz>]
+//            [--trim <mode>] [--jobs <n>] --property <name> ...
+//
+// The case file is text. Its first line names the properties to set, each
+// further line holds the values of one case. Properties below "ic/" are set
+// before the initial conditions are applied, all others afterwards, so
+// that control inputs survive the reset. '#' starts a comment.
+//
+//   ic/h-sl-ft  ic/vc-kts  ic/gamma-deg  fcs/throttle-cmd-norm
+//   5000        120        0             0.8
+//   5000        140        0             0.8
+//
+// The cases are run by worker processes, not threads: the ground callback,
+// the message queue and other state of JSBSim are process-wide, so two
+// FGFDMExec must not run at the same time in one process. Each worker
+// loads the aircraft once and then runs every n-th case on it, resetting
+// it to the new initial conditions; XML is only parsed once per worker.
+//
+// The output file is binary, in native byte order. Each worker writes its
+// runs to a file of its own, which are appended to the output at the end,
+// so the runs are not in case order:
+//
+//   char[8]  "JSBBATCH"
+//   uint32   version, 1
+//   uint32   number of columns C; the first one is the simulation time
+//   C times: uint32 length, then the characters of the column name
+//   then for each run:
+//     uint32   case number, counted from 0
+//     int32    status: 0 done, 1 trim failed, 2 error
+//     uint32   number of samples S
+//     C times: S doubles, the samples of that column
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <simgear/misc/stdint.hxx>
+
+#include <FDM/JSBSim/FGFDMExec.h>
+#include <FDM/JSBSim/initialization/FGTrim.h>
+#include <FDM/JSBSim/input_output/FGPropertyManager.h>
+
+using namespace std;
+using JSBSim::FGFDMExec;
+using JSBSim::FGPropertyManager;
+
+enum Status { Done = 0, TrimFailed = 1, Failed = 2 };
+
+struct Options {
+    Options() :
+        root("."), duration(10.0), dt(1.0/120.0), rate(0.0),
+        trim(-1), jobs(4)
+    { }
+    string root;
+    string aircraft;
+    string casesFile;
+    string outputFile;
+    double duration;
+    double dt;
+    double rate;
+    int trim;
+    unsigned jobs;
+    vector<string> properties;
+};
+
+struct Case {
+    vector<double> values;
+};
+
+struct Result {
+    uint32_t index;
+    int32_t status;
+    vector<double> samples; ///< column after column
+    uint32_t count;
+};
+
+/// The share of the cases of one worker and the file of its runs.
+class Batch {
+public:
+    Batch(const Options& options, const vector<string>& inputs,
+          const vector<Case>& cases, unsigned first, unsigned stride,
+          ostream& out) :
+        _options(options),
+        _inputs(inputs),
+        _cases(cases),
+        _out(out),
+        _first(first),
+        _next(first),
+        _stride(stride),
+        _count(0),
+        _finished(0),
+        _failed(0)
+    {
+        for (unsigned i = first; i < cases.size(); i += stride)
+            ++_count;
+    }
+
+    const Options& options() const { return _options; }
+    const vector<string>& inputs() const { return _inputs; }
+    const Case& getCase(unsigned index) const { return _cases[index]; }
+
+    bool next(unsigned& index)
+    {
+        if (_next >= _cases.size())
+            return false;
+        index = _next;
+        _next += _stride;
+        return true;
+    }
+
+    void write(const Result& result)
+    {
+        _out.write((const char*)&result.index, sizeof(result.index));
+        _out.write((const char*)&result.status, sizeof(result.status));
+        _out.write((const char*)&result.count, sizeof(result.count));
+        if (!result.samples.empty())
+            _out.write((const char*)&result.samples[0],
+                       result.samples.size()*sizeof(double));
+        ++_finished;
+        if (result.status != Done)
+            ++_failed;
+        if (_finished % 100 == 0 || _finished == _count)
+            cerr << "worker " << _first << ": " << _finished << "/"
+                 << _count << " cases, " << _failed << " failed" << endl;
+    }
+
+    unsigned failed() const { return _failed; }
+
+private:
+    const Options& _options;
+    const vector<string>& _inputs;
+    const vector<Case>& _cases;
+    ostream& _out;
+    unsigned _first;
+    unsigned _next;
+    unsigned _stride;
+    unsigned _count;
+    unsigned _finished;
+    unsigned _failed;
+};
+
+/// One aircraft instance, running the cases it is handed.
+class Worker {
+public:
+    Worker(Batch& batch) :
+        _batch(batch),
+        _exec(0)
+    { }
+    ~Worker()
+    {
+        delete _exec;
+    }
+
+    bool load()
+    {
+        const Options& options = _batch.options();
+        _exec = new FGFDMExec();
+        _exec->SetDebugLevel(0);
+        _exec->SetRootDir(options.root + "/");
+        _exec->SetAircraftPath("aircraft");
+        _exec->SetEnginePath("engine");
+        _exec->SetSystemsPath("systems");
+        if (!_exec->LoadModel(options.aircraft))
+            return false;
+        _exec->Setdt(options.dt);
+        // the aircraft's own <output> files would be written by every worker
+        _exec->SetLoggingRate(0.0);
+
+        FGPropertyManager* pm = _exec->GetPropertyManager();
+        for (unsigned i = 0; i < _batch.inputs().size(); ++i) {
+            const string& name = _batch.inputs()[i];
+            FGPropertyManager* node = pm->GetNode(name);
+            if (!node) {
+                cerr << "Unknown property " << name << endl;
+                return false;
+            }
+            _inputs.push_back(node);
+        }
+        for (unsigned i = 0; i < options.properties.size(); ++i) {
+            const string& name = options.properties[i];
+            FGPropertyManager* node = pm->GetNode(name);
+            if (!node) {
+                cerr << "Unknown property " << name << endl;
+                return false;
+            }
+            _outputs.push_back(node);
+        }
+        return true;
+    }
+
+    void run()
+    {
+        unsigned index;
+        Result result;
+        while (_batch.next(index)) {
+            result.index = index;
+            try {
+                result.status = simulate(_batch.getCase(index), result);
+            } catch (const string& msg) {
+                cerr << "Case " << index << ": " << msg << endl;
+                result.status = Failed;
+            } catch (const char* msg) {
+                cerr << "Case " << index << ": " << msg << endl;
+                result.status = Failed;
+            } catch (...) {
+                cerr << "Case " << index << ": unknown error" << endl;
+                result.status = Failed;
+            }
+            if (result.status != Done) {
+                result.samples.clear();
+                result.count = 0;
+            }
+            // nobody reads the landing and crash messages of the gear
+            while (_exec->SomeMessages())
+                _exec->ProcessNextMessage();
+            _batch.write(result);
+        }
+    }
+
+private:
+    Status simulate(const Case& c, Result& result)
+    {
+        const Options& options = _batch.options();
+        const vector<string>& names = _batch.inputs();
+
+        for (unsigned i = 0; i < _inputs.size(); ++i)
+            if (names[i].compare(0, 3, "ic/") == 0)
+                _inputs[i]->setDoubleValue(c.values[i]);
+        _exec->ResetToInitialConditions();
+        for (unsigned i = 0; i < _inputs.size(); ++i)
+            if (names[i].compare(0, 3, "ic/") != 0)
+                _inputs[i]->setDoubleValue(c.values[i]);
+
+        if (options.trim >= 0) {
+            JSBSim::FGTrim trim(_exec, (JSBSim::TrimMode)options.trim);
+            if (!trim.DoTrim())
+                return TrimFailed;
+            _exec->Setsim_time(0.0);
+        }
+
+        unsigned frames = (unsigned)floor(options.duration/options.dt + 0.5);
+        unsigned interval = 1;
+        if (options.rate > 0.0)
+            interval = max(1u, (unsigned)floor(1.0/(options.rate*options.dt) + 0.5));
+
+        // sample row by row, transpose into columns at the end
+        unsigned columns = _outputs.size() + 1;
+        _rows.clear();
+        _rows.reserve((frames/interval + 1)*columns);
+        for (unsigned frame = 0; ; ++frame) {
+            if (frame % interval == 0) {
+                _rows.push_back(_exec->GetSimTime());
+                for (unsigned i = 0; i < _outputs.size(); ++i)
+                    _rows.push_back(_outputs[i]->getDoubleValue());
+            }
+            if (frame == frames || !_exec->Run())
+                break;
+        }
+
+        result.count = _rows.size()/columns;
+        result.samples.resize(_rows.size());
+        for (unsigned r = 0; r < result.count; ++r)
+            for (unsigned i = 0; i < columns; ++i)
+                result.samples[i*result.count + r] = _rows[r*columns + i];
+        return Done;
+    }
+
+    Batch& _batch;
+    FGFDMExec* _exec;
+    vector<FGPropertyManager*> _inputs;
+    vector<FGPropertyManager*> _outputs;
+    vector<double> _rows;
+};
+
+static void usage()
+{
+    cerr << "Usage: jsbbatch --aircraft <name> --cases <file> --output <file>" << endl
+         << "                [--root <dir>] [--duration <sec>] [--dt <sec>]" << endl
+         << "                [--rate <hz>] [--trim <mode>] [--jobs <n>]" << endl
+         << "                --property <name> [--property <name> ...]" << endl;
+}
+
+static bool readCases(const string& fileName, vector<string>& inputs,
+                      vector<Case>& cases)
+{
+    ifstream in(fileName.c_str());
+    if (!in) {
+        cerr << "Could not open " << fileName << endl;
+        return false;
+    }
+
+    string line;
+    unsigned lineNumber = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        string::size_type comment = line.find('#');
+        if (comment != string::npos)
+            line.erase(comment);
+        istringstream stream(line);
+
+        if (inputs.empty()) {
+            string name;
+            while (stream >> name)
+                inputs.push_back(name);
+            continue;
+        }
+
+        Case c;
+        double value;
+        while (stream >> value)
+            c.values.push_back(value);
+        if (c.values.empty() && stream.eof())
+            continue;
+        if (!stream.eof() || c.values.size() != inputs.size()) {
+            cerr << fileName << ":" << lineNumber << ": expected "
+                 << inputs.size() << " values" << endl;
+            return false;
+        }
+        cases.push_back(c);
+    }
+    return true;
+}
+
+static void writeHeader(ostream& out, const Options& options)
+{
+    const uint32_t version = 1;
+    uint32_t columns = options.properties.size() + 1;
+    out.write("JSBBATCH", 8);
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)&columns, sizeof(columns));
+    for (uint32_t i = 0; i < columns; ++i) {
+        string name = i ? options.properties[i - 1] : "simulation/sim-time-sec";
+        uint32_t length = name.size();
+        out.write((const char*)&length, sizeof(length));
+        out.write(name.data(), length);
+    }
+}
+
+static string partFileName(const Options& options, unsigned worker)
+{
+    ostringstream name;
+    name << options.outputFile << "." << worker;
+    return name.str();
+}
+
+/// Run every jobs-th case from the first one on, in a forked process.
+/// Returns the exit status of the worker: 2 if some cases failed.
+static int runWorker(const Options& options, const vector<string>& inputs,
+                     const vector<Case>& cases, unsigned first, unsigned jobs)
+{
+    string part = partFileName(options, first);
+    ofstream out(part.c_str(), ios::out | ios::binary);
+    if (!out) {
+        cerr << "Could not create " << part << endl;
+        return EXIT_FAILURE;
+    }
+
+    Batch batch(options, inputs, cases, first, jobs, out);
+    Worker worker(batch);
+    if (!worker.load()) {
+        cerr << "Could not load " << options.aircraft << endl;
+        return EXIT_FAILURE;
+    }
+    worker.run();
+
+    out.close();
+    if (!out) {
+        cerr << "Error writing " << part << endl;
+        return EXIT_FAILURE;
+    }
+    return batch.failed() ? 2 : EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 == argc) {
+            usage();
+            return EXIT_FAILURE;
+        }
+        string value = argv[++i];
+        if (arg == "--root")
+            options.root = value;
+        else if (arg == "--aircraft")
+            options.aircraft = value;
+        else if (arg == "--cases")
+            options.casesFile = value;
+        else if (arg == "--output")
+            options.outputFile = value;
+        else if (arg == "--duration")
+            options.duration = atof(value.c_str());
+        else if (arg == "--dt")
+            options.dt = atof(value.c_str());
+        else if (arg == "--rate")
+            options.rate = atof(value.c_str());
+        else if (arg == "--trim")
+            options.trim = atoi(value.c_str());
+        else if (arg == "--jobs")
+            options.jobs = atoi(value.c_str());
+        else if (arg == "--property")
+            options.properties.push_back(value);
+        else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.aircraft.empty() || options.casesFile.empty() ||
+        options.outputFile.empty() || !(options.dt > 0.0)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    vector<string> inputs;
+    vector<Case> cases;
+    if (!readCases(options.casesFile, inputs, cases))
+        return EXIT_FAILURE;
+    if (cases.empty()) {
+        cerr << "No cases in " << options.casesFile << endl;
+        return EXIT_FAILURE;
+    }
+
+    ofstream out(options.outputFile.c_str(), ios::out | ios::binary);
+    if (!out) {
+        cerr << "Could not create " << options.outputFile << endl;
+        return EXIT_FAILURE;
+    }
+    writeHeader(out, options);
+    out.flush();
+
+    unsigned jobs = max(1u, min(options.jobs, (unsigned)cases.size()));
+    vector<pid_t> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "Could not start worker " << i << endl;
+            break;
+        }
+        if (pid == 0)
+            _exit(runWorker(options, inputs, cases, i, jobs));
+        workers.push_back(pid);
+    }
+
+    bool ok = workers.size() == jobs;
+    bool failed = false;
+    for (unsigned i = 0; i < workers.size(); ++i) {
+        int status;
+        if (waitpid(workers[i], &status, 0) < 0 || !WIFEXITED(status)) {
+            cerr << "Worker " << i << " died" << endl;
+            ok = false;
+        } else if (WEXITSTATUS(status) == 2) {
+            failed = true;
+        } else if (WEXITSTATUS(status) != EXIT_SUCCESS) {
+            ok = false;
+        }
+    }
+
+    for (unsigned i = 0; i < workers.size(); ++i) {
+        string part = partFileName(options, i);
+        ifstream in(part.c_str(), ios::in | ios::binary);
+        if (in && in.peek() != EOF)
+            out << in.rdbuf();
+        in.close();
+        remove(part.c_str());
+    }
+
+    out.close();
+    if (!out) {
+        cerr << "Error writing " << options.outputFile << endl;
+        return EXIT_FAILURE;
+    }
+    if (!ok)
+        return EXIT_FAILURE;
+    return failed ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+// jsbbin2csv.cxx -- convert JSBSim binary output files to text
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+// Reads the files written by the BINARY output type of JSBSim (see
+// FGOutputBinaryFile.h for the format) and writes them as CSV, or with
+// --header, just lists the columns. Files written on a machine of the
+// other byte order are converted as well.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include <simgear/misc/stdint.hxx>
+
+using namespace std;
+
+static bool swapBytes = false;
+
+static void byteSwap(char* p, size_t n)
+{
+    for (size_t i = 0; i < n/2; ++i)
+        std::swap(p[i], p[n - 1 - i]);
+}
+
+template<class T>
+static T get(const char* p)
+{
+    T value;
+    memcpy(&value, p, sizeof(value));
+    if (swapBytes)
+        byteSwap((char*)&value, sizeof(value));
+    return value;
+}
+
+template<class T>
+static bool read(istream& in, T& value)
+{
+    if (!in.read((char*)&value, sizeof(value)))
+        return false;
+    if (swapBytes)
+        byteSwap((char*)&value, sizeof(value));
+    return true;
+}
+
+static void usage()
+{
+    cerr << "Usage: jsbbin2csv [--header] [--delimiter <string>] <file> [<output>]" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    bool headerOnly = false;
+    string delimiter = ",";
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        } else if (arg == "--header") {
+            headerOnly = true;
+        } else if (arg == "--delimiter" && i + 1 < argc) {
+            delimiter = argv[++i];
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty() || files.size() > 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    ifstream in(files[0].c_str(), ios::in | ios::binary);
+    if (!in) {
+        cerr << "Could not open " << files[0] << endl;
+        return EXIT_FAILURE;
+    }
+
+    char magic[8];
+    uint32_t byteOrder, version, recordSize, columns;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, "JSBSBIN", 8) != 0 ||
+        !read(in, byteOrder)) {
+        cerr << files[0] << " is not a JSBSim binary output file" << endl;
+        return EXIT_FAILURE;
+    }
+    if (byteOrder != 0x01020304) {
+        byteSwap((char*)&byteOrder, sizeof(byteOrder));
+        if (byteOrder != 0x01020304) {
+            cerr << files[0] << " has an unknown byte order" << endl;
+            return EXIT_FAILURE;
+        }
+        swapBytes = true;
+    }
+    if (!read(in, version) || version != 1) {
+        cerr << files[0] << " has an unsupported format version" << endl;
+        return EXIT_FAILURE;
+    }
+    if (!read(in, recordSize) || !read(in, columns)) {
+        cerr << files[0] << " is truncated" << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<char> types(columns);
+    vector<string> names(columns);
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < columns; ++i) {
+        uint32_t length;
+        if (!in.read(&types[i], 1) || !read(in, length)) {
+            cerr << files[0] << " is truncated" << endl;
+            return EXIT_FAILURE;
+        }
+        names[i].resize(length);
+        if (length && !in.read(&names[i][0], length)) {
+            cerr << files[0] << " is truncated" << endl;
+            return EXIT_FAILURE;
+        }
+        switch (types[i]) {
+        case 'd': size += sizeof(double); break;
+        case 'f': size += sizeof(float); break;
+        case 'i': size += sizeof(int32_t); break;
+        case 'b': size += 1; break;
+        default:
+            cerr << files[0] << ": unknown type of column " << names[i] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (size != recordSize) {
+        cerr << files[0] << ": the columns do not match the record size" << endl;
+        return EXIT_FAILURE;
+    }
+
+    ofstream file;
+    if (files.size() > 1) {
+        file.open(files[1].c_str());
+        if (!file) {
+            cerr << "Could not create " << files[1] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    ostream& out = files.size() > 1 ? file : cout;
+    out.precision(18);
+
+    if (headerOnly) {
+        for (uint32_t i = 0; i < columns; ++i)
+            out << types[i] << " " << names[i] << endl;
+        return EXIT_SUCCESS;
+    }
+
+    for (uint32_t i = 0; i < columns; ++i)
+        out << (i ? delimiter : "") << names[i];
+    out << endl;
+
+    vector<char> record(recordSize);
+    unsigned long records = 0;
+    while (in.read(&record[0], recordSize)) {
+        const char* p = &record[0];
+        for (uint32_t i = 0; i < columns; ++i) {
+            if (i)
+                out << delimiter;
+            switch (types[i]) {
+            case 'd':
+                out << get<double>(p);
+                p += sizeof(double);
+                break;
+            case 'f':
+                out << get<float>(p);
+                p += sizeof(float);
+                break;
+            case 'i':
+                out << get<int32_t>(p);
+                p += sizeof(int32_t);
+                break;
+            case 'b':
+                out << (*p ? 1 : 0);
+                p += 1;
+                break;
+            }
+        }
+        out << '\n';
+        ++records;
+    }
+    if (in.gcount() != 0)
+        cerr << files[0] << ": the last record is truncated" << endl;
+
+    out.flush();
+    if (!out) {
+        cerr << "Error writing the output" << endl;
+        return EXIT_FAILURE;
+    }
+    cerr << records << " records" << endl;
+    return EXIT_SUCCESS;
+}